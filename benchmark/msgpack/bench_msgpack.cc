@@ -0,0 +1,165 @@
+// Compares MessagePack decoding against JSON parsing.
+//
+// Usage: bench_msgpack [files...]
+//
+// Each JSON file is parsed and converted to MessagePack. Then the time to
+// build a json::Value from either format is measured, as well as the time to
+// run the SAX interface with callbacks that do nothing.
+
+#include "../../src/json.h"
+#include "../../src/json_msgpack.h"
+#include "../../src/json_parser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* benchmark_files[] = {
+    "test_data/examples/apache_builds.json",
+    "test_data/examples/canada.json",
+    "test_data/examples/citm_catalog.json",
+    "test_data/examples/github_events.json",
+    "test_data/examples/gsoc-2018.json",
+    "test_data/examples/instruments.json",
+    "test_data/examples/marine_ik.json",
+    "test_data/examples/mesh.json",
+    "test_data/examples/mesh.pretty.json",
+    "test_data/examples/numbers.json",
+    "test_data/examples/random.json",
+    "test_data/examples/twitter.json",
+    "test_data/examples/twitterescaped.json",
+    "test_data/examples/update-center.json",
+};
+
+static bool ReadFile(std::string& str, char const* filename)
+{
+    FILE* file = fopen(filename, "rb");
+    if (file == nullptr)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long const length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    str.resize(static_cast<size_t>(length));
+    size_t const num_read = fread(&str[0], 1, str.size(), file);
+    fclose(file);
+
+    return num_read == str.size();
+}
+
+struct NullCallbacks
+{
+    json::ParseStatus HandleNull() { return {}; }
+    json::ParseStatus HandleTrue() { return {}; }
+    json::ParseStatus HandleFalse() { return {}; }
+    json::ParseStatus HandleNumber(char const* /*first*/, char const* /*last*/, json::NumberClass /*nc*/) { return {}; }
+    json::ParseStatus HandleDouble(double /*value*/) { return {}; }
+    json::ParseStatus HandleString(char const* /*first*/, char const* /*last*/, json::StringClass /*sc*/) { return {}; }
+    json::ParseStatus HandleBeginArray() { return {}; }
+    json::ParseStatus HandleEndArray(size_t /*count*/) { return {}; }
+    json::ParseStatus HandleEndElement(size_t& /*count*/) { return {}; }
+    json::ParseStatus HandleBeginObject() { return {}; }
+    json::ParseStatus HandleEndObject(size_t /*count*/) { return {}; }
+    json::ParseStatus HandleEndMember(size_t& /*count*/) { return {}; }
+    json::ParseStatus HandleKey(char const* /*first*/, char const* /*last*/, json::StringClass /*sc*/) { return {}; }
+};
+
+template <typename Fn>
+static double Milliseconds(Fn fn)
+{
+    constexpr int kRuns = 10;
+
+    double min_ms = 1e300;
+    for (int i = 0; i < kRuns; ++i)
+    {
+        auto const start = Clock::now();
+        bool const ok = fn();
+        auto const end = Clock::now();
+
+        if (!ok)
+        {
+            fprintf(stderr, "error\n");
+            abort();
+        }
+
+        min_ms = std::min(min_ms, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    return min_ms;
+}
+
+static void benchmark(char const* filename)
+{
+    std::string input;
+    if (!ReadFile(input, filename))
+    {
+        fprintf(stderr, "file not found: %s\n", filename);
+        return;
+    }
+
+    json::Value doc;
+    if (json::parse(doc, input) != json::ParseStatus::success)
+    {
+        fprintf(stderr, "parse error: %s\n", filename);
+        return;
+    }
+
+    std::string packed;
+    if (!json::msgpack::encode(packed, doc))
+    {
+        fprintf(stderr, "encode error: %s\n", filename);
+        return;
+    }
+
+    char const* const json_first = input.data();
+    char const* const json_last = input.data() + input.size();
+    char const* const packed_first = packed.data();
+    char const* const packed_last = packed.data() + packed.size();
+
+    double const parse_ms = Milliseconds([&] {
+        json::Value value;
+        return json::parse(value, json_first, json_last).ec == json::ParseStatus::success;
+    });
+    double const decode_ms = Milliseconds([&] {
+        json::Value value;
+        return json::msgpack::decode(value, packed_first, packed_last).ec == json::ParseStatus::success;
+    });
+    double const parse_sax_ms = Milliseconds([&] {
+        NullCallbacks cb;
+        return json::ParseSAX(cb, json_first, json_last, json::Mode::strict).ec == json::ParseStatus::success;
+    });
+    double const decode_sax_ms = Milliseconds([&] {
+        NullCallbacks cb;
+        return json::msgpack::DecodeSAX(cb, packed_first, packed_last, json::Mode::strict).ec == json::ParseStatus::success;
+    });
+
+    fprintf(stderr, "%s (%.1f kB json, %.1f kB msgpack)\n", filename,
+        static_cast<double>(input.size()) / 1024.0,
+        static_cast<double>(packed.size()) / 1024.0);
+    fprintf(stderr, "  Value: parse %9.3f ms --- decode %9.3f ms --- speedup x %.2f\n", parse_ms, decode_ms, parse_ms / decode_ms);
+    fprintf(stderr, "  SAX:   parse %9.3f ms --- decode %9.3f ms --- speedup x %.2f\n", parse_sax_ms, decode_sax_ms, parse_sax_ms / decode_sax_ms);
+}
+
+int main(int argc, const char** argv)
+{
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        files.push_back(argv[i]);
+    }
+
+    if (files.empty())
+        files.assign(std::begin(benchmark_files), std::end(benchmark_files));
+
+    for (auto const* filename : files)
+    {
+        fprintf(stderr, "---\n");
+        benchmark(filename);
+    }
+}
@@ -0,0 +1,136 @@
+// Scaling benchmark for the parallel stringify.
+//
+// Usage: bench_stringify [--repeat N] [--threads T] [files...]
+//
+// Each file is parsed and copied N times into a JSON array, which is then
+// stringified using 1, 2, 4, ..., T threads.
+
+#include "../../src/json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* benchmark_files[] = {
+    "test_data/examples/canada.json",
+    "test_data/examples/citm_catalog.json",
+    "test_data/examples/twitter.json",
+};
+
+static bool ReadFile(std::string& str, char const* filename)
+{
+    FILE* file = fopen(filename, "rb");
+    if (file == nullptr)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long const length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    str.resize(static_cast<size_t>(length));
+    size_t const num_read = fread(&str[0], 1, str.size(), file);
+    fclose(file);
+
+    return num_read == str.size();
+}
+
+static double StringifyMilliseconds(json::Value const& value, json::StringifyOptions const& options, std::string const& expected)
+{
+    constexpr int kRuns = 5;
+
+    double min_ms = 1e300;
+    for (int i = 0; i < kRuns; ++i)
+    {
+        std::string str;
+
+        auto const start = Clock::now();
+        bool const ok = json::stringify(str, value, options);
+        auto const end = Clock::now();
+
+        if (!ok || (!expected.empty() && str != expected))
+        {
+            fprintf(stderr, "stringify error\n");
+            abort();
+        }
+
+        min_ms = std::min(min_ms, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    return min_ms;
+}
+
+static void benchmark(char const* filename, int repeat, int max_threads)
+{
+    std::string input;
+    if (!ReadFile(input, filename))
+    {
+        fprintf(stderr, "file not found: %s\n", filename);
+        return;
+    }
+
+    json::Value doc;
+    if (json::parse(doc, input) != json::ParseStatus::success)
+    {
+        fprintf(stderr, "parse error: %s\n", filename);
+        return;
+    }
+
+    json::Value value = json::Array{};
+    for (int i = 0; i < repeat; ++i)
+    {
+        value.push_back(doc);
+    }
+
+    json::StringifyOptions options;
+
+    std::string expected;
+    json::stringify(expected, value, options);
+
+    fprintf(stderr, "%s x %d (%.1f MB)\n", filename, repeat, static_cast<double>(expected.size()) / (1024.0 * 1024.0));
+
+    double serial_ms = 0;
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        options.num_threads = num_threads;
+
+        double const ms = StringifyMilliseconds(value, options, expected);
+        if (num_threads == 1)
+            serial_ms = ms;
+
+        double const mbps = static_cast<double>(expected.size()) / (1024.0 * 1024.0) / (ms / 1000.0);
+        fprintf(stderr, "  threads %3d: %9.2f ms --- %8.1f MB/sec --- speedup x %.2f\n", num_threads, ms, mbps, serial_ms / ms);
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    int repeat = 16;
+    int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+            repeat = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            max_threads = std::atoi(argv[++i]);
+        else
+            files.push_back(argv[i]);
+    }
+
+    if (files.empty())
+        files.assign(std::begin(benchmark_files), std::end(benchmark_files));
+
+    for (auto const* filename : files)
+    {
+        fprintf(stderr, "---\n");
+        benchmark(filename, repeat, max_threads);
+    }
+}
@@ -42,5 +42,7 @@ inline void traverse(jsonstats& stats, const json::Value& v)
             traverse(stats, e.second);
         }
         break;
+    case json::Type::raw:
+        break;
     }
 }
@@ -74,6 +74,11 @@ workspace "Json"
             -- "-fsanitize=memory",
         }
 
+    configuration { "gmake*", "linux" }
+        links {
+            "pthread", -- std::thread (parallel stringify)
+        }
+
     configuration { "vs*" }
         buildoptions {
             "/utf-8",
@@ -139,6 +144,7 @@ project "test"
     files {
         "test/catch.hpp",
         "test/catch_main.cc",
+        "test/test*.h",
         "test/test*.cc",
     }
     links {
@@ -176,3 +182,41 @@ project "benchmark"
             "-Wconversion",
             "-pedantic",
         }
+
+project "bench_stringify"
+    language "C++"
+    kind "ConsoleApp"
+    files {
+        "benchmark/stringify/*.cc",
+    }
+    links {
+        "json",
+    }
+    configuration { "gmake*" }
+        buildoptions {
+            "-Wsign-compare",
+            "-Wsign-conversion",
+            "-Wold-style-cast",
+            "-Wshadow",
+            "-Wconversion",
+            "-pedantic",
+        }
+
+project "bench_msgpack"
+    language "C++"
+    kind "ConsoleApp"
+    files {
+        "benchmark/msgpack/*.cc",
+    }
+    links {
+        "json",
+    }
+    configuration { "gmake*" }
+        buildoptions {
+            "-Wsign-compare",
+            "-Wsign-conversion",
+            "-Wold-style-cast",
+            "-Wshadow",
+            "-Wconversion",
+            "-pedantic",
+        }
@@ -86,6 +86,14 @@ constexpr int kDoubleMaxDecimalPower = 309;
 // as non-zero (equal to the min non-zero double).
 constexpr int kDoubleMinDecimalPower = -324;
 
+// Max float: 3.4028234663852886 * 10^38, which has 39 digits.
+// Any x >= 10^39 is interpreted as +infinity.
+constexpr int kSingleMaxDecimalPower = 39;
+
+// Min non-zero float: 1.4012984643248171 * 10^-45
+// Any x <= 10^-46 is interpreted as 0.
+constexpr int kSingleMinDecimalPower = -46;
+
 inline constexpr int Min(int x, int y) { return y < x ? y : x; }
 inline constexpr int Max(int x, int y) { return y < x ? x : y; }
 
@@ -1161,5 +1169,92 @@ CC_NEVER_INLINE double DigitsToDouble(char const* digits, int num_digits, int ex
     return v.NextValue();
 }
 
+//--------------------------------------------------------------------------------------------------
+// DigitsToFloat
+//--------------------------------------------------------------------------------------------------
+
+// Convert the decimal representation 'digits * 10^exponent' into an IEEE
+// single-precision number.
+//
+// PRE: digits must contain only ASCII characters in the range '0'...'9'.
+// PRE: num_digits >= 0
+// PRE: num_digits + exponent must not overflow.
+CC_NEVER_INLINE float DigitsToFloat(char const* digits, int num_digits, int exponent, bool nonzero_tail = false)
+{
+    CC_ASSERT(num_digits >= 0);
+    CC_ASSERT(exponent <= INT_MAX - num_digits);
+
+    TrimDigits(digits, num_digits, exponent, nonzero_tail);
+
+    if (num_digits == 0)
+    {
+        return 0;
+    }
+
+    // Any v >= 10^39 is interpreted as +Infinity.
+    if (num_digits + exponent > kSingleMaxDecimalPower)
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    // Any v <= 10^-46 is interpreted as 0.
+    if (num_digits + exponent <= kSingleMinDecimalPower)
+    {
+        return 0.0f;
+    }
+
+    // First compute the correctly rounded double-precision value v.
+    // In the given range, v is always a normalized double.
+    Double const v(DigitsToDouble(digits, num_digits, exponent, nonzero_tail));
+    CC_ASSERT(!v.IsSubnormalOrZero() && v.IsFinite());
+
+    // Then round v to single-precision.
+    // Write v = f * 2^e and let q * 2^e_single be the single-precision number
+    // which is obtained by truncating v.
+    uint64_t const f = v.NormalizedSignificand();
+    int const e = v.NormalizedExponent();
+
+    int const e_single = Max(e + (Double::SignificandSize - Single::SignificandSize), Single::MinExponent);
+    int const shift = e_single - e;
+    CC_ASSERT(shift >= Double::SignificandSize - Single::SignificandSize);
+    CC_ASSERT(shift <= 63);
+
+    uint64_t const q    = f >> shift;
+    uint64_t const rem  = f & ((uint64_t{1} << shift) - 1);
+    uint64_t const half = uint64_t{1} << (shift - 1);
+
+    // Rounding v to single-precision is the same as rounding the input to
+    // single-precision, unless v is exactly halfway between two adjacent floats.
+    // The input might lie slightly above or below v in this case, and we need
+    // to compare the input with v.
+    //
+    //     lo            v             hi
+    //  ---+-------------+-------------+---
+    //              B
+
+    bool round_up;
+    if (rem != half)
+    {
+        round_up = rem > half;
+    }
+    else
+    {
+        int const cmp = CompareBufferWithDiyFp(digits, num_digits, exponent, nonzero_tail, DiyFpFromFloat(v));
+        round_up = cmp > 0 || (cmp == 0 && (q & 1) != 0);
+    }
+
+    // Assemble the result.
+    // If q has a hidden bit (i.e. is normalized), the hidden bit will be
+    // added to the biased exponent. This also correctly handles the case where
+    // rounding up produces a carry into the exponent.
+    uint64_t const bits = (static_cast<uint64_t>(e_single - Single::MinExponent) << Single::PhysicalSignificandSize) + q + (round_up ? 1 : 0);
+    if (bits >= Single::ExponentMask)
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    return Single(static_cast<uint32_t>(bits)).Value();
+}
+
 } // namespace bellerophon
 } // namespace charconv
@@ -33,6 +33,10 @@ static_assert(std::numeric_limits<double>::is_iec559
         && std::numeric_limits<double>::digits == 53 && std::numeric_limits<double>::max_exponent == 1024,
     "IEEE-754 double-precision implementation required");
 
+static_assert(std::numeric_limits<float>::is_iec559
+        && std::numeric_limits<float>::digits == 24 && std::numeric_limits<float>::max_exponent == 128,
+    "IEEE-754 single-precision implementation required");
+
 namespace charconv {
 
 //==================================================================================================
@@ -146,4 +150,75 @@ struct Double
 inline bool operator==(Double x, Double y) { return x.bits == y.bits; }
 inline bool operator!=(Double x, Double y) { return x.bits != y.bits; }
 
+//==================================================================================================
+// IEEE single-precision inspection
+//==================================================================================================
+
+struct Single
+{
+    using value_type = float;
+    using bits_type = uint32_t;
+
+    static constexpr int       SignificandSize         = std::numeric_limits<value_type>::digits; // = p   (includes the hidden bit)
+    static constexpr int       PhysicalSignificandSize = SignificandSize - 1;                     // = p-1 (excludes the hidden bit)
+    static constexpr int       UnbiasedMinExponent     = 1;
+    static constexpr int       UnbiasedMaxExponent     = 2 * std::numeric_limits<value_type>::max_exponent - 1 - 1;
+    static constexpr int       ExponentBias            = 2 * std::numeric_limits<value_type>::max_exponent / 2 - 1 + (SignificandSize - 1);
+    static constexpr int       MinExponent             = UnbiasedMinExponent - ExponentBias;
+    static constexpr int       MaxExponent             = UnbiasedMaxExponent - ExponentBias;
+    static constexpr bits_type HiddenBit               = bits_type{1} << (SignificandSize - 1);   // = 2^(p-1)
+    static constexpr bits_type SignificandMask         = HiddenBit - 1;                           // = 2^(p-1) - 1
+    static constexpr bits_type ExponentMask            = bits_type{2 * std::numeric_limits<value_type>::max_exponent - 1} << PhysicalSignificandSize;
+    static constexpr bits_type SignMask                = ~(~bits_type{0} >> 1);
+
+    bits_type /*const*/ bits;
+
+    explicit Single(bits_type bits_) : bits(bits_) {}
+    explicit Single(value_type value) : bits(ReinterpretBits<bits_type>(value)) {}
+
+    bits_type PhysicalSignificand() const {
+        return bits & SignificandMask;
+    }
+
+    bits_type PhysicalExponent() const {
+        return (bits & ExponentMask) >> PhysicalSignificandSize;
+    }
+
+    // Returns whether x is zero, subnormal or normal (not infinite or NaN).
+    bool IsFinite() const {
+        return (bits & ExponentMask) != ExponentMask;
+    }
+
+    // Returns whether x is infinite.
+    bool IsInf() const {
+        return (bits & ExponentMask) == ExponentMask && (bits & SignificandMask) == 0;
+    }
+
+    // Returns whether x is a NaN.
+    bool IsNaN() const {
+        return (bits & ExponentMask) == ExponentMask && (bits & SignificandMask) != 0;
+    }
+
+    // Returns whether x is +0 or -0.
+    bool IsZero() const {
+        return (bits & ~SignMask) == 0;
+    }
+
+    // Returns whether x has negative sign. Applies to zeros and NaNs as well.
+    bool SignBit() const {
+        return (bits & SignMask) != 0;
+    }
+
+    value_type Value() const {
+        return ReinterpretBits<value_type>(bits);
+    }
+
+    value_type AbsValue() const {
+        return ReinterpretBits<value_type>(bits & ~SignMask);
+    }
+};
+
+inline bool operator==(Single x, Single y) { return x.bits == y.bits; }
+inline bool operator!=(Single x, Single y) { return x.bits != y.bits; }
+
 } // namespace charconv
@@ -739,4 +739,108 @@ inline Uint64x2 ComputePow5(int i)
         : ComputePow5ForNegativeExponent(-i);
 }
 
+inline uint64_t ComputeSinglePow5ForNegativeExponent(int i)
+{
+    // Stores 5^-i in the form:
+    //   k = ceil(log_2 5^i) - 1 + 64
+    //   pow[i] = ceil(2^k / 5^i)
+    static constexpr uint64_t kPow5Inv[29 + 1] = {
+        0x8000000000000000,
+        0xCCCCCCCCCCCCCCCD,
+        0xA3D70A3D70A3D70B,
+        0x83126E978D4FDF3C,
+        0xD1B71758E219652C,
+        0xA7C5AC471B478424,
+        0x8637BD05AF6C69B6,
+        0xD6BF94D5E57A42BD,
+        0xABCC77118461CEFD,
+        0x89705F4136B4A598,
+        0xDBE6FECEBDEDD5BF,
+        0xAFEBFF0BCB24AAFF,
+        0x8CBCCC096F5088CC,
+        0xE12E13424BB40E14,
+        0xB424DC35095CD810,
+        0x901D7CF73AB0ACDA,
+        0xE69594BEC44DE15C,
+        0xB877AA3236A4B44A,
+        0x9392EE8E921D5D08,
+        0xEC1E4A7DB69561A6,
+        0xBCE5086492111AEB,
+        0x971DA05074DA7BEF,
+        0xF1C90080BAF72CB2,
+        0xC16D9A0095928A28,
+        0x9ABE14CD44753B53,
+        0xF79687AED3EEC552,
+        0xC612062576589DDB,
+        0x9E74D1B791E07E49,
+        0xFD87B5F28300CA0E,
+        0xCAD2F7F5359A3B3F,
+    };
+
+    CC_ASSERT(i >= 0);
+    CC_ASSERT(static_cast<size_t>(i) < ArraySize(kPow5Inv));
+    return kPow5Inv[i];
+}
+
+inline uint64_t ComputeSinglePow5ForPositiveExponent(int i)
+{
+    // Stores 5^i in the form:
+    //   k = floor(log_2 5^i) + 1 - 64
+    //   pow[i] = floor(5^i / 2^k)
+    static constexpr uint64_t kPow5[47 + 1] = {
+        0x8000000000000000,
+        0xA000000000000000,
+        0xC800000000000000,
+        0xFA00000000000000,
+        0x9C40000000000000,
+        0xC350000000000000,
+        0xF424000000000000,
+        0x9896800000000000,
+        0xBEBC200000000000,
+        0xEE6B280000000000,
+        0x9502F90000000000,
+        0xBA43B74000000000,
+        0xE8D4A51000000000,
+        0x9184E72A00000000,
+        0xB5E620F480000000,
+        0xE35FA931A0000000,
+        0x8E1BC9BF04000000,
+        0xB1A2BC2EC5000000,
+        0xDE0B6B3A76400000,
+        0x8AC7230489E80000,
+        0xAD78EBC5AC620000,
+        0xD8D726B7177A8000,
+        0x878678326EAC9000,
+        0xA968163F0A57B400,
+        0xD3C21BCECCEDA100,
+        0x84595161401484A0,
+        0xA56FA5B99019A5C8,
+        0xCECB8F27F4200F3A,
+        0x813F3978F8940984,
+        0xA18F07D736B90BE5,
+        0xC9F2C9CD04674EDE,
+        0xFC6F7C4045812296,
+        0x9DC5ADA82B70B59D,
+        0xC5371912364CE305,
+        0xF684DF56C3E01BC6,
+        0x9A130B963A6C115C,
+        0xC097CE7BC90715B3,
+        0xF0BDC21ABB48DB20,
+        0x96769950B50D88F4,
+        0xBC143FA4E250EB31,
+        0xEB194F8E1AE525FD,
+        0x92EFD1B8D0CF37BE,
+        0xB7ABC627050305AD,
+        0xE596B7B0C643C719,
+        0x8F7E32CE7BEA5C6F,
+        0xB35DBF821AE4F38B,
+        0xE0352F62A19E306E,
+        0x8C213D9DA502DE45,
+    };
+
+    CC_ASSERT(i >= 0);
+    CC_ASSERT(static_cast<size_t>(i) < ArraySize(kPow5));
+    return kPow5[i];
+}
+
 } // namespace charconv
@@ -521,5 +521,265 @@ CC_NEVER_INLINE DoubleToDecimalResult DoubleToDecimal(double value)
     return {output, e10};
 }
 
+//==================================================================================================
+// IEEE single-precision implementation
+//==================================================================================================
+
+inline uint64_t MulShiftSingle(uint64_t m, uint64_t mul, int j)
+{
+    CC_ASSERT((m >> 26) == 0); // m is maximum 26 bits
+    CC_ASSERT(j >= 57);
+    CC_ASSERT(j <= 63);
+
+    uint32_t const mulLo = static_cast<uint32_t>(mul);
+    uint32_t const mulHi = static_cast<uint32_t>(mul >> 32);
+
+    uint64_t const b0 = m * mulLo; // 26 + 32 = 58 bits
+    uint64_t const b2 = m * mulHi; // 26 + 32 = 58 bits
+
+    return ((b0 >> 32) + b2) >> (j - 32);
+}
+
+inline void MulShiftAllSingle(uint64_t mv, uint64_t mp, uint64_t mm, uint64_t mul, int j, uint64_t* vr, uint64_t* vp, uint64_t* vm)
+{
+    *vr = MulShiftSingle(mv, mul, j);
+    *vp = MulShiftSingle(mp, mul, j);
+    *vm = MulShiftSingle(mm, mul, j);
+}
+
+struct FloatToDecimalResult {
+    uint32_t digits;
+    int exponent;
+};
+
+CC_NEVER_INLINE FloatToDecimalResult FloatToDecimal(float value)
+{
+    CC_ASSERT(Single(value).IsFinite());
+    CC_ASSERT(value > 0);
+
+    //
+    // Step 1:
+    // Decode the floating point number, and unify normalized and subnormal cases.
+    //
+
+    Single const ieeeValue(value);
+
+    // Decode bits into mantissa, and exponent.
+    uint32_t const ieeeMantissa = ieeeValue.PhysicalSignificand();
+    uint32_t const ieeeExponent = ieeeValue.PhysicalExponent();
+
+    uint32_t m2;
+    int e2;
+    if (ieeeExponent == 0) {
+        m2 = ieeeMantissa;
+        e2 = 1;
+    } else {
+        m2 = Single::HiddenBit | ieeeMantissa;
+        e2 = static_cast<int>(ieeeExponent);
+    }
+
+    bool const even = (m2 & 1) == 0;
+    bool const acceptBounds = even;
+
+    //
+    // Step 2:
+    // Determine the interval of legal decimal representations.
+    //
+
+    // We subtract 2 so that the bounds computation has 2 additional bits.
+    e2 -= Single::ExponentBias + 2;
+
+    uint64_t const mv = 4 * uint64_t{m2};
+    uint64_t const mp = mv + 2;
+    uint32_t const mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1) ? 1 : 0;
+    uint64_t const mm = mv - 1 - mmShift;
+
+    //
+    // Step 3:
+    // Convert to a decimal power base using 64-bit arithmetic.
+    //
+
+    int e10;
+
+    uint64_t vm;
+    uint64_t vr;
+    uint64_t vp;
+
+    bool vmIsTrailingZeros = false;
+    bool vrIsTrailingZeros = false;
+
+    if (e2 >= 0)
+    {
+        // q = max(0, log_10(2^e2) - 1)
+        int const q = FloorLog10Pow2(e2) - (e2 > 3); // exponent <= 0
+        CC_ASSERT(q >= 0);
+        int const k = CeilLog2Pow5(q) - 1 + 64;
+        int const j = -e2 + q + k; // shift
+
+        e10 = q;
+
+        // mul = ceil(2^k / 5^q)
+        MulShiftAllSingle(mv, mp, mm, ComputeSinglePow5ForNegativeExponent(q), j, &vr, &vp, &vm);
+
+        // 11 = floor(log_5(2^(24+2)))
+        if (q <= 11)
+        {
+            // Only one of mp, mv, and mm can be a multiple of 5, if any.
+            if (mv % 5 == 0)
+            {
+                vrIsTrailingZeros = MultipleOfPow5(mv, q);
+            }
+            else if (acceptBounds)
+            {
+                vmIsTrailingZeros = MultipleOfPow5(mm, q);
+            }
+            else
+            {
+                vp -= MultipleOfPow5(mp, q);
+            }
+        }
+    }
+    else
+    {
+        // q = max(0, log_10(5^-e2) - 1)
+        int const q = FloorLog10Pow5(-e2) - (-e2 > 1);
+        CC_ASSERT(q >= 0);
+        int const i = -e2 - q; // -exponent > 0
+        CC_ASSERT(i > 0);
+        int const k = FloorLog2Pow5(i) + 1 - 64;
+        int const j = q - k; // shift
+
+        e10 = -i;
+
+        // mul = floor(5^i / 2^k)
+        MulShiftAllSingle(mv, mp, mm, ComputeSinglePow5ForPositiveExponent(i), j, &vr, &vp, &vm);
+
+        if (q <= 1)
+        {
+            // {vr,vp,vm} is trailing zeros if {mv,mp,mm} has at least q trailing 0 bits.
+            // mv = 4 * m2, so it always has at least two trailing 0 bits.
+            vrIsTrailingZeros = true;
+
+            if (acceptBounds)
+            {
+                // mm = mv - 1 - mmShift, so it has 1 trailing 0 bit iff mmShift == 1.
+                vmIsTrailingZeros = (mmShift == 1);
+            }
+            else
+            {
+                // mp = mv + 2, so it always has at least one trailing 0 bit.
+                --vp;
+            }
+        }
+        else if (q <= Single::SignificandSize + 2)
+        {
+            vrIsTrailingZeros = MultipleOfPow2(mv, q - 1);
+        }
+    }
+
+    //
+    // Step 4:
+    // Find the shortest decimal representation in the interval of legal representations.
+    //
+
+    uint64_t output;
+
+    if (vmIsTrailingZeros || vrIsTrailingZeros)
+    {
+        // General case, which happens rarely (~4%).
+
+        uint32_t lastRemovedDigit = 0;
+
+        bool vrPrevIsTrailingZeros = vrIsTrailingZeros;
+
+        for (;;)
+        {
+            uint64_t const vmDiv10 = Div10(vm);
+            uint64_t const vpDiv10 = Div10(vp);
+            if (vmDiv10 >= vpDiv10)
+                break;
+
+            uint32_t const vmMod10 = Mod10(vm, vmDiv10);
+            vmIsTrailingZeros &= (vmMod10 == 0);
+            vrPrevIsTrailingZeros &= (lastRemovedDigit == 0);
+
+            uint64_t const vrDiv10 = Div10(vr);
+            uint32_t const vrMod10 = Mod10(vr, vrDiv10);
+            lastRemovedDigit = vrMod10;
+
+            vm = vmDiv10;
+            vr = vrDiv10;
+            vp = vpDiv10;
+            ++e10;
+        }
+
+        if (vmIsTrailingZeros)
+        {
+            for (;;)
+            {
+                uint64_t const vmDiv10 = Div10(vm);
+                uint32_t const vmMod10 = Mod10(vm, vmDiv10);
+                if (vmMod10 != 0)
+                    break;
+
+                vrPrevIsTrailingZeros &= (lastRemovedDigit == 0);
+
+                uint64_t const vrDiv10 = Div10(vr);
+                uint32_t const vrMod10 = Mod10(vr, vrDiv10);
+                lastRemovedDigit = vrMod10;
+
+                vm = vmDiv10;
+                vr = vrDiv10;
+                ++e10;
+            }
+        }
+
+        bool roundUp = lastRemovedDigit >= 5;
+        if (lastRemovedDigit == 5 && vrPrevIsTrailingZeros)
+        {
+            // Halfway case: The number ends in ...500...00.
+            roundUp = (static_cast<uint32_t>(vr) % 2 != 0);
+        }
+
+        // We need to take vr+1 if vr is outside bounds...
+        // or we need to round up.
+        bool const inc = (vr == vm && !(acceptBounds && vmIsTrailingZeros)) || roundUp;
+
+        output = vr + (inc ? 1 : 0);
+    }
+    else
+    {
+        // Specialized for the common case (~96%).
+
+        bool roundUp = false;
+
+        for (;;)
+        {
+            uint64_t const vmDiv10 = Div10(vm);
+            uint64_t const vpDiv10 = Div10(vp);
+            if (vmDiv10 >= vpDiv10)
+                break;
+
+            uint64_t const vrDiv10 = Div10(vr);
+            uint32_t const vrMod10 = Mod10(vr, vrDiv10);
+            roundUp = (vrMod10 >= 5);
+
+            vm = vmDiv10;
+            vr = vrDiv10;
+            vp = vpDiv10;
+            ++e10;
+        }
+
+        // We need to take vr+1 if vr is outside bounds...
+        // or we need to round up.
+        bool const inc = vr == vm || roundUp;
+
+        output = vr + (inc ? 1 : 0);
+    }
+
+    CC_ASSERT(output <= 999999999);
+    return {static_cast<uint32_t>(output), e10};
+}
+
 } // namespace ryu
 } // namespace charconv
@@ -19,16 +19,47 @@
 // SOFTWARE.
 
 #include "json.h"
+#include "json_cbor.h"
+#include "json_intern.h"
+#include "json_msgpack.h"
 #include "json_parser.h"
+#include "json_record.h"
+#include "json_schema.h"
+#include "json_snapshot.h"
 #include "json_number_conversions.h"
 #include "json_numbers.h"
 #include "json_strings.h"
 
 #include <climits>
 #include <cmath>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+
+#if _WIN32
+#include <io.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace json;
 
@@ -38,8 +69,182 @@ using namespace json;
 
 Value const Value::kUndefined = {};
 
+// The source text of an array or object which has not been parsed yet.
+struct json::impl::LazyValue
+{
+    std::shared_ptr<String const> buffer; // owns the source text
+    char const* first;
+    char const* last;
+    Mode mode;
+
+    static Value Create(std::shared_ptr<String const> const& buffer, char const* first, char const* last, Mode mode)
+    {
+        JSON_ASSERT(first != last);
+        JSON_ASSERT(*first == '[' || *first == '{');
+
+        Value v;
+        v.data_.lazy = new LazyValue{buffer, first, last, mode};
+        v.type_ = *first == '{' ? Type::object : Type::array;
+        v.lazy_ = true;
+        return v;
+    }
+};
+
+// The header of a reference-counted, immutable String, Array or Object.
+// The payload is stored directly after the header, and shared values point to
+// the payload as usual, so that read-only access does not need to know about
+// the header.
+struct json::impl::SharedNode
+{
+    std::atomic<size_t> refs;
+    std::atomic<size_t> hash; // Value::hash() of the payload, or 0 if not yet computed
+
+    template <typename T>
+    static T* Create(T&& payload)
+    {
+        static_assert(sizeof(SharedNode) % alignof(T) == 0, "payload would be misaligned");
+
+        void* const memory = ::operator new(sizeof(SharedNode) + sizeof(T));
+        auto const node = ::new (memory) SharedNode{{1}, {0}};
+        try
+        {
+            return ::new (static_cast<void*>(node + 1)) T(std::move(payload));
+        }
+        catch (...)
+        {
+            node->~SharedNode();
+            ::operator delete(memory);
+            throw;
+        }
+    }
+
+    static SharedNode* From(Value const& v) noexcept
+    {
+        JSON_ASSERT(v.shared_);
+        return static_cast<SharedNode*>(static_cast<void*>(v.data_.string)) - 1;
+    }
+
+    // Moves the payload of V into a new shared node.
+    // If this throws, V is unchanged.
+    // PRE: V is a string, array or object, which is neither lazy nor shared.
+    static void Share(Value& v)
+    {
+        JSON_ASSERT(!v.lazy_);
+        JSON_ASSERT(!v.shared_);
+
+        switch (v.type_)
+        {
+        case Type::string:
+        case Type::raw:
+            {
+                String* const p = v.data_.string;
+                v.data_.string = Create(std::move(*p));
+                delete p;
+            }
+            break;
+        case Type::array:
+            {
+                Array* const p = v.data_.array;
+                v.data_.array = Create(std::move(*p));
+                delete p;
+            }
+            break;
+        case Type::object:
+            {
+                Object* const p = v.data_.object;
+                v.data_.object = Create(std::move(*p));
+                delete p;
+            }
+            break;
+        default:
+            JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+            return;
+        }
+
+        v.shared_ = true;
+    }
+
+    static void Retain(Value const& v) noexcept
+    {
+        From(v)->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void Release(Value& v) noexcept
+    {
+        auto const node = From(v);
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        switch (v.type_)
+        {
+        case Type::string:
+        case Type::raw:
+            v.data_.string->~String();
+            break;
+        case Type::array:
+            v.data_.array->~Array();
+            break;
+        case Type::object:
+            v.data_.object->~Object();
+            break;
+        default:
+            JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+            break;
+        }
+
+        node->~SharedNode();
+        ::operator delete(node);
+    }
+
+    // Replaces the shared payload of V with a private copy.
+    // The payload is moved instead of copied if V holds the only reference.
+    static void Unshare(Value& v)
+    {
+        bool const unique = From(v)->refs.load(std::memory_order_acquire) == 1;
+
+        Value::Data data;
+        switch (v.type_)
+        {
+        case Type::string:
+        case Type::raw:
+            data.string = unique ? new String(std::move(*v.data_.string)) : new String(*v.data_.string);
+            break;
+        case Type::array:
+            data.array = unique ? new Array(std::move(*v.data_.array)) : new Array(*v.data_.array);
+            break;
+        case Type::object:
+            data.object = unique ? new Object(std::move(*v.data_.object)) : new Object(*v.data_.object);
+            break;
+        default:
+            JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+            return;
+        }
+
+        Release(v);
+        v.data_ = data;
+        v.shared_ = false;
+    }
+};
+
 Value::Value(Value const& rhs)
 {
+    if (rhs.shared_)
+    {
+        impl::SharedNode::Retain(rhs);
+        data_ = rhs.data_;
+        type_ = rhs.type_;
+        shared_ = true;
+        return;
+    }
+
+    if (rhs.lazy_)
+    {
+        data_.lazy = new impl::LazyValue(*rhs.data_.lazy);
+        type_ = rhs.type_;
+        lazy_ = true;
+        return;
+    }
+
     switch (rhs.type_)
     {
     case Type::undefined:
@@ -61,6 +266,10 @@ Value::Value(Value const& rhs)
         data_.object = new Object(*rhs.data_.object);
         type_ = Type::object;
         break;
+    case Type::raw:
+        data_.string = new String(*rhs.data_.string);
+        type_ = Type::raw;
+        break;
     }
 }
 
@@ -86,6 +295,9 @@ Value::Value(Type t)
     case Type::object:
         data_.object = new Object{};
         break;
+    case Type::raw:
+        data_.string = new String("null");
+        break;
     default:
         JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
         t = Type::undefined;
@@ -174,8 +386,24 @@ Object& Value::assign(Tag_object, Object&& v)
     return _assign_object(std::move(v));
 }
 
+String const& Value::assign(Tag_raw, String const& v)
+{
+    return _assign_raw(v);
+}
+
+String const& Value::assign(Tag_raw, String&& v)
+{
+    return _assign_raw(std::move(v));
+}
+
 Value& Value::operator=(Value const& rhs)
 {
+    if (this != &rhs && (rhs.lazy_ || rhs.shared_))
+    {
+        // Don't expand rhs, resp. share the node of rhs.
+        return *this = Value(rhs);
+    }
+
     if (this != &rhs)
     {
         switch (rhs.type())
@@ -201,6 +429,9 @@ Value& Value::operator=(Value const& rhs)
         case Type::object:
             assign(object_tag, rhs.get_object());
             break;
+        case Type::raw:
+            assign(raw_tag, rhs.get_raw());
+            break;
         }
     }
 
@@ -209,6 +440,22 @@ Value& Value::operator=(Value const& rhs)
 
 void Value::_clear_allocated()
 {
+    if (shared_)
+    {
+        impl::SharedNode::Release(*this);
+        shared_ = false;
+        type_ = Type::undefined;
+        return;
+    }
+
+    if (lazy_)
+    {
+        delete data_.lazy;
+        lazy_ = false;
+        type_ = Type::undefined;
+        return;
+    }
+
     switch (type_)
     {
     case Type::undefined:
@@ -226,6 +473,9 @@ void Value::_clear_allocated()
     case Type::object:
         delete data_.object;
         break;
+    case Type::raw:
+        delete data_.string;
+        break;
     }
 
     type_ = Type::undefined;
@@ -234,6 +484,12 @@ void Value::_clear_allocated()
 template <typename T>
 String& Value::_assign_string(T&& value)
 {
+    if (lazy_)
+        _clear_allocated();
+
+    // VALUE might refer to the shared node. Keep the node alive until VALUE has been copied.
+    Value const shared_node = shared_ ? std::move(*this) : Value{};
+
     switch (type_)
     {
     case Type::undefined:
@@ -244,7 +500,9 @@ String& Value::_assign_string(T&& value)
         type_ = Type::string;
         break;
     case Type::string:
+    case Type::raw:
         *data_.string = std::forward<T>(value);
+        type_ = Type::string;
         break;
     case Type::array:
         {
@@ -272,6 +530,12 @@ String& Value::_assign_string(T&& value)
 template <typename T>
 Array& Value::_assign_array(T&& value)
 {
+    if (lazy_)
+        _clear_allocated();
+
+    // VALUE might refer to the shared node. Keep the node alive until VALUE has been copied.
+    Value const shared_node = shared_ ? std::move(*this) : Value{};
+
     switch (type_)
     {
     case Type::undefined:
@@ -282,6 +546,7 @@ Array& Value::_assign_array(T&& value)
         type_ = Type::array;
         break;
     case Type::string:
+    case Type::raw:
         {
             auto p = new Array(std::forward<T>(value));
             // noexcept ->
@@ -310,6 +575,12 @@ Array& Value::_assign_array(T&& value)
 template <typename T>
 Object& Value::_assign_object(T&& value)
 {
+    if (lazy_)
+        _clear_allocated();
+
+    // VALUE might refer to the shared node. Keep the node alive until VALUE has been copied.
+    Value const shared_node = shared_ ? std::move(*this) : Value{};
+
     switch (type_)
     {
     case Type::undefined:
@@ -320,6 +591,7 @@ Object& Value::_assign_object(T&& value)
         type_ = Type::object;
         break;
     case Type::string:
+    case Type::raw:
         {
             auto p = new Object(std::forward<T>(value));
             // noexcept ->
@@ -345,7 +617,16 @@ Object& Value::_assign_object(T&& value)
     return get_object();
 }
 
-bool Value::equal_to(Value const& rhs) const noexcept
+template <typename T>
+String& Value::_assign_raw(T&& value)
+{
+    // Reuse the string representation.
+    String& str = _assign_string(std::forward<T>(value));
+    type_ = Type::raw;
+    return str;
+}
+
+bool Value::equal_to(Value const& rhs) const
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (is_undefined() || rhs.is_undefined())
@@ -358,6 +639,9 @@ bool Value::equal_to(Value const& rhs) const noexcept
     if (type() != rhs.type())
         return false;
 
+    if (shared_ && rhs.shared_ && data_.string == rhs.data_.string)
+        return true;
+
     switch (type())
     {
     case Type::undefined:
@@ -374,13 +658,15 @@ bool Value::equal_to(Value const& rhs) const noexcept
         return get_array() == rhs.get_array();
     case Type::object:
         return get_object() == rhs.get_object();
+    case Type::raw:
+        return get_raw() == rhs.get_raw();
     default:
         JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
         return {};
     }
 }
 
-bool Value::less_than(Value const& rhs) const noexcept
+bool Value::less_than(Value const& rhs) const
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (is_undefined() || rhs.is_undefined())
@@ -411,6 +697,8 @@ bool Value::less_than(Value const& rhs) const noexcept
         return get_array() < rhs.get_array();
     case Type::object:
         return get_object() < rhs.get_object();
+    case Type::raw:
+        return get_raw() < rhs.get_raw();
     default:
         JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
         return {};
@@ -429,9 +717,9 @@ static size_t HashCombine(size_t h1, size_t h2) noexcept
     return h1;
 }
 
-size_t Value::hash() const noexcept
+static size_t ComputeHash(Value const& v)
 {
-    switch (type())
+    switch (v.type())
     {
     case Type::undefined:
         JSON_ASSERT(false && "cannot compute hash value for 'undefined'");
@@ -439,44 +727,203 @@ size_t Value::hash() const noexcept
     case Type::null:
         return 0;
     case Type::boolean:
-        return std::hash<bool>()(get_boolean());
+        return std::hash<bool>()(v.get_boolean());
     case Type::number:
-        return std::hash<double>()(get_number());
+        return std::hash<double>()(v.get_number());
     case Type::string:
-        return std::hash<String>()(get_string());
+        return std::hash<String>()(v.get_string());
     case Type::array:
         {
             size_t h = std::hash<char>()('['); // initial value for empty arrays
-            for (auto const& v : get_array())
+            for (auto const& elem : v.get_array())
             {
-                h = HashCombine(h, v.hash());
+                h = HashCombine(h, elem.hash());
             }
             return h;
         }
     case Type::object:
         {
             size_t h = std::hash<char>()('{'); // initial value for empty objects
-            for (auto const& v : get_object())
+            for (auto const& kv : v.get_object())
             {
-                auto const h1 = std::hash<String>()(v.first);
-                auto const h2 = v.second.hash();
+                auto const h1 = std::hash<String>()(kv.first);
+                auto const h2 = kv.second.hash();
                 h ^= HashCombine(h1, h2); // Permutation resistant to support unordered maps.
             }
             return h;
         }
+    case Type::raw:
+        return HashCombine(std::hash<char>()('`'), std::hash<String>()(v.get_raw()));
     default:
         JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
         return {};
     }
 }
 
+size_t Value::hash() const
+{
+    if (!shared_)
+        return ComputeHash(*this);
+
+    // Shared nodes are immutable, so the hash value can be cached.
+    // NB: The children of shared arrays and objects are usually shared, too,
+    // so that computing the hash value of a new node is O(size).
+    auto const node = impl::SharedNode::From(*this);
+
+    size_t h = node->hash.load(std::memory_order_relaxed);
+    if (h == 0)
+    {
+        h = ComputeHash(*this);
+        node->hash.store(h, std::memory_order_relaxed);
+    }
+    return h;
+}
+
 void Value::swap(Value& rhs) noexcept
 {
     std::swap(data_, rhs.data_);
     std::swap(type_, rhs.type_);
+    std::swap(lazy_, rhs.lazy_);
+    std::swap(shared_, rhs.shared_);
+}
+
+void Value::_unshare()
+{
+    impl::SharedNode::Unshare(*this);
+}
+
+void Value::share()
+{
+    if (shared_)
+        return;
+
+    if (lazy_)
+        _expand();
+
+    switch (type_)
+    {
+    case Type::string:
+    case Type::raw:
+        break;
+    case Type::array:
+        for (auto& v : *data_.array)
+            v.share();
+        break;
+    case Type::object:
+        for (auto& kv : *data_.object)
+            kv.second.share();
+        break;
+    default:
+        return;
+    }
+
+    impl::SharedNode::Share(*this);
+}
+
+// Returns a deep copy of the given value whose nodes are allocated in
+// depth-first order.
+// If keep_nodes is true, shared nodes are retained and lazy values are copied
+// as-is.
+static Value CloneCompact(Value const& v, bool keep_nodes)
+{
+    if (keep_nodes && (v.is_shared() || v.is_lazy()))
+        return v;
+
+    switch (v.type())
+    {
+    case Type::string:
+        return Value(string_tag, v.get_string());
+    case Type::array:
+        {
+            auto const& arr = v.get_array();
+
+            // Allocate the elements before the children, so that the children
+            // follow their parent in memory.
+            Value result(Type::array);
+            auto& copy = result.get_array();
+            copy.reserve(arr.size());
+            for (auto const& elem : arr)
+                copy.push_back(CloneCompact(elem, keep_nodes));
+            return result;
+        }
+    case Type::object:
+        {
+            auto const& obj = v.get_object();
+
+            // NB: The copy constructor of std::map copies the tree structure,
+            // which allocates the nodes in pre-order. Inserting the members in
+            // sorted order allocates each node right before its value.
+            Value result(Type::object);
+            auto& copy = result.get_object();
+            for (auto const& kv : obj)
+                copy.emplace_hint(copy.end(), kv.first, CloneCompact(kv.second, keep_nodes));
+            return result;
+        }
+    case Type::raw:
+        return Value(raw_tag, v.get_raw());
+    default:
+        return v;
+    }
+}
+
+Value Value::clone_compact() const
+{
+    return CloneCompact(*this, /*keep_nodes*/ false);
+}
+
+// Returns the (estimated) number of bytes allocated for the strings, arrays
+// and objects in the given value. Shared nodes and lazy values are not
+// included.
+static size_t HeapSize(Value const& v) noexcept
+{
+    if (v.is_shared() || v.is_lazy())
+        return 0;
+
+    // Size of a std::map node without the value (color, parent, left, right).
+    static constexpr size_t kMapNodeOverhead = 4 * sizeof(void*);
+
+    auto const string_size = [](String const& str) {
+        return str.capacity() > String().capacity() ? str.capacity() + 1 : 0;
+    };
+
+    switch (v.type())
+    {
+    case Type::string:
+        return sizeof(String) + string_size(v.get_string());
+    case Type::array:
+        {
+            auto const& arr = v.get_array();
+            size_t n = sizeof(Array) + arr.capacity() * sizeof(Value);
+            for (auto const& elem : arr)
+                n += HeapSize(elem);
+            return n;
+        }
+    case Type::object:
+        {
+            auto const& obj = v.get_object();
+            size_t n = sizeof(Object) + obj.size() * (kMapNodeOverhead + sizeof(Object::value_type));
+            for (auto const& kv : obj)
+                n += string_size(kv.first) + HeapSize(kv.second);
+            return n;
+        }
+    case Type::raw:
+        return sizeof(String) + string_size(v.get_raw());
+    default:
+        return 0;
+    }
+}
+
+size_t json::compact(Value& value)
+{
+    size_t const size_before = HeapSize(value);
+    value = CloneCompact(value, /*keep_nodes*/ true);
+    size_t const size_after = HeapSize(value);
+
+    JSON_ASSERT(size_after <= size_before);
+    return size_before - size_after;
 }
 
-size_t Value::size() const noexcept
+size_t Value::size() const
 {
     switch (type())
     {
@@ -484,7 +931,8 @@ size_t Value::size() const noexcept
     case Type::null:
     case Type::boolean:
     case Type::number:
-        JSON_ASSERT(false && "cannot read property 'size' of undefined, null, boolean or number"); // LCOV_EXCL_LINE
+    case Type::raw:
+        JSON_ASSERT(false && "cannot read property 'size' of undefined, null, boolean, number or raw"); // LCOV_EXCL_LINE
         return 0;
     case Type::string:
         return get_string().size();
@@ -498,7 +946,7 @@ size_t Value::size() const noexcept
     }
 }
 
-bool Value::empty() const noexcept
+bool Value::empty() const
 {
     switch (type())
     {
@@ -506,7 +954,8 @@ bool Value::empty() const noexcept
     case Type::null:
     case Type::boolean:
     case Type::number:
-        JSON_ASSERT(false && "cannot read property 'empty' of undefined, null, boolean or number"); // LCOV_EXCL_LINE
+    case Type::raw:
+        JSON_ASSERT(false && "cannot read property 'empty' of undefined, null, boolean, number or raw"); // LCOV_EXCL_LINE
         return true; // i.e. size() == 0
     case Type::string:
         return get_string().empty();
@@ -540,7 +989,7 @@ Value& Value::operator[](size_t index)
     return arr[index];
 }
 
-Value const& Value::operator[](size_t index) const noexcept
+Value const& Value::operator[](size_t index) const
 {
 #if JSON_VALUE_ALLOW_UNDEFINED_ACCESS
     JSON_ASSERT(is_undefined() || is_array());
@@ -622,6 +1071,46 @@ Value& Value::operator[](Object::key_type&& key)
     return _get_or_assign_object()[std::move(key)];
 }
 
+Value& Value::operator[](Key const& key)
+{
+    auto& obj = _get_or_assign_object();
+
+    auto const it = obj.lower_bound(key);
+    if (it != obj.end() && it->first == key) {
+        return it->second;
+    }
+    return obj.emplace_hint(it, key.str(), Value{})->second;
+}
+
+Value const& Value::operator[](Key const& key) const
+{
+#if JSON_VALUE_ALLOW_UNDEFINED_ACCESS
+    JSON_ASSERT(is_undefined() || is_object());
+    if (!is_object())
+        return kUndefined;
+#endif
+
+    auto& obj = get_object();
+    auto const it = obj.find(key);
+    if (it != obj.end()) {
+        return it->second;
+    }
+    return kUndefined;
+}
+
+size_t Value::erase(Key const& key)
+{
+    auto& obj = get_object();
+
+    // map::erase does not support transparent keys (before C++23).
+    auto const it = obj.find(key);
+    if (it == obj.end()) {
+        return 0;
+    }
+    obj.erase(it);
+    return 1;
+}
+
 Value::item_iterator Value::erase(const_item_iterator pos)
 {
     auto& obj = get_object();
@@ -653,7 +1142,8 @@ bool Value::to_boolean() const noexcept
         return !get_string().empty();
     case Type::array:
     case Type::object:
-        JSON_ASSERT(false && "to_boolean must not be called for arrays or objects"); // LCOV_EXCL_LINE
+    case Type::raw:
+        JSON_ASSERT(false && "to_boolean must not be called for arrays, objects or raw values"); // LCOV_EXCL_LINE
         return {};
     default:
         JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
@@ -682,7 +1172,8 @@ double Value::to_number() const noexcept
         }
     case Type::array:
     case Type::object:
-        JSON_ASSERT(false && "to_number must not be called for arrays or objects"); // LCOV_EXCL_LINE
+    case Type::raw:
+        JSON_ASSERT(false && "to_number must not be called for arrays, objects or raw values"); // LCOV_EXCL_LINE
         return {};
     default:
         JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
@@ -758,7 +1249,8 @@ String Value::to_string() const
         return get_string();
     case Type::array:
     case Type::object:
-        JSON_ASSERT(false && "to_string must not be called for arrays or objects"); // LCOV_EXCL_LINE
+    case Type::raw:
+        JSON_ASSERT(false && "to_string must not be called for arrays, objects or raw values"); // LCOV_EXCL_LINE
         return {};
     default:
         JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
@@ -770,6 +1262,50 @@ String Value::to_string() const
 // parse
 //==================================================================================================
 
+// Unescape the string [first, last) into str.
+// The unescaped string is written into a pre-sized buffer.
+static bool UnescapeString(String& str, char const* first, char const* last, Mode mode)
+{
+    bool const allow_invalid_unicode = (mode != Mode::strict);
+
+    // The unescaped string is never longer than the input, unless invalid
+    // UTF-8 sequences are replaced by U+FFFD, which may be longer than the
+    // sequence it replaces. The buffer grows in this (rare) case.
+    size_t const len = static_cast<size_t>(last - first);
+    str.resize(len);
+
+    char* out = &str[0];
+    char* out_last = out + len;
+
+    auto const reserve = [&](size_t n) {
+        if (static_cast<size_t>(out_last - out) >= n)
+            return;
+
+        JSON_ASSERT(allow_invalid_unicode);
+        size_t const pos = static_cast<size_t>(out - &str[0]);
+        str.resize(std::max(2 * str.size(), pos + n));
+        out = &str[0] + pos;
+        out_last = &str[0] + str.size();
+    };
+
+    auto const res = strings::UnescapeString(first, last, allow_invalid_unicode,
+        [&](char ch) {
+            reserve(1);
+            *out++ = ch;
+        },
+        [&](char const* p, intptr_t n) {
+            reserve(static_cast<size_t>(n));
+            std::memcpy(out, p, static_cast<size_t>(n));
+            out += n;
+        });
+
+    if (res.ec != strings::Status::success)
+        return false;
+
+    str.resize(static_cast<size_t>(out - &str[0]));
+    return true;
+}
+
 struct ParseValueCallbacks
 {
     static constexpr int kMaxElements = 120;
@@ -809,16 +1345,21 @@ struct ParseValueCallbacks
         return {};
     }
 
+    ParseStatus HandleDouble(double value)
+    {
+        if (mode == Mode::strict && !std::isfinite(value))
+            return ParseStatus::invalid_number;
+
+        stack.emplace_back(value);
+        return {};
+    }
+
     ParseStatus HandleString(char const* first, char const* last, StringClass string_class)
     {
         if (string_class != StringClass::clean)
         {
             String str;
-
-            str.reserve(static_cast<size_t>(last - first));
-
-            auto const res = strings::UnescapeString(first, last, /*allow_invalid_unicode*/ mode != Mode::strict, [&](char ch) { str.push_back(ch); });
-            if (res.ec != strings::Status::success)
+            if (!UnescapeString(str, first, last, mode))
                 return ParseStatus::invalid_string;
 
             stack.emplace_back(std::move(str));
@@ -874,11 +1415,7 @@ struct ParseValueCallbacks
         if (string_class != StringClass::clean)
         {
             String str;
-
-            str.reserve(static_cast<size_t>(last - first));
-
-            auto const res = strings::UnescapeString(first, last, /*allow_invalid_unicode*/ mode != Mode::strict, [&](char ch) { str.push_back(ch); });
-            if (res.ec != strings::Status::success)
+            if (!UnescapeString(str, first, last, mode))
                 return ParseStatus::invalid_string;
 
             keys.emplace_back(std::move(str));
@@ -962,225 +1499,4262 @@ private:
     }
 };
 
-ParseResult json::parse(Value& value, char const* next, char const* last, Mode mode)
+// Builds a Value from CBOR or MessagePack.
+// Strings which contain characters that must be escaped in JSON are received as
+// is, instead of being escaped by the decoder and unescaped here.
+struct DecodeValueCallbacks : ParseValueCallbacks
 {
-    ParseValueCallbacks cb;
-
-    cb.mode = mode;
-
-    auto const res = json::ParseSAX(cb, next, last, mode);
-    if (res.ec == ParseStatus::success)
+    ParseStatus HandleUnescapedString(char const* first, char const* last)
     {
-        JSON_ASSERT(cb.stack.size() == 1);
-
-//      value.swap(cb.stack.back());
-        value = std::move(cb.stack.back());
+        stack.emplace_back(json::string_tag, first, last);
+        return {};
     }
 
-    return res;
-}
+    ParseStatus HandleUnescapedKey(char const* first, char const* last)
+    {
+        keys.emplace_back(first, last);
+        return {};
+    }
+};
 
-ParseStatus json::parse(Value& value, std::string const& str, Mode mode)
+// Stores the values of selected object members as raw values.
+// The contents of these values are only validated.
+struct ParseRawValueCallbacks : ParseValueCallbacks
 {
-    char const* next = str.data();
-    char const* last = str.data() + str.size();
+    std::function<bool(String const&)> const* capture_raw = nullptr;
+    bool capturing = false;       // whether the current value is captured
+    bool at_member_value = false; // whether the next value is the value of an object member
+    String scratch;               // for validating strings
 
-    return json::parse(value, next, last, mode).ec;
-}
+    ParseStatus HandleNull()
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleNull();
+    }
 
+    ParseStatus HandleTrue()
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleTrue();
+    }
+
+    ParseStatus HandleFalse()
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleFalse();
+    }
+
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc)
+    {
+        if (capturing)
+        {
+            if (nc == NumberClass::invalid)
+                return ParseStatus::invalid_number;
+            if (mode == Mode::strict && !IsFinite(nc))
+                return ParseStatus::invalid_number;
+            return {};
+        }
+        return ParseValueCallbacks::HandleNumber(first, last, nc);
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, StringClass string_class)
+    {
+        if (capturing)
+            return ValidateString(first, last, string_class);
+        return ParseValueCallbacks::HandleString(first, last, string_class);
+    }
+
+    ParseStatus HandleBeginArray()
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleBeginArray();
+    }
+
+    ParseStatus HandleEndArray(size_t count)
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleEndArray(count);
+    }
+
+    ParseStatus HandleEndElement(size_t& count)
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleEndElement(count);
+    }
+
+    ParseStatus HandleBeginObject()
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleBeginObject();
+    }
+
+    ParseStatus HandleEndObject(size_t count)
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleEndObject(count);
+    }
+
+    ParseStatus HandleKey(char const* first, char const* last, StringClass string_class)
+    {
+        if (capturing)
+            return ValidateString(first, last, string_class);
+
+        at_member_value = true;
+        return ParseValueCallbacks::HandleKey(first, last, string_class);
+    }
+
+    ParseStatus HandleEndMember(size_t& count)
+    {
+        if (capturing)
+            return {};
+        return ParseValueCallbacks::HandleEndMember(count);
+    }
+
+    bool CaptureRaw()
+    {
+        JSON_ASSERT(!capturing);
+
+        if (!at_member_value)
+            return false;
+
+        at_member_value = false;
+
+        JSON_ASSERT(!keys.empty());
+        capturing = capture_raw != nullptr && (*capture_raw)(keys.back());
+        return capturing;
+    }
+
+    ParseStatus HandleRaw(char const* first, char const* last)
+    {
+        JSON_ASSERT(capturing);
+
+        capturing = false;
+        stack.emplace_back(json::raw_tag, first, last);
+        return {};
+    }
+
+private:
+    ParseStatus ValidateString(char const* first, char const* last, StringClass string_class)
+    {
+        if (string_class != StringClass::clean && !UnescapeString(scratch, first, last, mode))
+            return ParseStatus::invalid_string;
+        return {};
+    }
+};
+
+// Checks whether the input is valid JSON, without building a Value.
+struct ParseValidateCallbacks
+{
+    Mode mode;
+    String scratch; // for validating strings
+
+    ParseStatus HandleNull() { return {}; }
+    ParseStatus HandleTrue() { return {}; }
+    ParseStatus HandleFalse() { return {}; }
+
+    ParseStatus HandleNumber(char const* /*first*/, char const* /*last*/, NumberClass nc)
+    {
+        if (nc == NumberClass::invalid)
+            return ParseStatus::invalid_number;
+        if (mode == Mode::strict && !IsFinite(nc))
+            return ParseStatus::invalid_number;
+        return {};
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, StringClass string_class)
+    {
+        if (string_class != StringClass::clean && !UnescapeString(scratch, first, last, mode))
+            return ParseStatus::invalid_string;
+        return {};
+    }
+
+    ParseStatus HandleBeginArray() { return {}; }
+    ParseStatus HandleEndArray(size_t /*count*/) { return {}; }
+    ParseStatus HandleEndElement(size_t& /*count*/) { return {}; }
+    ParseStatus HandleBeginObject() { return {}; }
+    ParseStatus HandleEndObject(size_t /*count*/) { return {}; }
+
+    ParseStatus HandleKey(char const* first, char const* last, StringClass string_class)
+    {
+        return HandleString(first, last, string_class);
+    }
+
+    ParseStatus HandleEndMember(size_t& /*count*/) { return {}; }
+};
+
+// Stores nested arrays and objects as lazy values.
+// The source text of each lazy value is validated, so that expanding a lazy
+// value never fails.
+struct ParseLazyValueCallbacks : ParseRawValueCallbacks
+{
+    std::shared_ptr<String const> buffer;
+    bool validate = true; // false if the input is known to be valid
+
+    ParseStatus HandleLazy(char const* first, char const* last)
+    {
+        JSON_ASSERT(!capturing);
+
+        if (validate)
+        {
+            ParseValidateCallbacks validator;
+            validator.mode = mode;
+            auto const res = json::ParseSAX(validator, first, last, mode);
+            if (res.ec != ParseStatus::success)
+                return res.ec;
+        }
+
+        at_member_value = false;
+        stack.push_back(impl::LazyValue::Create(buffer, first, last, mode));
+        return {};
+    }
+};
+
+// Validates the input against a schema while building the Value.
+struct ParseValidatedValueCallbacks : ParseValueCallbacks
+{
+    SchemaValidator* validator = nullptr;
+
+    ParseStatus HandleNull()
+    {
+        if (Failed ec = validator->HandleNull())
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleNull();
+    }
+
+    ParseStatus HandleTrue()
+    {
+        if (Failed ec = validator->HandleTrue())
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleTrue();
+    }
+
+    ParseStatus HandleFalse()
+    {
+        if (Failed ec = validator->HandleFalse())
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleFalse();
+    }
+
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc)
+    {
+        if (Failed ec = validator->HandleNumber(first, last, nc))
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleNumber(first, last, nc);
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, StringClass string_class)
+    {
+        if (Failed ec = validator->HandleString(first, last, string_class))
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleString(first, last, string_class);
+    }
+
+    ParseStatus HandleBeginArray()
+    {
+        if (Failed ec = validator->HandleBeginArray())
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleBeginArray();
+    }
+
+    ParseStatus HandleEndArray(size_t count)
+    {
+        if (Failed ec = validator->HandleEndArray(count))
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleEndArray(count);
+    }
+
+    ParseStatus HandleBeginObject()
+    {
+        if (Failed ec = validator->HandleBeginObject())
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleBeginObject();
+    }
+
+    ParseStatus HandleEndObject(size_t count)
+    {
+        if (Failed ec = validator->HandleEndObject(count))
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleEndObject(count);
+    }
+
+    ParseStatus HandleKey(char const* first, char const* last, StringClass string_class)
+    {
+        if (Failed ec = validator->HandleKey(first, last, string_class))
+            return ParseStatus(ec);
+        return ParseValueCallbacks::HandleKey(first, last, string_class);
+    }
+};
+
+// Stores structurally identical arrays and objects in a single shared node.
+struct ParseSharedValueCallbacks : ParseValueCallbacks
+{
+    // The shared nodes created so far, by hash value.
+    std::unordered_multimap<size_t, Value> nodes;
+
+    ParseStatus HandleEndArray(size_t count)
+    {
+        ParseValueCallbacks::HandleEndArray(count);
+        Share(stack.back());
+        return {};
+    }
+
+    ParseStatus HandleEndObject(size_t count)
+    {
+        ParseValueCallbacks::HandleEndObject(count);
+        Share(stack.back());
+        return {};
+    }
+
+private:
+    // Replaces V with an existing node with the same contents, or moves V
+    // into a new shared node.
+    //
+    // Nodes are matched bit-exactly, not with Value::equal_to(): merging
+    // [0.0] and [-0.0] would change the parsed data.
+    // The elements resp. members of V have already been shared, so that
+    // nested arrays and objects are identical iff they are the same node,
+    // and computing the hash value and comparing V with existing nodes is
+    // O(size).
+    void Share(Value& v)
+    {
+        size_t const h = IdentityHash(v);
+
+        auto const range = nodes.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (Identical(it->second, v))
+            {
+                v = it->second;
+                return;
+            }
+        }
+
+        impl::SharedNode::Share(v);
+        nodes.emplace(h, v);
+    }
+
+    static uint64_t NumberBits(double num) noexcept
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &num, sizeof(double));
+        return bits;
+    }
+
+    // Returns the hash value of a scalar, or the address of a (shared) array
+    // or object.
+    static size_t ElementHash(Value const& v) noexcept
+    {
+        switch (v.type())
+        {
+        case Type::number:
+            return std::hash<uint64_t>()(NumberBits(v.get_number()));
+        case Type::array:
+            JSON_ASSERT(v.is_shared());
+            return std::hash<void const*>()(&v.get_array());
+        case Type::object:
+            JSON_ASSERT(v.is_shared());
+            return std::hash<void const*>()(&v.get_object());
+        default:
+            return v.hash();
+        }
+    }
+
+    static bool ElementsIdentical(Value const& lhs, Value const& rhs) noexcept
+    {
+        if (lhs.type() != rhs.type())
+            return false;
+
+        switch (lhs.type())
+        {
+        case Type::number:
+            return NumberBits(lhs.get_number()) == NumberBits(rhs.get_number());
+        case Type::array:
+            return &lhs.get_array() == &rhs.get_array();
+        case Type::object:
+            return &lhs.get_object() == &rhs.get_object();
+        default:
+            return lhs.equal_to(rhs);
+        }
+    }
+
+    static size_t IdentityHash(Value const& v) noexcept
+    {
+        if (v.is_array())
+        {
+            size_t h = std::hash<char>()('[');
+            for (auto const& elem : v.get_array())
+            {
+                h = HashCombine(h, ElementHash(elem));
+            }
+            return h;
+        }
+        else
+        {
+            size_t h = std::hash<char>()('{');
+            for (auto const& kv : v.get_object())
+            {
+                h = HashCombine(h, std::hash<String>()(kv.first));
+                h = HashCombine(h, ElementHash(kv.second));
+            }
+            return h;
+        }
+    }
+
+    static bool Identical(Value const& lhs, Value const& rhs) noexcept
+    {
+        if (lhs.type() != rhs.type())
+            return false;
+
+        if (lhs.is_array())
+        {
+            auto const& arr1 = lhs.get_array();
+            auto const& arr2 = rhs.get_array();
+            return arr1.size() == arr2.size()
+                && std::equal(arr1.begin(), arr1.end(), arr2.begin(), ElementsIdentical);
+        }
+        else
+        {
+            auto const& obj1 = lhs.get_object();
+            auto const& obj2 = rhs.get_object();
+            return obj1.size() == obj2.size()
+                && std::equal(obj1.begin(), obj1.end(), obj2.begin(), [](auto const& kv1, auto const& kv2) {
+                    return kv1.first == kv2.first && ElementsIdentical(kv1.second, kv2.second);
+                });
+        }
+    }
+};
+
+template <typename Callbacks>
+static ParseResult ParseValue(Value& value, Callbacks& cb, char const* next, char const* last, Mode mode)
+{
+    cb.mode = mode;
+
+    auto const res = json::ParseSAX(cb, next, last, mode);
+    if (res.ec == ParseStatus::success)
+    {
+        JSON_ASSERT(cb.stack.size() == 1);
+
+//      value.swap(cb.stack.back());
+        value = std::move(cb.stack.back());
+    }
+
+    return res;
+}
+
+void Value::_expand() const
+{
+    JSON_ASSERT(lazy_);
+    JSON_ASSERT(is_array() || is_object());
+
+    // NB: The lazy value is only released after parsing succeeded, so that
+    // this value is unchanged if parsing throws.
+    impl::LazyValue* const lazy = data_.lazy;
+
+    // The source text has been validated by parse().
+    ParseLazyValueCallbacks cb;
+    cb.buffer = lazy->buffer;
+    cb.validate = false;
+
+    Value value;
+    if (ParseValue(value, cb, lazy->first, lazy->last, lazy->mode).ec != ParseStatus::success)
+    {
+        JSON_ASSERT(false && "invalid lazy value"); // LCOV_EXCL_LINE
+        value = Value(type_);
+    }
+
+    JSON_ASSERT(value.type_ == type_);
+    JSON_ASSERT(!value.lazy_);
+
+    data_ = value.data_;
+    lazy_ = false;
+    value.type_ = Type::undefined;
+    delete lazy;
+}
+
+ParseStatus Value::expand()
+{
+    // Shared nodes never contain lazy values.
+    if (shared_)
+        return ParseStatus::success;
+
+    if (lazy_)
+    {
+        // See _expand().
+        impl::LazyValue* const lazy = data_.lazy;
+
+        Value value;
+        auto const ec = json::parse(value, lazy->first, lazy->last, lazy->mode).ec;
+        if (ec != ParseStatus::success)
+            value = Value(type_);
+
+        data_ = value.data_;
+        lazy_ = false;
+        value.type_ = Type::undefined;
+        delete lazy;
+        return ec;
+    }
+
+    ParseStatus ec = ParseStatus::success;
+    switch (type())
+    {
+    case Type::array:
+        for (auto& v : get_array())
+        {
+            auto const ec1 = v.expand();
+            if (ec == ParseStatus::success)
+                ec = ec1;
+        }
+        break;
+    case Type::object:
+        for (auto& kv : get_object())
+        {
+            auto const ec1 = kv.second.expand();
+            if (ec == ParseStatus::success)
+                ec = ec1;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return ec;
+}
+
+ParseResult json::parse(Value& value, char const* next, char const* last, Mode mode)
+{
+    ParseValueCallbacks cb;
+    return ParseValue(value, cb, next, last, mode);
+}
+
+ParseResult json::parse(Value& value, char const* next, char const* last, ParseOptions const& options)
+{
+    if (options.schema != nullptr)
+    {
+        SchemaValidator validator(*options.schema, options.mode);
+
+        ParseValidatedValueCallbacks cb;
+        cb.validator = &validator;
+        return ParseValue(value, cb, next, last, options.mode);
+    }
+
+    if (options.share_duplicates)
+    {
+        ParseSharedValueCallbacks cb;
+        return ParseValue(value, cb, next, last, options.mode);
+    }
+
+    if (options.lazy)
+    {
+        // The lazy values point into a copy of the input.
+        auto const buffer = std::make_shared<String const>(next, last);
+        char const* const buffer_next = buffer->data();
+
+        ParseLazyValueCallbacks cb;
+        cb.buffer = buffer;
+        if (options.capture_raw)
+            cb.capture_raw = &options.capture_raw;
+
+        auto res = ParseValue(value, cb, buffer_next, buffer_next + buffer->size(), options.mode);
+        res.ptr = next + (res.ptr - buffer_next);
+        return res;
+    }
+
+    if (!options.capture_raw)
+        return json::parse(value, next, last, options.mode);
+
+    ParseRawValueCallbacks cb;
+    cb.capture_raw = &options.capture_raw;
+    return ParseValue(value, cb, next, last, options.mode);
+}
+
+ParseStatus json::parse(Value& value, std::string const& str, Mode mode)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse(value, next, last, mode).ec;
+}
+
+ParseStatus json::parse(Value& value, std::string const& str, ParseOptions const& options)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse(value, next, last, options).ec;
+}
+
+//==================================================================================================
+// OutputSink
+//==================================================================================================
+
+OutputSink::~OutputSink()
+{
+}
+
+bool OutputSink::Flush()
+{
+    if (!failed_ && !Sync())
+        failed_ = true;
+
+    return !failed_;
+}
+
+void OutputSink::WriteSlow(char const* str, size_t len)
+{
+    if (!failed_ && !Overflow(str, len))
+        failed_ = true;
+}
+
+StringSink::StringSink(std::string& str)
+    : str_(str)
+{
+    // The buffer is empty. The first write allocates the unused capacity.
+    char* const data = &str_[0];
+    SetBuffer(data, data + str_.size(), data + str_.size());
+}
+
+StringSink::~StringSink()
+{
+    Flush();
+}
+
+bool StringSink::Overflow(char const* str, size_t len)
+{
+    size_t const size = static_cast<size_t>(BufferNext() - &str_[0]);
+
+    // Grow the string geometrically.
+    // Use the capacity which is available anyway.
+    size_t new_size = std::max(str_.capacity(), size + len);
+    new_size = std::max(new_size, 2 * size);
+    new_size = std::max(new_size, size_t{256});
+
+    str_.resize(new_size);
+
+    char* const data = &str_[0];
+    std::memcpy(data + size, str, len);
+    SetBuffer(data, data + size + len, data + new_size);
+
+    return true;
+}
+
+bool StringSink::Sync()
+{
+    size_t const size = static_cast<size_t>(BufferNext() - &str_[0]);
+    str_.resize(size);
+
+    // The next write allocates a new buffer.
+    char* const data = &str_[0];
+    SetBuffer(data, data + size, data + size);
+
+    return true;
+}
+
+ArraySink::ArraySink(char* first, char* last)
+{
+    SetBuffer(first, first, last);
+}
+
+bool ArraySink::Overflow(char const* /*str*/, size_t /*len*/)
+{
+    return false;
+}
+
+bool ArraySink::Sync()
+{
+    return true;
+}
+
+BufferedSink::BufferedSink(char* buffer, size_t buffer_size)
+    : buffer_(buffer)
+    , buffer_size_(buffer_size)
+{
+    JSON_ASSERT(buffer_size > 0);
+    SetBuffer(buffer_, buffer_, buffer_ + buffer_size_);
+}
+
+bool BufferedSink::Overflow(char const* str, size_t len)
+{
+    if (!Sync())
+        return false;
+
+    if (len >= buffer_size_)
+        return Output(str, len);
+
+    std::memcpy(buffer_, str, len);
+    SetBuffer(buffer_, buffer_ + len, buffer_ + buffer_size_);
+
+    return true;
+}
+
+bool BufferedSink::Sync()
+{
+    size_t const len = static_cast<size_t>(BufferNext() - buffer_);
+    SetBuffer(buffer_, buffer_, buffer_ + buffer_size_);
+
+    return len == 0 || Output(buffer_, len);
+}
+
+CallbackSink::CallbackSink(char* buffer, size_t buffer_size, std::function<bool(char const*, size_t)> output)
+    : BufferedSink(buffer, buffer_size)
+    , output_(std::move(output))
+{
+}
+
+CallbackSink::~CallbackSink()
+{
+    Flush();
+}
+
+bool CallbackSink::Output(char const* str, size_t len)
+{
+    return output_(str, len);
+}
+
+FileSink::FileSink(std::FILE* file)
+    : BufferedSink(buffer_, sizeof(buffer_))
+    , file_(file)
+{
+}
+
+FileSink::~FileSink()
+{
+    Flush();
+}
+
+bool FileSink::Output(char const* str, size_t len)
+{
+    return std::fwrite(str, 1, len, file_) == len;
+}
+
+FdSink::FdSink(int fd)
+    : BufferedSink(buffer_, sizeof(buffer_))
+    , fd_(fd)
+{
+}
+
+FdSink::~FdSink()
+{
+    Flush();
+}
+
+bool FdSink::Output(char const* str, size_t len)
+{
+    while (len > 0)
+    {
+#if _WIN32
+        unsigned const chunk = static_cast<unsigned>(std::min(len, size_t{INT_MAX}));
+        int const n = ::_write(fd_, str, chunk);
+#else
+        auto const n = ::write(fd_, str, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        if (n <= 0)
+            return false;
+
+        str += n;
+        len -= static_cast<size_t>(n);
+    }
+
+    return true;
+}
+
+StreamSink::StreamSink(std::ostream& stream)
+    : BufferedSink(buffer_, sizeof(buffer_))
+    , stream_(stream)
+{
+}
+
+StreamSink::~StreamSink()
+{
+    Flush();
+}
+
+bool StreamSink::Output(char const* str, size_t len)
+{
+    stream_.write(str, static_cast<std::streamsize>(len));
+    return !stream_.fail();
+}
+
+//==================================================================================================
+// stringify
+//==================================================================================================
+
+static bool StringifyValue(OutputSink& out, Value const& value, StringifyOptions const& options, int curr_indent);
+
+static void WriteIndent(OutputSink& out, int count)
+{
+    static constexpr char const kSpaces[] = "                                                                ";
+    static constexpr size_t kNumSpaces = sizeof(kSpaces) - 1;
+
+    JSON_ASSERT(count >= 0);
+    auto n = static_cast<size_t>(count);
+    while (n > 0)
+    {
+        size_t const k = std::min(n, kNumSpaces);
+        out.Write(kSpaces, k);
+        n -= k;
+    }
+}
+
+static bool StringifyNull(OutputSink& out, StringifyOptions const& /*options*/)
+{
+    out.Write("null", 4);
+    return true;
+}
+
+static bool StringifyBoolean(OutputSink& out, bool value)
+{
+    if (value)
+        out.Write("true", 4);
+    else
+        out.Write("false", 5);
+    return true;
+}
+
+static bool StringifyNumber(OutputSink& out, double value, StringifyOptions const& options)
+{
+    if (options.single_precision)
+    {
+        // NB: Rounding might produce +-Infinity.
+        float const f = numbers::ToSingle(value);
+
+        if (options.mode == Mode::strict && !std::isfinite(f))
+        {
+            out.Write("null", 4);
+            return true;
+        }
+
+        if (char* const p = out.TryReserve(32))
+        {
+            out.Commit(numbers::FloatToString(p, 32, f, /*force_trailing_dot_zero*/ true));
+        }
+        else
+        {
+            char buf[32];
+            char* end = numbers::FloatToString(buf, 32, f, /*force_trailing_dot_zero*/ true);
+            out.Write(buf, static_cast<size_t>(end - buf));
+        }
+
+        return true;
+    }
+
+    if (options.mode == Mode::strict && !std::isfinite(value))
+    {
+        out.Write("null", 4);
+        return true;
+    }
+
+    if (char* const p = out.TryReserve(32))
+    {
+        out.Commit(numbers::NumberToString(p, 32, value, /*force_trailing_dot_zero*/ true));
+    }
+    else
+    {
+        char buf[32];
+        char* end = numbers::NumberToString(buf, 32, value, /*force_trailing_dot_zero*/ true);
+        out.Write(buf, static_cast<size_t>(end - buf));
+    }
+
+    return true;
+}
+
+static bool StringifyString(OutputSink& out, String const& value, StringifyOptions const& options)
+{
+    bool success = true;
+
+    out.Put('"');
+
+    char const* const next = value.data();
+    char const* const last = value.data() + value.size();
+    if (next != last)
+    {
+        auto const res = strings::EscapeString(next, last, /*allow_invalid_unicode*/ options.mode != Mode::strict,
+            [&](char ch) { out.Put(ch); },
+            [&](char const* p, intptr_t n) { out.Write(p, static_cast<size_t>(n)); });
+        success = res.ec == strings::Status::success;
+    }
+
+    out.Put('"');
+
+    return success;
+}
+
+// Write the separator in front of an array element or object member.
+// elem_indent is the indentation of the elements of the current container.
+static void StringifySeparator(OutputSink& out, bool is_first, StringifyOptions const& options, int elem_indent)
+{
+    if (!is_first)
+    {
+        out.Put(',');
+        if (options.indent_width == 0)
+            out.Put(' ');
+    }
+
+    if (options.indent_width > 0)
+    {
+        out.Put('\n');
+        WriteIndent(out, elem_indent);
+    }
+}
+
+// Write the elements [I, E) of an array, including the separators.
+// is_first denotes whether I is the first element of the array.
+static bool StringifyElements(OutputSink& out, Array::const_iterator I, Array::const_iterator E, bool is_first, StringifyOptions const& options, int elem_indent)
+{
+    for ( ; I != E; ++I, is_first = false)
+    {
+        StringifySeparator(out, is_first, options, elem_indent);
+
+        if (!StringifyValue(out, *I, options, elem_indent))
+            return false;
+    }
+
+    return true;
+}
+
+// Write the members [I, E) of an object, including the separators.
+// is_first denotes whether I is the first member of the object.
+static bool StringifyMembers(OutputSink& out, Object::const_iterator I, Object::const_iterator E, bool is_first, StringifyOptions const& options, int elem_indent)
+{
+    for ( ; I != E; ++I, is_first = false)
+    {
+        StringifySeparator(out, is_first, options, elem_indent);
+
+        if (!StringifyString(out, I->first, options))
+            return false;
+        out.Put(':');
+        if (options.indent_width >= 0)
+            out.Put(' ');
+        if (!StringifyValue(out, I->second, options, elem_indent))
+            return false;
+    }
+
+    return true;
+}
+
+static int ElementIndent(StringifyOptions const& options, int curr_indent)
+{
+    return options.indent_width > 0 ? curr_indent + options.indent_width : curr_indent;
+}
+
+// Write the end of a non-empty array or object.
+static void StringifyClose(OutputSink& out, char close, StringifyOptions const& options, int curr_indent)
+{
+    if (options.indent_width > 0)
+    {
+        out.Put('\n');
+        WriteIndent(out, curr_indent);
+    }
+
+    out.Put(close);
+}
+
+static bool StringifyArray(OutputSink& out, Array const& value, StringifyOptions const& options, int curr_indent)
+{
+    out.Put('[');
+
+    if (value.empty())
+    {
+        out.Put(']');
+        return true;
+    }
+
+    if (!StringifyElements(out, value.begin(), value.end(), /*is_first*/ true, options, ElementIndent(options, curr_indent)))
+        return false;
+
+    StringifyClose(out, ']', options, curr_indent);
+    return true;
+}
+
+static bool StringifyObject(OutputSink& out, Object const& value, StringifyOptions const& options, int curr_indent)
+{
+    out.Put('{');
+
+    if (value.empty())
+    {
+        out.Put('}');
+        return true;
+    }
+
+    if (!StringifyMembers(out, value.begin(), value.end(), /*is_first*/ true, options, ElementIndent(options, curr_indent)))
+        return false;
+
+    StringifyClose(out, '}', options, curr_indent);
+    return true;
+}
+
+namespace {
+
+// Re-indents raw JSON text.
+// Only whitespace (and comments) is changed, strings and numbers are copied verbatim.
+struct ReindentCallbacks
+{
+    OutputSink& out;
+    StringifyOptions const& options;
+    int curr_indent;
+    int depth = 0;
+    bool is_first = false;        // whether the next value is the first value of the current container
+    bool at_member_value = false; // whether the next value is the value of an object member
+
+    ReindentCallbacks(OutputSink& out_, StringifyOptions const& options_, int curr_indent_)
+        : out(out_)
+        , options(options_)
+        , curr_indent(curr_indent_)
+    {
+    }
+
+    void BeginValue()
+    {
+        if (at_member_value)
+        {
+            at_member_value = false;
+        }
+        else if (depth > 0)
+        {
+            StringifySeparator(out, is_first, options, curr_indent);
+            is_first = false;
+        }
+    }
+
+    void WriteQuoted(char const* first, char const* last)
+    {
+        out.Put('"');
+        out.Write(first, static_cast<size_t>(last - first));
+        out.Put('"');
+    }
+
+    void Open(char open)
+    {
+        BeginValue();
+        out.Put(open);
+        curr_indent = ElementIndent(options, curr_indent);
+        is_first = true;
+        ++depth;
+    }
+
+    void Close(char close)
+    {
+        if (options.indent_width > 0)
+            curr_indent -= options.indent_width;
+        --depth;
+
+        if (is_first) // empty
+            out.Put(close);
+        else
+            StringifyClose(out, close, options, curr_indent);
+
+        is_first = false;
+    }
+
+    ParseStatus HandleNull()
+    {
+        BeginValue();
+        out.Write("null", 4);
+        return {};
+    }
+
+    ParseStatus HandleTrue()
+    {
+        BeginValue();
+        out.Write("true", 4);
+        return {};
+    }
+
+    ParseStatus HandleFalse()
+    {
+        BeginValue();
+        out.Write("false", 5);
+        return {};
+    }
+
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass /*nc*/)
+    {
+        BeginValue();
+        out.Write(first, static_cast<size_t>(last - first));
+        return {};
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, StringClass /*string_class*/)
+    {
+        BeginValue();
+        WriteQuoted(first, last);
+        return {};
+    }
+
+    ParseStatus HandleBeginArray()
+    {
+        Open('[');
+        return {};
+    }
+
+    ParseStatus HandleEndArray(size_t /*count*/)
+    {
+        Close(']');
+        return {};
+    }
+
+    ParseStatus HandleEndElement(size_t& /*count*/)
+    {
+        return {};
+    }
+
+    ParseStatus HandleBeginObject()
+    {
+        Open('{');
+        return {};
+    }
+
+    ParseStatus HandleEndObject(size_t /*count*/)
+    {
+        Close('}');
+        return {};
+    }
+
+    ParseStatus HandleKey(char const* first, char const* last, StringClass /*string_class*/)
+    {
+        StringifySeparator(out, is_first, options, curr_indent);
+        is_first = false;
+
+        WriteQuoted(first, last);
+        out.Put(':');
+        if (options.indent_width >= 0)
+            out.Put(' ');
+
+        at_member_value = true;
+        return {};
+    }
+
+    ParseStatus HandleEndMember(size_t& /*count*/)
+    {
+        return {};
+    }
+};
+
+} // namespace
+
+static bool StringifyRaw(OutputSink& out, String const& value, StringifyOptions const& options, int curr_indent)
+{
+    if (options.indent_width < 0)
+    {
+        out.Write(value.data(), value.size());
+        return true;
+    }
+
+    // The raw value might have been captured in lenient mode.
+    ReindentCallbacks cb(out, options, curr_indent);
+    auto const res = json::ParseSAX(cb, value.data(), value.data() + value.size(), Mode::lenient);
+    return res.ec == ParseStatus::success;
+}
+
+static bool StringifyValue(OutputSink& out, Value const& value, StringifyOptions const& options, int curr_indent)
+{
+    switch (value.type())
+    {
+    case Type::undefined:
+        JSON_ASSERT(false && "cannot stringify 'undefined'"); // LCOV_EXCL_LINE
+        return StringifyNull(out, options);
+    case Type::null:
+        return StringifyNull(out, options);
+    case Type::boolean:
+        return StringifyBoolean(out, value.get_boolean());
+    case Type::number:
+        return StringifyNumber(out, value.get_number(), options);
+    case Type::string:
+        return StringifyString(out, value.get_string(), options);
+    case Type::array:
+        return StringifyArray(out, value.get_array(), options, curr_indent);
+    case Type::object:
+        return StringifyObject(out, value.get_object(), options, curr_indent);
+    case Type::raw:
+        return StringifyRaw(out, value.get_raw(), options, curr_indent);
+    default:
+        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+        return {};
+    }
+}
+
+static bool StringifiedSizeValue(size_t& size, Value const& value, StringifyOptions const& options, int curr_indent);
+
+static size_t StringifiedSizeNumber(double value, StringifyOptions const& options)
+{
+    char buf[32];
+    char* end;
+
+    if (options.single_precision)
+    {
+        float const f = numbers::ToSingle(value);
+        if (options.mode == Mode::strict && !std::isfinite(f))
+            return 4; // null
+        end = numbers::FloatToString(buf, 32, f, /*force_trailing_dot_zero*/ true);
+    }
+    else
+    {
+        if (options.mode == Mode::strict && !std::isfinite(value))
+            return 4; // null
+        end = numbers::NumberToString(buf, 32, value, /*force_trailing_dot_zero*/ true);
+    }
+
+    return static_cast<size_t>(end - buf);
+}
+
+static bool StringifiedSizeString(size_t& size, String const& value, StringifyOptions const& options)
+{
+    size += 2; // quotes
+
+    char const* const next = value.data();
+    char const* const last = value.data() + value.size();
+    if (next != last)
+    {
+        auto const res = strings::EscapeString(next, last, /*allow_invalid_unicode*/ options.mode != Mode::strict,
+            [&](char /*ch*/) { size += 1; },
+            [&](char const* /*p*/, intptr_t n) { size += static_cast<size_t>(n); });
+        return res.ec == strings::Status::success;
+    }
+
+    return true;
+}
+
+static bool StringifiedSizeArray(size_t& size, Array const& value, StringifyOptions const& options, int curr_indent)
+{
+    size += 2; // brackets
+
+    if (value.empty())
+        return true;
+
+    size_t const count = value.size();
+    if (options.indent_width > 0)
+    {
+        // Each element is on its own line, followed by ',' except for the last one.
+        // The closing bracket is on its own line.
+        int const indent = curr_indent + options.indent_width;
+        size += count * (1 + static_cast<size_t>(indent)) + (count - 1) + (1 + static_cast<size_t>(curr_indent));
+        for (auto const& v : value)
+        {
+            if (!StringifiedSizeValue(size, v, options, indent))
+                return false;
+        }
+    }
+    else
+    {
+        // ", " or ","
+        size += (count - 1) * (options.indent_width == 0 ? 2u : 1u);
+        for (auto const& v : value)
+        {
+            if (!StringifiedSizeValue(size, v, options, curr_indent))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool StringifiedSizeObject(size_t& size, Object const& value, StringifyOptions const& options, int curr_indent)
+{
+    size += 2; // braces
+
+    if (value.empty())
+        return true;
+
+    size_t const count = value.size();
+    if (options.indent_width > 0)
+    {
+        // As for arrays. Additionally each member contains ": ".
+        int const indent = curr_indent + options.indent_width;
+        size += count * (1 + static_cast<size_t>(indent) + 2) + (count - 1) + (1 + static_cast<size_t>(curr_indent));
+        for (auto const& kv : value)
+        {
+            if (!StringifiedSizeString(size, kv.first, options))
+                return false;
+            if (!StringifiedSizeValue(size, kv.second, options, indent))
+                return false;
+        }
+    }
+    else
+    {
+        // ": " and ", " or ":" and ","
+        size_t const sep = (options.indent_width == 0 ? 2u : 1u);
+        size += count * sep + (count - 1) * sep;
+        for (auto const& kv : value)
+        {
+            if (!StringifiedSizeString(size, kv.first, options))
+                return false;
+            if (!StringifiedSizeValue(size, kv.second, options, curr_indent))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool StringifiedSizeRaw(size_t& size, String const& value, StringifyOptions const& options, int curr_indent)
+{
+    if (options.indent_width < 0)
+    {
+        size += value.size();
+        return true;
+    }
+
+    // Re-indenting is not worth duplicating here.
+    std::string str;
+    StringSink sink(str);
+    if (!StringifyRaw(sink, value, options, curr_indent))
+        return false;
+    sink.Flush();
+
+    size += str.size();
+    return true;
+}
+
+static bool StringifiedSizeValue(size_t& size, Value const& value, StringifyOptions const& options, int curr_indent)
+{
+    switch (value.type())
+    {
+    case Type::undefined:
+        JSON_ASSERT(false && "cannot stringify 'undefined'"); // LCOV_EXCL_LINE
+        size += 4;
+        return true;
+    case Type::null:
+        size += 4;
+        return true;
+    case Type::boolean:
+        size += value.get_boolean() ? 4u : 5u;
+        return true;
+    case Type::number:
+        size += StringifiedSizeNumber(value.get_number(), options);
+        return true;
+    case Type::string:
+        return StringifiedSizeString(size, value.get_string(), options);
+    case Type::array:
+        return StringifiedSizeArray(size, value.get_array(), options, curr_indent);
+    case Type::object:
+        return StringifiedSizeObject(size, value.get_object(), options, curr_indent);
+    case Type::raw:
+        return StringifiedSizeRaw(size, value.get_raw(), options, curr_indent);
+    default:
+        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+        return {};
+    }
+}
+
+size_t json::stringified_size(Value const& value, StringifyOptions const& options)
+{
+    size_t size = 0;
+    if (!StringifiedSizeValue(size, value, options, 0))
+        return 0;
+
+    return size;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Parallel stringify
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+// A range of elements of an array or a range of members of an object, which
+// is stringified by a single thread.
+struct StringifyTask
+{
+    Array::const_iterator elements_first;
+    Array::const_iterator elements_last;
+    Object::const_iterator members_first;
+    Object::const_iterator members_last;
+    bool is_object;
+    bool is_first;
+    int elem_indent;
+};
+
+// The output is the concatenation of all pieces.
+// Each piece consists of some text (brackets, separators, keys), which is
+// written by the planner, followed by the output of a task.
+struct StringifyPiece
+{
+    size_t text_last; // the text is [text_last of the previous piece, text_last)
+    size_t task;      // index into tasks, or SIZE_MAX
+};
+
+class StringifyPlanner
+{
+    StringifyOptions const& options;
+    std::string text;
+    StringSink text_sink;
+
+public:
+    std::vector<StringifyPiece> pieces;
+    std::vector<StringifyTask> tasks;
+
+    // Returns the text written by the planner.
+    // Only valid after Finish().
+    std::string const& Text() const { return text; }
+
+    explicit StringifyPlanner(StringifyOptions const& options_)
+        : options(options_)
+        , text_sink(text)
+    {
+    }
+
+    // Returns the (approximate) number of values in the given value, but
+    // stops counting at limit.
+    static size_t Weight(Value const& value, size_t limit);
+
+    bool PlanValue(Value const& value, int curr_indent);
+
+    void Finish();
+
+private:
+    void AddTask(StringifyTask const& task);
+    bool PlanArray(Array const& value, int curr_indent);
+    bool PlanObject(Object const& value, int curr_indent);
+};
+
+} // namespace
+
+size_t StringifyPlanner::Weight(Value const& value, size_t limit)
+{
+    switch (value.type())
+    {
+    case Type::string:
+        // Long strings take a while to stringify, too.
+        return 1 + value.get_string().size() / 32;
+    case Type::raw:
+        return 1 + value.get_raw().size() / 256;
+    case Type::array:
+        {
+            size_t weight = 1;
+            for (auto const& v : value.get_array())
+            {
+                if (weight >= limit)
+                    break;
+                weight += Weight(v, limit - weight);
+            }
+            return weight;
+        }
+    case Type::object:
+        {
+            size_t weight = 1;
+            for (auto const& kv : value.get_object())
+            {
+                if (weight >= limit)
+                    break;
+                weight += 1 + kv.first.size() / 32 + Weight(kv.second, limit - weight);
+            }
+            return weight;
+        }
+    default:
+        return 1;
+    }
+}
+
+void StringifyPlanner::AddTask(StringifyTask const& task)
+{
+    text_sink.Flush();
+    pieces.push_back({text.size(), tasks.size()});
+    tasks.push_back(task);
+}
+
+void StringifyPlanner::Finish()
+{
+    text_sink.Flush();
+    pieces.push_back({text.size(), SIZE_MAX});
+}
+
+bool StringifyPlanner::PlanValue(Value const& value, int curr_indent)
+{
+    switch (value.type())
+    {
+    case Type::array:
+        return PlanArray(value.get_array(), curr_indent);
+    case Type::object:
+        return PlanObject(value.get_object(), curr_indent);
+    default:
+        return StringifyValue(text_sink, value, options, curr_indent);
+    }
+}
+
+bool StringifyPlanner::PlanArray(Array const& value, int curr_indent)
+{
+    size_t const chunk_size = options.parallel_chunk_size;
+    int const elem_indent = ElementIndent(options, curr_indent);
+
+    text_sink.Put('[');
+
+    if (value.empty())
+    {
+        text_sink.Put(']');
+        return true;
+    }
+
+    // Collect consecutive small elements into tasks.
+    // Descend into large arrays and objects.
+    auto range_first = value.begin();
+    size_t range_weight = 0;
+
+    auto const E = value.end();
+    for (auto I = value.begin(); I != E; ++I)
+    {
+        size_t const weight = Weight(*I, chunk_size);
+        if (weight >= chunk_size && (I->is_array() || I->is_object()))
+        {
+            if (range_first != I)
+                AddTask({range_first, I, {}, {}, /*is_object*/ false, range_first == value.begin(), elem_indent});
+
+            StringifySeparator(text_sink, I == value.begin(), options, elem_indent);
+            if (!PlanValue(*I, elem_indent))
+                return false;
+
+            range_first = std::next(I);
+            range_weight = 0;
+        }
+        else
+        {
+            range_weight += weight;
+            if (range_weight >= chunk_size)
+            {
+                AddTask({range_first, std::next(I), {}, {}, /*is_object*/ false, range_first == value.begin(), elem_indent});
+
+                range_first = std::next(I);
+                range_weight = 0;
+            }
+        }
+    }
+
+    if (range_first != E)
+        AddTask({range_first, E, {}, {}, /*is_object*/ false, range_first == value.begin(), elem_indent});
+
+    StringifyClose(text_sink, ']', options, curr_indent);
+    return true;
+}
+
+bool StringifyPlanner::PlanObject(Object const& value, int curr_indent)
+{
+    size_t const chunk_size = options.parallel_chunk_size;
+    int const elem_indent = ElementIndent(options, curr_indent);
+
+    text_sink.Put('{');
+
+    if (value.empty())
+    {
+        text_sink.Put('}');
+        return true;
+    }
+
+    auto range_first = value.begin();
+    size_t range_weight = 0;
+
+    auto const E = value.end();
+    for (auto I = value.begin(); I != E; ++I)
+    {
+        size_t const weight = Weight(I->second, chunk_size);
+        if (weight >= chunk_size && (I->second.is_array() || I->second.is_object()))
+        {
+            if (range_first != I)
+                AddTask({{}, {}, range_first, I, /*is_object*/ true, range_first == value.begin(), elem_indent});
+
+            StringifySeparator(text_sink, I == value.begin(), options, elem_indent);
+            if (!StringifyString(text_sink, I->first, options))
+                return false;
+            text_sink.Put(':');
+            if (options.indent_width >= 0)
+                text_sink.Put(' ');
+            if (!PlanValue(I->second, elem_indent))
+                return false;
+
+            range_first = std::next(I);
+            range_weight = 0;
+        }
+        else
+        {
+            range_weight += weight;
+            if (range_weight >= chunk_size)
+            {
+                AddTask({{}, {}, range_first, std::next(I), /*is_object*/ true, range_first == value.begin(), elem_indent});
+
+                range_first = std::next(I);
+                range_weight = 0;
+            }
+        }
+    }
+
+    if (range_first != E)
+        AddTask({{}, {}, range_first, E, /*is_object*/ true, range_first == value.begin(), elem_indent});
+
+    StringifyClose(text_sink, '}', options, curr_indent);
+    return true;
+}
+
+static bool StringifyParallel(OutputSink& out, Value const& value, StringifyOptions const& options)
+{
+    StringifyPlanner planner(options);
+    if (!planner.PlanValue(value, 0))
+        return false;
+    planner.Finish();
+
+    auto const& tasks = planner.tasks;
+    auto const& pieces = planner.pieces;
+
+    std::vector<std::string> results(tasks.size());
+    std::atomic<size_t> next_task{0};
+    std::atomic<bool> success{true};
+
+    auto run = [&]() {
+        for (;;)
+        {
+            size_t const i = next_task.fetch_add(1, std::memory_order_relaxed);
+            if (i >= tasks.size())
+                break;
+
+            auto const& task = tasks[i];
+
+            StringSink task_out(results[i]);
+            bool const ok = task.is_object
+                ? StringifyMembers(task_out, task.members_first, task.members_last, task.is_first, options, task.elem_indent)
+                : StringifyElements(task_out, task.elements_first, task.elements_last, task.is_first, options, task.elem_indent);
+            if (!ok)
+                success.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    size_t const num_threads = std::min(static_cast<size_t>(options.num_threads), tasks.size());
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads > 0 ? num_threads - 1 : 0);
+    for (size_t i = 1; i < num_threads; ++i)
+    {
+        threads.emplace_back(run);
+    }
+    run();
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (!success.load())
+        return false;
+
+    char const* const text = planner.Text().data();
+
+    size_t text_first = 0;
+    for (auto const& piece : pieces)
+    {
+        out.Write(text + text_first, piece.text_last - text_first);
+        text_first = piece.text_last;
+
+        if (piece.task != SIZE_MAX)
+        {
+            auto const& result = results[piece.task];
+            out.Write(result.data(), result.size());
+        }
+    }
+
+    return true;
+}
+
+static bool StringifyTopLevel(OutputSink& out, Value const& value, StringifyOptions const& options)
+{
+    if (options.num_threads > 1 && options.parallel_chunk_size > 0)
+    {
+        size_t const min_weight = 2 * options.parallel_chunk_size;
+        if (StringifyPlanner::Weight(value, min_weight) >= min_weight)
+            return StringifyParallel(out, value, options);
+    }
+
+    return StringifyValue(out, value, options, 0);
+}
+
+bool json::stringify(std::string& str, Value const& value, StringifyOptions const& options)
+{
+    StringSink out(str);
+    bool const success = StringifyTopLevel(out, value, options);
+    out.Flush();
+    return success;
+}
+
+bool json::stringify(OutputSink& sink, Value const& value, StringifyOptions const& options)
+{
+    bool const success = StringifyTopLevel(sink, value, options);
+    return sink.Flush() && success;
+}
+
+//==================================================================================================
+// CBOR
+//==================================================================================================
+
+// Writes FIRST_BYTE followed by the NUM_BYTES least significant bytes of
+// VALUE in big-endian order.
+static void WriteBigEndian(OutputSink& out, int first_byte, uint64_t value, int num_bytes)
+{
+    char buf[9];
+
+    buf[0] = static_cast<char>(first_byte);
+    for (int i = 0; i < num_bytes; ++i)
+    {
+        buf[1 + i] = static_cast<char>(value >> (8 * (num_bytes - 1 - i)));
+    }
+
+    out.Write(buf, static_cast<size_t>(1 + num_bytes));
+}
+
+static void CborEncodeHead(OutputSink& out, uint8_t major, uint64_t arg)
+{
+    int const initial_byte = major << 5;
+
+    if (arg < 24)
+        out.Put(static_cast<char>(initial_byte | static_cast<int>(arg)));
+    else if (arg <= 0xFF)
+        WriteBigEndian(out, initial_byte | 24, arg, 1);
+    else if (arg <= 0xFFFF)
+        WriteBigEndian(out, initial_byte | 25, arg, 2);
+    else if (arg <= 0xFFFFFFFF)
+        WriteBigEndian(out, initial_byte | 26, arg, 4);
+    else
+        WriteBigEndian(out, initial_byte | 27, arg, 8);
+}
+
+static void CborEncodeNumber(OutputSink& out, double value)
+{
+    // Integers are encoded as such, -0.0 is not an integer.
+    if (value == std::trunc(value) && !(value == 0 && std::signbit(value)))
+    {
+        if (value >= 0 && value < 18446744073709551616.0)
+        {
+            CborEncodeHead(out, 0, static_cast<uint64_t>(value));
+            return;
+        }
+        if (value < 0 && value >= -18446744073709551616.0)
+        {
+            // Encodes -1 - n.
+            // NB: -value - 1 is not always exact, but -value is.
+            uint64_t const n = value == -18446744073709551616.0 ? UINT64_MAX : static_cast<uint64_t>(-value) - 1;
+            CborEncodeHead(out, 1, n);
+            return;
+        }
+    }
+
+    if (std::isnan(value))
+    {
+        // Canonical NaN (RFC 8949, 4.2.2).
+        out.Write("\xF9\x7E\x00", 3);
+        return;
+    }
+
+    float const f = numbers::ToSingle(value);
+    if (static_cast<double>(f) == value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(float));
+        WriteBigEndian(out, 0xFA, bits, 4);
+    }
+    else
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(double));
+        WriteBigEndian(out, 0xFB, bits, 8);
+    }
+}
+
+static bool CborEncodeString(OutputSink& out, char const* first, char const* last, Mode mode)
+{
+    if (mode == Mode::strict && !json::impl::IsValidUTF8(first, last))
+        return false;
+
+    size_t const len = static_cast<size_t>(last - first);
+    CborEncodeHead(out, 3, len);
+    out.Write(first, len);
+    return true;
+}
+
+// Converts JSON text into CBOR.
+// Arrays and objects are encoded with indefinite length.
+struct CborEncodeCallbacks
+{
+    OutputSink& out;
+    Mode mode;
+    String scratch;
+
+    ParseStatus HandleNull()
+    {
+        out.Put(static_cast<char>(0xF6));
+        return {};
+    }
+
+    ParseStatus HandleTrue()
+    {
+        out.Put(static_cast<char>(0xF5));
+        return {};
+    }
+
+    ParseStatus HandleFalse()
+    {
+        out.Put(static_cast<char>(0xF4));
+        return {};
+    }
+
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc)
+    {
+        if (nc == NumberClass::invalid)
+            return ParseStatus::invalid_number;
+
+        CborEncodeNumber(out, numbers::StringToNumber(first, last, nc));
+        return {};
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, StringClass string_class)
+    {
+        if (string_class != StringClass::clean)
+        {
+            if (!UnescapeString(scratch, first, last, mode))
+                return ParseStatus::invalid_string;
+
+            first = scratch.data();
+            last = scratch.data() + scratch.size();
+        }
+
+        if (!CborEncodeString(out, first, last, mode))
+            return ParseStatus::invalid_string;
+
+        return {};
+    }
+
+    ParseStatus HandleBeginArray()
+    {
+        out.Put(static_cast<char>(0x9F));
+        return {};
+    }
+
+    ParseStatus HandleEndArray(size_t /*count*/)
+    {
+        out.Put(static_cast<char>(0xFF));
+        return {};
+    }
+
+    ParseStatus HandleEndElement(size_t& /*count*/)
+    {
+        return {};
+    }
+
+    ParseStatus HandleBeginObject()
+    {
+        out.Put(static_cast<char>(0xBF));
+        return {};
+    }
+
+    ParseStatus HandleEndObject(size_t /*count*/)
+    {
+        out.Put(static_cast<char>(0xFF));
+        return {};
+    }
+
+    ParseStatus HandleEndMember(size_t& /*count*/)
+    {
+        return {};
+    }
+
+    ParseStatus HandleKey(char const* first, char const* last, StringClass string_class)
+    {
+        return HandleString(first, last, string_class);
+    }
+};
+
+static bool CborEncodeValue(OutputSink& out, Value const& value, Mode mode)
+{
+    switch (value.type())
+    {
+    case Type::undefined:
+        out.Put(static_cast<char>(0xF7));
+        return true;
+    case Type::null:
+        out.Put(static_cast<char>(0xF6));
+        return true;
+    case Type::boolean:
+        out.Put(static_cast<char>(value.get_boolean() ? 0xF5 : 0xF4));
+        return true;
+    case Type::number:
+        CborEncodeNumber(out, value.get_number());
+        return true;
+    case Type::string:
+        {
+            auto const& str = value.get_string();
+            return CborEncodeString(out, str.data(), str.data() + str.size(), mode);
+        }
+    case Type::array:
+        {
+            auto const& arr = value.get_array();
+            CborEncodeHead(out, 4, arr.size());
+            for (auto const& v : arr)
+            {
+                if (!CborEncodeValue(out, v, mode))
+                    return false;
+            }
+            return true;
+        }
+    case Type::object:
+        {
+            auto const& obj = value.get_object();
+            CborEncodeHead(out, 5, obj.size());
+            for (auto const& kv : obj)
+            {
+                if (!CborEncodeString(out, kv.first.data(), kv.first.data() + kv.first.size(), mode))
+                    return false;
+                if (!CborEncodeValue(out, kv.second, mode))
+                    return false;
+            }
+            return true;
+        }
+    case Type::raw:
+        {
+            auto const& str = value.get_raw();
+            CborEncodeCallbacks cb{out, mode, {}};
+            auto const res = json::ParseSAX(cb, str.data(), str.data() + str.size(), mode);
+            return res.ec == ParseStatus::success;
+        }
+    default:
+        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+        return false;
+    }
+}
+
+bool json::cbor::encode(OutputSink& sink, Value const& value, Mode mode)
+{
+    bool const success = CborEncodeValue(sink, value, mode);
+    return sink.Flush() && success;
+}
+
+bool json::cbor::encode(std::string& str, Value const& value, Mode mode)
+{
+    StringSink out(str);
+    bool const success = CborEncodeValue(out, value, mode);
+    out.Flush();
+    return success;
+}
+
+ParseResult json::cbor::decode(Value& value, char const* next, char const* last, Mode mode)
+{
+    DecodeValueCallbacks cb;
+    cb.mode = mode;
+
+    auto const res = json::cbor::DecodeSAX(cb, next, last, mode);
+    if (res.ec == ParseStatus::success)
+    {
+        JSON_ASSERT(cb.stack.size() == 1);
+        value = std::move(cb.stack.back());
+    }
+
+    return res;
+}
+
+ParseStatus json::cbor::decode(Value& value, std::string const& str, Mode mode)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::cbor::decode(value, next, last, mode).ec;
+}
+
+//==================================================================================================
+// MessagePack
+//==================================================================================================
+
+static void MsgpackEncodeNumber(OutputSink& out, double value)
+{
+    // Integers are encoded as such, -0.0 is not an integer.
+    if (value == std::trunc(value) && !(value == 0 && std::signbit(value)))
+    {
+        if (value >= 0 && value < 18446744073709551616.0)
+        {
+            uint64_t const n = static_cast<uint64_t>(value);
+            if (n <= 0x7F)
+                out.Put(static_cast<char>(n));
+            else if (n <= 0xFF)
+                WriteBigEndian(out, 0xCC, n, 1);
+            else if (n <= 0xFFFF)
+                WriteBigEndian(out, 0xCD, n, 2);
+            else if (n <= 0xFFFFFFFF)
+                WriteBigEndian(out, 0xCE, n, 4);
+            else
+                WriteBigEndian(out, 0xCF, n, 8);
+            return;
+        }
+        if (value < 0 && value >= -9223372036854775808.0)
+        {
+            int64_t const n = static_cast<int64_t>(value);
+            if (n >= -32)
+                out.Put(static_cast<char>(n));
+            else if (n >= INT8_MIN)
+                WriteBigEndian(out, 0xD0, static_cast<uint64_t>(n), 1);
+            else if (n >= INT16_MIN)
+                WriteBigEndian(out, 0xD1, static_cast<uint64_t>(n), 2);
+            else if (n >= INT32_MIN)
+                WriteBigEndian(out, 0xD2, static_cast<uint64_t>(n), 4);
+            else
+                WriteBigEndian(out, 0xD3, static_cast<uint64_t>(n), 8);
+            return;
+        }
+    }
+
+    if (std::isnan(value))
+    {
+        out.Write("\xCA\x7F\xC0\x00\x00", 5);
+        return;
+    }
+
+    float const f = numbers::ToSingle(value);
+    if (static_cast<double>(f) == value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(float));
+        WriteBigEndian(out, 0xCA, bits, 4);
+    }
+    else
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(double));
+        WriteBigEndian(out, 0xCB, bits, 8);
+    }
+}
+
+static bool MsgpackEncodeString(OutputSink& out, char const* first, char const* last, Mode mode)
+{
+    if (mode == Mode::strict && !json::impl::IsValidUTF8(first, last))
+        return false;
+
+    size_t const len = static_cast<size_t>(last - first);
+    if (len <= 31)
+        out.Put(static_cast<char>(0xA0 | len));
+    else if (len <= 0xFF)
+        WriteBigEndian(out, 0xD9, len, 1);
+    else if (len <= 0xFFFF)
+        WriteBigEndian(out, 0xDA, len, 2);
+    else
+        WriteBigEndian(out, 0xDB, len, 4);
+
+    out.Write(first, len);
+    return true;
+}
+
+static void MsgpackEncodeContainer(OutputSink& out, size_t len, bool is_map)
+{
+    if (len <= 15)
+        out.Put(static_cast<char>((is_map ? 0x80 : 0x90) | len));
+    else if (len <= 0xFFFF)
+        WriteBigEndian(out, is_map ? 0xDE : 0xDC, len, 2);
+    else
+        WriteBigEndian(out, is_map ? 0xDF : 0xDD, len, 4);
+}
+
+static bool MsgpackEncodeValue(OutputSink& out, Value const& value, Mode mode)
+{
+    switch (value.type())
+    {
+    case Type::undefined:
+    case Type::null:
+        out.Put(static_cast<char>(0xC0));
+        return true;
+    case Type::boolean:
+        out.Put(static_cast<char>(value.get_boolean() ? 0xC3 : 0xC2));
+        return true;
+    case Type::number:
+        MsgpackEncodeNumber(out, value.get_number());
+        return true;
+    case Type::string:
+        {
+            auto const& str = value.get_string();
+            return MsgpackEncodeString(out, str.data(), str.data() + str.size(), mode);
+        }
+    case Type::array:
+        {
+            auto const& arr = value.get_array();
+            MsgpackEncodeContainer(out, arr.size(), /*is_map*/ false);
+            for (auto const& v : arr)
+            {
+                if (!MsgpackEncodeValue(out, v, mode))
+                    return false;
+            }
+            return true;
+        }
+    case Type::object:
+        {
+            auto const& obj = value.get_object();
+            MsgpackEncodeContainer(out, obj.size(), /*is_map*/ true);
+            for (auto const& kv : obj)
+            {
+                if (!MsgpackEncodeString(out, kv.first.data(), kv.first.data() + kv.first.size(), mode))
+                    return false;
+                if (!MsgpackEncodeValue(out, kv.second, mode))
+                    return false;
+            }
+            return true;
+        }
+    case Type::raw:
+        {
+            // The lengths of arrays and maps must be known in advance.
+            auto const& str = value.get_raw();
+            Value parsed;
+            if (json::parse(parsed, str.data(), str.data() + str.size(), mode).ec != ParseStatus::success)
+                return false;
+            return MsgpackEncodeValue(out, parsed, mode);
+        }
+    default:
+        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+        return false;
+    }
+}
+
+bool json::msgpack::encode(OutputSink& sink, Value const& value, Mode mode)
+{
+    bool const success = MsgpackEncodeValue(sink, value, mode);
+    return sink.Flush() && success;
+}
+
+bool json::msgpack::encode(std::string& str, Value const& value, Mode mode)
+{
+    StringSink out(str);
+    bool const success = MsgpackEncodeValue(out, value, mode);
+    out.Flush();
+    return success;
+}
+
+ParseResult json::msgpack::decode(Value& value, char const* next, char const* last, Mode mode)
+{
+    DecodeValueCallbacks cb;
+    cb.mode = mode;
+
+    auto const res = json::msgpack::DecodeSAX(cb, next, last, mode);
+    if (res.ec == ParseStatus::success)
+    {
+        JSON_ASSERT(cb.stack.size() == 1);
+        value = std::move(cb.stack.back());
+    }
+
+    return res;
+}
+
+ParseStatus json::msgpack::decode(Value& value, std::string const& str, Mode mode)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::msgpack::decode(value, next, last, mode).ec;
+}
+
+//==================================================================================================
+// Snapshot
+//==================================================================================================
+
+static constexpr char const kSnapshotMagic[8] = {'J', 'S', 'O', 'N', '1', 'S', 'N', 'P'};
+static constexpr uint32_t kSnapshotVersion = 1;
+static constexpr uint32_t kSnapshotByteOrder = 0x01020304;
+
+namespace {
+
+// Builds the snapshot in memory.
+// Arrays and objects reserve their slots first and are filled in afterwards,
+// so that the slots of each container are stored contiguously.
+struct SnapshotBuilder
+{
+    std::string buf;
+
+    uint64_t Allocate(size_t size)
+    {
+        // Keep everything 8-byte aligned.
+        size_t const offset = (buf.size() + 7) & ~size_t{7};
+        buf.resize(offset + size);
+        return offset;
+    }
+
+    uint64_t AppendString(char const* str, size_t len)
+    {
+        uint64_t const offset = Allocate(len + 1);
+        std::memcpy(&buf[offset], str, len); // '\0' has been added by resize()
+        return offset;
+    }
+
+    void StoreSlot(uint64_t offset, impl::SnapshotSlot const& slot)
+    {
+        std::memcpy(&buf[offset], &slot, sizeof(impl::SnapshotSlot));
+    }
+
+    bool Store(uint64_t slot_offset, Value const& value)
+    {
+        impl::SnapshotSlot slot{static_cast<uint32_t>(value.type()), 0, 0};
+
+        switch (value.type())
+        {
+        case Type::undefined:
+        case Type::null:
+            break;
+        case Type::boolean:
+            slot.payload = value.get_boolean() ? 1 : 0;
+            break;
+        case Type::number:
+            {
+                double const number = value.get_number();
+                std::memcpy(&slot.payload, &number, sizeof(double));
+            }
+            break;
+        case Type::string:
+        case Type::raw:
+            {
+                auto const& str = value.is_string() ? value.get_string() : value.get_raw();
+                if (str.size() > UINT32_MAX)
+                    return false;
+                slot.size = static_cast<uint32_t>(str.size());
+                slot.payload = AppendString(str.data(), str.size());
+            }
+            break;
+        case Type::array:
+            {
+                auto const& arr = value.get_array();
+                if (arr.size() > UINT32_MAX)
+                    return false;
+                slot.size = static_cast<uint32_t>(arr.size());
+                slot.payload = Allocate(arr.size() * sizeof(impl::SnapshotSlot));
+
+                uint64_t elem_offset = slot.payload;
+                for (auto const& v : arr)
+                {
+                    if (!Store(elem_offset, v))
+                        return false;
+                    elem_offset += sizeof(impl::SnapshotSlot);
+                }
+            }
+            break;
+        case Type::object:
+            {
+                auto const& obj = value.get_object();
+                if (obj.size() > UINT32_MAX)
+                    return false;
+                slot.size = static_cast<uint32_t>(obj.size());
+                slot.payload = Allocate(obj.size() * sizeof(impl::SnapshotMember));
+
+                uint64_t member_offset = slot.payload;
+                for (auto const& kv : obj)
+                {
+                    if (kv.first.size() > UINT32_MAX)
+                        return false;
+
+                    impl::SnapshotMember member{};
+                    member.key = AppendString(kv.first.data(), kv.first.size());
+                    member.key_size = static_cast<uint32_t>(kv.first.size());
+                    std::memcpy(&buf[member_offset], &member, sizeof(impl::SnapshotMember));
+
+                    if (!Store(member_offset + offsetof(impl::SnapshotMember, value), kv.second))
+                        return false;
+                    member_offset += sizeof(impl::SnapshotMember);
+                }
+            }
+            break;
+        default:
+            JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+            return false;
+        }
+
+        StoreSlot(slot_offset, slot);
+        return true;
+    }
+};
+
+} // namespace
+
+bool json::save_snapshot(Value const& value, std::string const& path)
+{
+    SnapshotBuilder builder;
+
+    uint64_t const header_offset = builder.Allocate(sizeof(impl::SnapshotHeader));
+    JSON_ASSERT(header_offset == 0);
+    static_cast<void>(header_offset);
+
+    if (!builder.Store(offsetof(impl::SnapshotHeader, root), value))
+        return false;
+
+    impl::SnapshotHeader header;
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.byte_order = kSnapshotByteOrder;
+    header.file_size = builder.buf.size();
+    std::memcpy(&header.root, &builder.buf[offsetof(impl::SnapshotHeader, root)], sizeof(impl::SnapshotSlot));
+    std::memcpy(&builder.buf[0], &header, sizeof(impl::SnapshotHeader));
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    bool success = std::fwrite(builder.buf.data(), 1, builder.buf.size(), file) == builder.buf.size();
+    if (std::fclose(file) != 0)
+        success = false;
+
+    return success;
+}
+
+Value SnapshotView::to_value() const
+{
+    switch (type())
+    {
+    case Type::undefined:
+        return Value();
+    case Type::null:
+        return Value(nullptr);
+    case Type::boolean:
+        return Value(get_boolean());
+    case Type::number:
+        return Value(get_number());
+    case Type::string:
+        return Value(string_tag, get_string(), get_string() + size());
+    case Type::raw:
+        return Value(raw_tag, String(get_raw(), size()));
+    case Type::array:
+        {
+            Value result(array_tag);
+            auto& arr = result.get_array();
+            arr.reserve(size());
+            for (size_t i = 0, n = size(); i != n; ++i)
+            {
+                arr.push_back((*this)[i].to_value());
+            }
+            return result;
+        }
+    case Type::object:
+        {
+            Value result(object_tag);
+            auto& obj = result.get_object();
+            for (size_t i = 0, n = size(); i != n; ++i)
+            {
+                // Keys are sorted.
+                obj.emplace_hint(obj.end(), String(key(i), key_size(i)), value(i).to_value());
+            }
+            return result;
+        }
+    default:
+        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+        return Value();
+    }
+}
+
+Snapshot::Snapshot(Snapshot&& rhs) noexcept
+    : data_(rhs.data_)
+    , size_(rhs.size_)
+{
+    rhs.data_ = nullptr;
+    rhs.size_ = 0;
+}
+
+Snapshot& Snapshot::operator=(Snapshot&& rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        close();
+        data_ = rhs.data_;
+        size_ = rhs.size_;
+        rhs.data_ = nullptr;
+        rhs.size_ = 0;
+    }
+    return *this;
+}
+
+Snapshot::~Snapshot()
+{
+    close();
+}
+
+void Snapshot::close() noexcept
+{
+    if (data_ == nullptr)
+        return;
+
+#if _WIN32
+    ::UnmapViewOfFile(data_);
+#else
+    ::munmap(const_cast<char*>(data_), size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+}
+
+static bool IsValidSnapshotHeader(char const* data, size_t size)
+{
+    if (size < sizeof(impl::SnapshotHeader))
+        return false;
+
+    impl::SnapshotHeader header;
+    std::memcpy(&header, data, sizeof(impl::SnapshotHeader));
+
+    return std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) == 0
+        && header.version == kSnapshotVersion
+        && header.byte_order == kSnapshotByteOrder
+        && header.file_size == size;
+}
+
+Snapshot json::open_snapshot(std::string const& path)
+{
+    Snapshot snapshot;
+
+#if _WIN32
+    HANDLE const file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return snapshot;
+
+    LARGE_INTEGER file_size;
+    if (!::GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(impl::SnapshotHeader)))
+    {
+        ::CloseHandle(file);
+        return snapshot;
+    }
+
+    HANDLE const mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    ::CloseHandle(file);
+    if (mapping == nullptr)
+        return snapshot;
+
+    void const* const data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    ::CloseHandle(mapping); // The view keeps the mapping alive.
+    if (data == nullptr)
+        return snapshot;
+
+    snapshot.data_ = static_cast<char const*>(data);
+    snapshot.size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return snapshot;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(impl::SnapshotHeader)))
+    {
+        ::close(fd);
+        return snapshot;
+    }
+
+    size_t const size = static_cast<size_t>(st.st_size);
+    void* const data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive.
+    if (data == MAP_FAILED)
+        return snapshot;
+
+    snapshot.data_ = static_cast<char const*>(data);
+    snapshot.size_ = size;
+#endif
+
+    if (!IsValidSnapshotHeader(snapshot.data_, snapshot.size_))
+        snapshot.close();
+
+    return snapshot;
+}
+
+//==================================================================================================
+// Schema
+//==================================================================================================
+
+namespace json {
+namespace impl {
+
+struct SchemaCompiler
+{
+    Schema& schema;
+    std::map<String, uint32_t, std::less<>> pointers; // JSON pointer -> node
+    std::vector<std::pair<uint32_t, String>> refs;    // node -> $ref
+
+    static void AppendPointer(String& pointer, String const& token)
+    {
+        pointer += '/';
+        for (char const ch : token)
+        {
+            if (ch == '~')
+                pointer += "~0";
+            else if (ch == '/')
+                pointer += "~1";
+            else
+                pointer += ch;
+        }
+    }
+
+    static bool GetNumber(Value const& v, double& result)
+    {
+        if (!v.is_number())
+            return false;
+        result = v.get_number();
+        return std::isfinite(result);
+    }
+
+    static bool GetCount(Value const& v, uint32_t& result)
+    {
+        if (!v.is_number())
+            return false;
+        double const d = v.get_number();
+        if (!(d >= 0) || std::trunc(d) != d)
+            return false;
+        result = d >= static_cast<double>(UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(d);
+        return true;
+    }
+
+    static bool IsScalar(Value const& v)
+    {
+        return v.is_null() || v.is_boolean() || v.is_number() || v.is_string();
+    }
+
+    static bool GetTypes(Value const& v, uint32_t& types)
+    {
+        static constexpr struct { char const* name; uint32_t types; } kTypes[] = {
+            {"null",    Schema::type_null},
+            {"boolean", Schema::type_boolean},
+            {"integer", Schema::type_integer},
+            {"number",  Schema::type_integer | Schema::type_number},
+            {"string",  Schema::type_string},
+            {"array",   Schema::type_array},
+            {"object",  Schema::type_object},
+        };
+
+        if (!v.is_string())
+            return false;
+        for (auto const& t : kTypes)
+        {
+            if (v.get_string() == t.name)
+            {
+                types |= t.types;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool IsUnsupported(String const& key)
+    {
+        static constexpr char const* const kUnsupported[] = {
+            "$dynamicRef",
+            "$recursiveRef",
+            "additionalItems",
+            "contains",
+            "dependencies",
+            "dependentRequired",
+            "dependentSchemas",
+            "maxContains",
+            "minContains",
+            "pattern",
+            "patternProperties",
+            "propertyNames",
+            "unevaluatedItems",
+            "unevaluatedProperties",
+        };
+
+        for (char const* name : kUnsupported)
+        {
+            if (key == name)
+                return true;
+        }
+        return false;
+    }
+
+    // Compiles a non-empty array of schemas.
+    bool CompileList(std::vector<uint32_t>& list, Value const& v, String const& pointer)
+    {
+        if (!v.is_array() || v.get_array().empty())
+            return false;
+
+        uint32_t i = 0;
+        for (auto const& s : v.get_array())
+        {
+            String child = pointer;
+            child += '/';
+            child += std::to_string(i++);
+
+            uint32_t index;
+            if (!CompileNode(index, s, child))
+                return false;
+            list.push_back(index);
+        }
+        return true;
+    }
+
+    bool CompileNode(uint32_t& index, Value const& s, String const& pointer)
+    {
+        index = static_cast<uint32_t>(schema.nodes_.size());
+        schema.nodes_.emplace_back();
+        pointers[pointer] = index;
+
+        Schema::Node node;
+
+        if (s.is_boolean())
+        {
+            node.reject = !s.get_boolean();
+            schema.nodes_[index] = node;
+            return true;
+        }
+
+        if (!s.is_object())
+            return false;
+
+        bool has_type = false;
+        std::vector<uint32_t> prefix_items;
+        std::vector<uint32_t> all_of;
+        std::vector<uint32_t> any_of;
+        std::vector<uint32_t> one_of;
+        std::vector<Schema::Property> properties;
+        std::vector<String> required;
+        std::vector<Value> enums;
+
+        for (auto const& kv : s.get_object())
+        {
+            String const& key = kv.first;
+            Value const& v = kv.second;
+
+            String child = pointer;
+            AppendPointer(child, key);
+
+            bool ok = true;
+            if (key == "type")
+            {
+                has_type = true;
+                node.types = 0;
+                if (v.is_array())
+                {
+                    for (auto const& t : v.get_array())
+                        ok = ok && GetTypes(t, node.types);
+                }
+                else
+                {
+                    ok = GetTypes(v, node.types);
+                }
+            }
+            else if (key == "enum")
+            {
+                ok = v.is_array();
+                if (ok)
+                {
+                    for (auto const& e : v.get_array())
+                    {
+                        ok = ok && IsScalar(e);
+                        enums.push_back(e);
+                    }
+                }
+                node.has_enum = true;
+            }
+            else if (key == "const")
+            {
+                ok = IsScalar(v);
+                enums.push_back(v);
+                node.has_enum = true;
+            }
+            else if (key == "minimum")
+                ok = node.has_minimum = GetNumber(v, node.minimum);
+            else if (key == "maximum")
+                ok = node.has_maximum = GetNumber(v, node.maximum);
+            else if (key == "exclusiveMinimum")
+                ok = node.has_exclusive_minimum = GetNumber(v, node.exclusive_minimum);
+            else if (key == "exclusiveMaximum")
+                ok = node.has_exclusive_maximum = GetNumber(v, node.exclusive_maximum);
+            else if (key == "multipleOf")
+                ok = node.has_multiple_of = GetNumber(v, node.multiple_of) && node.multiple_of > 0;
+            else if (key == "minLength")
+                ok = GetCount(v, node.min_length);
+            else if (key == "maxLength")
+                ok = GetCount(v, node.max_length);
+            else if (key == "minItems")
+                ok = GetCount(v, node.min_items);
+            else if (key == "maxItems")
+                ok = GetCount(v, node.max_items);
+            else if (key == "minProperties")
+                ok = GetCount(v, node.min_properties);
+            else if (key == "maxProperties")
+                ok = GetCount(v, node.max_properties);
+            else if (key == "uniqueItems")
+                ok = v.is_boolean() && !v.get_boolean();
+            else if (key == "items")
+                ok = !v.is_array() && CompileNode(node.items, v, child);
+            else if (key == "prefixItems")
+                ok = CompileList(prefix_items, v, child);
+            else if (key == "additionalProperties")
+                ok = CompileNode(node.additional_properties, v, child);
+            else if (key == "properties")
+            {
+                ok = v.is_object();
+                if (ok)
+                {
+                    // NB: Object members are sorted by key.
+                    for (auto const& p : v.get_object())
+                    {
+                        String prop = child;
+                        AppendPointer(prop, p.first);
+
+                        uint32_t prop_index;
+                        if (!CompileNode(prop_index, p.second, prop))
+                            return false;
+                        properties.push_back({p.first, prop_index});
+                    }
+                }
+            }
+            else if (key == "required")
+            {
+                ok = v.is_array();
+                if (ok)
+                {
+                    for (auto const& r : v.get_array())
+                    {
+                        ok = ok && r.is_string();
+                        if (ok)
+                            required.push_back(r.get_string());
+                    }
+                }
+            }
+            else if (key == "allOf")
+                ok = CompileList(all_of, v, child);
+            else if (key == "anyOf")
+                ok = CompileList(any_of, v, child);
+            else if (key == "oneOf")
+                ok = CompileList(one_of, v, child);
+            else if (key == "not")
+                ok = CompileNode(node.not_, v, child);
+            else if (key == "if")
+                ok = CompileNode(node.if_, v, child);
+            else if (key == "then")
+                ok = CompileNode(node.then_, v, child);
+            else if (key == "else")
+                ok = CompileNode(node.else_, v, child);
+            else if (key == "$ref")
+            {
+                ok = v.is_string();
+                if (ok)
+                    refs.emplace_back(index, v.get_string());
+            }
+            else if (key == "$defs" || key == "definitions")
+            {
+                ok = v.is_object();
+                if (ok)
+                {
+                    for (auto const& d : v.get_object())
+                    {
+                        String def = child;
+                        AppendPointer(def, d.first);
+
+                        uint32_t def_index;
+                        if (!CompileNode(def_index, d.second, def))
+                            return false;
+                    }
+                }
+            }
+            else if (IsUnsupported(key))
+                ok = false;
+
+            if (!ok)
+                return false;
+        }
+
+        if (has_type && node.types == 0)
+            return false;
+
+        std::sort(required.begin(), required.end());
+        required.erase(std::unique(required.begin(), required.end()), required.end());
+
+        auto append = [](auto& table, auto& items, uint32_t& first, uint32_t& count) {
+            first = static_cast<uint32_t>(table.size());
+            count = static_cast<uint32_t>(items.size());
+            std::move(items.begin(), items.end(), std::back_inserter(table));
+        };
+
+        append(schema.enums_, enums, node.enum_first, node.enum_count);
+        append(schema.indices_, prefix_items, node.prefix_items_first, node.prefix_items_count);
+        append(schema.indices_, all_of, node.all_of_first, node.all_of_count);
+        append(schema.indices_, any_of, node.any_of_first, node.any_of_count);
+        append(schema.indices_, one_of, node.one_of_first, node.one_of_count);
+        append(schema.properties_, properties, node.properties_first, node.properties_count);
+        append(schema.required_, required, node.required_first, node.required_count);
+
+        schema.nodes_[index] = node;
+        return true;
+    }
+
+    // Resolves local references, i.e. JSON pointers to compiled subschemas.
+    bool ResolveRefs()
+    {
+        for (auto const& r : refs)
+        {
+            String const& ref = r.second;
+            if (ref.empty() || ref[0] != '#')
+                return false;
+
+            auto const it = pointers.find(ref.substr(1));
+            if (it == pointers.end())
+                return false;
+
+            schema.nodes_[r.first].ref = it->second;
+        }
+        return true;
+    }
+
+    // Returns false if a subschema (indirectly) applies itself to the same
+    // value, which would never terminate.
+    enum : uint8_t { kWhite, kGray, kBlack };
+
+    bool CheckCycles()
+    {
+        std::vector<uint8_t> color(schema.nodes_.size(), kWhite);
+        for (uint32_t i = 0; i < schema.nodes_.size(); ++i)
+        {
+            if (!Visit(color, i))
+                return false;
+        }
+        return true;
+    }
+
+    bool Visit(std::vector<uint8_t>& color, uint32_t index)
+    {
+        if (color[index] == kBlack)
+            return true;
+        if (color[index] == kGray)
+            return false;
+
+        color[index] = kGray;
+
+        auto const& node = schema.nodes_[index];
+        auto visit = [&](uint32_t child) { return child == Schema::kNone || Visit(color, child); };
+        auto visit_list = [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (!Visit(color, schema.indices_[first + i]))
+                    return false;
+            }
+            return true;
+        };
+
+        bool const ok = visit(node.ref)
+            && visit(node.not_)
+            && visit(node.if_)
+            && visit(node.then_)
+            && visit(node.else_)
+            && visit_list(node.all_of_first, node.all_of_count)
+            && visit_list(node.any_of_first, node.any_of_count)
+            && visit_list(node.one_of_first, node.one_of_count);
+
+        color[index] = kBlack;
+        return ok;
+    }
+};
+
+} // namespace impl
+} // namespace json
+
+constexpr uint32_t Schema::kNone;
+
+bool Schema::compile(Value const& document)
+{
+    nodes_.clear();
+    indices_.clear();
+    properties_.clear();
+    required_.clear();
+    enums_.clear();
+
+    impl::SchemaCompiler compiler{*this, {}, {}};
+
+    uint32_t root;
+    if (compiler.CompileNode(root, document, String{}) && compiler.ResolveRefs() && compiler.CheckCycles())
+    {
+        JSON_ASSERT(root == 0);
+        return true;
+    }
+
+    nodes_.clear();
+    indices_.clear();
+    properties_.clear();
+    required_.clear();
+    enums_.clear();
+    return false;
+}
+
+// How the result of an evaluation contributes to the result of its parent.
+enum : uint8_t {
+    kRelationAnd,   // allOf, $ref, items, properties, ...
+    kRelationAnyOf,
+    kRelationOneOf,
+    kRelationNot,
+    kRelationIf,
+    kRelationThen,
+    kRelationElse,
+};
+
+struct SchemaValidator::Instance
+{
+    uint32_t type = 0; // one of Schema::type_*
+    bool boolean = false;
+    double number = 0;
+    char const* str = nullptr;
+    size_t len = 0;
+};
+
+SchemaValidator::SchemaValidator(Schema const& schema, Mode mode)
+    : schema_(schema)
+    , mode_(mode)
+{
+    JSON_ASSERT(!schema.empty() && "schema has not been compiled");
+}
+
+ParseStatus SchemaValidator::HandleNull()
+{
+    Instance inst;
+    inst.type = Schema::type_null;
+    return BeginValue(inst);
+}
+
+ParseStatus SchemaValidator::HandleTrue()
+{
+    Instance inst;
+    inst.type = Schema::type_boolean;
+    inst.boolean = true;
+    return BeginValue(inst);
+}
+
+ParseStatus SchemaValidator::HandleFalse()
+{
+    Instance inst;
+    inst.type = Schema::type_boolean;
+    inst.boolean = false;
+    return BeginValue(inst);
+}
+
+ParseStatus SchemaValidator::HandleNumber(char const* first, char const* last, NumberClass nc)
+{
+    if (nc == NumberClass::invalid)
+        return ParseStatus::invalid_number;
+
+    return HandleDouble(numbers::StringToNumber(first, last, nc));
+}
+
+// Infinities are numbers, but not integers (although trunc(inf) == inf).
+static bool IsInteger(double value)
+{
+    return std::isfinite(value) && std::trunc(value) == value;
+}
+
+ParseStatus SchemaValidator::HandleDouble(double value)
+{
+    if (mode_ == Mode::strict && !std::isfinite(value))
+        return ParseStatus::invalid_number;
+
+    Instance inst;
+    inst.type = IsInteger(value) ? Schema::type_integer : Schema::type_number;
+    inst.number = value;
+    return BeginValue(inst);
+}
+
+ParseStatus SchemaValidator::HandleString(char const* first, char const* last, StringClass string_class)
+{
+    if (!Unescape(first, last, string_class))
+        return ParseStatus::invalid_string;
+
+    Instance inst;
+    inst.type = Schema::type_string;
+    inst.str = first;
+    inst.len = static_cast<size_t>(last - first);
+    return BeginValue(inst);
+}
+
+ParseStatus SchemaValidator::HandleBeginArray()
+{
+    Instance inst;
+    inst.type = Schema::type_array;
+    return BeginValue(inst);
+}
+
+ParseStatus SchemaValidator::HandleEndArray(size_t /*count*/)
+{
+    return EndContainer();
+}
+
+ParseStatus SchemaValidator::HandleEndElement(size_t& /*count*/)
+{
+    return {};
+}
+
+ParseStatus SchemaValidator::HandleBeginObject()
+{
+    Instance inst;
+    inst.type = Schema::type_object;
+    return BeginValue(inst);
+}
+
+ParseStatus SchemaValidator::HandleEndObject(size_t /*count*/)
+{
+    return EndContainer();
+}
+
+ParseStatus SchemaValidator::HandleEndMember(size_t& /*count*/)
+{
+    return {};
+}
+
+ParseStatus SchemaValidator::HandleKey(char const* first, char const* last, StringClass string_class)
+{
+    if (!Unescape(first, last, string_class))
+        return ParseStatus::invalid_string;
+
+    return Key(first, static_cast<size_t>(last - first));
+}
+
+ParseStatus SchemaValidator::ValidateValue(Value const& value)
+{
+    switch (value.type())
+    {
+    case Type::undefined:
+    case Type::null:
+        return HandleNull();
+    case Type::boolean:
+        return value.get_boolean() ? HandleTrue() : HandleFalse();
+    case Type::number:
+        return HandleDouble(value.get_number());
+    case Type::string:
+        {
+            Instance inst;
+            inst.type = Schema::type_string;
+            inst.str = value.get_string().data();
+            inst.len = value.get_string().size();
+            return BeginValue(inst);
+        }
+    case Type::array:
+        if (Failed ec = HandleBeginArray())
+            return ParseStatus(ec);
+        for (auto const& v : value.get_array())
+        {
+            if (Failed ec = ValidateValue(v))
+                return ParseStatus(ec);
+        }
+        return EndContainer();
+    case Type::object:
+        if (Failed ec = HandleBeginObject())
+            return ParseStatus(ec);
+        for (auto const& kv : value.get_object())
+        {
+            if (Failed ec = Key(kv.first.data(), kv.first.size()))
+                return ParseStatus(ec);
+            if (Failed ec = ValidateValue(kv.second))
+                return ParseStatus(ec);
+        }
+        return EndContainer();
+    case Type::raw:
+        {
+            auto const& raw = value.get_raw();
+            return json::ParseSAX(*this, raw.data(), raw.data() + raw.size(), mode_).ec;
+        }
+    }
+
+    JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+    return ParseStatus::unknown;
+}
+
+ParseStatus SchemaValidator::BeginValue(Instance const& instance)
+{
+    JSON_ASSERT(!failed_);
+
+    size_t const first = evals_.size();
+
+    if (frames_.empty())
+    {
+        JSON_ASSERT(first == 0 && "a validator can only be used for a single document");
+        Instantiate(0, Schema::kNone, kRelationAnd);
+    }
+    else if (frames_.back().is_object)
+    {
+        for (auto const& p : pending_)
+            Instantiate(p.node, p.parent, kRelationAnd);
+        pending_.clear();
+    }
+    else
+    {
+        Frame const frame = frames_.back();
+        for (size_t i = frame.first; i != frame.last; ++i)
+        {
+            if (evals_[i].failed)
+                continue;
+
+            auto const& node = schema_.nodes_[evals_[i].node];
+            uint32_t const index = evals_[i].count++;
+            if (index >= node.max_items)
+            {
+                Fail(i);
+                continue;
+            }
+
+            uint32_t const child = index < node.prefix_items_count
+                ? schema_.indices_[node.prefix_items_first + index]
+                : node.items;
+            if (child != Schema::kNone)
+                Instantiate(child, static_cast<uint32_t>(i), kRelationAnd);
+        }
+    }
+
+    for (size_t i = first; i != evals_.size(); ++i)
+        Check(i, instance);
+
+    if (failed_)
+        return ParseStatus::schema_violation;
+
+    if (instance.type == Schema::type_array)
+    {
+        frames_.push_back({first, evals_.size(), false, false});
+    }
+    else if (instance.type == Schema::type_object)
+    {
+        bool counts_keys = false;
+        for (size_t i = first; !counts_keys && i != evals_.size(); ++i)
+        {
+            auto const& node = schema_.nodes_[evals_[i].node];
+            counts_keys = node.min_properties != 0 || node.max_properties != UINT32_MAX;
+        }
+
+        if (counts_keys)
+            keys_.emplace_back();
+        frames_.push_back({first, evals_.size(), true, counts_keys});
+    }
+    else
+    {
+        EndValue(first);
+    }
+
+    return failed_ ? ParseStatus::schema_violation : ParseStatus::success;
+}
+
+ParseStatus SchemaValidator::EndContainer()
+{
+    JSON_ASSERT(!frames_.empty());
+
+    Frame const frame = frames_.back();
+    frames_.pop_back();
+
+    JSON_ASSERT(frame.last == evals_.size());
+
+    if (frame.counts_keys)
+        keys_.pop_back();
+
+    for (size_t i = frame.first; i != frame.last; ++i)
+    {
+        auto const& e = evals_[i];
+        if (e.failed)
+            continue;
+
+        auto const& node = schema_.nodes_[e.node];
+        if (frame.is_object)
+        {
+            bool valid = e.count >= node.min_properties;
+            for (uint32_t k = 0; valid && k < node.required_count; ++k)
+                valid = seen_[e.seen_first + k] != 0;
+            if (!valid)
+                Fail(i);
+        }
+        else
+        {
+            if (e.count < node.min_items)
+                Fail(i);
+        }
+    }
+
+    EndValue(frame.first);
+
+    return failed_ ? ParseStatus::schema_violation : ParseStatus::success;
+}
+
+ParseStatus SchemaValidator::Key(char const* key, size_t len)
+{
+    JSON_ASSERT(!frames_.empty() && frames_.back().is_object);
+    JSON_ASSERT(pending_.empty());
+
+    Frame const frame = frames_.back();
+
+    bool const is_new_key = !frame.counts_keys || keys_.back().emplace(key, len).second;
+
+    for (size_t i = frame.first; i != frame.last; ++i)
+    {
+        auto& e = evals_[i];
+        if (e.failed)
+            continue;
+
+        auto const& node = schema_.nodes_[e.node];
+        if (is_new_key && ++e.count > node.max_properties)
+        {
+            Fail(i);
+            continue;
+        }
+
+        auto const less = [](String const& lhs, std::pair<char const*, size_t> const& rhs) {
+            return lhs.compare(0, String::npos, rhs.first, rhs.second) < 0;
+        };
+        auto const k = std::make_pair(key, len);
+
+        auto const props_first = schema_.properties_.begin() + node.properties_first;
+        auto const props_last = props_first + node.properties_count;
+        auto const prop = std::lower_bound(props_first, props_last, k, [&](Schema::Property const& p, auto const& rhs) { return less(p.key, rhs); });
+        if (prop != props_last && prop->key.compare(0, String::npos, key, len) == 0)
+            pending_.push_back({prop->node, static_cast<uint32_t>(i)});
+        else if (node.additional_properties != Schema::kNone)
+            pending_.push_back({node.additional_properties, static_cast<uint32_t>(i)});
+
+        auto const req_first = schema_.required_.begin() + node.required_first;
+        auto const req_last = req_first + node.required_count;
+        auto const req = std::lower_bound(req_first, req_last, k, less);
+        if (req != req_last && req->compare(0, String::npos, key, len) == 0)
+            seen_[e.seen_first + static_cast<size_t>(req - req_first)] = 1;
+    }
+
+    if (failed_)
+    {
+        pending_.clear();
+        return ParseStatus::schema_violation;
+    }
+
+    return {};
+}
+
+void SchemaValidator::Instantiate(uint32_t node, uint32_t parent, uint8_t relation)
+{
+    auto const index = static_cast<uint32_t>(evals_.size());
+    auto const& n = schema_.nodes_[node];
+
+    Eval e;
+    e.node = node;
+    e.parent = parent;
+    e.relation = relation;
+    e.failed = false;
+    e.not_valid = false;
+    e.if_valid = false;
+    e.then_valid = false;
+    e.else_valid = false;
+    e.any_of_valid = false;
+    e.one_of_valid = 0;
+    e.count = 0;
+    e.seen_first = seen_.size();
+    evals_.push_back(e);
+
+    seen_.resize(seen_.size() + n.required_count, 0);
+
+    if (n.ref != Schema::kNone)
+        Instantiate(n.ref, index, kRelationAnd);
+    for (uint32_t i = 0; i < n.all_of_count; ++i)
+        Instantiate(schema_.indices_[n.all_of_first + i], index, kRelationAnd);
+    for (uint32_t i = 0; i < n.any_of_count; ++i)
+        Instantiate(schema_.indices_[n.any_of_first + i], index, kRelationAnyOf);
+    for (uint32_t i = 0; i < n.one_of_count; ++i)
+        Instantiate(schema_.indices_[n.one_of_first + i], index, kRelationOneOf);
+    if (n.not_ != Schema::kNone)
+        Instantiate(n.not_, index, kRelationNot);
+    if (n.if_ != Schema::kNone)
+    {
+        Instantiate(n.if_, index, kRelationIf);
+        if (n.then_ != Schema::kNone)
+            Instantiate(n.then_, index, kRelationThen);
+        if (n.else_ != Schema::kNone)
+            Instantiate(n.else_, index, kRelationElse);
+    }
+}
+
+void SchemaValidator::Check(size_t index, Instance const& instance)
+{
+    auto const& e = evals_[index];
+    if (e.failed)
+        return;
+
+    auto const& node = schema_.nodes_[e.node];
+
+    bool valid = !node.reject && (node.types & instance.type) != 0;
+
+    if (valid && node.has_enum)
+    {
+        valid = false;
+        for (uint32_t i = 0; !valid && i < node.enum_count; ++i)
+        {
+            auto const& v = schema_.enums_[node.enum_first + i];
+            switch (instance.type)
+            {
+            case Schema::type_null:
+                valid = v.is_null();
+                break;
+            case Schema::type_boolean:
+                valid = v.is_boolean() && v.get_boolean() == instance.boolean;
+                break;
+            case Schema::type_integer:
+            case Schema::type_number:
+                valid = v.is_number() && v.get_number() == instance.number;
+                break;
+            case Schema::type_string:
+                valid = v.is_string() && v.get_string().compare(0, String::npos, instance.str, instance.len) == 0;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (valid && (instance.type == Schema::type_integer || instance.type == Schema::type_number))
+    {
+        double const x = instance.number;
+        if (node.has_minimum && !(x >= node.minimum))
+            valid = false;
+        else if (node.has_maximum && !(x <= node.maximum))
+            valid = false;
+        else if (node.has_exclusive_minimum && !(x > node.exclusive_minimum))
+            valid = false;
+        else if (node.has_exclusive_maximum && !(x < node.exclusive_maximum))
+            valid = false;
+        else if (node.has_multiple_of)
+        {
+            // The quotient of decimal numbers is usually inexact, e.g.
+            // 0.3 / 0.1 = 2.9999999999999996, so allow a small relative error.
+            static constexpr double kEpsilon = 4 * std::numeric_limits<double>::epsilon();
+
+            double const q = x / node.multiple_of;
+            if (!std::isfinite(x))
+                valid = false;
+            else if (std::isinf(q))
+                // The exact quotient is far beyond 2^53, where every double is an integer.
+                valid = true;
+            else if (q == 0)
+                // The quotient underflows unless X is zero.
+                valid = x == 0;
+            else
+                valid = std::abs(q - std::round(q)) <= kEpsilon * std::abs(q);
+        }
+    }
+
+    if (valid && instance.type == Schema::type_string && (node.min_length != 0 || node.max_length != UINT32_MAX))
+    {
+        // The length of a string is the number of code points.
+        size_t length = 0;
+        for (size_t i = 0; i < instance.len; ++i)
+        {
+            if ((static_cast<unsigned char>(instance.str[i]) & 0xC0) != 0x80)
+                ++length;
+        }
+        valid = length >= node.min_length && length <= node.max_length;
+    }
+
+    if (!valid)
+        Fail(index);
+}
+
+void SchemaValidator::EndValue(size_t first)
+{
+    JSON_ASSERT(first <= evals_.size());
+
+    // Children are evaluated before their parents.
+    for (size_t i = evals_.size(); i-- > first; )
+    {
+        auto const& e = evals_[i];
+        auto const& node = schema_.nodes_[e.node];
+
+        bool valid = !e.failed;
+        if (valid && node.any_of_count != 0 && !e.any_of_valid)
+            valid = false;
+        if (valid && node.one_of_count != 0 && e.one_of_valid != 1)
+            valid = false;
+        if (valid && node.not_ != Schema::kNone && e.not_valid)
+            valid = false;
+        if (valid && node.if_ != Schema::kNone)
+        {
+            if (e.if_valid)
+                valid = node.then_ == Schema::kNone || e.then_valid;
+            else
+                valid = node.else_ == Schema::kNone || e.else_valid;
+        }
+
+        if (e.parent == Schema::kNone)
+        {
+            if (!valid)
+                failed_ = true;
+            continue;
+        }
+
+        auto& parent = evals_[e.parent];
+        switch (e.relation)
+        {
+        case kRelationAnd:
+            if (!valid)
+                Fail(e.parent);
+            break;
+        case kRelationAnyOf:
+            parent.any_of_valid = parent.any_of_valid || valid;
+            break;
+        case kRelationOneOf:
+            parent.one_of_valid += valid ? 1 : 0;
+            break;
+        case kRelationNot:
+            parent.not_valid = valid;
+            break;
+        case kRelationIf:
+            parent.if_valid = valid;
+            break;
+        case kRelationThen:
+            parent.then_valid = valid;
+            break;
+        case kRelationElse:
+            parent.else_valid = valid;
+            break;
+        }
+    }
+
+    if (first < evals_.size())
+    {
+        seen_.resize(evals_[first].seen_first);
+        evals_.resize(first);
+    }
+}
+
+void SchemaValidator::Fail(size_t index)
+{
+    // Propagate the failure eagerly, so that the parser can stop as soon as
+    // the root fails.
+    for (;;)
+    {
+        auto& e = evals_[index];
+        if (e.failed)
+            return;
+
+        e.failed = true;
+        if (e.relation != kRelationAnd)
+            return;
+        if (e.parent == Schema::kNone)
+        {
+            failed_ = true;
+            return;
+        }
+
+        index = e.parent;
+    }
+}
+
+bool SchemaValidator::Unescape(char const*& first, char const*& last, StringClass string_class)
+{
+    if (string_class == StringClass::clean)
+        return true;
+
+    if (!UnescapeString(scratch_, first, last, mode_))
+        return false;
+
+    first = scratch_.data();
+    last = scratch_.data() + scratch_.size();
+    return true;
+}
+
+ParseResult json::validate(Schema const& schema, char const* next, char const* last, Mode mode)
+{
+    SchemaValidator validator(schema, mode);
+    return json::ParseSAX(validator, next, last, mode);
+}
+
+ParseStatus json::validate(Schema const& schema, std::string const& str, Mode mode)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::validate(schema, next, last, mode).ec;
+}
+
+bool json::validate_value(Schema const& schema, Value const& value)
+{
+    SchemaValidator validator(schema, Mode::lenient);
+    return validator.ValidateValue(value) == ParseStatus::success;
+}
+
+//==================================================================================================
+// KeyIndex
+//==================================================================================================
+
+constexpr uint32_t KeyIndex::kNone;
+
+KeyIndex::KeyIndex(std::vector<String> keys)
+    : keys_(std::move(keys))
+{
+    Build();
+}
+
+KeyIndex::KeyIndex(std::initializer_list<String> keys)
+    : keys_(keys)
+{
+    Build();
+}
+
+KeyIndex::KeyIndex(Schema const& schema)
+{
+    if (schema.empty())
+    {
+        Build();
+        return;
+    }
+
+    // Collect the properties of the root node and of all nodes which are
+    // applied to the same value and whose results are required.
+    std::vector<uint32_t> todo = {0};
+    std::vector<uint8_t> visited(schema.nodes_.size());
+    while (!todo.empty())
+    {
+        uint32_t const index = todo.back();
+        todo.pop_back();
+        if (visited[index])
+            continue;
+        visited[index] = 1;
+
+        auto const& node = schema.nodes_[index];
+        for (uint32_t i = 0; i < node.properties_count; ++i)
+            keys_.push_back(schema.properties_[node.properties_first + i].key);
+        if (node.ref != Schema::kNone)
+            todo.push_back(node.ref);
+        for (uint32_t i = 0; i < node.all_of_count; ++i)
+            todo.push_back(schema.indices_[node.all_of_first + i]);
+    }
+
+    Build();
+}
+
+uint32_t KeyIndex::FindLinear(char const* key, size_t len) const noexcept
+{
+    for (size_t i = 0; i < keys_.size(); ++i)
+    {
+        if (keys_[i].size() == len && std::memcmp(keys_[i].data(), key, len) == 0)
+            return static_cast<uint32_t>(i);
+    }
+    return kNone;
+}
+
+void KeyIndex::Build()
+{
+    // Remove duplicate keys, keeping the first occurrence.
+    std::vector<String> unique_keys;
+    unique_keys.reserve(keys_.size());
+    for (auto& k : keys_)
+    {
+        if (std::find(unique_keys.begin(), unique_keys.end(), k) == unique_keys.end())
+            unique_keys.push_back(std::move(k));
+    }
+    keys_ = std::move(unique_keys);
+
+    JSON_ASSERT(keys_.size() < kNone);
+
+    std::vector<uint64_t> hashes;
+    hashes.reserve(keys_.size());
+    for (auto const& k : keys_)
+        hashes.push_back(impl::KeyHash(k.data(), k.size()));
+
+    // Search for a seed which maps all keys to different buckets, starting
+    // with a table with a load factor <= 1/2. The table is doubled after a
+    // few unsuccessful attempts.
+    uint32_t log2_size = 1;
+    while ((size_t{1} << log2_size) < 2 * keys_.size())
+        ++log2_size;
+
+    for (int attempts = 0; log2_size <= 24; ++attempts)
+    {
+        if (attempts == 16)
+        {
+            attempts = 0;
+            ++log2_size;
+        }
+
+        seed_ = 0xD1B54A32D192ED03ull * static_cast<unsigned>(attempts + 1) + log2_size;
+        shift_ = 64 - log2_size;
+        table_.assign(size_t{1} << log2_size, kNone);
+
+        bool collision = false;
+        for (size_t i = 0; i < keys_.size(); ++i)
+        {
+            auto& bucket = table_[Bucket(hashes[i])];
+            if (bucket != kNone)
+            {
+                collision = true;
+                break;
+            }
+            bucket = static_cast<uint32_t>(i);
+        }
+
+        if (!collision)
+        {
+            linear_ = false;
+            return;
+        }
+    }
+
+    // Only possible if two keys have the same 64-bit hash.
+    table_.clear(); // LCOV_EXCL_LINE
+}
+
+//==================================================================================================
+// Record
 //==================================================================================================
-// stringify
-//==================================================================================================
 
-static bool StringifyValue(std::string& str, Value const& value, StringifyOptions const& options, int curr_indent);
+// Stores the members of the top-level object in the slots of a Record.
+struct ParseRecordCallbacks : ParseValueCallbacks
+{
+    KeyIndex const* index = nullptr;
+    Record* record = nullptr;
+    size_t depth = 0;
+    uint32_t slot = KeyIndex::kNone; // slot of the current top-level member
+    String scratch;
+
+    ParseStatus HandleNull()
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleNull();
+    }
+
+    ParseStatus HandleTrue()
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleTrue();
+    }
+
+    ParseStatus HandleFalse()
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleFalse();
+    }
+
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc)
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleNumber(first, last, nc);
+    }
+
+    ParseStatus HandleString(char const* first, char const* last, StringClass string_class)
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleString(first, last, string_class);
+    }
+
+    ParseStatus HandleBeginArray()
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        ++depth;
+        return ParseValueCallbacks::HandleBeginArray();
+    }
+
+    ParseStatus HandleEndArray(size_t count)
+    {
+        --depth;
+        return ParseValueCallbacks::HandleEndArray(count);
+    }
+
+    ParseStatus HandleBeginObject()
+    {
+        ++depth;
+        return ParseValueCallbacks::HandleBeginObject();
+    }
+
+    ParseStatus HandleEndObject(size_t count)
+    {
+        --depth;
+        return ParseValueCallbacks::HandleEndObject(count);
+    }
+
+    ParseStatus HandleKey(char const* first, char const* last, StringClass string_class)
+    {
+        if (depth != 1)
+            return ParseValueCallbacks::HandleKey(first, last, string_class);
+
+        if (string_class != StringClass::clean)
+        {
+            if (!UnescapeString(scratch, first, last, mode))
+                return ParseStatus::invalid_string;
+            first = scratch.data();
+            last = scratch.data() + scratch.size();
+        }
+
+        slot = index->find(first, static_cast<size_t>(last - first));
+        if (slot != KeyIndex::kNone)
+            return {};
+
+        keys.emplace_back(first, last);
+        return {};
+    }
+
+    ParseStatus HandleEndMember(size_t& count)
+    {
+        if (depth == 1 && slot != KeyIndex::kNone)
+        {
+            JSON_ASSERT(count != 0);
+            JSON_ASSERT(stack.size() >= 2);
+
+            record->slots[slot] = std::move(stack.back());
+            stack.pop_back();
+            slot = KeyIndex::kNone;
+            --count;
+            return {};
+        }
+
+        return ParseValueCallbacks::HandleEndMember(count);
+    }
+};
 
-static bool StringifyNull(std::string& str, StringifyOptions const& /*options*/)
+ParseResult json::parse_record(Record& record, KeyIndex const& index, char const* next, char const* last, Mode mode)
 {
-    str += "null";
-    return true;
+    Record result;
+    result.slots.resize(index.size());
+
+    ParseRecordCallbacks cb;
+    cb.index = &index;
+    cb.record = &result;
+
+    Value value;
+    auto const res = ParseValue(value, cb, next, last, mode);
+    if (res.ec == ParseStatus::success)
+    {
+        result.overflow = std::move(value.get_object());
+        record = std::move(result);
+    }
+
+    return res;
 }
 
-static bool StringifyBoolean(std::string& str, bool value)
+ParseStatus json::parse_record(Record& record, KeyIndex const& index, std::string const& str, Mode mode)
 {
-    str += value ? "true" : "false";
-    return true;
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse_record(record, index, next, last, mode).ec;
 }
 
-static bool StringifyNumber(std::string& str, double value, StringifyOptions const& options)
+//==================================================================================================
+// RecordArray
+//==================================================================================================
+
+constexpr uint32_t RecordArray::kNoShape;
+
+static Value const kUndefinedMember{};
+
+// Stores the objects in the top-level array as shapes plus values.
+struct json::impl::ParseRecordArrayCallbacks : ParseValueCallbacks
 {
-    if (options.mode == Mode::strict && !std::isfinite(value))
+    RecordArray* records = nullptr;
+    size_t depth = 0;
+    uint32_t last_shape = RecordArray::kNoShape; // shape of the previous object
+    // The current object:
+    bool matching = false;  // whether the keys so far are a prefix of the keys of last_shape
+    uint32_t num_keys = 0;
+    std::vector<String> row_keys; // the keys so far, if !matching
+    std::unordered_map<uint64_t, uint32_t> shape_by_hash;
+    String scratch;
+
+    ParseStatus HandleNull()
     {
-        str += "null";
-        return true;
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleNull();
     }
 
-    char buf[32];
-    char* end = numbers::NumberToString(buf, 32, value, /*force_trailing_dot_zero*/ true);
-    str.append(buf, end);
+    ParseStatus HandleTrue()
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleTrue();
+    }
 
-    return true;
-}
+    ParseStatus HandleFalse()
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleFalse();
+    }
 
-static bool StringifyString(std::string& str, String const& value, StringifyOptions const& options)
-{
-    bool success = true;
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc)
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleNumber(first, last, nc);
+    }
 
-    str += '"';
+    ParseStatus HandleString(char const* first, char const* last, StringClass string_class)
+    {
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+        return ParseValueCallbacks::HandleString(first, last, string_class);
+    }
 
-    char const* const next = value.data();
-    char const* const last = value.data() + value.size();
-    if (next != last)
+    ParseStatus HandleBeginArray()
     {
-        auto const res = strings::EscapeString(next, last, /*allow_invalid_unicode*/ options.mode != Mode::strict, [&](char ch) { str += ch; });
-        success = res.ec == strings::Status::success;
+        // The top-level array is not stored on the stack.
+        if (depth++ == 0)
+            return {};
+        return ParseValueCallbacks::HandleBeginArray();
+    }
+
+    ParseStatus HandleEndArray(size_t count)
+    {
+        if (--depth == 0)
+        {
+            // The array is immutable from now on.
+            records->rows_.shrink_to_fit();
+            records->values_.shrink_to_fit();
+            return {};
+        }
+        return ParseValueCallbacks::HandleEndArray(count);
     }
 
-    str += '"';
+    ParseStatus HandleEndElement(size_t& count)
+    {
+        if (depth != 1)
+            return ParseValueCallbacks::HandleEndElement(count);
 
-    return success;
-}
+        // Objects have already been moved into the RecordArray.
+        if (!stack.empty())
+        {
+            JSON_ASSERT(stack.size() == 1);
+            AddRow(RecordArray::kNoShape, 1);
+        }
 
-static bool StringifyArray(std::string& str, Array const& value, StringifyOptions const& options, int curr_indent)
-{
-    str += '[';
+        return {};
+    }
 
-    auto       I = value.begin();
-    auto const E = value.end();
-    if (I != E)
+    ParseStatus HandleBeginObject()
     {
-        if (options.indent_width > 0)
+        if (depth == 0)
+            return ParseStatus::schema_violation;
+
+        if (depth++ != 1)
+            return ParseValueCallbacks::HandleBeginObject();
+
+        // The members of the object are collected on the stack.
+        JSON_ASSERT(stack.empty());
+        matching = last_shape != RecordArray::kNoShape;
+        num_keys = 0;
+        row_keys.clear();
+        return {};
+    }
+
+    ParseStatus HandleEndObject(size_t count)
+    {
+        if (--depth != 1)
+            return ParseValueCallbacks::HandleEndObject(count);
+
+        JSON_ASSERT(stack.size() == count);
+        JSON_ASSERT(num_keys == count);
+
+        if (matching && num_keys == records->shapes_[last_shape].size())
         {
-            curr_indent += options.indent_width;
+            AddRow(last_shape, num_keys);
+            return {};
+        }
 
-            for (;;)
-            {
-                str += '\n';
-                str.append(static_cast<size_t>(curr_indent), ' ');
+        if (matching)
+            MaterializeKeys();
 
-                if (!StringifyValue(str, *I, options, curr_indent))
-                    return false;
+        uint32_t const shape = FindOrAddShape();
+        if (shape != RecordArray::kNoShape)
+        {
+            last_shape = shape;
+            AddRow(shape, num_keys);
+            return {};
+        }
 
-                if (++I == E)
-                    break;
+        // Duplicate keys. Store as an ordinary object.
+        Value obj(json::object_tag);
+        for (size_t i = 0; i < row_keys.size(); ++i)
+            obj.get_object()[std::move(row_keys[i])] = std::move(stack[i]);
+        stack.clear();
+        stack.push_back(std::move(obj));
+        AddRow(RecordArray::kNoShape, 1);
 
-                str += ',';
-            }
+        return {};
+    }
 
-            curr_indent -= options.indent_width;
+    ParseStatus HandleKey(char const* first, char const* last, StringClass string_class)
+    {
+        if (depth != 2)
+            return ParseValueCallbacks::HandleKey(first, last, string_class);
 
-            str += '\n';
-            str.append(static_cast<size_t>(curr_indent), ' ');
+        if (string_class != StringClass::clean)
+        {
+            if (!UnescapeString(scratch, first, last, mode))
+                return ParseStatus::invalid_string;
+            first = scratch.data();
+            last = scratch.data() + scratch.size();
         }
-        else
+
+        auto const len = static_cast<size_t>(last - first);
+
+        if (matching)
         {
-            for (;;)
+            auto const& shape = records->shapes_[last_shape];
+            if (num_keys < shape.size())
             {
-                if (!StringifyValue(str, *I, options, curr_indent))
-                    return false;
+                String const& key = shape.key(num_keys);
+                if (key.size() == len && std::memcmp(key.data(), first, len) == 0)
+                {
+                    ++num_keys;
+                    return {};
+                }
+            }
 
-                if (++I == E)
-                    break;
+            MaterializeKeys();
+        }
 
-                str += ',';
-                if (options.indent_width == 0)
-                    str += ' ';
-            }
+        row_keys.emplace_back(first, last);
+        ++num_keys;
+        return {};
+    }
+
+    ParseStatus HandleEndMember(size_t& count)
+    {
+        // The values of the current object stay on the stack until the end of the object.
+        if (depth == 2)
+            return {};
+
+        return ParseValueCallbacks::HandleEndMember(count);
+    }
+
+private:
+    // Copy the matching prefix of the keys of last_shape into row_keys.
+    void MaterializeKeys()
+    {
+        JSON_ASSERT(matching);
+        JSON_ASSERT(row_keys.empty());
+
+        auto const& shape = records->shapes_[last_shape];
+        for (uint32_t i = 0; i < num_keys; ++i)
+            row_keys.push_back(shape.key(i));
+
+        matching = false;
+    }
+
+    // Returns the shape for the keys in row_keys, or kNoShape if the keys are
+    // not unique.
+    uint32_t FindOrAddShape()
+    {
+        uint64_t hash = row_keys.size();
+        for (auto const& k : row_keys)
+            hash = impl::KeyHashMix(hash, impl::KeyHash(k.data(), k.size()));
+
+        auto const it = shape_by_hash.find(hash);
+        if (it != shape_by_hash.end())
+        {
+            if (HasKeys(records->shapes_[it->second]))
+                return it->second;
         }
+
+        KeyIndex shape(row_keys);
+        if (shape.size() != row_keys.size())
+            return RecordArray::kNoShape;
+
+        JSON_ASSERT(records->shapes_.size() < RecordArray::kNoShape);
+        auto const index = static_cast<uint32_t>(records->shapes_.size());
+        records->shapes_.push_back(std::move(shape));
+        // Keep the first shape on (very unlikely) hash collisions. Later shapes are not shared then.
+        shape_by_hash.emplace(hash, index);
+        return index;
     }
 
-    str += ']';
+    bool HasKeys(KeyIndex const& shape) const
+    {
+        if (shape.size() != row_keys.size())
+            return false;
+
+        for (size_t i = 0; i < row_keys.size(); ++i)
+        {
+            if (shape.key(i) != row_keys[i])
+                return false;
+        }
 
-    return true;
+        return true;
+    }
+
+    void AddRow(uint32_t shape, size_t count)
+    {
+        JSON_ASSERT(stack.size() == count);
+        JSON_ASSERT(count <= UINT32_MAX);
+
+        records->rows_.push_back({shape, static_cast<uint32_t>(count), records->values_.size()});
+        records->values_.insert(records->values_.end(), std::make_move_iterator(stack.begin()), std::make_move_iterator(stack.end()));
+        stack.clear();
+    }
+};
+
+RecordArray::Column RecordArray::column(String key) const
+{
+    Column column;
+    column.slots_.reserve(shapes_.size());
+    for (auto const& shape : shapes_)
+        column.slots_.push_back(shape.find(key));
+    column.key_ = std::move(key);
+
+    return column;
 }
 
-static bool StringifyObject(std::string& str, Object const& value, StringifyOptions const& options, int curr_indent)
+Value const& RecordArray::get(size_t row, Column const& column) const noexcept
 {
-    str += '{';
+    JSON_ASSERT(row < rows_.size());
+    JSON_ASSERT(column.slots_.size() == shapes_.size());
 
-    auto       I = value.begin();
-    auto const E = value.end();
-    if (I != E)
+    auto const& r = rows_[row];
+    if (r.shape == kNoShape)
     {
-        if (options.indent_width > 0)
+        auto const& element = values_[r.first];
+        auto const* value = element.is_object() ? element.get_ptr(column.key_) : nullptr;
+        return value != nullptr ? *value : kUndefinedMember;
+    }
+
+    uint32_t const slot = column.slots_[r.shape];
+    return slot != KeyIndex::kNone ? values_[r.first + slot] : kUndefinedMember;
+}
+
+Value const& RecordArray::Get(size_t row, char const* key, size_t len, uint64_t hash) const noexcept
+{
+    JSON_ASSERT(row < rows_.size());
+
+    auto const& r = rows_[row];
+    if (r.shape == kNoShape)
+    {
+        auto const& element = values_[r.first];
+        if (element.is_object())
         {
-            curr_indent += options.indent_width;
+            auto const& obj = element.get_object();
+            auto const it = obj.find(String(key, len));
+            if (it != obj.end())
+                return it->second;
+        }
+        return kUndefinedMember;
+    }
 
-            for (;;)
-            {
-                str += '\n';
-                str.append(static_cast<size_t>(curr_indent), ' ');
+    uint32_t const slot = shapes_[r.shape].find(key, len, hash);
+    return slot != KeyIndex::kNone ? values_[r.first + slot] : kUndefinedMember;
+}
 
-                if (!StringifyString(str, I->first, options))
-                    return false;
-                str += ':';
-                str += ' ';
-                if (!StringifyValue(str, I->second, options, curr_indent))
-                    return false;
+Value RecordArray::to_value(size_t row) const
+{
+    JSON_ASSERT(row < rows_.size());
 
-                if (++I == E)
-                    break;
+    auto const& r = rows_[row];
+    if (r.shape == kNoShape)
+        return values_[r.first];
 
-                str += ',';
-            }
+    auto const& shape = shapes_[r.shape];
 
-            curr_indent -= options.indent_width;
+    Value obj(json::object_tag);
+    auto& members = obj.get_object();
+    for (size_t i = 0; i < r.size; ++i)
+        members.emplace(shape.key(i), values_[r.first + i]);
 
-            str += '\n';
-            str.append(static_cast<size_t>(curr_indent), ' ');
-        }
-        else
-        {
-            for (;;)
-            {
-                if (!StringifyString(str, I->first, options))
-                    return false;
-                str += ':';
-                if (options.indent_width == 0)
-                    str += ' ';
-                if (!StringifyValue(str, I->second, options, curr_indent))
-                    return false;
+    return obj;
+}
 
-                if (++I == E)
-                    break;
+Value RecordArray::to_value() const
+{
+    Value arr(json::array_tag);
+    auto& elements = arr.get_array();
+    elements.reserve(rows_.size());
+    for (size_t i = 0; i < rows_.size(); ++i)
+        elements.push_back(to_value(i));
 
-                str += ',';
-                if (options.indent_width == 0)
-                    str += ' ';
-            }
+    return arr;
+}
+
+ParseResult json::parse_records(RecordArray& records, char const* next, char const* last, Mode mode)
+{
+    RecordArray result;
+
+    json::impl::ParseRecordArrayCallbacks cb;
+    cb.mode = mode;
+    cb.records = &result;
+
+    auto const res = json::ParseSAX(cb, next, last, mode);
+    if (res.ec == ParseStatus::success)
+        records = std::move(result);
+
+    return res;
+}
+
+ParseStatus json::parse_records(RecordArray& records, std::string const& str, Mode mode)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse_records(records, next, last, mode).ec;
+}
+
+//==================================================================================================
+// StringPool
+//==================================================================================================
+
+constexpr size_t StringPool::kNumShards;
+
+// An open-addressing hash table with linear probing.
+// Slots are only ever changed from null to an entry, so that readers can
+// probe the table without locking.
+struct StringPool::Table
+{
+    size_t mask;
+    std::unique_ptr<std::atomic<impl::InternedEntry const*>[]> slots;
+
+    explicit Table(size_t capacity)
+        : mask(capacity - 1)
+        , slots(new std::atomic<impl::InternedEntry const*>[capacity])
+    {
+        JSON_ASSERT(capacity != 0 && (capacity & (capacity - 1)) == 0);
+
+        for (size_t i = 0; i < capacity; ++i)
+            slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const noexcept { return mask + 1; }
+};
+
+StringPool::StringPool(StringPoolOptions const& options)
+    : options_(options)
+{
+}
+
+StringPool::~StringPool()
+{
+    clear();
+}
+
+StringPool& StringPool::global()
+{
+    static StringPool pool;
+    return pool;
+}
+
+InternedString StringPool::intern(char const* str, size_t len)
+{
+    uint64_t const hash = impl::KeyHash(str, len);
+    Shard& shard = shards_[static_cast<size_t>(hash >> 60)];
+    static_assert(kNumShards == 16, "shard index uses the upper 4 bits of the hash");
+
+    if (auto const entry = Find(shard.table.load(std::memory_order_acquire), str, len, hash))
+        return InternedString(entry);
+
+    if (len > options_.max_length)
+        return {};
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Another thread might have inserted the string in the meantime.
+    if (auto const entry = Find(shard.table.load(std::memory_order_relaxed), str, len, hash))
+        return InternedString(entry);
+
+    return InternedString(Insert(shard, str, len, hash));
+}
+
+InternedString StringPool::find(char const* str, size_t len) const noexcept
+{
+    uint64_t const hash = impl::KeyHash(str, len);
+    Shard const& shard = shards_[static_cast<size_t>(hash >> 60)];
+
+    return InternedString(Find(shard.table.load(std::memory_order_acquire), str, len, hash));
+}
+
+void StringPool::clear() noexcept
+{
+    for (auto& shard : shards_)
+    {
+        if (auto const table = shard.table.load(std::memory_order_relaxed))
+        {
+            // Each entry is stored in the current table of its shard.
+            for (size_t i = 0; i < table->capacity(); ++i)
+                std::free(const_cast<impl::InternedEntry*>(table->slots[i].load(std::memory_order_relaxed)));
+            delete table;
         }
+        for (auto const table : shard.retired)
+            delete table;
+
+        shard.table.store(nullptr, std::memory_order_relaxed);
+        shard.retired.clear();
+        shard.count = 0;
     }
 
-    str += '}';
+    num_strings_.store(0, std::memory_order_relaxed);
+    num_bytes_.store(0, std::memory_order_relaxed);
+}
+
+impl::InternedEntry const* StringPool::Find(Table const* table, char const* str, size_t len, uint64_t hash) noexcept
+{
+    if (table == nullptr)
+        return nullptr;
 
-    return true;
+    for (size_t i = static_cast<size_t>(hash) & table->mask; ; i = (i + 1) & table->mask)
+    {
+        auto const entry = table->slots[i].load(std::memory_order_acquire);
+        if (entry == nullptr)
+            return nullptr;
+        if (entry->hash == hash && entry->size == len && std::memcmp(entry->data(), str, len) == 0)
+            return entry;
+    }
 }
 
-static bool StringifyValue(std::string& str, Value const& value, StringifyOptions const& options, int curr_indent)
+impl::InternedEntry const* StringPool::Insert(Shard& shard, char const* str, size_t len, uint64_t hash)
 {
-    switch (value.type())
+    // Keep the load factor <= 1/2. Readers might still probe the old table,
+    // so it is only deleted when the pool is cleared.
+    // The table is grown before the entry is allocated, so that neither the
+    // entry nor the counters need to be rolled back if this throws.
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    if (table == nullptr || 2 * (shard.count + 1) > table->capacity())
     {
-    case Type::undefined:
-        JSON_ASSERT(false && "cannot stringify 'undefined'"); // LCOV_EXCL_LINE
-        return StringifyNull(str, options);
-    case Type::null:
-        return StringifyNull(str, options);
-    case Type::boolean:
-        return StringifyBoolean(str, value.get_boolean());
-    case Type::number:
-        return StringifyNumber(str, value.get_number(), options);
-    case Type::string:
-        return StringifyString(str, value.get_string(), options);
-    case Type::array:
-        return StringifyArray(str, value.get_array(), options, curr_indent);
-    case Type::object:
-        return StringifyObject(str, value.get_object(), options, curr_indent);
-    default:
-        JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
-        return {};
+        auto next = std::make_unique<Table>(table == nullptr ? 64 : 2 * table->capacity());
+        if (table != nullptr)
+        {
+            for (size_t i = 0; i < table->capacity(); ++i)
+            {
+                auto const e = table->slots[i].load(std::memory_order_relaxed);
+                if (e == nullptr)
+                    continue;
+
+                size_t k = static_cast<size_t>(e->hash) & next->mask;
+                while (next->slots[k].load(std::memory_order_relaxed) != nullptr)
+                    k = (k + 1) & next->mask;
+                next->slots[k].store(e, std::memory_order_relaxed);
+            }
+            shard.retired.push_back(table);
+        }
+
+        table = next.release();
+        shard.table.store(table, std::memory_order_release);
+    }
+
+    size_t const entry_size = sizeof(impl::InternedEntry) + len + 1;
+    if (!Reserve(entry_size))
+        return nullptr;
+
+    auto const entry = static_cast<impl::InternedEntry*>(std::malloc(entry_size));
+    if (entry == nullptr)
+    {
+        num_strings_.fetch_sub(1, std::memory_order_relaxed); // LCOV_EXCL_LINE
+        num_bytes_.fetch_sub(entry_size, std::memory_order_relaxed); // LCOV_EXCL_LINE
+        throw std::bad_alloc(); // LCOV_EXCL_LINE
     }
+    entry->hash = hash;
+    entry->size = len;
+    std::memcpy(const_cast<char*>(entry->data()), str, len);
+    const_cast<char*>(entry->data())[len] = '\0';
+
+    size_t k = static_cast<size_t>(hash) & table->mask;
+    while (table->slots[k].load(std::memory_order_relaxed) != nullptr)
+        k = (k + 1) & table->mask;
+    table->slots[k].store(entry, std::memory_order_release);
+    ++shard.count;
+
+    return entry;
 }
 
-bool json::stringify(std::string& str, Value const& value, StringifyOptions const& options)
+bool StringPool::Reserve(size_t bytes) noexcept
 {
-    return StringifyValue(str, value, options, 0);
+    if (num_strings_.fetch_add(1, std::memory_order_relaxed) >= options_.max_strings)
+    {
+        num_strings_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t const prev = num_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (bytes > options_.max_bytes || prev > options_.max_bytes - bytes)
+    {
+        num_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        num_strings_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
 }
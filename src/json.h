@@ -23,10 +23,14 @@
 #include "json_defs.h" // Mode
 #include "json_number_conversions.h"
 
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <functional>
+#include <iosfwd>
 #include <limits>
 #include <map>
 #include <string>
@@ -54,6 +58,7 @@ namespace json {
 //==================================================================================================
 
 class Value;
+class Schema;
 
 using Null    = std::nullptr_t;
 using String  = std::string;
@@ -68,6 +73,7 @@ enum class Type : int {
     string,
     array,
     object,
+    raw,        // JSON text which is written verbatim by stringify()
 };
 
 inline constexpr bool operator<(Type lhs, Type rhs) {
@@ -106,6 +112,7 @@ using Tag_number    = Type_const<Type::number >;
 using Tag_string    = Type_const<Type::string >;
 using Tag_array     = Type_const<Type::array  >;
 using Tag_object    = Type_const<Type::object >;
+using Tag_raw       = Type_const<Type::raw    >;
 
 JSON_INLINE_VARIABLE constexpr Tag_undefined const undefined_tag{};
 JSON_INLINE_VARIABLE constexpr Tag_null      const null_tag{};
@@ -114,6 +121,119 @@ JSON_INLINE_VARIABLE constexpr Tag_number    const number_tag{};
 JSON_INLINE_VARIABLE constexpr Tag_string    const string_tag{};
 JSON_INLINE_VARIABLE constexpr Tag_array     const array_tag{};
 JSON_INLINE_VARIABLE constexpr Tag_object    const object_tag{};
+JSON_INLINE_VARIABLE constexpr Tag_raw       const raw_tag{};
+
+//==================================================================================================
+// Key
+//==================================================================================================
+
+namespace impl {
+
+// A fast 64-bit hash for object keys.
+// This is a constexpr function, so that hashes of string literals can be
+// computed at compile time.
+constexpr uint64_t KeyHashMix(uint64_t h, uint64_t w) noexcept
+{
+    h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 32);
+}
+
+constexpr uint64_t KeyHash(char const* key, size_t len) noexcept
+{
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ (len * 0xC4CEB9FE1A85EC53ull);
+
+    size_t i = 0;
+    for ( ; len - i >= 8; i += 8)
+    {
+        uint64_t w = 0;
+        for (size_t k = 0; k < 8; ++k)
+            w |= uint64_t{static_cast<unsigned char>(key[i + k])} << (8 * k);
+        h = KeyHashMix(h, w);
+    }
+
+    if (i != len)
+    {
+        uint64_t w = 0;
+        for (size_t k = 0; i + k < len; ++k)
+            w |= uint64_t{static_cast<unsigned char>(key[i + k])} << (8 * k);
+        h = KeyHashMix(h, w);
+    }
+
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return h;
+}
+
+} // namespace impl
+
+// An object key with precomputed length and hash.
+//
+// Keys are usually created from string literals using the _jk suffix:
+//
+//      using namespace json::literals;
+//      auto const& name = value["name"_jk];
+//
+// Declare keys 'static constexpr' to guarantee that the hash is computed at
+// compile time. Lookups with a Key compare the known number of characters,
+// instead of calling strlen() for every comparison like 'char const*' keys.
+//
+// The Key does not own the characters, which must outlive the Key.
+class Key
+{
+    char const* data_;
+    size_t size_;
+    uint64_t hash_;
+
+public:
+    constexpr Key(char const* data, size_t size) noexcept
+        : data_(data)
+        , size_(size)
+        , hash_(impl::KeyHash(data, size))
+    {
+    }
+
+    constexpr char const* data() const noexcept { return data_; }
+    constexpr size_t size() const noexcept { return size_; }
+    constexpr uint64_t hash() const noexcept { return hash_; }
+
+    String str() const { return String(data_, size_); }
+
+    // Compares lexicographically, like String::compare().
+    int compare(String const& str) const noexcept
+    {
+        size_t const n = size_ < str.size() ? size_ : str.size();
+        if (n != 0)
+        {
+            // Most keys differ in the first character.
+            auto const c0 = static_cast<unsigned char>(data_[0]);
+            auto const c1 = static_cast<unsigned char>(str[0]);
+            if (c0 != c1)
+                return c0 < c1 ? -1 : 1;
+
+            int const c = std::memcmp(data_, str.data(), n);
+            if (c != 0)
+                return c;
+        }
+        return size_ < str.size() ? -1 : (size_ > str.size() ? 1 : 0);
+    }
+
+    friend bool operator==(Key const& lhs, String const& rhs) noexcept { return lhs.size_ == rhs.size() && lhs.compare(rhs) == 0; }
+    friend bool operator==(String const& lhs, Key const& rhs) noexcept { return rhs == lhs; }
+    friend bool operator!=(Key const& lhs, String const& rhs) noexcept { return !(lhs == rhs); }
+    friend bool operator!=(String const& lhs, Key const& rhs) noexcept { return !(rhs == lhs); }
+    friend bool operator<(Key const& lhs, String const& rhs) noexcept { return lhs.compare(rhs) < 0; }
+    friend bool operator<(String const& lhs, Key const& rhs) noexcept { return rhs.compare(lhs) > 0; }
+};
+
+inline namespace literals {
+
+constexpr Key operator""_jk(char const* str, size_t len) noexcept
+{
+    return Key(str, len);
+}
+
+} // namespace literals
 
 namespace impl {
 
@@ -125,6 +245,7 @@ template <>     struct TargetType<Type::number   > { using type = double;  };
 template <>     struct TargetType<Type::string   > { using type = String;  };
 template <>     struct TargetType<Type::array    > { using type = Array;   };
 template <>     struct TargetType<Type::object   > { using type = Object;  };
+template <>     struct TargetType<Type::raw      > { using type = String;  };
 
 template <typename T>
 struct AlwaysFalse { static constexpr bool value = false; };
@@ -150,6 +271,12 @@ struct DefaultTraits_number {
     template <typename V> static decltype(auto) from_json(V&& in) { return std::forward<V>(in).get_number(); }
 };
 
+struct DefaultTraits_float {
+    using tag = Tag_number;
+    template <typename V> static decltype(auto) to_json(V&& in) { return static_cast<double>(in); }
+    template <typename V> static decltype(auto) from_json(V&& in) { return json::numbers::ToSingle(std::forward<V>(in).get_number()); }
+};
+
 template <typename T>
 struct DefaultTraits_s32 {
     static_assert(std::is_integral<T>::value, "bug");
@@ -218,7 +345,7 @@ struct DefaultTraits<Value>
 template <> struct DefaultTraits<std::nullptr_t    > : DefaultTraits_null    {};
 template <> struct DefaultTraits<bool              > : DefaultTraits_boolean {};
 template <> struct DefaultTraits<double            > : DefaultTraits_number  {};
-template <> struct DefaultTraits<float             > : DefaultTraits_number  {};
+template <> struct DefaultTraits<float             > : DefaultTraits_float   {};
 template <> struct DefaultTraits<signed char       > : DefaultTraits_s32<signed char   > {};
 template <> struct DefaultTraits<signed short      > : DefaultTraits_s32<signed short  > {};
 template <> struct DefaultTraits<signed int        > : DefaultTraits_s32<signed int    > {};
@@ -338,18 +465,34 @@ using TargetTypeFor = typename impl::TargetType<TagFor<T>::value>::type;
 template <typename T>
 using ToJsonResultTypeFor = decltype(( TraitsFor<T>::to_json(std::declval<T>()) ));
 
+namespace impl {
+    struct LazyValue;
+    struct SharedNode;
+}
+
 class Value final
 {
+    friend struct impl::LazyValue;
+    friend struct impl::SharedNode;
+
     union Data {
         bool    boolean;
         double  number;
         String* string;
         Array*  array;
         Object* object;
+        impl::LazyValue* lazy;
     };
 
-    Data data_;
+    // Lazy arrays and objects are expanded on first access, even through
+    // const member functions.
+    mutable Data data_;
     Type type_ = Type::undefined;
+    mutable bool lazy_ = false;
+    // Strings, arrays and objects might be stored in reference-counted,
+    // immutable nodes, which are shared with other values. The node is copied
+    // on the first mutable access.
+    bool shared_ = false;
 
     static Value const kUndefined;
 
@@ -367,6 +510,8 @@ public:
     Value(Value&& rhs) noexcept
         : data_(rhs.data_)
         , type_(std::exchange(rhs.type_, Type::undefined))
+        , lazy_(std::exchange(rhs.lazy_, false))
+        , shared_(std::exchange(rhs.shared_, false))
     {
     }
 
@@ -441,6 +586,17 @@ public:
         type_ = Type::object;
     }
 
+    // raw
+    // PRE: The arguments construct a String containing a valid JSON value.
+    //      (This is not checked.)
+
+    template <typename ...Args>
+    Value(Tag_raw, Args&&... args)
+    {
+        data_.string = new String(std::forward<Args>(args)...);
+        type_ = Type::raw;
+    }
+
     // generic constructors
 
     template <typename T,
@@ -508,6 +664,12 @@ public:
     Object& assign(Tag_object, Object const& value);
     Object& assign(Tag_object, Object&& value);
 
+    // raw
+    // PRE: value contains a valid JSON value.
+
+    String const& assign(Tag_raw, String const& value);
+    String const& assign(Tag_raw, String&& value);
+
     // assignment operators
 
     Value& operator=(Value const& rhs);
@@ -517,6 +679,8 @@ public:
 
         data_ = rhs.data_;
         type_ = std::exchange(rhs.type_, Type::undefined);
+        lazy_ = std::exchange(rhs.lazy_, false);
+        shared_ = std::exchange(rhs.shared_, false);
         return *this;
     }
 
@@ -562,6 +726,9 @@ private:
     template <typename T> String& _assign_string(T&& value);
     template <typename T> Array&  _assign_array (T&& value);
     template <typename T> Object& _assign_object(T&& value);
+    template <typename T> String& _assign_raw   (T&& value);
+    void _expand() const;
+    void _unshare();
 
 public:
     // Returns the type of the actual value stored in this JSON object.
@@ -578,6 +745,7 @@ public:
     bool is_string()     const noexcept { return type() == Type::string;    }
     bool is_array()      const noexcept { return type() == Type::array;     }
     bool is_object()     const noexcept { return type() == Type::object;    }
+    bool is_raw()        const noexcept { return type() == Type::raw;       }
     bool is_primitive()  const noexcept { return Type::null <= type() && type() <= Type::string; }
     bool is_structured() const noexcept { return is_array() || is_object(); }
 
@@ -585,6 +753,12 @@ public:
 
     // get_X returns a reference to the value of type X stored in this JSON object.
     // PRE: is_X() == true
+    //
+    // NB: get_array() and get_object() parse lazy values on first access,
+    // even through a const reference, and may throw std::bad_alloc.
+    // NB: The non-const overloads of get_string(), get_array() and
+    // get_object() copy shared nodes (see is_shared()) and may throw
+    // std::bad_alloc, too.
 
     bool& get_boolean() & noexcept
     {
@@ -622,9 +796,11 @@ public:
         return data_.number;
     }
 
-    String& get_string() & noexcept
+    String& get_string() &
     {
         JSON_ASSERT(is_string());
+        if (shared_)
+            _unshare();
         return *data_.string;
     }
 
@@ -634,48 +810,86 @@ public:
         return *data_.string;
     }
 
-    String get_string() && noexcept
+    String get_string() &&
     {
         JSON_ASSERT(is_string());
+        if (shared_)
+            _unshare();
         return std::move(*data_.string);
     }
 
-    Array& get_array() & noexcept
+    Array& get_array() &
     {
         JSON_ASSERT(is_array());
+        if (lazy_)
+            _expand();
+        if (shared_)
+            _unshare();
         return *data_.array;
     }
 
-    Array const& get_array() const& noexcept
+    Array const& get_array() const&
     {
         JSON_ASSERT(is_array());
+        if (lazy_)
+            _expand();
         return *data_.array;
     }
 
-    Array get_array() && noexcept
+    Array get_array() &&
     {
         JSON_ASSERT(is_array());
+        if (lazy_)
+            _expand();
+        if (shared_)
+            _unshare();
         return std::move(*data_.array);
     }
 
-    Object& get_object() & noexcept
+    Object& get_object() &
     {
         JSON_ASSERT(is_object());
+        if (lazy_)
+            _expand();
+        if (shared_)
+            _unshare();
         return *data_.object;
     }
 
-    Object const& get_object() const& noexcept
+    Object const& get_object() const&
     {
         JSON_ASSERT(is_object());
+        if (lazy_)
+            _expand();
         return *data_.object;
     }
 
-    Object get_object() && noexcept
+    Object get_object() &&
     {
         JSON_ASSERT(is_object());
+        if (lazy_)
+            _expand();
+        if (shared_)
+            _unshare();
         return std::move(*data_.object);
     }
 
+    // NB: Raw values are immutable. Use assign() to replace the JSON text.
+
+    String const& get_raw() const& noexcept
+    {
+        JSON_ASSERT(is_raw());
+        return *data_.string;
+    }
+
+    String get_raw() &&
+    {
+        JSON_ASSERT(is_raw());
+        if (shared_)
+            _unshare();
+        return std::move(*data_.string);
+    }
+
     // as<T> uses Traits::from_json to convert this JSON value into an object
     // of type T.
 
@@ -693,24 +907,64 @@ public:
 #endif
 
     // Compare this value to another. Strict equality (i.e. types must match).
-    bool equal_to(Value const& rhs) const noexcept;
+    bool equal_to(Value const& rhs) const;
 
     // Lexicographically compare this value to another.
-    bool less_than(Value const& rhs) const noexcept;
+    bool less_than(Value const& rhs) const;
 
     // Compute a hash value for this JSON value.
-    size_t hash() const noexcept;
+    size_t hash() const;
 
     // Swap this value with another
     void swap(Value& other) noexcept;
 
+    // Returns whether this is an array or object which has not been parsed yet.
+    // See ParseOptions::lazy.
+    // NB: A lazy value is modified on first access, even through const member
+    // functions (get_array(), operator[], size(), ==, hash(), etc.), so a
+    // lazy value must not be accessed from multiple threads concurrently.
+    // Call expand() before sharing the value between threads.
+    bool is_lazy() const noexcept { return lazy_; }
+
+    // Returns whether this string, array or object is stored in a shared node.
+    // Copying a shared value only increments a reference count. The node is
+    // copied on the first mutable access (e.g. through get_array() or
+    // operator[]), so that other values are not affected.
+    // See ParseOptions::share_duplicates.
+    bool is_shared() const noexcept { return shared_; }
+
+    // Moves all strings, arrays and objects in this value into shared nodes
+    // (copy-on-write). Copying the value is O(1) afterwards, and modifying a
+    // copy only copies the nodes on the path from the root to the modified
+    // value. The reference counts are atomic, so copies can be handed to
+    // other threads.
+    // Lazy values are expanded first.
+    // NB: Mutable access copies a node which is referenced by other values,
+    // even if the value is only read, e.g. through the non-const operator[].
+    // Use const references to read shared values.
+    // NB: If this throws std::bad_alloc, the value is unchanged, except that
+    // some of its nodes may be shared.
+    void share();
+
+    // Returns a deep copy of this value whose nodes are allocated in
+    // depth-first order, i.e. in the order in which they are visited when the
+    // copy is traversed. Arrays and strings are allocated with the exact size.
+    // Unlike the copy constructor, the result never references shared nodes
+    // and contains no lazy values.
+    Value clone_compact() const;
+
+    // Parse this value and all nested lazy values.
+    // Returns the first error. In this case the invalid array or object is
+    // replaced by an empty array resp. object.
+    ParseStatus expand();
+
     // Returns the size of this string or array or object.
     // PRE: is_string() or is_array() or is_object()
-    size_t size() const noexcept;
+    size_t size() const;
 
     // Returns whether this string or array or object is empty.
     // PRE: is_string() or is_array() or is_object()
-    bool empty() const noexcept;
+    bool empty() const;
 
     //--------------------------------------------------------------------------
     // Array helper:
@@ -746,7 +1000,7 @@ public:
     // Returns a reference to the index-th element.
     // Or a reference to an 'undefined' value if the index is out of range.
     // PRE: is_array()
-    Value const& operator[](size_t index) const noexcept;
+    Value const& operator[](size_t index) const;
 
     // Returns a pointer the the value at the given index.
     // Or nullptr if this value is not an array of if the index is out bounds.
@@ -794,6 +1048,9 @@ private:
     template <typename T>
     using IsObjectKeyType = std::is_same<Object::key_type, std::decay_t<T>>;
 
+    template <typename T>
+    using IsKey = std::is_same<Key, std::decay_t<T>>;
+
     template <typename T>
     using IsTransparentKey = std::integral_constant<bool,
         // Integral "keys" are used to index arrays.
@@ -929,9 +1186,19 @@ public:
     Value& operator[](Object::key_type const& key);
     Value& operator[](Object::key_type&& key);
 
+    // Convert this value into an object and return a reference to the value with the given key.
+    // The key is copied into the object only if it does not exist yet.
+    // PRE: is_undefined() or is_object()
+    Value& operator[](Key const& key);
+
+    // Returns a reference to the value with the given key.
+    // Or a reference to an 'undefined' value if an element for 'key' does not exist.
+    // PRE: is_object()
+    Value const& operator[](Key const& key) const;
+
     // Convert this value into an object and return a reference to the value with the given key.
     // PRE: is_undefined() or is_object()
-    template <typename T, std::enable_if_t< !IsObjectKeyType<T>::value && IsTransparentKey<T>::value, int > = 0>
+    template <typename T, std::enable_if_t< !IsObjectKeyType<T>::value && !IsKey<T>::value && IsTransparentKey<T>::value, int > = 0>
     Value& operator[](T&& key)
     {
         auto& obj = _get_or_assign_object();
@@ -951,8 +1218,8 @@ public:
     // Returns a reference to the value with the given key.
     // Or a reference to an 'undefined' value if an element for 'key' does not exist.
     // PRE: is_object()
-    template <typename T, std::enable_if_t< IsTransparentKey<T>::value, int > = 0>
-    Value const& operator[](T&& key) const noexcept
+    template <typename T, std::enable_if_t< !IsKey<T>::value && IsTransparentKey<T>::value, int > = 0>
+    Value const& operator[](T&& key) const
     {
 #if JSON_VALUE_ALLOW_UNDEFINED_ACCESS
         JSON_ASSERT(is_undefined() || is_object());
@@ -1022,12 +1289,16 @@ public:
 
     // Erase the the given key.
     // PRE: is_object()
-    template <typename T, std::enable_if_t< IsTransparentKey<T>::value && !std::is_convertible<T, const_item_iterator>::value, int > = 0>
+    template <typename T, std::enable_if_t< !IsKey<T>::value && IsTransparentKey<T>::value && !std::is_convertible<T, const_item_iterator>::value, int > = 0>
     size_t erase(T&& key)
     {
         return get_object().erase(std::forward<T>(key));
     }
 
+    // Erase the the given key.
+    // PRE: is_object()
+    size_t erase(Key const& key);
+
     // Erase the the given key.
     // PRE: is_object()
     item_iterator erase(const_item_iterator pos);
@@ -1065,12 +1336,12 @@ inline void swap(Value& lhs, Value& rhs) noexcept
     lhs.swap(rhs);
 }
 
-inline bool operator==(Value const& lhs, Value const& rhs) noexcept
+inline bool operator==(Value const& lhs, Value const& rhs)
 {
     return lhs.equal_to(rhs);
 }
 
-inline bool operator!=(Value const& lhs, Value const& rhs) noexcept
+inline bool operator!=(Value const& lhs, Value const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined() || rhs.is_undefined())
@@ -1080,12 +1351,12 @@ inline bool operator!=(Value const& lhs, Value const& rhs) noexcept
     return !(lhs == rhs);
 }
 
-inline bool operator<(Value const& lhs, Value const& rhs) noexcept
+inline bool operator<(Value const& lhs, Value const& rhs)
 {
     return lhs.less_than(rhs);
 }
 
-inline bool operator>=(Value const& lhs, Value const& rhs) noexcept
+inline bool operator>=(Value const& lhs, Value const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined() || rhs.is_undefined())
@@ -1095,7 +1366,7 @@ inline bool operator>=(Value const& lhs, Value const& rhs) noexcept
     return !(lhs < rhs);
 }
 
-inline bool operator>(Value const& lhs, Value const& rhs) noexcept
+inline bool operator>(Value const& lhs, Value const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined() || rhs.is_undefined())
@@ -1105,7 +1376,7 @@ inline bool operator>(Value const& lhs, Value const& rhs) noexcept
     return rhs < lhs;
 }
 
-inline bool operator<=(Value const& lhs, Value const& rhs) noexcept
+inline bool operator<=(Value const& lhs, Value const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined() || rhs.is_undefined())
@@ -1115,33 +1386,40 @@ inline bool operator<=(Value const& lhs, Value const& rhs) noexcept
     return !(rhs < lhs);
 }
 
+// Relocates the strings, arrays and objects in the given value into
+// depth-first order (see Value::clone_compact) and shrinks them to fit.
+// Shared nodes and lazy values are not modified.
+// Returns the (estimated) number of bytes released.
+// NB: Temporarily requires memory for a second copy of the value.
+size_t compact(Value& value);
+
 namespace impl
 {
     template <typename T> bool cmp_eq(Value const& lhs, T const&,     Tag_null   ) noexcept { return lhs.is_null(); }
     template <typename T> bool cmp_eq(Value const& lhs, T const& rhs, Tag_boolean) noexcept { return lhs.type() == Type::boolean && lhs.get_boolean() == rhs; }
     template <typename T> bool cmp_eq(Value const& lhs, T const& rhs, Tag_number ) noexcept { return lhs.type() == Type::number  && lhs.get_number () == rhs; }
     template <typename T> bool cmp_eq(Value const& lhs, T const& rhs, Tag_string ) noexcept { return lhs.type() == Type::string  && lhs.get_string () == rhs; }
-    template <typename T> bool cmp_eq(Value const& lhs, T const& rhs, Tag_array  ) noexcept { return lhs.type() == Type::array   && lhs.get_array  () == rhs; }
-    template <typename T> bool cmp_eq(Value const& lhs, T const& rhs, Tag_object ) noexcept { return lhs.type() == Type::object  && lhs.get_object () == rhs; }
+    template <typename T> bool cmp_eq(Value const& lhs, T const& rhs, Tag_array  ) { return lhs.type() == Type::array   && lhs.get_array  () == rhs; }
+    template <typename T> bool cmp_eq(Value const& lhs, T const& rhs, Tag_object ) { return lhs.type() == Type::object  && lhs.get_object () == rhs; }
 
     template <typename T> bool cmp_lt(Value const& lhs, T const&,     Tag_null   ) noexcept { return lhs.type() < Type::null; } // type < null || (type == null && nullptr < nullptr)
     template <typename T> bool cmp_lt(Value const& lhs, T const& rhs, Tag_boolean) noexcept { return lhs.type() < Type::boolean || (lhs.type() == Type::boolean && lhs.get_boolean() < rhs); }
     template <typename T> bool cmp_lt(Value const& lhs, T const& rhs, Tag_number ) noexcept { return lhs.type() < Type::number  || (lhs.type() == Type::number  && lhs.get_number () < rhs); }
     template <typename T> bool cmp_lt(Value const& lhs, T const& rhs, Tag_string ) noexcept { return lhs.type() < Type::string  || (lhs.type() == Type::string  && lhs.get_string () < rhs); }
-    template <typename T> bool cmp_lt(Value const& lhs, T const& rhs, Tag_array  ) noexcept { return lhs.type() < Type::array   || (lhs.type() == Type::array   && lhs.get_array  () < rhs); }
-    template <typename T> bool cmp_lt(Value const& lhs, T const& rhs, Tag_object ) noexcept { return lhs.type() < Type::object  || (lhs.type() == Type::object  && lhs.get_object () < rhs); }
+    template <typename T> bool cmp_lt(Value const& lhs, T const& rhs, Tag_array  ) { return lhs.type() < Type::array   || (lhs.type() == Type::array   && lhs.get_array  () < rhs); }
+    template <typename T> bool cmp_lt(Value const& lhs, T const& rhs, Tag_object ) { return lhs.type() < Type::object  || (lhs.type() == Type::object  && lhs.get_object () < rhs); }
 
     template <typename T> bool cmp_gt(Value const& lhs, T const&,     Tag_null   ) noexcept { return Type::null    < lhs.type(); } // null < type || (null == type && nullptr < nullptr)
     template <typename T> bool cmp_gt(Value const& lhs, T const& rhs, Tag_boolean) noexcept { return Type::boolean < lhs.type() || (Type::boolean == lhs.type() && rhs < lhs.get_boolean()); }
     template <typename T> bool cmp_gt(Value const& lhs, T const& rhs, Tag_number ) noexcept { return Type::number  < lhs.type() || (Type::number  == lhs.type() && rhs < lhs.get_number ()); }
     template <typename T> bool cmp_gt(Value const& lhs, T const& rhs, Tag_string ) noexcept { return Type::string  < lhs.type() || (Type::string  == lhs.type() && rhs < lhs.get_string ()); }
-    template <typename T> bool cmp_gt(Value const& lhs, T const& rhs, Tag_array  ) noexcept { return Type::array   < lhs.type() || (Type::array   == lhs.type() && rhs < lhs.get_array  ()); }
-    template <typename T> bool cmp_gt(Value const& lhs, T const& rhs, Tag_object ) noexcept { return Type::object  < lhs.type() || (Type::object  == lhs.type() && rhs < lhs.get_object ()); }
+    template <typename T> bool cmp_gt(Value const& lhs, T const& rhs, Tag_array  ) { return Type::array   < lhs.type() || (Type::array   == lhs.type() && rhs < lhs.get_array  ()); }
+    template <typename T> bool cmp_gt(Value const& lhs, T const& rhs, Tag_object ) { return Type::object  < lhs.type() || (Type::object  == lhs.type() && rhs < lhs.get_object ()); }
 }
 
 // Value == T
 template < typename L, typename R, std::enable_if_t< std::is_same<Value, L>::value && !std::is_same<Value, R>::value, int > = 0 >
-bool operator==(L const& lhs, R const& rhs) noexcept
+bool operator==(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined())
@@ -1153,7 +1431,7 @@ bool operator==(L const& lhs, R const& rhs) noexcept
 
 // T == Value
 template < typename L, typename R, std::enable_if_t< !std::is_same<Value, L>::value && std::is_same<Value, R>::value, int > = 1 >
-bool operator==(L const& lhs, R const& rhs) noexcept
+bool operator==(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (rhs.is_undefined())
@@ -1165,7 +1443,7 @@ bool operator==(L const& lhs, R const& rhs) noexcept
 
 // Value != T
 template < typename L, typename R, std::enable_if_t< std::is_same<Value, L>::value && !std::is_same<Value, R>::value, int > = 0 >
-bool operator!=(L const& lhs, R const& rhs) noexcept
+bool operator!=(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined())
@@ -1177,7 +1455,7 @@ bool operator!=(L const& lhs, R const& rhs) noexcept
 
 // T != Value
 template < typename L, typename R, std::enable_if_t< !std::is_same<Value, L>::value && std::is_same<Value, R>::value, int > = 1 >
-bool operator!=(L const& lhs, R const& rhs) noexcept
+bool operator!=(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (rhs.is_undefined())
@@ -1189,7 +1467,7 @@ bool operator!=(L const& lhs, R const& rhs) noexcept
 
 // Value < T
 template < typename L, typename R, std::enable_if_t< std::is_same<Value, L>::value && !std::is_same<Value, R>::value, int > = 0 >
-bool operator<(L const& lhs, R const& rhs) noexcept
+bool operator<(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined())
@@ -1201,7 +1479,7 @@ bool operator<(L const& lhs, R const& rhs) noexcept
 
 // T < Value
 template < typename L, typename R, std::enable_if_t< !std::is_same<Value, L>::value && std::is_same<Value, R>::value, int > = 1 >
-bool operator<(L const& lhs, R const& rhs) noexcept
+bool operator<(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (rhs.is_undefined())
@@ -1213,7 +1491,7 @@ bool operator<(L const& lhs, R const& rhs) noexcept
 
 // Value >= T
 template < typename L, typename R, std::enable_if_t< std::is_same<Value, L>::value && !std::is_same<Value, R>::value, int > = 0 >
-bool operator>=(L const& lhs, R const& rhs) noexcept
+bool operator>=(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined())
@@ -1225,7 +1503,7 @@ bool operator>=(L const& lhs, R const& rhs) noexcept
 
 // T >= Value
 template < typename L, typename R, std::enable_if_t< !std::is_same<Value, L>::value && std::is_same<Value, R>::value, int > = 1 >
-bool operator>=(L const& lhs, R const& rhs) noexcept
+bool operator>=(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (rhs.is_undefined())
@@ -1237,7 +1515,7 @@ bool operator>=(L const& lhs, R const& rhs) noexcept
 
 // Value > T
 template < typename L, typename R, std::enable_if_t< std::is_same<Value, L>::value && !std::is_same<Value, R>::value, int > = 0 >
-bool operator>(L const& lhs, R const& rhs) noexcept
+bool operator>(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined())
@@ -1249,7 +1527,7 @@ bool operator>(L const& lhs, R const& rhs) noexcept
 
 // T > Value
 template < typename L, typename R, std::enable_if_t< !std::is_same<Value, L>::value && std::is_same<Value, R>::value, int > = 1 >
-bool operator>(L const& lhs, R const& rhs) noexcept
+bool operator>(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (rhs.is_undefined())
@@ -1261,7 +1539,7 @@ bool operator>(L const& lhs, R const& rhs) noexcept
 
 // Value <= T
 template < typename L, typename R, std::enable_if_t< std::is_same<Value, L>::value && !std::is_same<Value, R>::value, int > = 0 >
-bool operator<=(L const& lhs, R const& rhs) noexcept
+bool operator<=(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (lhs.is_undefined())
@@ -1273,7 +1551,7 @@ bool operator<=(L const& lhs, R const& rhs) noexcept
 
 // T <= Value
 template < typename L, typename R, std::enable_if_t< !std::is_same<Value, L>::value && std::is_same<Value, R>::value, int > = 1 >
-bool operator<=(L const& lhs, R const& rhs) noexcept
+bool operator<=(L const& lhs, R const& rhs)
 {
 #if JSON_VALUE_UNDEFINED_IS_UNORDERED
     if (rhs.is_undefined())
@@ -1309,6 +1587,43 @@ struct DefaultTraits<char*>
     }
 };
 
+template <typename T>
+inline auto ReserveIfPossible(T& container, size_t n, int /*prefer*/) -> decltype(void(container.reserve(n)))
+{
+    container.reserve(n);
+}
+
+template <typename T>
+inline void ReserveIfPossible(T& /*container*/, size_t /*n*/, long /*fallback*/)
+{
+}
+
+template <typename T>
+inline void ReserveIfPossible(T& container, size_t n)
+{
+    json::impl::ReserveIfPossible(container, n, 0);
+}
+
+inline String const& KeyToString(String const& key)
+{
+    return key;
+}
+
+template <typename K>
+inline String KeyToString(K const& key)
+{
+    return Value(key).to_string();
+}
+
+template <typename T>
+struct IsVectorOfNumbers : std::false_type {};
+
+template <typename T, typename Alloc>
+struct IsVectorOfNumbers<std::vector<T, Alloc>>
+    : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>
+{
+};
+
 #if 1
 template <typename T>
 using IsArray = std::integral_constant<bool,
@@ -1338,13 +1653,38 @@ struct DefaultTraits<T, std::enable_if_t<IsArray<T>::value>>
     static decltype(auto) from_json(V&& in)
     {
         auto&& arr = in.get_array();
+
+        return FromArray<V>(arr, IsVectorOfNumbers<T>{});
+    }
+
+private:
+    // Vectors of numbers are constructed with the final size and filled in-place.
+    template <typename V, typename A>
+    static T FromArray(A& arr, std::true_type /*vector_of_numbers*/)
+    {
+        T out(arr.size());
+
+        auto* p = out.data();
+        for (auto const& v : arr)
+        {
+            *p++ = v.template as<typename T::value_type>();
+        }
+
+        return out;
+    }
+
+    // Elements are moved out of rvalue Values.
+    template <typename V, typename A>
+    static T FromArray(A& arr, std::false_type /*vector_of_numbers*/)
+    {
         auto I = json::impl::safe_make_move_iterator<V>(arr.begin());
         auto E = json::impl::safe_make_move_iterator<V>(arr.end());
 
         T out;
+        json::impl::ReserveIfPossible(out, arr.size());
         for ( ; I != E; ++I)
         {
-            out.emplace(out.end(), I->template as<typename T::value_type>());
+            out.emplace(out.end(), (*I).template as<typename T::value_type>());
         }
 
         return out;
@@ -1376,10 +1716,14 @@ struct DefaultTraits<T, std::enable_if_t<IsObject<T>::value>>
         auto I = json::impl::safe_make_move_iterator<V>(in.begin());
         auto E = json::impl::safe_make_move_iterator<V>(in.end());
 
+        // Keys from ordered containers arrive in order, and inserting at the
+        // end is amortized O(1) then. Assign afterwards to keep the value of
+        // the last member if different keys map to the same string.
         Object out;
         for ( ; I != E; ++I)
         {
-            out[Value(I->first).to_string()] = I->second;
+            auto it = out.emplace_hint(out.end(), json::impl::KeyToString(I->first), Value{});
+            it->second = (*I).second;
         }
 
         return out;
@@ -1393,9 +1737,10 @@ struct DefaultTraits<T, std::enable_if_t<IsObject<T>::value>>
         auto E = json::impl::safe_make_move_iterator<V>(obj.end());
 
         T out;
+        json::impl::ReserveIfPossible(out, obj.size());
         for ( ; I != E; ++I)
         {
-            out.emplace(Value(I->first).to_string(), I->second.template as<typename T::mapped_type>());
+            out.emplace(I->first, (*I).second.template as<typename T::mapped_type>());
         }
 
         return out;
@@ -1482,11 +1827,54 @@ struct TestConversionToJson
 // parse
 //==================================================================================================
 
+struct ParseOptions
+{
+    Mode mode = Mode::strict;
+
+    // If set, this function is called with the key of each object member
+    // before its value is parsed. If it returns true, the value is only
+    // validated and stored as a raw value (Type::raw), which contains the
+    // source text of the value. Stringifying a raw value then just copies the
+    // source text.
+    // NB: In lenient mode, the source text is stored as-is and may contain
+    // comments or other non-standard extensions.
+    std::function<bool(String const& key)> capture_raw;
+
+    // If true, arrays and objects nested inside the top-level value are only
+    // skipped by matching brackets and stored as lazy values, which are
+    // parsed on first access (e.g. through get_object() or operator[]).
+    // This is faster if only a small part of the document is ever accessed.
+    // Lazy values share a copy of the input.
+    // NB: The contents of lazy values are still validated, and parse() fails
+    // if they are invalid. The error position is the end of the invalid
+    // array or object.
+    // NB: Accessing lazy values is not thread-safe, even through const
+    // member functions.
+    // NB: capture_raw is not applied to values inside lazy values.
+    bool lazy = false;
+
+    // If not null, the document is validated against the given schema while
+    // it is parsed, and parse() fails with ParseStatus::schema_violation as
+    // soon as the document is known to be invalid. See json_schema.h.
+    // NB: capture_raw and lazy are ignored if a schema is given.
+    Schema const* schema = nullptr;
+
+    // If true, structurally identical arrays and objects are stored only once,
+    // in shared nodes (see Value::is_shared()). This saves memory for
+    // documents which repeat the same sub-objects many times, and comparing
+    // two values which share a node is O(1).
+    // NB: capture_raw and lazy are ignored if share_duplicates is set, and
+    // share_duplicates is ignored if a schema is given.
+    bool share_duplicates = false;
+};
+
 // Parse the JSON value stored in [NEXT, LAST).
 ParseResult parse(Value& value, char const* next, char const* last, Mode mode = Mode::strict);
+ParseResult parse(Value& value, char const* next, char const* last, ParseOptions const& options);
 
 // Parse the JSON value stored in STR.
 ParseStatus parse(Value& value, std::string const& str, Mode mode = Mode::strict);
+ParseStatus parse(Value& value, std::string const& str, ParseOptions const& options);
 
 //==================================================================================================
 // stringify
@@ -1499,14 +1887,257 @@ struct StringifyOptions
     // If >= 0, pretty-print the JSON.
     // Default is < 0, that is the JSON is rendered as the shortest string possible.
     int8_t indent_width = -1;
+
+    // If true, numbers are rounded to single-precision and printed using the
+    // shortest representation which round-trips as a 'float'.
+    // Use this if the consumer reads numbers as float32 anyway, e.g. for
+    // coordinates or ML feature vectors. This produces considerably shorter
+    // output for most non-integral numbers.
+    bool single_precision = false;
+
+    // If > 1, large arrays and objects are split into chunks, which are
+    // stringified in parallel using up to this many threads and concatenated
+    // afterwards. The output is identical to the serial output.
+    int num_threads = 1;
+
+    // The approximate size of the chunks for parallel stringification, measured
+    // in the number of JSON values (long strings count as multiple values).
+    // Values smaller than twice this size are always stringified serially.
+    size_t parallel_chunk_size = 32 * 1024;
 };
 
+// Buffered output for stringify().
+//
+// Characters are written into a buffer provided by the derived class. If the
+// buffer is full, Overflow() is called, which must write the buffered
+// characters to the final destination and provide a new buffer.
+//
+// Errors are sticky: once Overflow() or Sync() has failed, all subsequent
+// output is discarded and Flush() returns false.
+class OutputSink
+{
+    char* first_ = nullptr;
+    char* next_ = nullptr;
+    char* last_ = nullptr;
+    bool failed_ = false;
+
+public:
+    OutputSink() = default;
+    OutputSink(OutputSink const&) = delete;
+    OutputSink& operator=(OutputSink const&) = delete;
+
+    virtual ~OutputSink();
+
+    void Put(char ch)
+    {
+        if (next_ != last_)
+            *next_++ = ch;
+        else
+            WriteSlow(&ch, 1);
+    }
+
+    void Write(char const* str, size_t len)
+    {
+        if (static_cast<size_t>(last_ - next_) >= len)
+        {
+            std::memcpy(next_, str, len);
+            next_ += len;
+        }
+        else
+        {
+            WriteSlow(str, len);
+        }
+    }
+
+    // Returns a pointer into the buffer, if the buffer has room for at least
+    // LEN characters. Returns nullptr otherwise.
+    // Use Commit() to mark the characters as written.
+    char* TryReserve(size_t len)
+    {
+        return static_cast<size_t>(last_ - next_) >= len ? next_ : nullptr;
+    }
+
+    // Mark the characters in [p, next) as written, where p is the pointer
+    // returned by the last call to TryReserve().
+    void Commit(char* next)
+    {
+        JSON_ASSERT(next_ <= next);
+        JSON_ASSERT(next <= last_);
+        next_ = next;
+    }
+
+    // Write all buffered characters to the final destination.
+    // Returns false if an error occurred since the sink has been created.
+    bool Flush();
+
+    // Returns whether an error occurred.
+    bool Failed() const { return failed_; }
+
+protected:
+    // Set the buffer to [first, last).
+    // The characters in [first, next) are already buffered.
+    void SetBuffer(char* first, char* next, char* last)
+    {
+        JSON_ASSERT(first <= next);
+        JSON_ASSERT(next <= last);
+
+        first_ = first;
+        next_ = next;
+        last_ = last;
+    }
+
+    // Returns a pointer to the start of the buffer.
+    char* BufferFirst() const { return first_; }
+
+    // Returns a pointer past the last buffered character.
+    char* BufferNext() const { return next_; }
+
+    // The buffer does not have enough room for the LEN characters at STR.
+    // Write the characters in [BufferFirst(), BufferNext()) and [STR, STR + LEN)
+    // to the final destination and provide a new buffer using SetBuffer().
+    // Returns false on error.
+    virtual bool Overflow(char const* str, size_t len) = 0;
+
+    // Write the characters in [BufferFirst(), BufferNext()) to the final
+    // destination.
+    // Returns false on error.
+    virtual bool Sync() = 0;
+
+private:
+    void WriteSlow(char const* str, size_t len);
+};
+
+// Appends to a std::string.
+// The string is written in place: the string is resized and its storage is
+// used as the buffer. The contents of the string are only valid after a call
+// to Flush() or after the sink has been destroyed.
+class StringSink : public OutputSink
+{
+    std::string& str_;
+
+public:
+    explicit StringSink(std::string& str);
+    ~StringSink() override;
+
+protected:
+    bool Overflow(char const* str, size_t len) override;
+    bool Sync() override;
+};
+
+// Writes into the pre-allocated range [FIRST, LAST).
+// Fails if the output does not fit into the range.
+class ArraySink : public OutputSink
+{
+public:
+    ArraySink(char* first, char* last);
+
+    // Returns the number of characters written.
+    size_t Size() const { return static_cast<size_t>(BufferNext() - BufferFirst()); }
+
+protected:
+    bool Overflow(char const* str, size_t len) override;
+    bool Sync() override;
+};
+
+// Writes the output in chunks using Output().
+// If a write does not fit into the (fixed size) buffer, the buffer is flushed.
+class BufferedSink : public OutputSink
+{
+    char* buffer_;
+    size_t buffer_size_;
+
+public:
+    BufferedSink(char* buffer, size_t buffer_size);
+
+protected:
+    // Write the LEN characters at STR to the final destination.
+    // Returns false on error.
+    virtual bool Output(char const* str, size_t len) = 0;
+
+    bool Overflow(char const* str, size_t len) override;
+    bool Sync() override;
+};
+
+// Writes the output in chunks into the given buffer and passes the full buffer
+// to the given callback.
+class CallbackSink : public BufferedSink
+{
+    std::function<bool(char const* /*str*/, size_t /*len*/)> output_;
+
+public:
+    CallbackSink(char* buffer, size_t buffer_size, std::function<bool(char const*, size_t)> output);
+    ~CallbackSink() override;
+
+protected:
+    bool Output(char const* str, size_t len) override;
+};
+
+// Writes the output to a C stream.
+class FileSink : public BufferedSink
+{
+    std::FILE* file_;
+    char buffer_[16 * 1024];
+
+public:
+    explicit FileSink(std::FILE* file);
+    ~FileSink() override;
+
+protected:
+    bool Output(char const* str, size_t len) override;
+};
+
+// Writes the output to a file descriptor.
+class FdSink : public BufferedSink
+{
+    int fd_;
+    char buffer_[16 * 1024];
+
+public:
+    explicit FdSink(int fd);
+    ~FdSink() override;
+
+protected:
+    bool Output(char const* str, size_t len) override;
+};
+
+// Writes the output to a C++ stream.
+class StreamSink : public BufferedSink
+{
+    std::ostream& stream_;
+    char buffer_[16 * 1024];
+
+public:
+    explicit StreamSink(std::ostream& stream);
+    ~StreamSink() override;
+
+protected:
+    bool Output(char const* str, size_t len) override;
+};
+
+// Returns the exact number of bytes stringify() would write for the given value.
+// Returns 0 if stringify() would fail, i.e., if the JSON value contains invalid
+// UTF-8 strings and options.mode is strict.
+//
+// NB:
+// Computing the size is about as expensive as stringify() itself, since all
+// numbers need to be formatted and all strings need to be scanned. Use this if
+// the size can be reused, e.g., to stringify the same value multiple times into
+// pre-allocated buffers using an ArraySink.
+size_t stringified_size(Value const& value, StringifyOptions const& options = {});
+
 // Write a stringified version of the given value to str.
 // Returns true if successful.
 // Returns false only if the JSON value contains invalid UTF-8 strings and
 // options.allow_invalid_unicode is false.
 bool stringify(std::string& str, Value const& value, StringifyOptions const& options = {});
 
+// Write a stringified version of the given value to the given sink and flush
+// the sink.
+// Returns true if successful.
+// Returns false if the JSON value contains invalid UTF-8 strings and
+// options.allow_invalid_unicode is false, or if writing to the sink failed.
+bool stringify(OutputSink& sink, Value const& value, StringifyOptions const& options = {});
+
 //==================================================================================================
 // traverse
 //==================================================================================================
@@ -1566,7 +2197,7 @@ namespace std
     template <>
     struct hash< ::json::Value >
     {
-        size_t operator()( ::json::Value const& j ) const noexcept {
+        size_t operator()( ::json::Value const& j ) const {
             return j.hash();
         }
     };
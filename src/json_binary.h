@@ -0,0 +1,221 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json_defs.h"
+#include "json_numbers.h"
+#include "json_strings.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace json {
+namespace impl {
+
+//==================================================================================================
+// Helpers for the binary formats (CBOR, MessagePack)
+//==================================================================================================
+
+inline uint64_t LoadBigEndian(char const* p, int num_bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < num_bytes; ++i)
+    {
+        value = (value << 8) | static_cast<uint8_t>(p[i]);
+    }
+    return value;
+}
+
+// Returns whether [first, last) contains a quote, a backslash or a control
+// character. If NON_ASCII is true, bytes >= 0x80 are reported, too.
+template <bool NonASCII>
+inline bool HasStringSpecial(char const* first, char const* last)
+{
+#if JSON_SSE42
+    __m128i const kQuotes = _mm_set1_epi8('"');
+    __m128i const kBackslashes = _mm_set1_epi8('\\');
+    __m128i const kSpaces = _mm_set1_epi8(' ');
+    __m128i const kControlMask = _mm_set1_epi8(static_cast<char>(0xE0));
+
+    for ( ; last - first >= 16; first += 16)
+    {
+        __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        __m128i const mask1 = _mm_or_si128(_mm_cmpeq_epi8(kQuotes, bytes), _mm_cmpeq_epi8(kBackslashes, bytes));
+        // NB: The (signed) comparison with ' ' also finds bytes >= 0x80.
+        __m128i const mask2 = NonASCII
+            ? _mm_cmpgt_epi8(kSpaces, bytes)
+            : _mm_cmpeq_epi8(_mm_and_si128(kControlMask, bytes), _mm_setzero_si128());
+        if (_mm_movemask_epi8(_mm_or_si128(mask1, mask2)) != 0)
+            return true;
+    }
+#endif
+
+    for ( ; first != last; ++first)
+    {
+        uint8_t const ch = static_cast<uint8_t>(*first);
+        if (ch == '"' || ch == '\\' || ch < 0x20 || (NonASCII && ch >= 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+// Returns whether the string [first, last) may be passed to the callbacks as
+// StringClass::clean, i.e. whether it is valid UTF-8 and does not contain any
+// characters which must be escaped in JSON.
+inline bool IsCleanString(char const* first, char const* last)
+{
+    if (!HasStringSpecial</*NonASCII*/ true>(first, last))
+        return true;
+
+    return !HasStringSpecial</*NonASCII*/ false>(first, last) && IsValidUTF8(first, last);
+}
+
+inline void AppendBase64url(std::string& out, char const* first, char const* last)
+{
+    static constexpr char const kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    for ( ; last - first >= 3; first += 3)
+    {
+        uint32_t const v = uint32_t{static_cast<uint8_t>(first[0])} << 16
+                         | uint32_t{static_cast<uint8_t>(first[1])} << 8
+                         | uint32_t{static_cast<uint8_t>(first[2])};
+        out.push_back(kAlphabet[(v >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(v >> 12) & 0x3F]);
+        out.push_back(kAlphabet[(v >>  6) & 0x3F]);
+        out.push_back(kAlphabet[(v      ) & 0x3F]);
+    }
+
+    // No padding.
+    if (last - first == 1)
+    {
+        uint32_t const v = uint32_t{static_cast<uint8_t>(first[0])} << 16;
+        out.push_back(kAlphabet[(v >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(v >> 12) & 0x3F]);
+    }
+    else if (last - first == 2)
+    {
+        uint32_t const v = uint32_t{static_cast<uint8_t>(first[0])} << 16
+                         | uint32_t{static_cast<uint8_t>(first[1])} << 8;
+        out.push_back(kAlphabet[(v >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(v >> 12) & 0x3F]);
+        out.push_back(kAlphabet[(v >>  6) & 0x3F]);
+    }
+}
+
+// Numbers are passed to HandleDouble(), if the callbacks have such a member
+// function. Otherwise they are converted to strings and passed to HandleNumber().
+template <typename ParseCallbacks, typename /*Enable*/ = void>
+struct HasHandleDouble : std::false_type
+{
+};
+
+template <typename ParseCallbacks>
+struct HasHandleDouble<ParseCallbacks, decltype(void( std::declval<ParseCallbacks&>().HandleDouble(0.0) ))>
+    : std::true_type
+{
+};
+
+template <typename ParseCallbacks>
+inline ParseStatus HandleDouble(ParseCallbacks& cb, double value, std::true_type)
+{
+    return cb.HandleDouble(value);
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus HandleDouble(ParseCallbacks& cb, double value, std::false_type)
+{
+    char buf[32];
+    char* const end = json::numbers::NumberToString(buf, 32, value, /*force_trailing_dot_zero*/ false);
+
+    NumberClass nc;
+    if (std::isnan(value))
+        nc = NumberClass::nan;
+    else if (std::isinf(value))
+        nc = value > 0 ? NumberClass::pos_infinity : NumberClass::neg_infinity;
+    else
+        nc = json::ScanNumber(buf, end).number_class;
+
+    return cb.HandleNumber(buf, end, nc);
+}
+
+// Strings which are valid UTF-8, but contain characters which must be escaped
+// in JSON, are passed to HandleUnescapedString() resp. HandleUnescapedKey(), if
+// the callbacks have such member functions. Otherwise they are escaped and
+// passed to HandleString() resp. HandleKey(), which then unescape them again.
+template <typename ParseCallbacks, typename /*Enable*/ = void>
+struct HasHandleUnescapedString : std::false_type
+{
+};
+
+template <typename ParseCallbacks>
+struct HasHandleUnescapedString<ParseCallbacks, decltype(void( std::declval<ParseCallbacks&>().HandleUnescapedString(nullptr, nullptr) ))>
+    : std::true_type
+{
+};
+
+// Passes the text string [first, last) to the callbacks.
+// SCRATCH is used if the string must be escaped.
+template <typename ParseCallbacks>
+inline ParseStatus HandleText(ParseCallbacks& cb, std::string& scratch, char const* first, char const* last, bool is_key, Mode mode, std::false_type)
+{
+    StringClass sc = StringClass::clean;
+    if (!IsCleanString(first, last))
+    {
+        // The callbacks expect the contents of a JSON string.
+        scratch.clear();
+        auto const res = json::strings::EscapeString(first, last, /*allow_invalid_unicode*/ mode != Mode::strict,
+            [&](char ch) { scratch.push_back(ch); },
+            [&](char const* p, intptr_t n) { scratch.append(p, static_cast<size_t>(n)); });
+        if (res.ec != json::strings::Status::success)
+            return ParseStatus::invalid_string;
+
+        first = scratch.data();
+        last = scratch.data() + scratch.size();
+        sc = StringClass::needs_cleaning;
+    }
+
+    if (is_key)
+        return cb.HandleKey(first, last, sc);
+    else
+        return cb.HandleString(first, last, sc);
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus HandleText(ParseCallbacks& cb, std::string& scratch, char const* first, char const* last, bool is_key, Mode mode, std::true_type)
+{
+    if (!IsCleanString(first, last) && IsValidUTF8(first, last))
+    {
+        if (is_key)
+            return cb.HandleUnescapedKey(first, last);
+        else
+            return cb.HandleUnescapedString(first, last);
+    }
+
+    // Clean or invalid UTF-8.
+    return HandleText(cb, scratch, first, last, is_key, mode, std::false_type{});
+}
+
+} // namespace impl
+} // namespace json
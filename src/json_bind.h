@@ -0,0 +1,925 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+#include "json_numbers.h"
+#include "json_parser.h"
+#include "json_record.h"
+#include "json_strings.h"
+#include "json_writer.h"
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//==================================================================================================
+// Field lists
+//==================================================================================================
+
+// Declares the data members of a plain struct which are bound to the members
+// of a JSON object by json::parse_into() and json::write(). The member names
+// are used as keys.
+//
+//      struct Point { double x; double y; std::string label; };
+//      JSON_FIELDS(Point, x, y, label)
+//
+// Must be used in the namespace of the struct (the field list is found by
+// argument-dependent lookup). At most 32 fields are supported.
+#define JSON_FIELDS(TYPE, ...) \
+    inline auto JsonFields(TYPE*) { return std::make_tuple(JSON_IMPL_FOR_EACH(JSON_IMPL_FIELD, TYPE, __VA_ARGS__)); }
+
+#define JSON_IMPL_FIELD(TYPE, NAME) ::json::impl::MakeField(#NAME, &TYPE::NAME)
+
+#define JSON_IMPL_EXPAND(X) X
+#define JSON_IMPL_CONCAT_(A, B) A##B
+#define JSON_IMPL_CONCAT(A, B) JSON_IMPL_CONCAT_(A, B)
+#define JSON_IMPL_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define JSON_IMPL_NARGS(...) JSON_IMPL_EXPAND(JSON_IMPL_NARGS_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0))
+#define JSON_IMPL_FOR_EACH(M, T, ...) JSON_IMPL_EXPAND(JSON_IMPL_CONCAT(JSON_IMPL_FOR_EACH_, JSON_IMPL_NARGS(__VA_ARGS__))(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_1(M, T, X) M(T, X)
+#define JSON_IMPL_FOR_EACH_2(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_1(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_3(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_2(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_4(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_3(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_5(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_4(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_6(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_5(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_7(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_6(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_8(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_7(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_9(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_8(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_10(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_9(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_11(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_10(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_12(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_11(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_13(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_12(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_14(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_13(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_15(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_14(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_16(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_15(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_17(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_16(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_18(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_17(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_19(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_18(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_20(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_19(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_21(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_20(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_22(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_21(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_23(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_22(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_24(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_23(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_25(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_24(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_26(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_25(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_27(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_26(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_28(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_27(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_29(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_28(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_30(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_29(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_31(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_30(M, T, __VA_ARGS__))
+#define JSON_IMPL_FOR_EACH_32(M, T, X, ...) M(T, X), JSON_IMPL_EXPAND(JSON_IMPL_FOR_EACH_31(M, T, __VA_ARGS__))
+
+namespace json {
+
+namespace impl {
+
+template <typename T, typename M>
+struct Field
+{
+    char const* name;
+    size_t name_size;
+    M T::*member;
+};
+
+template <typename T, typename M, size_t N>
+constexpr Field<T, M> MakeField(char const (&name)[N], M T::*member)
+{
+    return {name, N - 1, member};
+}
+
+//==================================================================================================
+// BindReader
+//==================================================================================================
+
+// Reads JSON text token by token, for parse_into().
+class BindReader
+{
+    static constexpr uint32_t kMaxDepth = 500;
+
+    Lexer lexer;
+    Mode mode;
+    uint32_t depth = 0;
+    String key; // the current key, if it needs to be unescaped
+
+public:
+    BindReader(char const* next, char const* last, Mode mode_)
+        : mode(mode_)
+    {
+        lexer.SetInput(next, last);
+    }
+
+    char const* Next() const { return lexer.Next(); }
+
+    TokenKind Peek() { return lexer.Peek(mode); }
+
+    // Returns the status for a value of the wrong type.
+    ParseStatus Mismatch()
+    {
+        switch (Peek())
+        {
+        case TokenKind::l_brace:
+        case TokenKind::l_square:
+        case TokenKind::string:
+        case TokenKind::number:
+        case TokenKind::identifier:
+            return ParseStatus::schema_violation;
+        default:
+            return ParseStatus::expected_value;
+        }
+    }
+
+    ParseStatus ReadNull()
+    {
+        if (Peek() != TokenKind::identifier)
+            return Mismatch();
+
+        Token const curr = lexer.LexIdentifier();
+        if (IsIdentifier(curr, "null", 4))
+            return ParseStatus::success;
+
+        return CheckIdentifier(curr);
+    }
+
+    ParseStatus ReadBoolean(bool& out)
+    {
+        if (Peek() != TokenKind::identifier)
+            return Mismatch();
+
+        Token const curr = lexer.LexIdentifier();
+        if (IsIdentifier(curr, "true", 4))
+        {
+            out = true;
+            return ParseStatus::success;
+        }
+        if (IsIdentifier(curr, "false", 5))
+        {
+            out = false;
+            return ParseStatus::success;
+        }
+
+        return CheckIdentifier(curr);
+    }
+
+    ParseStatus ReadNumber(double& out)
+    {
+        NumberClass nc;
+        Token curr;
+
+        auto const peek = Peek();
+        if (peek == TokenKind::number)
+        {
+            curr = lexer.LexNumber();
+            nc = curr.number_class;
+        }
+        else if (peek == TokenKind::identifier)
+        {
+            curr = lexer.LexIdentifier();
+            if (IsIdentifier(curr, "NaN", 3))
+                nc = NumberClass::nan;
+            else if (IsIdentifier(curr, "Infinity", 8))
+                nc = NumberClass::pos_infinity;
+            else
+                return CheckIdentifier(curr);
+        }
+        else
+        {
+            return Mismatch();
+        }
+
+        if (nc == NumberClass::invalid)
+            return ParseStatus::invalid_number;
+        if (mode == Mode::strict && !IsFinite(nc))
+            return ParseStatus::invalid_number;
+
+        out = numbers::StringToNumber(curr.ptr, curr.end, nc);
+        return ParseStatus::success;
+    }
+
+    ParseStatus ReadString(String& out)
+    {
+        if (Peek() != TokenKind::string)
+            return Mismatch();
+
+        Token const curr = lexer.LexString();
+        if (curr.kind == TokenKind::incomplete_string)
+            return ParseStatus::expected_value;
+
+        if (!Unescape(out, curr.ptr + 1, curr.end - 1, curr.string_class))
+            return ParseStatus::invalid_string;
+
+        return ParseStatus::success;
+    }
+
+    // Calls READ_ELEMENT() for each element of an array.
+    template <typename ReadElement>
+    ParseStatus ReadArray(ReadElement read_element)
+    {
+        if (Peek() != TokenKind::l_square)
+            return Mismatch();
+        if (depth >= kMaxDepth)
+            return ParseStatus::max_depth_reached;
+
+        ++depth;
+        lexer.Skip(TokenKind::l_square);
+
+        auto peek = Peek();
+        if (peek != TokenKind::r_square)
+        {
+            for (;;)
+            {
+                if (Failed ec = read_element())
+                    return ParseStatus(ec);
+
+                peek = Peek();
+                if (peek != TokenKind::comma)
+                    break;
+
+                lexer.Skip(TokenKind::comma);
+
+                peek = Peek();
+                if (mode != Mode::strict && peek == TokenKind::r_square)
+                    break;
+            }
+
+            if (peek != TokenKind::r_square)
+                return ParseStatus::expected_comma_or_closing_bracket;
+        }
+
+        lexer.Skip(TokenKind::r_square);
+        --depth;
+        return ParseStatus::success;
+    }
+
+    // Calls READ_MEMBER(key, len) for each member of an object.
+    // The key is only valid until the value has been read.
+    template <typename ReadMember>
+    ParseStatus ReadObject(ReadMember read_member)
+    {
+        if (Peek() != TokenKind::l_brace)
+            return Mismatch();
+        if (depth >= kMaxDepth)
+            return ParseStatus::max_depth_reached;
+
+        ++depth;
+        lexer.Skip(TokenKind::l_brace);
+
+        auto peek = Peek();
+        if (peek != TokenKind::r_brace)
+        {
+            for (;;)
+            {
+                Token curr;
+                if (peek == TokenKind::string)
+                {
+                    curr = lexer.LexString();
+                    if (curr.kind == TokenKind::incomplete_string)
+                        return ParseStatus::expected_key;
+
+                    ++curr.ptr;
+                    --curr.end;
+                }
+                else if (mode != Mode::strict && peek == TokenKind::identifier)
+                {
+                    curr = lexer.LexIdentifier();
+                }
+                else
+                {
+                    return ParseStatus::expected_key;
+                }
+
+                char const* first = curr.ptr;
+                char const* last = curr.end;
+                if (curr.string_class != StringClass::clean)
+                {
+                    if (!Unescape(key, first, last, curr.string_class))
+                        return ParseStatus::invalid_string;
+                    first = key.data();
+                    last = key.data() + key.size();
+                }
+
+                if (Peek() != TokenKind::colon)
+                    return ParseStatus::expected_colon_after_key;
+
+                lexer.Skip(TokenKind::colon);
+
+                if (Failed ec = read_member(first, static_cast<size_t>(last - first)))
+                    return ParseStatus(ec);
+
+                peek = Peek();
+                if (peek != TokenKind::comma)
+                    break;
+
+                lexer.Skip(TokenKind::comma);
+
+                peek = Peek();
+                if (mode != Mode::strict && peek == TokenKind::r_brace)
+                    break;
+            }
+
+            if (peek != TokenKind::r_brace)
+                return ParseStatus::expected_comma_or_closing_brace;
+        }
+
+        lexer.Skip(TokenKind::r_brace);
+        --depth;
+        return ParseStatus::success;
+    }
+
+    // Validates and skips the next value.
+    ParseStatus SkipValue()
+    {
+        switch (Peek())
+        {
+        case TokenKind::l_brace:
+            return ReadObject([&](char const* /*key*/, size_t /*len*/) { return SkipValue(); });
+        case TokenKind::l_square:
+            return ReadArray([&] { return SkipValue(); });
+        case TokenKind::string:
+            {
+                Token const curr = lexer.LexString();
+                if (curr.kind == TokenKind::incomplete_string)
+                    return ParseStatus::expected_value;
+                if (curr.string_class != StringClass::clean && !Unescape(key, curr.ptr + 1, curr.end - 1, curr.string_class))
+                    return ParseStatus::invalid_string;
+                return ParseStatus::success;
+            }
+        case TokenKind::number:
+            {
+                double unused;
+                return ReadNumber(unused);
+            }
+        case TokenKind::identifier:
+            {
+                Token const curr = lexer.LexIdentifier();
+                if (IsIdentifier(curr, "null", 4) || IsIdentifier(curr, "true", 4) || IsIdentifier(curr, "false", 5))
+                    return ParseStatus::success;
+                if (IsIdentifier(curr, "NaN", 3) || IsIdentifier(curr, "Infinity", 8))
+                    return mode == Mode::strict ? ParseStatus::invalid_number : ParseStatus::success;
+                return ParseStatus::unrecognized_identifier;
+            }
+        default:
+            return ParseStatus::expected_value;
+        }
+    }
+
+    // Parses the next value into a Value.
+    ParseStatus ReadValue(Value& out)
+    {
+        Peek();
+
+        char const* const first = lexer.Next();
+        if (Failed ec = SkipValue())
+            return ParseStatus(ec);
+
+        return json::parse(out, first, lexer.Next(), mode).ec;
+    }
+
+private:
+    static bool IsIdentifier(Token const& curr, char const* name, size_t len)
+    {
+        return static_cast<size_t>(curr.end - curr.ptr) == len && std::memcmp(curr.ptr, name, len) == 0;
+    }
+
+    static ParseStatus CheckIdentifier(Token const& curr)
+    {
+        if (IsIdentifier(curr, "null", 4)
+            || IsIdentifier(curr, "true", 4)
+            || IsIdentifier(curr, "false", 5)
+            || IsIdentifier(curr, "NaN", 3)
+            || IsIdentifier(curr, "Infinity", 8))
+        {
+            return ParseStatus::schema_violation;
+        }
+        return ParseStatus::unrecognized_identifier;
+    }
+
+    bool Unescape(String& out, char const* first, char const* last, StringClass string_class)
+    {
+        if (string_class == StringClass::clean)
+        {
+            out.assign(first, last);
+            return true;
+        }
+
+        out.clear();
+        auto const res = strings::UnescapeString(first, last, /*allow_invalid_unicode*/ mode != Mode::strict,
+            [&](char ch) { out.push_back(ch); },
+            [&](char const* p, intptr_t n) { out.append(p, static_cast<size_t>(n)); });
+        return res.ec == strings::Status::success;
+    }
+};
+
+//==================================================================================================
+// Binder
+//==================================================================================================
+
+template <typename T>
+using UsesDefaultTraits = std::is_base_of<DefaultTraits<T>, Traits<T>>;
+
+template <typename T, typename /*Enable*/ = void>
+struct HasFields : std::false_type
+{
+};
+
+template <typename T>
+struct HasFields<T, decltype(void( JsonFields(static_cast<T*>(nullptr)) ))> : std::true_type
+{
+};
+
+// Array-like types: elements are appended using emplace(end(), element).
+template <typename T, typename /*Enable*/ = void>
+struct IsBindArray : std::false_type
+{
+};
+
+template <typename T>
+struct IsBindArray<T, decltype(void( std::declval<T&>().emplace(std::declval<T&>().end(), std::declval<typename T::value_type>()) ))>
+    : std::true_type
+{
+};
+
+// Object-like types: members are inserted using emplace(key, value).
+// Keys are written using Traits<key_type>::to_json, but must be constructible
+// from String for reading.
+template <typename T, typename /*Enable*/ = void>
+struct IsBindObject : std::false_type
+{
+};
+
+template <typename T>
+struct IsBindObject<T, decltype(void( std::declval<T&>().emplace(std::declval<typename T::key_type>(), std::declval<typename T::mapped_type>()) ))>
+    : std::true_type
+{
+};
+
+template <typename T>
+struct IsVector : std::false_type
+{
+};
+
+template <typename T, typename Alloc>
+struct IsVector<std::vector<T, Alloc>> : std::integral_constant<bool, !std::is_same<T, bool>::value>
+{
+};
+
+enum class BindKind {
+    fields,     // JSON_FIELDS
+    null,
+    boolean,
+    number,     // arithmetic types
+    string,
+    value,
+    vector,     // std::vector: elements are constructed in place
+    array,      // other array-like types
+    object,     // map-like types
+    traits,     // Traits<T>::from_json
+};
+
+template <typename T>
+constexpr BindKind GetBindKind()
+{
+    if (HasFields<T>::value)
+        return BindKind::fields;
+    if (std::is_same<T, Value>::value)
+        return BindKind::value;
+    if (!UsesDefaultTraits<T>::value)
+        return BindKind::traits;
+    if (std::is_same<T, std::nullptr_t>::value)
+        return BindKind::null;
+    if (std::is_same<T, bool>::value)
+        return BindKind::boolean;
+    if (std::is_arithmetic<T>::value)
+        return BindKind::number;
+    if (std::is_same<T, String>::value)
+        return BindKind::string;
+    if (IsVector<T>::value)
+        return BindKind::vector;
+    if (IsBindObject<T>::value)
+        return BindKind::object;
+    if (IsBindArray<T>::value)
+        return BindKind::array;
+    return BindKind::traits;
+}
+
+template <typename T, BindKind Kind = GetBindKind<T>()>
+struct Binder;
+
+template <typename T>
+inline ParseStatus BindRead(BindReader& r, T& out)
+{
+    return Binder<T>::Read(r, out);
+}
+
+// Passed to DefaultTraits<T>::from_json in place of a Value.
+struct BindNumber
+{
+    double value;
+    double get_number() const { return value; }
+};
+
+template <typename T>
+struct Binder<T, BindKind::null>
+{
+    static ParseStatus Read(BindReader& r, T& /*out*/)
+    {
+        return r.ReadNull();
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::boolean>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        return r.ReadBoolean(out);
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::number>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        double value;
+        if (Failed ec = r.ReadNumber(value))
+            return ParseStatus(ec);
+
+        out = static_cast<T>(TraitsFor<T>::from_json(BindNumber{value}));
+        return ParseStatus::success;
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::string>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        return r.ReadString(out);
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::value>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        return r.ReadValue(out);
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::vector>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        out.clear();
+        return r.ReadArray([&] {
+            out.emplace_back();
+            return BindRead(r, out.back());
+        });
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::array>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        out.clear();
+        return r.ReadArray([&]() -> ParseStatus {
+            typename T::value_type element{};
+            if (Failed ec = BindRead(r, element))
+                return ParseStatus(ec);
+            out.emplace(out.end(), std::move(element));
+            return ParseStatus::success;
+        });
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::object>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        static_assert(std::is_constructible<typename T::key_type, String>::value,
+            "parse_into: object keys must be constructible from String");
+
+        out.clear();
+        return r.ReadObject([&](char const* key, size_t len) -> ParseStatus {
+            String k(key, len);
+            typename T::mapped_type value{};
+            if (Failed ec = BindRead(r, value))
+                return ParseStatus(ec);
+            out.emplace(std::move(k), std::move(value));
+            return ParseStatus::success;
+        });
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::traits>
+{
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        Value value;
+        if (Failed ec = r.ReadValue(value))
+            return ParseStatus(ec);
+
+        out = std::move(value).template as<T>();
+        return ParseStatus::success;
+    }
+};
+
+template <typename T>
+struct Binder<T, BindKind::fields>
+{
+    using FieldList = decltype(JsonFields(static_cast<T*>(nullptr)));
+    using Indices = std::make_index_sequence<std::tuple_size<FieldList>::value>;
+    using ReadField = ParseStatus (*)(BindReader& r, T& out);
+
+    template <size_t I>
+    static ParseStatus ReadFieldAt(BindReader& r, T& out)
+    {
+        return BindRead(r, out.*(std::get<I>(JsonFields(static_cast<T*>(nullptr))).member));
+    }
+
+    template <size_t... Is>
+    static KeyIndex MakeKeyIndex(std::index_sequence<Is...>)
+    {
+        auto const fields = JsonFields(static_cast<T*>(nullptr));
+        return KeyIndex(std::vector<String>{String(std::get<Is>(fields).name, std::get<Is>(fields).name_size)...});
+    }
+
+    template <size_t... Is>
+    static ParseStatus Dispatch(BindReader& r, T& out, uint32_t slot, std::index_sequence<Is...>)
+    {
+        static constexpr ReadField const kReadFields[] = {&ReadFieldAt<Is>...};
+        return kReadFields[slot](r, out);
+    }
+
+    static ParseStatus Read(BindReader& r, T& out)
+    {
+        // Maps keys to field indices.
+        static KeyIndex const index = MakeKeyIndex(Indices{});
+
+        return r.ReadObject([&](char const* key, size_t len) {
+            uint32_t const slot = index.find(key, len);
+            if (slot == KeyIndex::kNone)
+                return r.SkipValue();
+            return Dispatch(r, out, slot, Indices{});
+        });
+    }
+};
+
+//==================================================================================================
+// BindWriter
+//==================================================================================================
+
+template <typename T, BindKind Kind = GetBindKind<T>()>
+struct BindWriter;
+
+template <typename T, typename Sink>
+inline bool BindWrite(Writer<Sink>& w, T const& in)
+{
+    return BindWriter<T>::Write(w, in);
+}
+
+template <typename Sink>
+inline bool BindWriteKey(Writer<Sink>& w, String const& key)
+{
+    return w.key(key);
+}
+
+template <typename Sink, typename K>
+inline bool BindWriteKey(Writer<Sink>& w, K const& key)
+{
+    Value const k(key);
+    return k.is_string() ? w.key(k.get_string()) : w.key(k.to_string());
+}
+
+template <typename T>
+struct BindWriter<T, BindKind::null>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& /*in*/)
+    {
+        return w.null();
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::boolean>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        return w.boolean(in);
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::number>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        return w.number(static_cast<double>(TraitsFor<T>::to_json(in)));
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::string>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        return w.string(in);
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::value>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        return w.value(in);
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::vector>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        if (!w.begin_array())
+            return false;
+        for (auto const& element : in)
+        {
+            if (!BindWrite(w, element))
+                return false;
+        }
+        return w.end_array();
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::array> : BindWriter<T, BindKind::vector>
+{
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::object>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        if (!w.begin_object())
+            return false;
+        for (auto const& kv : in)
+        {
+            if (!BindWriteKey(w, kv.first))
+                return false;
+            if (!BindWrite(w, kv.second))
+                return false;
+        }
+        return w.end_object();
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::traits>
+{
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        return w.value(Value(in));
+    }
+};
+
+template <typename T>
+struct BindWriter<T, BindKind::fields>
+{
+    template <typename Sink, typename Fields, size_t... Is>
+    static bool WriteFields(Writer<Sink>& w, T const& in, Fields const& fields, std::index_sequence<Is...>)
+    {
+        bool success = true;
+        // Evaluated in order.
+        bool const unused[] = {(success = success && w.key(std::get<Is>(fields).name, std::get<Is>(fields).name_size) && BindWrite(w, in.*(std::get<Is>(fields).member)))...};
+        static_cast<void>(unused);
+        return success;
+    }
+
+    template <typename Sink>
+    static bool Write(Writer<Sink>& w, T const& in)
+    {
+        auto const fields = JsonFields(static_cast<T*>(nullptr));
+
+        if (!w.begin_object())
+            return false;
+        if (!WriteFields(w, in, fields, std::make_index_sequence<std::tuple_size<decltype(fields)>::value>{}))
+            return false;
+        return w.end_object();
+    }
+};
+
+} // namespace impl
+
+//==================================================================================================
+// parse_into
+//==================================================================================================
+
+// Parse the JSON text stored in [NEXT, LAST) directly into OUT, without
+// building a Value.
+//
+// Supported types:
+//      structs with a JSON_FIELDS declaration (unknown keys are skipped and
+//          fields whose keys are missing are left unchanged),
+//      bool, arithmetic types, String, std::nullptr_t, Value,
+//      array-like and object-like containers (these are cleared first).
+// Other types are parsed into a Value and converted using Traits<T>::from_json.
+//
+// Returns ParseStatus::schema_violation if a JSON value does not have the
+// type required by the corresponding C++ object. OUT is partially updated
+// if parsing fails.
+template <typename T>
+ParseResult parse_into(T& out, char const* next, char const* last, Mode mode = Mode::strict)
+{
+    JSON_ASSERT(next != nullptr);
+    JSON_ASSERT(last != nullptr);
+
+    impl::BindReader r(next, last, mode);
+
+    ParseStatus ec = impl::BindRead(r, out);
+    if (ec == ParseStatus::success && r.Peek() != TokenKind::eof)
+        ec = ParseStatus::expected_eof;
+
+    return {r.Next(), ec};
+}
+
+template <typename T>
+ParseStatus parse_into(T& out, std::string const& str, Mode mode = Mode::strict)
+{
+    char const* next = str.data();
+    char const* last = str.data() + str.size();
+
+    return json::parse_into(out, next, last, mode).ec;
+}
+
+//==================================================================================================
+// write
+//==================================================================================================
+
+// Write IN as JSON to the given sink, without building a Value.
+// The sink is not flushed. See Writer for the requirements on SINK.
+//
+// Supports the same types as parse_into(). Types with their own Traits
+// specialization are converted into a Value using Traits<T>::to_json first.
+// The output is formatted as by stringify() using the same options, but
+// options.num_threads is ignored.
+//
+// Returns false if a string contains invalid UTF-8 and options.mode is
+// strict, or if the maximum nesting depth is exceeded. The output is invalid
+// in this case.
+template <typename Sink, typename T>
+bool write(Sink& sink, T const& in, StringifyOptions const& options = {})
+{
+    Writer<Sink> w(sink, options);
+    return impl::BindWrite(w, in);
+}
+
+// Write a stringified version of IN to STR, without building a Value.
+// See write().
+template <typename T>
+bool stringify(std::string& str, T const& in, StringifyOptions const& options = {})
+{
+    StringSink sink(str);
+    bool const success = json::write(sink, in, options);
+    sink.Flush();
+    return success;
+}
+
+} // namespace json
@@ -0,0 +1,501 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "json.h"
+#include "json_binary.h"
+#include "json_parser.h"
+#include "json_strings.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace json {
+namespace cbor {
+
+//==================================================================================================
+// CBOR
+//==================================================================================================
+
+// Concise Binary Object Representation (RFC 8949).
+//
+// Values are encoded as:
+//      undefined   -> undefined (simple value 23)
+//      null        -> null
+//      boolean     -> false/true
+//      number      -> unsigned/negative integer, if the number is an integer
+//                     in the range (-2^64, 2^64),
+//                     otherwise single-precision float, if exact,
+//                     otherwise double-precision float
+//      string      -> text string
+//      array       -> array
+//      object      -> map with text string keys
+//      raw         -> the JSON text is converted, arrays and objects are
+//                     encoded with indefinite length
+//
+// Decoding accepts all well-formed CBOR with text string map keys:
+//      integers, floats (including half-precision) -> number
+//      byte strings                                -> string (base64url encoded, RFC 8949, 6.1)
+//      tags                                        -> ignored, the tagged item is decoded
+//      undefined and other simple values           -> null
+//
+// Errors:
+//      ParseStatus::expected_value     malformed or truncated data item
+//      ParseStatus::expected_eof       trailing bytes after the data item
+//      ParseStatus::invalid_key        map key is not a text string
+//      ParseStatus::invalid_string     invalid UTF-8 in strict mode
+//      ParseStatus::invalid_number     NaN or Infinity in strict mode (decode only)
+//      ParseStatus::max_depth_reached  arrays or maps nested too deeply
+
+// Encode the given value and append the result to the given sink resp. string.
+// Returns false if a string contains invalid UTF-8 and mode is strict.
+bool encode(OutputSink& sink, Value const& value, Mode mode = Mode::strict);
+bool encode(std::string& str, Value const& value, Mode mode = Mode::strict);
+
+// Decode the CBOR data item stored in [NEXT, LAST).
+ParseResult decode(Value& value, char const* next, char const* last, Mode mode = Mode::strict);
+
+// Decode the CBOR data item stored in STR.
+ParseStatus decode(Value& value, std::string const& str, Mode mode = Mode::strict);
+
+//==================================================================================================
+// Decoder
+//==================================================================================================
+
+namespace impl {
+
+inline double DecodeHalf(uint16_t bits)
+{
+    int const exponent = (bits >> 10) & 0x1F;
+    int const mantissa = bits & 0x3FF;
+
+    double value;
+    if (exponent == 0)
+        value = std::ldexp(mantissa, -24);
+    else if (exponent != 31)
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    else
+        value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+
+    return (bits & 0x8000) != 0 ? -value : value;
+}
+
+} // namespace impl
+
+// Decodes CBOR and calls the ParseCallbacks, just like the JSON parser.
+// See json_parser.h. Additionally, the callbacks may implement
+//      ParseStatus HandleDouble(double value);
+// to receive numbers without converting them to strings, and
+//      ParseStatus HandleUnescapedString(char const* first, char const* last);
+//      ParseStatus HandleUnescapedKey(char const* first, char const* last);
+// to receive valid UTF-8 strings which contain quotes, backslashes or control
+// characters as is, instead of escaping them first.
+//
+// NB: Strings passed to the callbacks do not necessarily point into the input.
+template <typename ParseCallbacks>
+class Decoder
+{
+    static constexpr uint32_t kMaxDepth = 500;
+
+    ParseCallbacks& cb;
+    Mode mode;
+    char const* ptr = nullptr;
+    char const* end = nullptr;
+    std::string chunks; // indefinite-length strings and byte strings
+    std::string escaped;
+
+public:
+    Decoder(ParseCallbacks& cb_, Mode mode_);
+
+    void Init(char const* next, char const* last);
+
+    // Decode the next data item from the input
+    // and check whether EOF has been reached.
+    ParseResult Decode();
+
+    // Decode the next data item from the input.
+    ParseStatus DecodeValue();
+
+private:
+    ParseStatus ReadHead(uint8_t& major, uint8_t& info, uint64_t& arg);
+    ParseStatus ReadString(uint8_t major, uint8_t info, uint64_t arg, char const*& first, char const*& last);
+    ParseStatus DecodeKey();
+    ParseStatus DecodeText(uint8_t info, uint64_t arg, bool is_key);
+    ParseStatus DecodeBytes(uint8_t info, uint64_t arg);
+    ParseStatus DecodeSimple(uint8_t info, uint64_t arg);
+};
+
+template <typename ParseCallbacks>
+inline Decoder<ParseCallbacks>::Decoder(ParseCallbacks& cb_, Mode mode_)
+    : cb(cb_)
+    , mode(mode_)
+{
+}
+
+template <typename ParseCallbacks>
+inline void Decoder<ParseCallbacks>::Init(char const* next, char const* last)
+{
+    ptr = next;
+    end = last;
+}
+
+template <typename ParseCallbacks>
+inline ParseResult Decoder<ParseCallbacks>::Decode()
+{
+    ParseStatus ec = DecodeValue();
+
+    if (ec == ParseStatus::success)
+    {
+        if (ptr != end)
+        {
+            ec = ParseStatus::expected_eof;
+        }
+    }
+
+    return {ptr, ec};
+}
+
+template <typename ParseCallbacks>
+JSON_NEVER_INLINE ParseStatus Decoder<ParseCallbacks>::DecodeValue()
+{
+    struct StackElement {
+        uint64_t remaining; // number of remaining items, for definite-length arrays and maps
+        size_t count;       // number of elements or members in the current array resp. map
+        bool is_map;
+        bool indefinite;
+    };
+
+    uint32_t stack_size = 0;
+    StackElement stack[kMaxDepth];
+
+    for (;;)
+    {
+        if (stack_size != 0)
+        {
+            auto& top = stack[stack_size - 1];
+
+            // Check for the end of the current array or map.
+            bool at_end;
+            if (top.indefinite)
+            {
+                if (ptr == end)
+                    return ParseStatus::expected_value;
+
+                at_end = static_cast<uint8_t>(*ptr) == 0xFF; // "break"
+                if (at_end)
+                    ++ptr;
+            }
+            else
+            {
+                at_end = top.remaining == 0;
+                if (!at_end)
+                    --top.remaining;
+            }
+
+            if (at_end)
+            {
+                --stack_size;
+
+                if (top.is_map)
+                {
+                    if (Failed ec = cb.HandleEndObject(top.count))
+                        return ParseStatus(ec);
+                }
+                else
+                {
+                    if (Failed ec = cb.HandleEndArray(top.count))
+                        return ParseStatus(ec);
+                }
+
+                goto L_end_value;
+            }
+
+            if (top.is_map)
+            {
+                if (Failed ec = DecodeKey())
+                    return ParseStatus(ec);
+            }
+        }
+
+        {
+            uint8_t major;
+            uint8_t info;
+            uint64_t arg;
+
+            // Tags are ignored.
+            do
+            {
+                if (Failed ec = ReadHead(major, info, arg))
+                    return ParseStatus(ec);
+            }
+            while (major == 6);
+
+            ParseStatus ec;
+            switch (major)
+            {
+            case 0: // unsigned integer
+                ec = json::impl::HandleDouble(cb, static_cast<double>(arg), json::impl::HasHandleDouble<ParseCallbacks>{});
+                break;
+            case 1: // negative integer
+                ec = json::impl::HandleDouble(cb, -1.0 - static_cast<double>(arg), json::impl::HasHandleDouble<ParseCallbacks>{});
+                break;
+            case 2: // byte string
+                ec = DecodeBytes(info, arg);
+                break;
+            case 3: // text string
+                ec = DecodeText(info, arg, /*is_key*/ false);
+                break;
+            case 4: // array
+            case 5: // map
+                if (stack_size >= kMaxDepth)
+                    return ParseStatus::max_depth_reached;
+
+                // Each item is at least 1 byte long.
+                if (info != 31 && arg > static_cast<uint64_t>(end - ptr))
+                    return ParseStatus::expected_value;
+
+                // NB: For maps, REMAINING counts the members.
+                // Keys are decoded along with their values.
+                stack[stack_size] = {arg, 0, major == 5, info == 31};
+                ++stack_size;
+
+                if (major == 5)
+                    ec = cb.HandleBeginObject();
+                else
+                    ec = cb.HandleBeginArray();
+
+                if (ec != ParseStatus::success)
+                    return ec;
+                continue;
+            default: // simple values and floats
+                ec = DecodeSimple(info, arg);
+                break;
+            }
+
+            if (ec != ParseStatus::success)
+                return ec;
+        }
+
+L_end_value:
+        if (stack_size == 0)
+            return ParseStatus::success;
+
+        auto& top = stack[stack_size - 1];
+        ++top.count;
+
+        if (top.is_map)
+        {
+            if (Failed ec = cb.HandleEndMember(top.count))
+                return ParseStatus(ec);
+        }
+        else
+        {
+            if (Failed ec = cb.HandleEndElement(top.count))
+                return ParseStatus(ec);
+        }
+    }
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::ReadHead(uint8_t& major, uint8_t& info, uint64_t& arg)
+{
+    if (ptr == end)
+        return ParseStatus::expected_value;
+
+    uint8_t const initial_byte = static_cast<uint8_t>(*ptr);
+    ++ptr;
+
+    major = static_cast<uint8_t>(initial_byte >> 5);
+    info = static_cast<uint8_t>(initial_byte & 0x1F);
+
+    if (info < 24)
+    {
+        arg = info;
+    }
+    else if (info <= 27)
+    {
+        int const num_bytes = 1 << (info - 24);
+        if (end - ptr < num_bytes)
+            return ParseStatus::expected_value;
+
+        arg = json::impl::LoadBigEndian(ptr, num_bytes);
+        ptr += num_bytes;
+    }
+    else if (info == 31 && (major == 2 || major == 3 || major == 4 || major == 5))
+    {
+        arg = 0; // indefinite length
+    }
+    else
+    {
+        // Reserved, or "break" outside of an indefinite-length item.
+        return ParseStatus::expected_value;
+    }
+
+    return ParseStatus::success;
+}
+
+// Read the definite- or indefinite-length string with the given head.
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::ReadString(uint8_t major, uint8_t info, uint64_t arg, char const*& first, char const*& last)
+{
+    if (info != 31)
+    {
+        if (arg > static_cast<uint64_t>(end - ptr))
+            return ParseStatus::expected_value;
+
+        first = ptr;
+        ptr += static_cast<size_t>(arg);
+        last = ptr;
+        return ParseStatus::success;
+    }
+
+    // Indefinite length: concatenate the chunks, which must be definite-length
+    // strings of the same major type.
+    chunks.clear();
+    for (;;)
+    {
+        if (ptr == end)
+            return ParseStatus::expected_value;
+
+        if (static_cast<uint8_t>(*ptr) == 0xFF)
+        {
+            ++ptr;
+            break;
+        }
+
+        uint8_t chunk_major;
+        uint8_t chunk_info;
+        uint64_t chunk_len;
+        if (Failed ec = ReadHead(chunk_major, chunk_info, chunk_len))
+            return ParseStatus(ec);
+
+        if (chunk_major != major || chunk_info == 31 || chunk_len > static_cast<uint64_t>(end - ptr))
+            return ParseStatus::expected_value;
+
+        chunks.append(ptr, static_cast<size_t>(chunk_len));
+        ptr += static_cast<size_t>(chunk_len);
+    }
+
+    first = chunks.data();
+    last = chunks.data() + chunks.size();
+    return ParseStatus::success;
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::DecodeKey()
+{
+    uint8_t major;
+    uint8_t info;
+    uint64_t arg;
+
+    // Tags are ignored.
+    do
+    {
+        if (Failed ec = ReadHead(major, info, arg))
+            return ParseStatus(ec);
+    }
+    while (major == 6);
+
+    if (major != 3)
+        return ParseStatus::invalid_key;
+
+    return DecodeText(info, arg, /*is_key*/ true);
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::DecodeText(uint8_t info, uint64_t arg, bool is_key)
+{
+    char const* first;
+    char const* last;
+    if (Failed ec = ReadString(3, info, arg, first, last))
+        return ParseStatus(ec);
+
+    return json::impl::HandleText(cb, escaped, first, last, is_key, mode, json::impl::HasHandleUnescapedString<ParseCallbacks>{});
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::DecodeBytes(uint8_t info, uint64_t arg)
+{
+    char const* first;
+    char const* last;
+    if (Failed ec = ReadString(2, info, arg, first, last))
+        return ParseStatus(ec);
+
+    escaped.clear();
+    json::impl::AppendBase64url(escaped, first, last);
+
+    return cb.HandleString(escaped.data(), escaped.data() + escaped.size(), StringClass::clean);
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::DecodeSimple(uint8_t info, uint64_t arg)
+{
+    using has_handle_double = json::impl::HasHandleDouble<ParseCallbacks>;
+
+    switch (info)
+    {
+    case 20:
+        return cb.HandleFalse();
+    case 21:
+        return cb.HandleTrue();
+    case 25:
+        return json::impl::HandleDouble(cb, impl::DecodeHalf(static_cast<uint16_t>(arg)), has_handle_double{});
+    case 26:
+        {
+            uint32_t const bits = static_cast<uint32_t>(arg);
+            float f;
+            std::memcpy(&f, &bits, sizeof(float));
+            return json::impl::HandleDouble(cb, static_cast<double>(f), has_handle_double{});
+        }
+    case 27:
+        {
+            double d;
+            std::memcpy(&d, &arg, sizeof(double));
+            return json::impl::HandleDouble(cb, d, has_handle_double{});
+        }
+    default:
+        // null, undefined and all other simple values.
+        return cb.HandleNull();
+    }
+}
+
+//==================================================================================================
+// DecodeSAX
+//==================================================================================================
+
+template <typename ParseCallbacks>
+inline ParseResult DecodeSAX(ParseCallbacks& cb, char const* next, char const* last, Mode mode)
+{
+    JSON_ASSERT(next != nullptr);
+    JSON_ASSERT(last != nullptr);
+
+    Decoder<ParseCallbacks> decoder(cb, mode);
+
+    decoder.Init(next, last);
+
+    return decoder.Decode();
+}
+
+} // namespace cbor
+} // namespace json
@@ -54,6 +54,29 @@
 
 namespace json {
 
+//==================================================================================================
+// Bit operations
+//==================================================================================================
+
+namespace impl {
+
+#if JSON_SSE42
+inline int CountTrailingZeros(int bits)
+{
+    JSON_ASSERT(bits != 0);
+
+#if _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, static_cast<unsigned long>(bits));
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(static_cast<unsigned>(bits));
+#endif
+}
+#endif
+
+} // namespace impl
+
 //==================================================================================================
 // ScanNumber
 //==================================================================================================
@@ -194,10 +217,212 @@ inline ScanNumberResult ScanNumber(char const* next, char const* last)
 //==================================================================================================
 
 enum class StringClass : uint8_t {
-    clean, // => is ASCII (TODO: => is UTF-8)
+    clean, // => is valid UTF-8 and does not contain escape sequences or control characters
     needs_cleaning,
 };
 
+namespace impl {
+
+#if JSON_SSE42
+// Range checks for validating UTF-8 in blocks of 16 bytes.
+//
+// Based on:
+// Daniel Lemire, Kendall Willets,
+//  "Validating UTF-8 strings using as little as 0.7 cycles per byte"
+//
+// https://lemire.me/blog/2018/05/16/validating-utf-8-strings-using-as-little-as-0-7-cycles-per-byte/
+// https://github.com/lemire/fastvalidate-utf-8
+//
+// Legal UTF-8 byte sequences
+// http://www.unicode.org/versions/Unicode6.0.0/ch03.pdf - page 94
+//
+//  Code Points        1st       2s       3s       4s
+// U+0000..U+007F     00..7F
+// U+0080..U+07FF     C2..DF   80..BF
+// U+0800..U+0FFF     E0       A0..BF   80..BF
+// U+1000..U+CFFF     E1..EC   80..BF   80..BF
+// U+D000..U+D7FF     ED       80..9F   80..BF
+// U+E000..U+FFFF     EE..EF   80..BF   80..BF
+// U+10000..U+3FFFF   F0       90..BF   80..BF   80..BF
+// U+40000..U+FFFFF   F1..F3   80..BF   80..BF   80..BF
+// U+100000..U+10FFFF F4       80..8F   80..BF   80..BF
+
+struct UTF8Block {
+    __m128i bytes;
+    __m128i high_nibbles;
+    __m128i carried_continuations;
+};
+
+inline __m128i UTF8Byte(int b)
+{
+    return _mm_set1_epi8(static_cast<char>(b));
+}
+
+// Returns the bytes of [prev, curr] shifted right by 1 byte.
+inline __m128i UTF8PrevBytes1(__m128i prev, __m128i curr)
+{
+    return _mm_alignr_epi8(curr, prev, 15);
+}
+
+// Returns the bytes of [prev, curr] shifted right by 2 bytes.
+inline __m128i UTF8PrevBytes2(__m128i prev, __m128i curr)
+{
+    return _mm_alignr_epi8(curr, prev, 14);
+}
+
+inline UTF8Block ValidateUTF8Block(__m128i bytes, UTF8Block const& prev, __m128i& has_error)
+{
+    UTF8Block curr;
+    curr.bytes = bytes;
+    curr.high_nibbles = _mm_and_si128(_mm_srli_epi16(bytes, 4), UTF8Byte(0x0F));
+
+    // All bytes must be <= 0xF4.
+    // (unsigned, saturates to 0 below max)
+    has_error = _mm_or_si128(has_error, _mm_subs_epu8(bytes, UTF8Byte(0xF4)));
+
+    // Number of bytes in the sequence started by each byte.
+    // Continuation bytes have length 0.
+    __m128i const initial_lengths = _mm_shuffle_epi8(
+        _mm_setr_epi8(1, 1, 1, 1, 1, 1, 1, 1, // 0xxx (ASCII)
+                      0, 0, 0, 0,             // 10xx (continuation)
+                      2, 2,                   // 110x
+                      3,                      // 1110
+                      4),                     // 1111, next should be 0 (not checked here)
+        curr.high_nibbles);
+
+    // Carry the sequence lengths over the following bytes.
+    __m128i const right1 = _mm_subs_epu8(UTF8PrevBytes1(prev.carried_continuations, initial_lengths), UTF8Byte(1));
+    __m128i const sum = _mm_add_epi8(initial_lengths, right1);
+    __m128i const right2 = _mm_subs_epu8(UTF8PrevBytes2(prev.carried_continuations, sum), UTF8Byte(2));
+    curr.carried_continuations = _mm_add_epi8(sum, right2);
+
+    // Overlap or underlap:
+    // (carries > length) == (length > 0)
+    __m128i const overunder = _mm_cmpeq_epi8(
+        _mm_cmpgt_epi8(curr.carried_continuations, initial_lengths),
+        _mm_cmpgt_epi8(initial_lengths, _mm_setzero_si128()));
+    has_error = _mm_or_si128(has_error, overunder);
+
+    // When 0xED is found, the next byte must be <= 0x9F.
+    // When 0xF4 is found, the next byte must be <= 0x8F.
+    // The next byte must be a continuation byte, i.e., the sign bit is set, so signed < is ok.
+    __m128i const off1_bytes = UTF8PrevBytes1(prev.bytes, bytes);
+    __m128i const maskED = _mm_cmpeq_epi8(off1_bytes, UTF8Byte(0xED));
+    __m128i const maskF4 = _mm_cmpeq_epi8(off1_bytes, UTF8Byte(0xF4));
+    __m128i const badfollowED = _mm_and_si128(_mm_cmpgt_epi8(bytes, UTF8Byte(0x9F)), maskED);
+    __m128i const badfollowF4 = _mm_and_si128(_mm_cmpgt_epi8(bytes, UTF8Byte(0x8F)), maskF4);
+    has_error = _mm_or_si128(has_error, _mm_or_si128(badfollowED, badfollowF4));
+
+    // Overlong sequences:
+    //  hibits  off1        curr
+    //  C    => < C2     && true
+    //  E    => < E1     && < A0
+    //  F    => < F1     && < 90
+    //  else    false    && false
+    __m128i const off1_high_nibbles = UTF8PrevBytes1(prev.high_nibbles, curr.high_nibbles);
+    __m128i const initial_mins = _mm_shuffle_epi8(
+        _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128,
+                      -128, -128, -128, -128,             // 10xx => false
+                      static_cast<char>(0xC2), -128,      // 110x
+                      static_cast<char>(0xE1),            // 1110
+                      static_cast<char>(0xF1)),           // 1111
+        off1_high_nibbles);
+    __m128i const initial_under = _mm_cmpgt_epi8(initial_mins, off1_bytes);
+    __m128i const second_mins = _mm_shuffle_epi8(
+        _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128,
+                      -128, -128, -128, -128,             // 10xx => false
+                      127, 127,                           // 110x => true
+                      static_cast<char>(0xA0),            // 1110
+                      static_cast<char>(0x90)),           // 1111
+        off1_high_nibbles);
+    __m128i const second_under = _mm_cmpgt_epi8(second_mins, bytes);
+    has_error = _mm_or_si128(has_error, _mm_and_si128(initial_under, second_under));
+
+    return curr;
+}
+#endif
+
+// Returns whether [next, last) is a sequence of valid UTF-8 encoded code points.
+inline bool IsValidUTF8(char const* next, char const* last)
+{
+#if JSON_SSE42
+    UTF8Block prev = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+    __m128i has_error = _mm_setzero_si128();
+
+    for ( ; last - next >= 16; next += 16)
+    {
+        __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(next));
+        prev = ValidateUTF8Block(bytes, prev, has_error);
+    }
+
+    if (next != last)
+    {
+        char buf[16] = {0};
+        std::memcpy(buf, next, static_cast<size_t>(last - next));
+        prev = ValidateUTF8Block(_mm_loadu_si128(reinterpret_cast<__m128i const*>(buf)), prev, has_error);
+    }
+
+    // Check for incomplete sequences at the end of the input.
+    ValidateUTF8Block(_mm_setzero_si128(), prev, has_error);
+
+    return _mm_testz_si128(has_error, has_error) != 0;
+#else
+    while (next != last)
+    {
+        uint32_t const b1 = static_cast<uint8_t>(*next);
+        ++next;
+        if (b1 <= 0x7F)
+            continue;
+
+        // Determine the number of continuation bytes and the valid range of the
+        // second byte.
+        int len;
+        uint32_t lo = 0x80;
+        uint32_t hi = 0xBF;
+        if (b1 <= 0xC1)
+            return false;
+        else if (b1 <= 0xDF)
+            len = 1;
+        else if (b1 <= 0xEF)
+        {
+            len = 2;
+            if (b1 == 0xE0)
+                lo = 0xA0;
+            else if (b1 == 0xED)
+                hi = 0x9F;
+        }
+        else if (b1 <= 0xF4)
+        {
+            len = 3;
+            if (b1 == 0xF0)
+                lo = 0x90;
+            else if (b1 == 0xF4)
+                hi = 0x8F;
+        }
+        else
+            return false;
+
+        if (last - next < len)
+            return false;
+
+        uint32_t const b2 = static_cast<uint8_t>(*next);
+        if (b2 < lo || b2 > hi)
+            return false;
+        ++next;
+
+        for (int i = 1; i < len; ++i, ++next)
+        {
+            if ((static_cast<uint8_t>(*next) & 0xC0) != 0x80)
+                return false;
+        }
+    }
+
+    return true;
+#endif
+}
+
+} // namespace impl
+
 //==================================================================================================
 // Lexer
 //==================================================================================================
@@ -249,6 +474,7 @@ enum class ParseStatus : uint8_t {
     invalid_number,
     invalid_string,
     max_depth_reached,
+    schema_violation,
     unknown,
     unrecognized_identifier,
 };
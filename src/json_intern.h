@@ -0,0 +1,183 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "json.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace json {
+
+//==================================================================================================
+// StringPool
+//==================================================================================================
+
+class StringPool;
+
+namespace impl {
+
+// An interned string. Entries are immutable and live as long as their pool.
+// The characters (plus a terminating null character) follow the header.
+struct InternedEntry
+{
+    uint64_t hash;
+    size_t size;
+
+    char const* data() const noexcept { return reinterpret_cast<char const*>(this + 1); }
+};
+
+} // namespace impl
+
+// A handle to a string in a StringPool.
+//
+// Handles from the same pool are equal if and only if the strings are equal,
+// so comparing two handles is a pointer comparison. A default constructed
+// handle does not refer to any string; its data() is an empty string.
+//
+// Handles are only valid as long as their pool exists.
+class InternedString
+{
+    friend class StringPool;
+
+    impl::InternedEntry const* entry_ = nullptr;
+
+    explicit InternedString(impl::InternedEntry const* entry) noexcept : entry_(entry) {}
+
+public:
+    InternedString() = default;
+
+    // Returns whether this handle refers to a string.
+    explicit operator bool() const noexcept { return entry_ != nullptr; }
+
+    char const* data() const noexcept { return entry_ != nullptr ? entry_->data() : ""; }
+    size_t size() const noexcept { return entry_ != nullptr ? entry_->size : 0; }
+    bool empty() const noexcept { return size() == 0; }
+
+    // Returns impl::KeyHash(data(), size()).
+    uint64_t hash() const noexcept { return entry_ != nullptr ? entry_->hash : impl::KeyHash("", 0); }
+
+    String str() const { return String(data(), size()); }
+
+    friend bool operator==(InternedString lhs, InternedString rhs) noexcept { return lhs.entry_ == rhs.entry_; }
+    friend bool operator!=(InternedString lhs, InternedString rhs) noexcept { return lhs.entry_ != rhs.entry_; }
+};
+
+struct StringPoolOptions
+{
+    // Strings longer than this are not interned. Long strings rarely repeat.
+    size_t max_length = 256;
+
+    // The maximum number of strings in the pool.
+    size_t max_strings = 1u << 20;
+
+    // The maximum number of bytes used by the strings in the pool (without
+    // the hash tables).
+    size_t max_bytes = size_t{64} << 20;
+};
+
+// A thread-safe table of unique, immutable strings.
+//
+// Lookups of strings which are already in the pool do not lock and do not
+// write to shared memory. Inserts lock one of several shards, which are
+// selected by the hash of the string.
+//
+// Strings are never removed individually, so that handles stay valid without
+// reference counting. Instead, the pool is bounded: once a limit from the
+// StringPoolOptions is reached, intern() returns a null handle for new
+// strings, and callers should fall back to ordinary strings. To evict all
+// strings, destroy the pool (or call clear()) after all handles are gone.
+class StringPool
+{
+    static constexpr size_t kNumShards = 16;
+
+    struct Table;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::atomic<Table*> table{nullptr};
+        std::vector<Table*> retired; // previous tables, which might still be read
+        size_t count = 0;
+    };
+
+    StringPoolOptions options_;
+    std::atomic<size_t> num_strings_{0};
+    std::atomic<size_t> num_bytes_{0};
+    Shard shards_[kNumShards];
+
+public:
+    explicit StringPool(StringPoolOptions const& options = {});
+    ~StringPool();
+
+    StringPool(StringPool const&) = delete;
+    StringPool& operator=(StringPool const&) = delete;
+
+    // Returns the process-wide pool, which uses the default options.
+    static StringPool& global();
+
+    // Returns a handle to the string [STR, STR + LEN), which is inserted into
+    // the pool if necessary. Returns a null handle if the string is not in the
+    // pool and cannot be inserted because of the limits in the options.
+    InternedString intern(char const* str, size_t len);
+    InternedString intern(String const& str) { return intern(str.data(), str.size()); }
+
+    // Returns a handle to the string [STR, STR + LEN), or a null handle if the
+    // string is not in the pool. Never locks.
+    InternedString find(char const* str, size_t len) const noexcept;
+    InternedString find(String const& str) const noexcept { return find(str.data(), str.size()); }
+
+    // Returns the number of strings in the pool.
+    size_t size() const noexcept { return num_strings_.load(std::memory_order_relaxed); }
+
+    // Returns the number of bytes used by the strings in the pool.
+    size_t bytes() const noexcept { return num_bytes_.load(std::memory_order_relaxed); }
+
+    // Removes all strings from the pool.
+    // PRE: No other thread uses the pool, and no handles are used afterwards.
+    void clear() noexcept;
+
+private:
+    static impl::InternedEntry const* Find(Table const* table, char const* str, size_t len, uint64_t hash) noexcept;
+    impl::InternedEntry const* Insert(Shard& shard, char const* str, size_t len, uint64_t hash);
+    bool Reserve(size_t bytes) noexcept;
+};
+
+} // namespace json
+
+namespace std {
+
+template <>
+struct hash<::json::InternedString>
+{
+    size_t operator()(::json::InternedString const& str) const noexcept
+    {
+        return static_cast<size_t>(str.hash());
+    }
+};
+
+} // namespace std
@@ -0,0 +1,464 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "json.h"
+#include "json_binary.h"
+#include "json_parser.h"
+#include "json_strings.h"
+
+#include <cstring>
+#include <string>
+
+namespace json {
+namespace msgpack {
+
+//==================================================================================================
+// MessagePack
+//==================================================================================================
+
+// MessagePack (https://github.com/msgpack/msgpack/blob/master/spec.md).
+//
+// Values are encoded as:
+//      undefined, null -> nil
+//      boolean         -> false/true
+//      number          -> int or uint, if the number is an integer in the range [-2^63, 2^64),
+//                         otherwise float 32, if exact,
+//                         otherwise float 64
+//      string          -> str
+//      array           -> array
+//      object          -> map with str keys
+//      raw             -> the JSON text is parsed and the result is encoded
+//
+// Decoding accepts all well-formed MessagePack with str map keys:
+//      int, uint, float    -> number
+//      bin, ext            -> string (base64url encoded payload, the ext type is ignored)
+//
+// Errors:
+//      ParseStatus::expected_value     malformed or truncated object
+//      ParseStatus::expected_eof       trailing bytes after the object
+//      ParseStatus::invalid_key        map key is not a str
+//      ParseStatus::invalid_string     invalid UTF-8 in strict mode
+//      ParseStatus::invalid_number     NaN or Infinity in strict mode (decode only)
+//      ParseStatus::max_depth_reached  arrays or maps nested too deeply
+
+// Encode the given value and append the result to the given sink resp. string.
+// Returns false if a string contains invalid UTF-8 and mode is strict, or if a
+// raw value could not be parsed.
+bool encode(OutputSink& sink, Value const& value, Mode mode = Mode::strict);
+bool encode(std::string& str, Value const& value, Mode mode = Mode::strict);
+
+// Decode the MessagePack object stored in [NEXT, LAST).
+ParseResult decode(Value& value, char const* next, char const* last, Mode mode = Mode::strict);
+
+// Decode the MessagePack object stored in STR.
+ParseStatus decode(Value& value, std::string const& str, Mode mode = Mode::strict);
+
+//==================================================================================================
+// Decoder
+//==================================================================================================
+
+// Decodes MessagePack and calls the ParseCallbacks, just like the JSON parser.
+// See json_parser.h. Additionally, the callbacks may implement
+//      ParseStatus HandleDouble(double value);
+// to receive numbers without converting them to strings, and
+//      ParseStatus HandleUnescapedString(char const* first, char const* last);
+//      ParseStatus HandleUnescapedKey(char const* first, char const* last);
+// to receive valid UTF-8 strings which contain quotes, backslashes or control
+// characters as is, instead of escaping them first.
+//
+// Strings are passed to the callbacks as pointers into the input, unless
+// they contain characters which must be escaped in JSON and the callbacks do
+// not implement the functions above (or the string is invalid UTF-8), in which
+// case they are escaped into a temporary buffer first, and the callbacks must
+// unescape them again. bin and ext payloads are always converted to base64url.
+template <typename ParseCallbacks>
+class Decoder
+{
+    static constexpr uint32_t kMaxDepth = 500;
+
+    ParseCallbacks& cb;
+    Mode mode;
+    char const* ptr = nullptr;
+    char const* end = nullptr;
+    std::string scratch;
+
+public:
+    Decoder(ParseCallbacks& cb_, Mode mode_);
+
+    void Init(char const* next, char const* last);
+
+    // Decode the next object from the input
+    // and check whether EOF has been reached.
+    ParseResult Decode();
+
+    // Decode the next object from the input.
+    ParseStatus DecodeValue();
+
+private:
+    ParseStatus ReadLength(int num_bytes, uint64_t& len);
+    ParseStatus DecodeNumber(uint8_t type);
+    ParseStatus DecodeString(uint64_t len, bool is_key);
+    ParseStatus DecodeBinary(uint64_t len);
+};
+
+template <typename ParseCallbacks>
+inline Decoder<ParseCallbacks>::Decoder(ParseCallbacks& cb_, Mode mode_)
+    : cb(cb_)
+    , mode(mode_)
+{
+}
+
+template <typename ParseCallbacks>
+inline void Decoder<ParseCallbacks>::Init(char const* next, char const* last)
+{
+    ptr = next;
+    end = last;
+}
+
+template <typename ParseCallbacks>
+inline ParseResult Decoder<ParseCallbacks>::Decode()
+{
+    ParseStatus ec = DecodeValue();
+
+    if (ec == ParseStatus::success)
+    {
+        if (ptr != end)
+        {
+            ec = ParseStatus::expected_eof;
+        }
+    }
+
+    return {ptr, ec};
+}
+
+template <typename ParseCallbacks>
+JSON_NEVER_INLINE ParseStatus Decoder<ParseCallbacks>::DecodeValue()
+{
+    struct StackElement {
+        uint64_t remaining; // number of remaining elements resp. members
+        size_t count;       // number of elements or members in the current array resp. map
+        bool is_map;
+    };
+
+    uint32_t stack_size = 0;
+    StackElement stack[kMaxDepth];
+
+    for (;;)
+    {
+        if (stack_size != 0)
+        {
+            auto& top = stack[stack_size - 1];
+
+            if (top.remaining == 0)
+            {
+                --stack_size;
+
+                if (top.is_map)
+                {
+                    if (Failed ec = cb.HandleEndObject(top.count))
+                        return ParseStatus(ec);
+                }
+                else
+                {
+                    if (Failed ec = cb.HandleEndArray(top.count))
+                        return ParseStatus(ec);
+                }
+
+                goto L_end_value;
+            }
+
+            --top.remaining;
+
+            if (top.is_map)
+            {
+                if (ptr == end)
+                    return ParseStatus::expected_value;
+
+                uint8_t const type = static_cast<uint8_t>(*ptr);
+                ++ptr;
+
+                uint64_t len;
+                if (type >= 0xA0 && type <= 0xBF)
+                    len = type & 0x1Fu;
+                else if (type >= 0xD9 && type <= 0xDB)
+                {
+                    if (Failed ec = ReadLength(1 << (type - 0xD9), len))
+                        return ParseStatus(ec);
+                }
+                else
+                    return ParseStatus::invalid_key;
+
+                if (Failed ec = DecodeString(len, /*is_key*/ true))
+                    return ParseStatus(ec);
+            }
+        }
+
+        {
+            if (ptr == end)
+                return ParseStatus::expected_value;
+
+            uint8_t const type = static_cast<uint8_t>(*ptr);
+            ++ptr;
+
+            uint64_t len = 0;
+            bool is_map = false;
+
+            ParseStatus ec;
+            switch (type)
+            {
+            case 0xC0:
+                ec = cb.HandleNull();
+                break;
+            case 0xC2:
+                ec = cb.HandleFalse();
+                break;
+            case 0xC3:
+                ec = cb.HandleTrue();
+                break;
+            case 0xC4: // bin 8
+            case 0xC5: // bin 16
+            case 0xC6: // bin 32
+                ec = ReadLength(1 << (type - 0xC4), len);
+                if (ec == ParseStatus::success)
+                    ec = DecodeBinary(len);
+                break;
+            case 0xC7: // ext 8
+            case 0xC8: // ext 16
+            case 0xC9: // ext 32
+                ec = ReadLength(1 << (type - 0xC7), len);
+                if (ec == ParseStatus::success)
+                {
+                    if (ptr == end)
+                        return ParseStatus::expected_value;
+                    ++ptr; // Skip the ext type.
+                    ec = DecodeBinary(len);
+                }
+                break;
+            case 0xD4: // fixext 1
+            case 0xD5: // fixext 2
+            case 0xD6: // fixext 4
+            case 0xD7: // fixext 8
+            case 0xD8: // fixext 16
+                if (ptr == end)
+                    return ParseStatus::expected_value;
+                ++ptr; // Skip the ext type.
+                ec = DecodeBinary(uint64_t{1} << (type - 0xD4));
+                break;
+            case 0xD9: // str 8
+            case 0xDA: // str 16
+            case 0xDB: // str 32
+                ec = ReadLength(1 << (type - 0xD9), len);
+                if (ec == ParseStatus::success)
+                    ec = DecodeString(len, /*is_key*/ false);
+                break;
+            case 0xDC: // array 16
+            case 0xDD: // array 32
+                if (Failed ec1 = ReadLength(2 << (type - 0xDC), len))
+                    return ParseStatus(ec1);
+                goto L_begin_container;
+            case 0xDE: // map 16
+            case 0xDF: // map 32
+                if (Failed ec1 = ReadLength(2 << (type - 0xDE), len))
+                    return ParseStatus(ec1);
+                is_map = true;
+                goto L_begin_container;
+            case 0xC1: // never used
+                return ParseStatus::expected_value;
+            default:
+                if (type <= 0x7F || type >= 0xE0 || (type >= 0xCA && type <= 0xD3))
+                {
+                    ec = DecodeNumber(type);
+                }
+                else if (type <= 0x8F) // fixmap
+                {
+                    len = type & 0x0Fu;
+                    is_map = true;
+                    goto L_begin_container;
+                }
+                else if (type <= 0x9F) // fixarray
+                {
+                    len = type & 0x0Fu;
+                    goto L_begin_container;
+                }
+                else // fixstr
+                {
+                    ec = DecodeString(type & 0x1Fu, /*is_key*/ false);
+                }
+                break;
+            }
+
+            if (ec != ParseStatus::success)
+                return ec;
+            goto L_end_value;
+
+L_begin_container:
+            if (stack_size >= kMaxDepth)
+                return ParseStatus::max_depth_reached;
+
+            // Each element resp. member is at least 1 byte long.
+            if (len > static_cast<uint64_t>(end - ptr))
+                return ParseStatus::expected_value;
+
+            stack[stack_size] = {len, 0, is_map};
+            ++stack_size;
+
+            if (is_map)
+                ec = cb.HandleBeginObject();
+            else
+                ec = cb.HandleBeginArray();
+
+            if (ec != ParseStatus::success)
+                return ec;
+            continue;
+        }
+
+L_end_value:
+        if (stack_size == 0)
+            return ParseStatus::success;
+
+        auto& top = stack[stack_size - 1];
+        ++top.count;
+
+        if (top.is_map)
+        {
+            if (Failed ec = cb.HandleEndMember(top.count))
+                return ParseStatus(ec);
+        }
+        else
+        {
+            if (Failed ec = cb.HandleEndElement(top.count))
+                return ParseStatus(ec);
+        }
+    }
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::ReadLength(int num_bytes, uint64_t& len)
+{
+    if (end - ptr < num_bytes)
+        return ParseStatus::expected_value;
+
+    len = json::impl::LoadBigEndian(ptr, num_bytes);
+    ptr += num_bytes;
+    return ParseStatus::success;
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::DecodeNumber(uint8_t type)
+{
+    using has_handle_double = json::impl::HasHandleDouble<ParseCallbacks>;
+
+    if (type <= 0x7F) // positive fixint
+        return json::impl::HandleDouble(cb, static_cast<double>(type), has_handle_double{});
+    if (type >= 0xE0) // negative fixint
+        return json::impl::HandleDouble(cb, static_cast<double>(static_cast<int8_t>(type)), has_handle_double{});
+
+    static constexpr int8_t kNumBytes[] = {
+        4, 8,       // float 32, float 64
+        1, 2, 4, 8, // uint 8, 16, 32, 64
+        1, 2, 4, 8, // int 8, 16, 32, 64
+    };
+
+    JSON_ASSERT(type >= 0xCA && type <= 0xD3);
+    int const num_bytes = kNumBytes[type - 0xCA];
+
+    if (end - ptr < num_bytes)
+        return ParseStatus::expected_value;
+
+    uint64_t const bits = json::impl::LoadBigEndian(ptr, num_bytes);
+    ptr += num_bytes;
+
+    double value;
+    if (type == 0xCA)
+    {
+        uint32_t const f_bits = static_cast<uint32_t>(bits);
+        float f;
+        std::memcpy(&f, &f_bits, sizeof(float));
+        value = static_cast<double>(f);
+    }
+    else if (type == 0xCB)
+    {
+        std::memcpy(&value, &bits, sizeof(double));
+    }
+    else if (type <= 0xCF)
+    {
+        value = static_cast<double>(bits);
+    }
+    else
+    {
+        // Sign-extend.
+        int const shift = 64 - 8 * num_bytes;
+        value = static_cast<double>(static_cast<int64_t>(bits << shift) >> shift);
+    }
+
+    return json::impl::HandleDouble(cb, value, has_handle_double{});
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::DecodeString(uint64_t len, bool is_key)
+{
+    if (len > static_cast<uint64_t>(end - ptr))
+        return ParseStatus::expected_value;
+
+    char const* first = ptr;
+    char const* last = ptr + len;
+    ptr = last;
+
+    return json::impl::HandleText(cb, scratch, first, last, is_key, mode, json::impl::HasHandleUnescapedString<ParseCallbacks>{});
+}
+
+template <typename ParseCallbacks>
+inline ParseStatus Decoder<ParseCallbacks>::DecodeBinary(uint64_t len)
+{
+    if (len > static_cast<uint64_t>(end - ptr))
+        return ParseStatus::expected_value;
+
+    char const* first = ptr;
+    char const* last = ptr + len;
+    ptr = last;
+
+    scratch.clear();
+    json::impl::AppendBase64url(scratch, first, last);
+
+    return cb.HandleString(scratch.data(), scratch.data() + scratch.size(), StringClass::clean);
+}
+
+//==================================================================================================
+// DecodeSAX
+//==================================================================================================
+
+template <typename ParseCallbacks>
+inline ParseResult DecodeSAX(ParseCallbacks& cb, char const* next, char const* last, Mode mode)
+{
+    JSON_ASSERT(next != nullptr);
+    JSON_ASSERT(last != nullptr);
+
+    Decoder<ParseCallbacks> decoder(cb, mode);
+
+    decoder.Init(next, last);
+
+    return decoder.Decode();
+}
+
+} // namespace msgpack
+} // namespace json
@@ -354,5 +354,21 @@ inline int64_t DoubleToInt53(double x, bool& is_int53)
     return i;
 }
 
+// Returns the single-precision number nearest to x (ties-to-even).
+// Like Math.fround, values which are too large in magnitude are converted to
+// +-Infinity.
+inline float ToSingle(double x)
+{
+    // Any |x| >= 2^128 - 2^103 is rounded to infinity.
+    constexpr double kInfinityThreshold = 340282356779733661637539395458142568448.0;
+
+    if (x >= kInfinityThreshold)
+        return +std::numeric_limits<float>::infinity();
+    if (x <= -kInfinityThreshold)
+        return -std::numeric_limits<float>::infinity();
+
+    return static_cast<float>(x);
+}
+
 } // namespace numbers
 } // namespace json
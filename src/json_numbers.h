@@ -311,6 +311,22 @@ inline char* FormatScientific(char* buffer, intptr_t num_digits, int exponent, b
     return buffer;
 }
 
+// Print the decimal number 'digits * 10^decimal_exponent'.
+// Values in the range [10^-6, 10^21) are printed in fixed-point notation.
+// All other values will be printed in scientific notation.
+// This is what JavaScript does.
+inline char* FormatDecimal(char* buffer, uint64_t digits, int decimal_exponent, bool force_trailing_dot_zero)
+{
+    int const num_digits = PrintDecimalDigits(buffer, digits);
+    int const decimal_point = num_digits + decimal_exponent;
+    int const scientific_exponent = decimal_point - 1;
+
+    if (-6 <= scientific_exponent && scientific_exponent < 21)
+        return FormatFixed(buffer, num_digits, decimal_point, force_trailing_dot_zero);
+    else
+        return FormatScientific(buffer, num_digits, scientific_exponent, /*force_trailing_dot_zero*/ false);
+}
+
 } // namespace impl
 } // namespace json
 
@@ -389,29 +405,83 @@ JSON_NEVER_INLINE char* NumberToString(char* buffer, int buffer_length, double v
         decimal_exponent = res.exponent;
     }
 
-    // Convert the digits to decimal.
-    int const num_digits = json::impl::PrintDecimalDigits(buffer, digits);
-
     if (is_small_int)
     {
         // Done.
         // Never append a trailing ".0" in this case.
-        return buffer + num_digits;
+        return buffer + json::impl::PrintDecimalDigits(buffer, digits);
     }
     else
     {
-        // Print values in the range [10^-6, 10^21) in fixed-point notation.
-        // All other values will be printed in scientific notation.
-        // This is what JavaScript does and it is consistent with the integer formatting above (2^53 < 10^17).
+        // This is consistent with the integer formatting above (2^53 < 10^17).
+        return json::impl::FormatDecimal(buffer, digits, decimal_exponent, force_trailing_dot_zero);
+    }
+}
+
+// Convert the single-precision number `value` to a decimal floating-point
+// number.
+// The result is the shortest decimal representation which round-trips as a
+// single-precision number, and is formatted like NumberToString.
+// The buffer must be large enough! (size >= 32 is sufficient.)
+JSON_NEVER_INLINE char* FloatToString(char* buffer, int buffer_length, float value, bool force_trailing_dot_zero = true)
+{
+    JSON_ASSERT(buffer_length >= 32);
+    static_cast<void>(buffer_length);
+
+    using Single = charconv::Single;
+    Single const v(value);
+
+    bool const is_neg = v.SignBit();
+
+    if (!v.IsFinite())
+    {
+        if (v.IsNaN()) {
+            std::memcpy(buffer, "NaN", 3);
+            return buffer + 3;
+        }
+
+        if (is_neg)
+            *buffer++ = '-';
 
-        int const decimal_point = num_digits + decimal_exponent;
-        int const scientific_exponent = decimal_point - 1;
+        std::memcpy(buffer, "Infinity", 8);
+        return buffer + 8;
+    }
 
-        if (-6 <= scientific_exponent && scientific_exponent < 21)
-            return json::impl::FormatFixed(buffer, num_digits, decimal_point, force_trailing_dot_zero);
+    if (v.IsZero())
+    {
+        if (is_neg)
+        {
+            std::memcpy(buffer, "-0.0", 4);
+            buffer += 4;
+        }
         else
-            return json::impl::FormatScientific(buffer, num_digits, scientific_exponent, /*force_trailing_dot_zero*/ false);
+        {
+            *buffer++ = '0';
+        }
+
+        return buffer;
+    }
+
+    if (is_neg)
+    {
+        value = -value;
+        *buffer++ = '-';
+    }
+
+    // Integers in the range [1, 2^24] are exactly representable as 'float'.
+    // Print these numbers without a trailing ".0".
+    if (1.0f <= value && value <= 16777216.0f)
+    {
+        uint32_t const i = static_cast<uint32_t>(value);
+        if (value == static_cast<float>(i))
+        {
+            return buffer + json::impl::PrintDecimalDigits(buffer, i);
+        }
     }
+
+    auto const res = charconv::ryu::FloatToDecimal(value);
+
+    return json::impl::FormatDecimal(buffer, res.digits, res.exponent, force_trailing_dot_zero);
 }
 
 } // namespace numbers
@@ -428,9 +498,36 @@ namespace impl {
 // To avoid overflow in integer arithmetic.
 constexpr int const kMaxStringToDoubleLen = 99999999; // < INT_MAX / 4
 
-inline double InternalStringToDouble(char const* next, char const* last, NumberClass nc)
+template <typename Float>
+struct BinaryFloatTraits;
+
+template <>
+struct BinaryFloatTraits<double>
+{
+    // Integers with at most 15 decimal digits are exactly representable as 'double'.
+    static constexpr int kMaxExactIntegerDigits = 15;
+
+    static double FromDigits(char const* digits, int num_digits, int exponent, bool nonzero_tail) {
+        return charconv::bellerophon::DigitsToDouble(digits, num_digits, exponent, nonzero_tail);
+    }
+};
+
+template <>
+struct BinaryFloatTraits<float>
+{
+    // Integers with at most 7 decimal digits are exactly representable as 'float'.
+    static constexpr int kMaxExactIntegerDigits = 7;
+
+    static float FromDigits(char const* digits, int num_digits, int exponent, bool nonzero_tail) {
+        return charconv::bellerophon::DigitsToFloat(digits, num_digits, exponent, nonzero_tail);
+    }
+};
+
+template <typename Float>
+inline Float InternalStringToBinaryFloat(char const* next, char const* last, NumberClass nc)
 {
     using namespace charconv::bellerophon;
+    using Traits = BinaryFloatTraits<Float>;
 
     char        buffer[kDoubleMaxSignificantDigits];
     char const* digits     = nullptr;
@@ -450,12 +547,12 @@ inline double InternalStringToDouble(char const* next, char const* last, NumberC
         digits = next;
         num_digits = static_cast<int>(last - next);
 
-        // Integers with at most 15 decimal digits are exactly representable as 'double'.
+        // Small integers are exactly representable as 'Float'.
         // We could read up to 19 (or 20) decimal digits into an uint64_t and let static_cast
         // do the conversion, but then rounding would be implementation-defined.
-        if (num_digits <= 15)
+        if (num_digits <= Traits::kMaxExactIntegerDigits)
         {
-            return static_cast<double>(ReadInt<int64_t>(next, num_digits));
+            return static_cast<Float>(ReadInt<int64_t>(next, num_digits));
         }
     }
     else
@@ -515,7 +612,7 @@ inline double InternalStringToDouble(char const* next, char const* last, NumberC
                     --exponent;
                     ++next;
                     if (next == last)
-                        return 0.0;
+                        return Float(0);
                 }
             }
 
@@ -543,7 +640,7 @@ inline double InternalStringToDouble(char const* next, char const* last, NumberC
             if (num_digits == 0)
             {
                 // Number is of the form 0[.000]e+nnn.
-                return 0.0;
+                return Float(0);
             }
 
             ++next;
@@ -576,13 +673,13 @@ inline double InternalStringToDouble(char const* next, char const* last, NumberC
                 // parsed exponent might cancel each other out), but still correct
                 // for sane inputs.
                 return exp_is_neg
-                    ? 0.0
-                    : std::numeric_limits<double>::infinity();
+                    ? Float(0)
+                    : std::numeric_limits<Float>::infinity();
             }
         }
     }
 
-    return DigitsToDouble(digits, num_digits, exponent, !zero_tail);
+    return Traits::FromDigits(digits, num_digits, exponent, !zero_tail);
 }
 
 } // namespace impl
@@ -621,7 +718,7 @@ JSON_NEVER_INLINE double StringToNumber(char const* next, char const* last, Numb
         ++next;
     }
 
-    double const value = json::impl::InternalStringToDouble(next, last, nc);
+    double const value = json::impl::InternalStringToBinaryFloat<double>(next, last, nc);
     return is_neg ? -value : value;
 }
 
@@ -648,5 +745,64 @@ JSON_NEVER_INLINE bool StringToNumber(double& result, char const* next, char con
     return false;
 }
 
+// Convert the string `[first, last)` to a single-precision value.
+// The result is correctly rounded, i.e. this is not the same as converting the
+// result of StringToNumber to 'float'.
+// The string must be valid according to the JSON grammar and match the number
+// class defined by `nc` (which must not be `NumberClass::invalid`).
+JSON_NEVER_INLINE float StringToFloat(char const* next, char const* last, NumberClass nc)
+{
+    if (next == last)
+        return 0.0f;
+
+    if (last - next > json::impl::kMaxStringToDoubleLen)
+        return std::numeric_limits<float>::quiet_NaN();
+
+    switch (nc) {
+    case NumberClass::invalid:
+        return std::numeric_limits<float>::quiet_NaN();
+    case NumberClass::nan:
+        return std::numeric_limits<float>::quiet_NaN();
+    case NumberClass::pos_infinity:
+        return +std::numeric_limits<float>::infinity();
+    case NumberClass::neg_infinity:
+        return -std::numeric_limits<float>::infinity();
+    default:
+        break;
+    }
+
+    bool const is_neg = (*next == '-');
+    if (is_neg)
+    {
+        ++next;
+    }
+
+    float const value = json::impl::InternalStringToBinaryFloat<float>(next, last, nc);
+    return is_neg ? -value : value;
+}
+
+// Convert the string `[next, last)` to a single-precision value.
+// Returns true if the string is a valid number according to the JSON grammar.
+// Otherwise returns false and stores 'NaN' in `result`.
+JSON_NEVER_INLINE bool StringToFloat(float& result, char const* next, char const* last)
+{
+    if (next == last)
+    {
+        result = 0.0f;
+        return true;
+    }
+
+    auto const res = json::ScanNumber(next, last);
+
+    if (res.next == last && res.number_class != NumberClass::invalid)
+    {
+        result = json::numbers::StringToFloat(next, last, res.number_class);
+        return true;
+    }
+
+    result = std::numeric_limits<float>::quiet_NaN();
+    return false;
+}
+
 } // namespace numbers
 } // namespace json
@@ -22,6 +22,9 @@
 
 #include "json_defs.h"
 
+#include <type_traits>
+#include <utility>
+
 namespace json {
 
 //==================================================================================================
@@ -144,6 +147,14 @@ public:
 
     void Skip(TokenKind kind);
 
+    // Skip the array or object starting at Next() by matching brackets.
+    // The contents are not validated, only strings (and comments in lenient
+    // mode) are recognized. Brackets of different kinds are not distinguished.
+    // Returns false if the end of the input is reached before the matching
+    // closing bracket.
+    // PRE: *Next() == '[' or *Next() == '{'
+    bool SkipStructured(Mode mode);
+
     char const* Next() const { return ptr; }
     char const* Last() const { return end; }
 
@@ -257,37 +268,42 @@ inline Token Lexer::LexString()
 
     StringClass sc = StringClass::clean;
 
+    // Points to the first non-ASCII character in the string, if any.
+    // Strings which contain non-ASCII characters are clean iff they are valid UTF-8.
+    char const* non_ascii = nullptr;
+
 #if JSON_SSE42
-    auto CountTrailingZeros = [](int bits)
-    {
-#if _MSC_VER
-        unsigned long index;
-        _BitScanForward(&index, static_cast<unsigned long>(bits));
-        return static_cast<int>(index);
-#else
-        return __builtin_ctz(static_cast<unsigned>(bits));
-#endif
-    };
+    using ::json::impl::CountTrailingZeros;
 
     /*static*/ __m128i const kQuotes = _mm_set1_epi8('"');
     /*static*/ __m128i const kBackslashes = _mm_set1_epi8('\\');
-    /*static*/ __m128i const kSpaces = _mm_set1_epi8(' ');
+    /*static*/ __m128i const kControls = _mm_set1_epi8(0x1F);
 
     for ( ; end - p >= 16; p += 16)
     {
         __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
         __m128i const mask2 = _mm_cmpeq_epi8(kQuotes, bytes);
         __m128i const mask1 = _mm_or_si128(mask2, _mm_cmpeq_epi8(kBackslashes, bytes));
-        __m128i const mask0 = _mm_or_si128(mask1, _mm_cmpgt_epi8(kSpaces, bytes));
+        // NB: bytes <= 0x1F (unsigned)
+        __m128i const mask0 = _mm_or_si128(mask1, _mm_cmpeq_epi8(_mm_min_epu8(kControls, bytes), bytes));
         int const mmask = _mm_movemask_epi8(mask0);
+        int const hmask = _mm_movemask_epi8(bytes); // bytes >= 0x80
         if (mmask != 0)
         {
-            p += CountTrailingZeros(mmask);
+            int const pos = CountTrailingZeros(mmask);
+            int const hmask_before = hmask & ((1 << pos) - 1);
+            if (non_ascii == nullptr && hmask_before != 0)
+                non_ascii = p + CountTrailingZeros(hmask_before);
+            p += pos;
             if (*p == '"')
                 goto L_done;
             sc = StringClass::needs_cleaning;
             break;
         }
+        if (non_ascii == nullptr && hmask != 0)
+        {
+            non_ascii = p + CountTrailingZeros(hmask);
+        }
     }
 
     // NB:
@@ -318,8 +334,11 @@ inline Token Lexer::LexString()
             sc = StringClass::needs_cleaning;
             if (++p == end)
                 break;
-        } else if (' ' > static_cast<int8_t>(ch)) {
+        } else if (static_cast<uint8_t>(ch) < 0x20) {
             sc = StringClass::needs_cleaning;
+        } else if (static_cast<uint8_t>(ch) >= 0x80) {
+            if (non_ascii == nullptr)
+                non_ascii = p;
         }
     }
 
@@ -340,6 +359,15 @@ L_done:
         ++p;
     }
 L1:
+    if (p != end && static_cast<uint8_t>(*p) >= 0x80)
+    {
+        non_ascii = p;
+        for ( ; p != end; ++p)
+        {
+            if (static_cast<uint8_t>(*p) < 0x80 && (CharClass(*p) & (CC_string_special | CC_needs_cleaning)) != 0)
+                break;
+        }
+    }
     if (p != end && *p != '"')
     {
         sc = StringClass::needs_cleaning;
@@ -372,6 +400,12 @@ L1:
     }
 #endif
 
+    if (sc == StringClass::clean && non_ascii != nullptr)
+    {
+        if (!::json::impl::IsValidUTF8(non_ascii, p))
+            sc = StringClass::needs_cleaning;
+    }
+
     JSON_ASSERT(p == end || *p == '"');
 
     bool const is_incomplete = (p == end);
@@ -468,6 +502,129 @@ inline void Lexer::Skip(TokenKind /*kind*/)
     ++ptr;
 }
 
+JSON_NEVER_INLINE bool Lexer::SkipStructured(Mode mode)
+{
+    char const* p = ptr;
+    JSON_ASSERT(p != end);
+    JSON_ASSERT(*p == '[' || *p == '{');
+
+    uint32_t depth = 0;
+    bool in_string = false;
+
+#if JSON_SSE42
+    using ::json::impl::CountTrailingZeros;
+
+    /*static*/ __m128i const kQuotes = _mm_set1_epi8('"');
+    /*static*/ __m128i const kBackslashes = _mm_set1_epi8('\\');
+    /*static*/ __m128i const kSlashes = _mm_set1_epi8('/');
+    // '[' | 0x20 == '{' and ']' | 0x20 == '}'.
+    /*static*/ __m128i const kCaseBit = _mm_set1_epi8(0x20);
+    /*static*/ __m128i const kOpen = _mm_set1_epi8('{');
+    /*static*/ __m128i const kClose = _mm_set1_epi8('}');
+#endif
+
+    for (;;)
+    {
+        // Find the next special character.
+#if JSON_SSE42
+        while (end - p >= 16)
+        {
+            __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+
+            __m128i const folded = _mm_or_si128(bytes, kCaseBit);
+            __m128i const brackets = _mm_or_si128(_mm_cmpeq_epi8(folded, kOpen), _mm_cmpeq_epi8(folded, kClose));
+            __m128i const quotes = _mm_or_si128(_mm_cmpeq_epi8(bytes, kQuotes), _mm_cmpeq_epi8(bytes, kBackslashes));
+            __m128i const slashes = _mm_cmpeq_epi8(bytes, kSlashes);
+            __m128i const special = _mm_or_si128(_mm_or_si128(brackets, quotes), slashes);
+
+            int const mask = _mm_movemask_epi8(special);
+            if (mask != 0)
+            {
+                // The loop below stops immediately.
+                p += CountTrailingZeros(mask);
+                break;
+            }
+
+            p += 16;
+        }
+#endif
+
+        for (;;)
+        {
+            if (p == end)
+            {
+                ptr = p;
+                return false;
+            }
+
+            char const ch = *p;
+            if (ch == '"' || ch == '\\' || ch == '/' || ch == '[' || ch == ']' || ch == '{' || ch == '}')
+                break;
+
+            ++p;
+        }
+
+        char const ch = *p;
+
+        if (in_string)
+        {
+            if (ch == '"')
+            {
+                in_string = false;
+            }
+            else if (ch == '\\')
+            {
+                ++p; // Skip the escaped character.
+                if (p == end)
+                {
+                    ptr = p;
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            switch (ch)
+            {
+            case '"':
+                in_string = true;
+                break;
+            case '[':
+            case '{':
+                ++depth;
+                break;
+            case ']':
+            case '}':
+                JSON_ASSERT(depth > 0);
+                --depth;
+                if (depth == 0)
+                {
+                    ptr = p + 1;
+                    return true;
+                }
+                break;
+            case '/':
+                if (mode != Mode::strict)
+                {
+                    char const* next = SkipComment(p, end);
+                    if (next == nullptr)
+                    {
+                        ptr = end;
+                        return false;
+                    }
+                    p = next;
+                    continue;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        ++p;
+    }
+}
+
 inline char const* Lexer::Seek(intptr_t dist)
 {
     JSON_ASSERT(dist >= 0);
@@ -536,6 +693,52 @@ struct Failed
     explicit operator ParseStatus() const noexcept { return ec; }
 };
 
+namespace impl {
+
+// Raw values are captured iff the callbacks have a HandleRaw() member function.
+template <typename ParseCallbacks, typename /*Enable*/ = void>
+struct CapturesRaw : std::false_type
+{
+};
+
+template <typename ParseCallbacks>
+struct CapturesRaw<ParseCallbacks, decltype(void( std::declval<ParseCallbacks&>().HandleRaw(nullptr, nullptr) ))>
+    : std::true_type
+{
+};
+
+template <typename ParseCallbacks>
+inline bool CaptureRaw(ParseCallbacks& cb, std::true_type) { return cb.CaptureRaw(); }
+
+template <typename ParseCallbacks>
+inline bool CaptureRaw(ParseCallbacks& /*cb*/, std::false_type) { return false; }
+
+template <typename ParseCallbacks>
+inline ParseStatus HandleRaw(ParseCallbacks& cb, char const* first, char const* last, std::true_type) { return cb.HandleRaw(first, last); }
+
+template <typename ParseCallbacks>
+inline ParseStatus HandleRaw(ParseCallbacks& /*cb*/, char const* /*first*/, char const* /*last*/, std::false_type) { return ParseStatus::success; }
+
+// Nested arrays and objects are skipped iff the callbacks have a HandleLazy() member function.
+template <typename ParseCallbacks, typename /*Enable*/ = void>
+struct SkipsNested : std::false_type
+{
+};
+
+template <typename ParseCallbacks>
+struct SkipsNested<ParseCallbacks, decltype(void( std::declval<ParseCallbacks&>().HandleLazy(nullptr, nullptr) ))>
+    : std::true_type
+{
+};
+
+template <typename ParseCallbacks>
+inline ParseStatus HandleLazy(ParseCallbacks& cb, char const* first, char const* last, std::true_type) { return cb.HandleLazy(first, last); }
+
+template <typename ParseCallbacks>
+inline ParseStatus HandleLazy(ParseCallbacks& /*cb*/, char const* /*first*/, char const* /*last*/, std::false_type) { return ParseStatus::success; }
+
+} // namespace impl
+
 template <typename ParseCallbacks>
 class Parser
 {
@@ -562,6 +765,7 @@ private:
     ParseStatus ParseString();
     ParseStatus ParseNumber();
     ParseStatus ParseIdentifier();
+    ParseStatus ParseLazy();
 };
 
 template <typename ParseCallbacks>
@@ -604,6 +808,24 @@ JSON_NEVER_INLINE ParseStatus Parser<ParseCallbacks>::ParseValue()
     uint32_t stack_size = 0;
     StackElement stack[kMaxDepth];
 
+    // Raw values:
+    // If CaptureRaw() returns true before a value is parsed, the value is
+    // parsed as usual (the callbacks are responsible for not building the
+    // value) and HandleRaw() is called with the source text of the value
+    // afterwards. Raw values do not nest.
+    using captures_raw = impl::CapturesRaw<ParseCallbacks>;
+
+    // Lazy values:
+    // Arrays and objects nested inside the top-level value are skipped by
+    // matching brackets (see Lexer::SkipStructured) and HandleLazy() is called
+    // with their source text instead of the callbacks for their contents.
+    // Values captured as raw values are never skipped.
+    using skips_nested = impl::SkipsNested<ParseCallbacks>;
+
+    bool raw_active = false;
+    uint32_t raw_depth = 0;
+    char const* raw_first = nullptr;
+
     // The first token has been read in SetInput()
     // or in the last call to ParseValue().
 
@@ -797,12 +1019,29 @@ L_end_structured:
     if (0)
     {
 L_parse_value:
+        if (captures_raw::value && !raw_active && impl::CaptureRaw(cb, captures_raw{}))
+        {
+            raw_active = true;
+            raw_depth = stack_size;
+            raw_first = lexer.Next();
+        }
+
         ParseStatus ec;
         switch (peek)
         {
         case TokenKind::l_brace:
+            if (skips_nested::value && stack_size != 0 && !raw_active)
+            {
+                ec = ParseLazy();
+                break;
+            }
             goto L_begin_object;
         case TokenKind::l_square:
+            if (skips_nested::value && stack_size != 0 && !raw_active)
+            {
+                ec = ParseLazy();
+                break;
+            }
             goto L_begin_array;
         case TokenKind::string:
             ec = ParseString();
@@ -822,6 +1061,13 @@ L_parse_value:
             return ec;
     }
 
+    if (captures_raw::value && raw_active && raw_depth == stack_size)
+    {
+        raw_active = false;
+        if (Failed ec = impl::HandleRaw(cb, raw_first, lexer.Next(), captures_raw{}))
+            return ParseStatus(ec);
+    }
+
     if (stack_size == 0)
         return ParseStatus::success;
 
@@ -889,6 +1135,21 @@ inline ParseStatus Parser<ParseCallbacks>::ParseIdentifier()
     return ParseStatus::unrecognized_identifier;
 }
 
+template <typename ParseCallbacks>
+inline ParseStatus Parser<ParseCallbacks>::ParseLazy()
+{
+    char const* const first = lexer.Next();
+    JSON_ASSERT(*first == '[' || *first == '{');
+
+    if (!lexer.SkipStructured(mode))
+    {
+        return *first == '{' ? ParseStatus::expected_comma_or_closing_brace
+                             : ParseStatus::expected_comma_or_closing_bracket;
+    }
+
+    return impl::HandleLazy(cb, first, lexer.Next(), impl::SkipsNested<ParseCallbacks>{});
+}
+
 //==================================================================================================
 // ParseSAX
 //==================================================================================================
@@ -926,6 +1187,15 @@ inline ParseResult ParseSAX(ParseCallbacks& cb, char const* next, char const* la
 //    virtual json::ParseStatus HandleBeginObject() = 0;
 //    virtual json::ParseStatus HandleEndObject(size_t count) = 0;
 //    virtual json::ParseStatus HandleEndMember(size_t& count) = 0;
+//
+//    // Optional:
+//    // Return true to capture the next value as raw JSON text.
+//    bool CaptureRaw();
+//    // Called with the source text of a captured value, after the callbacks
+//    // for its contents.
+//    json::ParseStatus HandleRaw(char const* first, char const* last);
+//    // If present, nested arrays and objects are skipped and reported here.
+//    json::ParseStatus HandleLazy(char const* first, char const* last);
 //};
 //
 //json::ParseResult ParseJson(ParseCallbacks& cb, char const* next, char const* last, json::Mode mode = json::Mode::strict)
@@ -0,0 +1,278 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace json {
+
+class Schema;
+
+namespace impl {
+struct ParseRecordArrayCallbacks;
+}
+
+//==================================================================================================
+// KeyIndex
+//==================================================================================================
+
+// Maps a fixed set of object keys to slot indices [0, size()).
+//
+// The keys are stored in a perfect hash table, which is constructed once.
+// A lookup costs one hash computation and at most one key comparison, and
+// never allocates memory.
+class KeyIndex
+{
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+private:
+    std::vector<String> keys_;
+    std::vector<uint32_t> table_; // slot index or kNone
+    uint64_t seed_ = 0;
+    uint32_t shift_ = 63;
+    bool linear_ = true; // use a linear search (empty index or failed to build the table)
+
+public:
+    KeyIndex() = default;
+
+    // Construct an index for the given keys.
+    // The slot index of a key is its position in KEYS. If a key occurs
+    // multiple times, only the first occurrence is used.
+    explicit KeyIndex(std::vector<String> keys);
+    KeyIndex(std::initializer_list<String> keys);
+
+    // Construct an index for the keys of the properties of the root schema
+    // (including properties of subschemas referenced by $ref and allOf).
+    explicit KeyIndex(Schema const& schema);
+
+    // Returns the number of slots.
+    size_t size() const noexcept { return keys_.size(); }
+
+    // Returns the key of the given slot.
+    String const& key(size_t slot) const noexcept
+    {
+        JSON_ASSERT(slot < keys_.size());
+        return keys_[slot];
+    }
+
+    // Returns the slot index of the given key, or kNone.
+    uint32_t find(char const* key, size_t len) const noexcept
+    {
+        return find(key, len, impl::KeyHash(key, len));
+    }
+
+    uint32_t find(std::string const& key) const noexcept
+    {
+        return find(key.data(), key.size());
+    }
+
+    // Uses the precomputed hash of the key.
+    uint32_t find(Key const& key) const noexcept
+    {
+        return find(key.data(), key.size(), key.hash());
+    }
+
+    // Returns the slot index of the given key, or kNone.
+    // HASH must be impl::KeyHash(key, len).
+    uint32_t find(char const* key, size_t len, uint64_t hash) const noexcept
+    {
+        if (linear_)
+            return FindLinear(key, len);
+
+        uint32_t const slot = table_[Bucket(hash)];
+        if (slot == kNone)
+            return kNone;
+
+        String const& k = keys_[slot];
+        if (k.size() != len || std::memcmp(k.data(), key, len) != 0)
+            return kNone;
+
+        return slot;
+    }
+
+private:
+    size_t Bucket(uint64_t hash) const noexcept
+    {
+        return static_cast<size_t>(((hash ^ seed_) * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    uint32_t FindLinear(char const* key, size_t len) const noexcept;
+    void Build();
+};
+
+//==================================================================================================
+// Record
+//==================================================================================================
+
+// A JSON object with a known set of keys.
+//
+// The values of the keys in the KeyIndex are stored in a fixed array of slots,
+// all other members are stored in an ordinary Object.
+struct Record
+{
+    // slots[i] is the value of the member with key index.key(i), or
+    // undefined if the object does not contain this key.
+    std::vector<Value> slots;
+    // Members with unknown keys.
+    Object overflow;
+};
+
+// Parse the JSON object stored in [NEXT, LAST) into RECORD.
+// The keys of the top-level object are mapped to slots using INDEX, without
+// constructing a String or inserting into an Object. If a key occurs multiple
+// times, the last value is used.
+// Returns ParseStatus::schema_violation if the document is not an object.
+// On error, RECORD is unchanged.
+ParseResult parse_record(Record& record, KeyIndex const& index, char const* next, char const* last, Mode mode = Mode::strict);
+
+// Parse the JSON object stored in STR into RECORD.
+ParseStatus parse_record(Record& record, KeyIndex const& index, std::string const& str, Mode mode = Mode::strict);
+
+//==================================================================================================
+// RecordArray
+//==================================================================================================
+
+// An array of objects which (mostly) share the same keys.
+//
+// Objects with the same key sequence share a single "shape", which stores the
+// keys in document order. Each object is then stored as a reference to its
+// shape plus a dense array of values; the keys are stored only once per shape.
+// Elements which are not objects, or objects with duplicate keys, are stored
+// as ordinary Values.
+//
+// A RecordArray is constructed using parse_records() and is immutable.
+class RecordArray
+{
+    friend struct impl::ParseRecordArrayCallbacks;
+
+public:
+    static constexpr uint32_t kNoShape = UINT32_MAX;
+
+    // The slot indices of a key in each shape of a RecordArray.
+    class Column
+    {
+        friend class RecordArray;
+
+        String key_;
+        std::vector<uint32_t> slots_; // slots_[shape] is the slot of key_ or KeyIndex::kNone
+
+    public:
+        String const& key() const noexcept { return key_; }
+    };
+
+private:
+    struct Row {
+        uint32_t shape; // or kNoShape
+        uint32_t size;  // number of values
+        size_t first;   // index of the first value
+    };
+
+    std::vector<KeyIndex> shapes_;
+    std::vector<Row> rows_;
+    std::vector<Value> values_;
+
+public:
+    // Returns the number of elements.
+    size_t size() const noexcept { return rows_.size(); }
+    bool empty() const noexcept { return rows_.empty(); }
+
+    // Returns the number of distinct shapes.
+    size_t shape_count() const noexcept { return shapes_.size(); }
+
+    // Returns the keys of the given shape. The slot index of a key is its
+    // position in the original objects.
+    KeyIndex const& shape(size_t index) const noexcept
+    {
+        JSON_ASSERT(index < shapes_.size());
+        return shapes_[index];
+    }
+
+    // Returns the shape of the given element, or kNoShape if the element is
+    // stored as an ordinary Value.
+    uint32_t shape_of(size_t row) const noexcept
+    {
+        JSON_ASSERT(row < rows_.size());
+        return rows_[row].shape;
+    }
+
+    // Returns the value in the given slot of a shaped element.
+    Value const& value(size_t row, size_t slot) const noexcept
+    {
+        JSON_ASSERT(row < rows_.size());
+        JSON_ASSERT(rows_[row].shape != kNoShape);
+        JSON_ASSERT(slot < rows_[row].size);
+        return values_[rows_[row].first + slot];
+    }
+
+    // Returns an element which is stored as an ordinary Value.
+    Value const& element(size_t row) const noexcept
+    {
+        JSON_ASSERT(row < rows_.size());
+        JSON_ASSERT(rows_[row].shape == kNoShape);
+        return values_[rows_[row].first];
+    }
+
+    // Returns the member of the given element with the given key.
+    // Returns an undefined value if the element is not an object or does not
+    // have a member with this key.
+    Value const& get(size_t row, char const* key, size_t len) const noexcept { return Get(row, key, len, impl::KeyHash(key, len)); }
+    Value const& get(size_t row, String const& key) const noexcept { return get(row, key.data(), key.size()); }
+    Value const& get(size_t row, Key const& key) const noexcept { return Get(row, key.data(), key.size(), key.hash()); }
+
+    // Returns a Column for the given key.
+    // The slot of the key in each shape is looked up once, so that the members
+    // of many elements can be accessed without hashing the key again.
+    Column column(String key) const;
+    Column column(Key const& key) const { return column(key.str()); }
+
+    // Returns the member of the given element with the key of the Column.
+    // The Column must have been created by this RecordArray.
+    Value const& get(size_t row, Column const& column) const noexcept;
+
+    // Converts the given element into an ordinary Value.
+    Value to_value(size_t row) const;
+
+    // Converts this array into an ordinary Value.
+    Value to_value() const;
+
+private:
+    Value const& Get(size_t row, char const* key, size_t len, uint64_t hash) const noexcept;
+};
+
+// Parse the JSON array stored in [NEXT, LAST) into RECORDS.
+// The keys of the objects in the top-level array are compared against the
+// shape of the previous object, so that only the first object of each shape
+// allocates its keys. If an object contains a key multiple times, the last
+// value is used.
+// Returns ParseStatus::schema_violation if the document is not an array.
+ParseResult parse_records(RecordArray& records, char const* next, char const* last, Mode mode = Mode::strict);
+
+// Parse the JSON array stored in STR into RECORDS.
+ParseStatus parse_records(RecordArray& records, std::string const& str, Mode mode = Mode::strict);
+
+} // namespace json
@@ -0,0 +1,266 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "json.h"
+#include "json_parser.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace json {
+
+namespace impl {
+struct SchemaCompiler;
+}
+
+//==================================================================================================
+// Schema
+//==================================================================================================
+
+// A compiled JSON Schema (draft 2020-12 subset).
+//
+// Supported keywords:
+//      type, enum, const
+//      minimum, maximum, exclusiveMinimum, exclusiveMaximum, multipleOf
+//      minLength, maxLength
+//      items, prefixItems, minItems, maxItems
+//      properties, required, additionalProperties, minProperties, maxProperties
+//      allOf, anyOf, oneOf, not, if, then, else
+//      $ref (local JSON pointers, e.g. "#" or "#/$defs/name"), $defs, definitions
+//
+// Annotations (title, description, default, format, ...) and unknown keywords
+// are ignored. Schemas using other assertions (pattern, uniqueItems, contains,
+// unevaluatedProperties, ...) or enum/const with arrays or objects are rejected
+// by compile().
+//
+// A schema is compiled into a flat list of nodes, which reference each other by
+// index. Validation is driven by parser events (see SchemaValidator), so
+// documents can be validated while they are parsed, without building a Value.
+class Schema
+{
+    friend class KeyIndex;
+    friend class SchemaValidator;
+    friend struct impl::SchemaCompiler;
+
+public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    enum : uint32_t {
+        type_null    = 1u << 0,
+        type_boolean = 1u << 1,
+        type_integer = 1u << 2, // numbers without a fractional part
+        type_number  = 1u << 3,
+        type_string  = 1u << 4,
+        type_array   = 1u << 5,
+        type_object  = 1u << 6,
+        type_any     = (1u << 7) - 1,
+    };
+
+    struct Node
+    {
+        bool reject = false; // the schema 'false'
+        bool has_enum = false;
+        uint32_t types = type_any;
+
+        bool has_minimum = false;
+        bool has_maximum = false;
+        bool has_exclusive_minimum = false;
+        bool has_exclusive_maximum = false;
+        bool has_multiple_of = false;
+        double minimum = 0;
+        double maximum = 0;
+        double exclusive_minimum = 0;
+        double exclusive_maximum = 0;
+        double multiple_of = 0;
+
+        uint32_t min_length = 0;
+        uint32_t max_length = UINT32_MAX;
+        uint32_t min_items = 0;
+        uint32_t max_items = UINT32_MAX;
+        uint32_t min_properties = 0;
+        uint32_t max_properties = UINT32_MAX;
+
+        uint32_t items = kNone;
+        uint32_t additional_properties = kNone;
+        uint32_t not_ = kNone;
+        uint32_t if_ = kNone;
+        uint32_t then_ = kNone;
+        uint32_t else_ = kNone;
+        uint32_t ref = kNone;
+
+        // Ranges [first, first + count) into the tables below.
+        uint32_t enum_first = 0;            // enums
+        uint32_t enum_count = 0;
+        uint32_t prefix_items_first = 0;    // indices
+        uint32_t prefix_items_count = 0;
+        uint32_t all_of_first = 0;          // indices
+        uint32_t all_of_count = 0;
+        uint32_t any_of_first = 0;          // indices
+        uint32_t any_of_count = 0;
+        uint32_t one_of_first = 0;          // indices
+        uint32_t one_of_count = 0;
+        uint32_t properties_first = 0;      // properties, sorted by key
+        uint32_t properties_count = 0;
+        uint32_t required_first = 0;        // required, sorted
+        uint32_t required_count = 0;
+    };
+
+    struct Property
+    {
+        String key;
+        uint32_t node;
+    };
+
+private:
+    std::vector<Node> nodes_; // nodes_[0] is the root
+    std::vector<uint32_t> indices_;
+    std::vector<Property> properties_;
+    std::vector<String> required_;
+    std::vector<Value> enums_;
+
+public:
+    // Compile the given JSON Schema.
+    // Returns false if the schema is invalid or uses unsupported keywords,
+    // or if a $ref cannot be resolved or forms a cycle which does not
+    // consume any input. The schema is empty in this case.
+    bool compile(Value const& document);
+
+    // Returns whether the schema is empty, i.e. has not been compiled.
+    bool empty() const noexcept { return nodes_.empty(); }
+
+    // Returns the number of compiled nodes.
+    size_t size() const noexcept { return nodes_.size(); }
+};
+
+//==================================================================================================
+// SchemaValidator
+//==================================================================================================
+
+// Validates a document against a Schema, driven by ParseCallbacks events.
+//
+// Use with json::ParseSAX() (or the CBOR and MessagePack decoders) to
+// validate without building a Value. The handlers return
+// ParseStatus::schema_violation as soon as the document is known to be
+// invalid, which stops the parser.
+//
+// A validator can only be used for a single document.
+class SchemaValidator
+{
+    // The evaluation of a schema node for the current value.
+    // Combinators (allOf, anyOf, ...) create additional evaluations for the
+    // same value, arrays and objects create evaluations for their elements
+    // resp. member values. Evaluations form a stack.
+    struct Eval
+    {
+        uint32_t node;
+        uint32_t parent;    // or Schema::kNone
+        uint8_t relation;   // how the result contributes to the parent
+        bool failed;
+        bool not_valid;     // result of the 'not' subschema
+        bool if_valid;      // result of the 'if' subschema
+        bool then_valid;
+        bool else_valid;
+        bool any_of_valid;  // whether any anyOf subschema is valid
+        uint32_t one_of_valid; // number of valid oneOf subschemas
+        uint32_t count;       // number of elements resp. members seen so far
+        size_t seen_first;    // required properties seen, index into seen_
+    };
+
+    // The evaluations of an array or object value.
+    struct Frame
+    {
+        size_t first;
+        size_t last;
+        bool is_object;
+        bool counts_keys; // whether the keys of this object are stored in keys_
+    };
+
+    // A schema node to be applied to the next value.
+    struct Pending
+    {
+        uint32_t node;
+        uint32_t parent;
+    };
+
+    Schema const& schema_;
+    Mode mode_;
+    bool failed_ = false;
+    std::vector<Eval> evals_;
+    std::vector<Frame> frames_;
+    std::vector<Pending> pending_;
+    std::vector<uint8_t> seen_;
+    // The keys of the enclosing objects with a minProperties or maxProperties
+    // constraint. Duplicate keys count only once, as in validate_value().
+    std::vector<std::unordered_set<String>> keys_;
+    String scratch_;
+
+public:
+    explicit SchemaValidator(Schema const& schema, Mode mode = Mode::strict);
+
+    // Returns whether the document is known to be invalid.
+    bool failed() const noexcept { return failed_; }
+
+    ParseStatus HandleNull();
+    ParseStatus HandleTrue();
+    ParseStatus HandleFalse();
+    ParseStatus HandleNumber(char const* first, char const* last, NumberClass nc);
+    ParseStatus HandleDouble(double value);
+    ParseStatus HandleString(char const* first, char const* last, StringClass string_class);
+    ParseStatus HandleBeginArray();
+    ParseStatus HandleEndArray(size_t count);
+    ParseStatus HandleEndElement(size_t& count);
+    ParseStatus HandleBeginObject();
+    ParseStatus HandleEndObject(size_t count);
+    ParseStatus HandleEndMember(size_t& count);
+    ParseStatus HandleKey(char const* first, char const* last, StringClass string_class);
+
+    // Validates the given value, which may contain raw and lazy values.
+    ParseStatus ValidateValue(Value const& value);
+
+private:
+    struct Instance;
+
+    ParseStatus BeginValue(Instance const& instance);
+    ParseStatus EndContainer();
+    ParseStatus Key(char const* key, size_t len);
+    void Instantiate(uint32_t node, uint32_t parent, uint8_t relation);
+    void Check(size_t index, Instance const& instance);
+    void EndValue(size_t first);
+    void Fail(size_t index);
+    bool Unescape(char const*& first, char const*& last, StringClass string_class);
+};
+
+// Validate the JSON document stored in [NEXT, LAST) without building a Value.
+// Returns ParseStatus::schema_violation if the document does not match the
+// schema, or any other ParseStatus if the document could not be parsed.
+ParseResult validate(Schema const& schema, char const* next, char const* last, Mode mode = Mode::strict);
+
+// Validate the JSON document stored in STR without building a Value.
+ParseStatus validate(Schema const& schema, std::string const& str, Mode mode = Mode::strict);
+
+// Validate the given value.
+bool validate_value(Schema const& schema, Value const& value);
+
+} // namespace json
@@ -0,0 +1,336 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace json {
+
+//==================================================================================================
+// Snapshot
+//==================================================================================================
+
+// A snapshot is a binary image of a Value, which can be mapped into memory and
+// used read-only, without parsing or allocating any memory. Loading a snapshot
+// costs O(pages touched) instead of O(document size).
+//
+// All references inside a snapshot are offsets relative to the start of the
+// file. The format uses the byte order of the machine which created it.
+// open_snapshot() rejects snapshots created on machines with a different byte
+// order.
+//
+// Layout:
+//      Header
+//          char     magic[8]       "JSON1SNP"
+//          uint32_t version        1
+//          uint32_t byte_order     0x01020304
+//          uint64_t file_size
+//          Slot     root
+//
+//      Slot (16 bytes, 8-byte aligned)
+//          uint32_t type           Type
+//          uint32_t size           string or raw: length, array: number of elements, object: number of members
+//          uint64_t payload        boolean: 0 or 1, number: bits of the double,
+//                                  string or raw: offset of the characters (followed by '\0'),
+//                                  array: offset of the element Slots,
+//                                  object: offset of the Members, sorted by key
+//
+//      Member (32 bytes, 8-byte aligned)
+//          uint64_t key            offset of the key characters (followed by '\0')
+//          uint32_t key_size
+//          uint32_t reserved       0
+//          Slot     value
+
+namespace impl {
+
+struct SnapshotSlot
+{
+    uint32_t type;
+    uint32_t size;
+    uint64_t payload;
+};
+
+struct SnapshotMember
+{
+    uint64_t key;
+    uint32_t key_size;
+    uint32_t reserved;
+    SnapshotSlot value;
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    SnapshotSlot root;
+};
+
+} // namespace impl
+
+// A read-only view of a value stored in a snapshot.
+// Views are cheap to copy. They are valid as long as the Snapshot they were
+// obtained from is open.
+class SnapshotView
+{
+    char const* base_ = nullptr;
+    impl::SnapshotSlot const* slot_ = nullptr;
+
+public:
+    // Constructs a view of an undefined value.
+    SnapshotView() = default;
+
+    SnapshotView(char const* base, impl::SnapshotSlot const* slot)
+        : base_(base)
+        , slot_(slot)
+    {
+    }
+
+    Type type() const noexcept { return slot_ != nullptr ? static_cast<Type>(slot_->type) : Type::undefined; }
+
+    bool is_undefined() const noexcept { return type() == Type::undefined; }
+    bool is_null()      const noexcept { return type() == Type::null; }
+    bool is_boolean()   const noexcept { return type() == Type::boolean; }
+    bool is_number()    const noexcept { return type() == Type::number; }
+    bool is_string()    const noexcept { return type() == Type::string; }
+    bool is_array()     const noexcept { return type() == Type::array; }
+    bool is_object()    const noexcept { return type() == Type::object; }
+    bool is_raw()       const noexcept { return type() == Type::raw; }
+
+    bool get_boolean() const noexcept
+    {
+        JSON_ASSERT(is_boolean());
+        return slot_->payload != 0;
+    }
+
+    double get_number() const noexcept
+    {
+        JSON_ASSERT(is_number());
+        double value;
+        std::memcpy(&value, &slot_->payload, sizeof(double));
+        return value;
+    }
+
+    // Returns a pointer to the characters of this string, which are followed
+    // by a '\0'. Use size() to obtain the length of the string.
+    // PRE: is_string()
+    char const* get_string() const noexcept
+    {
+        JSON_ASSERT(is_string());
+        return base_ + slot_->payload;
+    }
+
+    // Returns a pointer to the JSON text of this raw value, which is followed
+    // by a '\0'. Use size() to obtain the length of the text.
+    // PRE: is_raw()
+    char const* get_raw() const noexcept
+    {
+        JSON_ASSERT(is_raw());
+        return base_ + slot_->payload;
+    }
+
+    // Returns the size of this string or raw value or array or object.
+    // PRE: is_string() or is_raw() or is_array() or is_object()
+    size_t size() const noexcept
+    {
+        JSON_ASSERT(is_string() || is_raw() || is_array() || is_object());
+        return slot_->size;
+    }
+
+    // Returns whether this string or raw value or array or object is empty.
+    // PRE: is_string() or is_raw() or is_array() or is_object()
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    // Returns the element at the given index.
+    // PRE: is_array()
+    // PRE: index < size()
+    SnapshotView operator[](size_t index) const noexcept
+    {
+        JSON_ASSERT(is_array());
+        JSON_ASSERT(index < size());
+        return {base_, Elements() + index};
+    }
+
+    // Returns the key of the member at the given index.
+    // Members are sorted by key, as in Object.
+    // PRE: is_object()
+    // PRE: index < size()
+    char const* key(size_t index) const noexcept
+    {
+        JSON_ASSERT(is_object());
+        JSON_ASSERT(index < size());
+        return base_ + Members()[index].key;
+    }
+
+    // Returns the length of the key of the member at the given index.
+    // PRE: is_object()
+    // PRE: index < size()
+    size_t key_size(size_t index) const noexcept
+    {
+        JSON_ASSERT(is_object());
+        JSON_ASSERT(index < size());
+        return Members()[index].key_size;
+    }
+
+    // Returns the value of the member at the given index.
+    // PRE: is_object()
+    // PRE: index < size()
+    SnapshotView value(size_t index) const noexcept
+    {
+        JSON_ASSERT(is_object());
+        JSON_ASSERT(index < size());
+        return {base_, &Members()[index].value};
+    }
+
+    // Returns the value of the member with the given key, or an undefined
+    // view if there is no such member.
+    // Uses binary search.
+    // PRE: is_object()
+    SnapshotView find(char const* key_first, size_t key_len) const noexcept
+    {
+        JSON_ASSERT(is_object());
+
+        impl::SnapshotMember const* const members = Members();
+
+        size_t lo = 0;
+        size_t hi = size();
+        while (lo < hi)
+        {
+            size_t const mid = lo + (hi - lo) / 2;
+            int const cmp = CompareKey(members[mid], key_first, key_len);
+            if (cmp == 0)
+                return {base_, &members[mid].value};
+            if (cmp < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return {};
+    }
+
+    SnapshotView find(char const* key) const noexcept
+    {
+        return find(key, std::strlen(key));
+    }
+
+    SnapshotView find(std::string const& key) const noexcept
+    {
+        return find(key.data(), key.size());
+    }
+
+    // Returns the value of the member with the given key, or an undefined
+    // view if this is not an object or if there is no such member.
+    // NB: Takes string literals by reference to avoid ambiguity with operator[](size_t).
+    template <size_t N>
+    SnapshotView operator[](char const (&key)[N]) const noexcept
+    {
+        return is_object() ? find(key) : SnapshotView{};
+    }
+
+    SnapshotView operator[](std::string const& key) const noexcept
+    {
+        return is_object() ? find(key) : SnapshotView{};
+    }
+
+    // Returns a copy of the viewed value.
+    Value to_value() const;
+
+private:
+    impl::SnapshotSlot const* Elements() const noexcept
+    {
+        return reinterpret_cast<impl::SnapshotSlot const*>(base_ + slot_->payload);
+    }
+
+    impl::SnapshotMember const* Members() const noexcept
+    {
+        return reinterpret_cast<impl::SnapshotMember const*>(base_ + slot_->payload);
+    }
+
+    // Compares like std::string::compare.
+    int CompareKey(impl::SnapshotMember const& member, char const* key_first, size_t key_len) const noexcept
+    {
+        size_t const n = member.key_size < key_len ? member.key_size : key_len;
+        int const cmp = n != 0 ? std::memcmp(base_ + member.key, key_first, n) : 0;
+        if (cmp != 0)
+            return cmp;
+        if (member.key_size < key_len)
+            return -1;
+        if (member.key_size > key_len)
+            return 1;
+        return 0;
+    }
+};
+
+// A memory-mapped snapshot file.
+class Snapshot
+{
+    char const* data_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    Snapshot() = default;
+    Snapshot(Snapshot&& rhs) noexcept;
+    Snapshot& operator=(Snapshot&& rhs) noexcept;
+    ~Snapshot();
+
+    // Returns whether a snapshot has been opened successfully.
+    bool is_open() const noexcept { return data_ != nullptr; }
+
+    // Returns the size of the snapshot in bytes.
+    size_t size() const noexcept { return size_; }
+
+    // Returns a view of the stored value.
+    // PRE: is_open()
+    SnapshotView root() const noexcept
+    {
+        JSON_ASSERT(is_open());
+        return {data_, &reinterpret_cast<impl::SnapshotHeader const*>(data_)->root};
+    }
+
+    // Unmaps the snapshot. All views become invalid.
+    void close() noexcept;
+
+private:
+    friend Snapshot open_snapshot(std::string const& path);
+};
+
+// Writes a snapshot of the given value to the given file.
+// Lazy values are expanded.
+// Returns false if the file could not be written.
+bool save_snapshot(Value const& value, std::string const& path);
+
+// Maps the given snapshot file into memory.
+// Only the header of the file is validated, the file must have been created
+// by save_snapshot(). Returns a closed snapshot if the file could not be
+// mapped or is not a snapshot.
+Snapshot open_snapshot(std::string const& path);
+
+} // namespace json
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "json_defs.h" // JSON_SSE42
+
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -278,15 +280,35 @@ struct DecodeUCNSequenceResult {
 
 inline bool ReadHex16_unsafe(char const* next, char32_t& W)
 {
-    using json::charclass::HexDigitValue;
+    // Convert all four hex digits at once (SWAR).
+    // The first character is stored in the lowest byte.
+
+    uint32_t const v = uint32_t{static_cast<uint8_t>(next[0])}
+                    | (uint32_t{static_cast<uint8_t>(next[1])} <<  8)
+                    | (uint32_t{static_cast<uint8_t>(next[2])} << 16)
+                    | (uint32_t{static_cast<uint8_t>(next[3])} << 24);
+
+    // Since all bytes are < 0x80 (checked below), the additions here do
+    // not carry into the next byte. The high bit of each byte of
+    // (x + (0x80 - k)) is set iff x >= k.
+    // Digits must be tested on the raw bytes: case-folding would map the
+    // control characters 0x10-0x19 onto '0'-'9'.
+    uint32_t const x = v | 0x20202020; // 'A'-'F' => 'a'-'f'
+    uint32_t const is_digit = (v + 0x50505050) & ~(v + 0x46464646); // >= '0' && < '9' + 1
+    uint32_t const is_alpha = (x + 0x1F1F1F1F) & ~(x + 0x19191919); // >= 'a' && < 'f' + 1
+    if (((v & 0x80808080) | (~(is_digit | is_alpha) & 0x80808080)) != 0)
+    {
+        return false;
+    }
 
-    char32_t const h0 = HexDigitValue(next[0]);
-    char32_t const h1 = HexDigitValue(next[1]);
-    char32_t const h2 = HexDigitValue(next[2]);
-    char32_t const h3 = HexDigitValue(next[3]);
+    // '0'-'9' => 0-9, 'a'-'f' => 1-6 + 9.
+    uint32_t const nibbles = (v & 0x0F0F0F0F) + ((is_alpha & 0x80808080) >> 7) * 9;
 
-    W = (h0 << 12) | (h1 << 8) | (h2 << 4) | h3;
-    return W <= 0xFFFF;
+    // n3 n2 n1 n0 => (n2 n3) (n0 n1)
+    uint32_t const bytes = ((nibbles << 4) | (nibbles >> 8)) & 0x00FF00FF;
+
+    W = static_cast<char32_t>(((bytes & 0xFF) << 8) | (bytes >> 16));
+    return true;
 }
 
 inline DecodeUCNSequenceResult DecodeUCNSequence(char const* next, char const* last, char32_t& U)
@@ -346,6 +368,148 @@ inline DecodeUCNSequenceResult DecodeUCNSequence(char const* next, char const* l
 } // namespace unicode
 } // namespace impl
 
+//==================================================================================================
+// Fast scanning
+//==================================================================================================
+
+namespace impl {
+
+// Returns a pointer to the first backslash, control character or non-ASCII
+// character in [f, l), or l if there is no such character.
+inline char const* SkipUnescapedASCII(char const* f, char const* l)
+{
+#if JSON_SSE42
+    __m128i const kBackslashes = _mm_set1_epi8('\\');
+    __m128i const kSpaces = _mm_set1_epi8(' ');
+
+    for ( ; l - f >= 32; f += 32)
+    {
+        __m128i const bytes0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(f));
+        __m128i const bytes1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(f + 16));
+        // NB: The (signed) comparison with ' ' also finds bytes >= 0x80.
+        __m128i const mask0 = _mm_or_si128(_mm_cmpeq_epi8(kBackslashes, bytes0), _mm_cmpgt_epi8(kSpaces, bytes0));
+        __m128i const mask1 = _mm_or_si128(_mm_cmpeq_epi8(kBackslashes, bytes1), _mm_cmpgt_epi8(kSpaces, bytes1));
+        int const mmask0 = _mm_movemask_epi8(mask0);
+        int const mmask1 = _mm_movemask_epi8(mask1);
+        if (mmask0 != 0)
+            return f + CountTrailingZeros(mmask0);
+        if (mmask1 != 0)
+            return f + 16 + CountTrailingZeros(mmask1);
+    }
+
+    for ( ; l - f >= 16; f += 16)
+    {
+        __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(f));
+        __m128i const mask = _mm_or_si128(_mm_cmpeq_epi8(kBackslashes, bytes), _mm_cmpgt_epi8(kSpaces, bytes));
+        int const mmask = _mm_movemask_epi8(mask);
+        if (mmask != 0)
+            return f + CountTrailingZeros(mmask);
+    }
+#endif
+
+    for ( ; f != l; ++f)
+    {
+        if (*f == '\\' || static_cast<int8_t>(*f) < ' ')
+            break;
+    }
+
+    return f;
+}
+
+// Returns a pointer to the first quote, backslash, slash, control character or
+// non-ASCII character in [f, l), or l if there is no such character.
+inline char const* SkipUnquotedASCII(char const* f, char const* l)
+{
+#if JSON_SSE42
+    __m128i const kQuotes = _mm_set1_epi8('"');
+    __m128i const kBackslashes = _mm_set1_epi8('\\');
+    __m128i const kSlashes = _mm_set1_epi8('/');
+    __m128i const kSpaces = _mm_set1_epi8(' ');
+
+    auto Classify = [&](__m128i bytes)
+    {
+        // NB: The (signed) comparison with ' ' also finds bytes >= 0x80.
+        __m128i const mask2 = _mm_or_si128(_mm_cmpeq_epi8(kQuotes, bytes), _mm_cmpeq_epi8(kBackslashes, bytes));
+        __m128i const mask1 = _mm_or_si128(_mm_cmpeq_epi8(kSlashes, bytes), _mm_cmpgt_epi8(kSpaces, bytes));
+        return _mm_movemask_epi8(_mm_or_si128(mask2, mask1));
+    };
+
+    for ( ; l - f >= 32; f += 32)
+    {
+        int const mmask0 = Classify(_mm_loadu_si128(reinterpret_cast<__m128i const*>(f)));
+        int const mmask1 = Classify(_mm_loadu_si128(reinterpret_cast<__m128i const*>(f + 16)));
+        if (mmask0 != 0)
+            return f + CountTrailingZeros(mmask0);
+        if (mmask1 != 0)
+            return f + 16 + CountTrailingZeros(mmask1);
+    }
+
+    for ( ; l - f >= 16; f += 16)
+    {
+        int const mmask = Classify(_mm_loadu_si128(reinterpret_cast<__m128i const*>(f)));
+        if (mmask != 0)
+            return f + CountTrailingZeros(mmask);
+    }
+#endif
+
+    for ( ; f != l; ++f)
+    {
+        if (*f == '\\' || *f == '"' || *f == '/' || static_cast<int8_t>(*f) < ' ')
+            break;
+    }
+
+    return f;
+}
+
+// Returns a pointer to the first quote, backslash, slash or control character
+// in [f, l), or l if there is no such character.
+// Unlike SkipUnquotedASCII, non-ASCII characters are skipped.
+inline char const* SkipUnquoted(char const* f, char const* l)
+{
+#if JSON_SSE42
+    __m128i const kQuotes = _mm_set1_epi8('"');
+    __m128i const kBackslashes = _mm_set1_epi8('\\');
+    __m128i const kSlashes = _mm_set1_epi8('/');
+    __m128i const kMaxControl = _mm_set1_epi8(0x1F);
+
+    for ( ; l - f >= 16; f += 16)
+    {
+        __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(f));
+        // (unsigned, saturates to 0 for bytes <= 0x1F)
+        __m128i const controls = _mm_cmpeq_epi8(_mm_subs_epu8(bytes, kMaxControl), _mm_setzero_si128());
+        __m128i const mask2 = _mm_or_si128(_mm_cmpeq_epi8(kQuotes, bytes), _mm_cmpeq_epi8(kBackslashes, bytes));
+        __m128i const mask1 = _mm_or_si128(_mm_cmpeq_epi8(kSlashes, bytes), controls);
+        int const mmask = _mm_movemask_epi8(_mm_or_si128(mask2, mask1));
+        if (mmask != 0)
+            return f + CountTrailingZeros(mmask);
+    }
+#endif
+
+    for ( ; f != l; ++f)
+    {
+        if (*f == '\\' || *f == '"' || *f == '/' || static_cast<uint8_t>(*f) <= 0x1F)
+            break;
+    }
+
+    return f;
+}
+
+// Returns whether [f, l) contains U+2028 or U+2029 (E2 80 A8 resp. E2 80 A9).
+inline bool HasLineOrParagraphSeparator(char const* f, char const* l)
+{
+    for (;;)
+    {
+        auto const p = static_cast<char const*>(std::memchr(f, '\xE2', static_cast<size_t>(l - f)));
+        if (p == nullptr || l - p < 3)
+            return false;
+        if (p[1] == '\x80' && (p[2] == '\xA8' || p[2] == '\xA9'))
+            return true;
+        f = p + 1;
+    }
+}
+
+} // namespace impl
+
 //==================================================================================================
 // Strings
 //==================================================================================================
@@ -392,21 +556,14 @@ inline UnescapeStringResult UnescapeString(char const* curr, char const* last, b
 {
     namespace unicode = json::impl::unicode;
 
-    auto SkipFast = [](char const* f, char const* l)
+    for (;;)
     {
-        for ( ; f != l; ++f)
+        auto* const next = json::impl::SkipUnescapedASCII(curr, last);
+        if (next != curr)
         {
-            if (*f == '\\' || static_cast<int8_t>(*f) < ' ')
-                break;
+            yield_n(curr, next - curr);
+            curr = next;
         }
-        return f;
-    };
-
-    for (;;)
-    {
-        auto* const next = SkipFast(curr, last);
-        yield_n(curr, next - curr);
-        curr = next;
 
         if (curr == last)
         {
@@ -555,22 +712,16 @@ inline EscapeStringResult EscapeString(char const* curr, char const* last, bool
 
     static constexpr char const kHexDigits[] = "0123456789ABCDEF";
 
-    auto SkipFast = [](char const* f, char const* l)
-    {
-        for ( ; f != l; ++f)
-        {
-            if (*f == '\\' || *f == '"' || *f == '/' || static_cast<int8_t>(*f) < ' ')
-                break;
-        }
-        return f;
-    };
-
     char const* const first = curr;
+    char const* checked = curr; // non-ASCII characters before this position are escaped one at a time
     for (;;)
     {
-        auto* const next = SkipFast(curr, last);
-        yield_n(curr, next - curr);
-        curr = next;
+        auto* const next = json::impl::SkipUnquotedASCII(curr, last);
+        if (next != curr)
+        {
+            yield_n(curr, next - curr);
+            curr = next;
+        }
 
         if (curr == last)
         {
@@ -599,6 +750,20 @@ inline EscapeStringResult EscapeString(char const* curr, char const* last, bool
         }
         else if (static_cast<uint8_t>(*curr) >= 0x80)
         {
+            // Copy valid UTF-8 up to the next character which needs to be
+            // escaped at once.
+            if (curr >= checked)
+            {
+                auto* const run_end = json::impl::SkipUnquoted(curr, last);
+                if (json::impl::IsValidUTF8(curr, run_end) && !json::impl::HasLineOrParagraphSeparator(curr, run_end))
+                {
+                    yield_n(curr, run_end - curr);
+                    curr = run_end;
+                    continue;
+                }
+                checked = run_end;
+            }
+
             auto* const f = curr;
 
             char32_t U;
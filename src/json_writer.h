@@ -0,0 +1,508 @@
+// Copyright 2018 Alexander Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "json.h"
+#include "json_numbers.h"
+#include "json_number_conversions.h"
+#include "json_parser.h"
+#include "json_strings.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace json {
+
+//==================================================================================================
+// Writer
+//==================================================================================================
+
+// Writes JSON directly to a sink, without building a Value first.
+//
+// The sink must provide the member functions
+//      void Put(char ch);
+//      void Write(char const* str, size_t len);
+// Any OutputSink can be used.
+//
+// The output is formatted as by stringify() using the same options.
+//
+// The writer does not allocate any memory. In debug builds, the structure of
+// the output is validated using JSON_ASSERT: e.g., keys must only be written
+// inside objects, and each key must be followed by exactly one value.
+//
+// The member functions return false if a string contains invalid UTF-8 and
+// options.mode is strict. The output is invalid in this case.
+//
+// begin_array() and begin_object() return false if the maximum nesting depth
+// would be exceeded. The writer is then in a failed state: all further calls
+// return false and write nothing.
+template <typename Sink = OutputSink>
+class Writer
+{
+    static constexpr uint32_t kMaxDepth = 500;
+
+    struct StackElement {
+        uint32_t count; // number of elements or members in the current array resp. object
+        bool is_object;
+        bool has_key;   // for objects: whether a key has been written and is waiting for its value
+    };
+
+    Sink& sink;
+    StringifyOptions options;
+    uint32_t stack_size = 0;
+    int curr_indent = 0;
+    bool done = false; // whether a complete value has been written
+    bool failed = false; // whether the maximum nesting depth has been exceeded
+    StackElement stack[kMaxDepth];
+
+public:
+    explicit Writer(Sink& sink_, StringifyOptions const& options_ = {})
+        : sink(sink_)
+        , options(options_)
+    {
+    }
+
+    Writer(Writer const&) = delete;
+    Writer& operator=(Writer const&) = delete;
+
+    // Returns whether a complete JSON value has been written.
+    bool is_complete() const { return done; }
+
+    // Returns the current nesting depth.
+    uint32_t depth() const { return stack_size; }
+
+    // Returns whether the maximum nesting depth has been exceeded.
+    bool has_failed() const { return failed; }
+
+    bool null()
+    {
+        if (failed)
+            return false;
+
+        BeginValue();
+        sink.Write("null", 4);
+        EndValue();
+        return true;
+    }
+
+    bool boolean(bool value)
+    {
+        if (failed)
+            return false;
+
+        BeginValue();
+        if (value)
+            sink.Write("true", 4);
+        else
+            sink.Write("false", 5);
+        EndValue();
+        return true;
+    }
+
+    bool number(double value)
+    {
+        if (failed)
+            return false;
+
+        BeginValue();
+        WriteNumber(value);
+        EndValue();
+        return true;
+    }
+
+    bool string(char const* str, size_t len)
+    {
+        if (failed)
+            return false;
+
+        BeginValue();
+        bool const success = WriteString(str, len);
+        EndValue();
+        return success;
+    }
+
+    bool string(char const* str)
+    {
+        return string(str, std::strlen(str));
+    }
+
+    bool string(std::string const& str)
+    {
+        return string(str.data(), str.size());
+    }
+
+    bool key(char const* str, size_t len)
+    {
+        if (failed)
+            return false;
+
+        BeginKey();
+        bool const success = WriteString(str, len);
+        EndKey();
+        return success;
+    }
+
+    bool key(char const* str)
+    {
+        return key(str, std::strlen(str));
+    }
+
+    bool key(std::string const& str)
+    {
+        return key(str.data(), str.size());
+    }
+
+    bool begin_array()
+    {
+        if (!CanPush())
+            return false;
+
+        BeginValue();
+        Push(/*is_object*/ false);
+        sink.Put('[');
+        return true;
+    }
+
+    bool end_array()
+    {
+        if (failed)
+            return false;
+
+        JSON_ASSERT(stack_size > 0 && !stack[stack_size - 1].is_object && "end_array() without matching begin_array()");
+
+        Pop();
+        sink.Put(']');
+        EndValue();
+        return true;
+    }
+
+    bool begin_object()
+    {
+        if (!CanPush())
+            return false;
+
+        BeginValue();
+        Push(/*is_object*/ true);
+        sink.Put('{');
+        return true;
+    }
+
+    bool end_object()
+    {
+        if (failed)
+            return false;
+
+        JSON_ASSERT(stack_size > 0 && stack[stack_size - 1].is_object && "end_object() without matching begin_object()");
+        JSON_ASSERT(!stack[stack_size - 1].has_key && "key() must be followed by a value");
+
+        Pop();
+        sink.Put('}');
+        EndValue();
+        return true;
+    }
+
+    // Write the given JSON text, which must be a single valid JSON value.
+    // The text is copied verbatim, unless pretty-printing is requested, in
+    // which case it is re-indented. Returns false if the text could not be
+    // parsed for re-indenting. The output is invalid in this case.
+    bool raw(char const* str, size_t len)
+    {
+        if (failed)
+            return false;
+
+        if (options.indent_width < 0)
+        {
+            BeginValue();
+            sink.Write(str, len);
+            EndValue();
+            return true;
+        }
+
+        RawCallbacks cb{*this};
+        auto const res = json::ParseSAX(cb, str, str + len, Mode::lenient);
+        return res.ec == ParseStatus::success;
+    }
+
+    bool raw(std::string const& str)
+    {
+        return raw(str.data(), str.size());
+    }
+
+    // Write the given JSON value.
+    bool value(Value const& val)
+    {
+        switch (val.type())
+        {
+        case Type::undefined:
+            JSON_ASSERT(false && "cannot stringify 'undefined'"); // LCOV_EXCL_LINE
+            return null();
+        case Type::null:
+            return null();
+        case Type::boolean:
+            return boolean(val.get_boolean());
+        case Type::number:
+            return number(val.get_number());
+        case Type::string:
+            return string(val.get_string());
+        case Type::array:
+            if (!begin_array())
+                return false;
+            for (auto const& v : val.get_array())
+            {
+                if (!value(v))
+                    return false;
+            }
+            return end_array();
+        case Type::object:
+            if (!begin_object())
+                return false;
+            for (auto const& kv : val.get_object())
+            {
+                if (!key(kv.first))
+                    return false;
+                if (!value(kv.second))
+                    return false;
+            }
+            return end_object();
+        case Type::raw:
+            return raw(val.get_raw());
+        default:
+            JSON_ASSERT(false && "invalid type"); // LCOV_EXCL_LINE
+            return false;
+        }
+    }
+
+private:
+    // Re-indents raw JSON text.
+    // Strings and numbers are copied verbatim.
+    struct RawCallbacks
+    {
+        Writer& w;
+
+        void WriteQuoted(char const* first, char const* last)
+        {
+            w.sink.Put('"');
+            w.sink.Write(first, static_cast<size_t>(last - first));
+            w.sink.Put('"');
+        }
+
+        ParseStatus HandleNull() { w.null(); return {}; }
+        ParseStatus HandleTrue() { w.boolean(true); return {}; }
+        ParseStatus HandleFalse() { w.boolean(false); return {}; }
+
+        ParseStatus HandleNumber(char const* first, char const* last, NumberClass /*nc*/)
+        {
+            w.BeginValue();
+            w.sink.Write(first, static_cast<size_t>(last - first));
+            w.EndValue();
+            return {};
+        }
+
+        ParseStatus HandleString(char const* first, char const* last, StringClass /*string_class*/)
+        {
+            w.BeginValue();
+            WriteQuoted(first, last);
+            w.EndValue();
+            return {};
+        }
+
+        ParseStatus HandleBeginArray() { return w.begin_array() ? ParseStatus::success : ParseStatus::max_depth_reached; }
+        ParseStatus HandleEndArray(size_t /*count*/) { w.end_array(); return {}; }
+        ParseStatus HandleEndElement(size_t& /*count*/) { return {}; }
+        ParseStatus HandleBeginObject() { return w.begin_object() ? ParseStatus::success : ParseStatus::max_depth_reached; }
+        ParseStatus HandleEndObject(size_t /*count*/) { w.end_object(); return {}; }
+        ParseStatus HandleEndMember(size_t& /*count*/) { return {}; }
+
+        ParseStatus HandleKey(char const* first, char const* last, StringClass /*string_class*/)
+        {
+            w.BeginKey();
+            WriteQuoted(first, last);
+            w.EndKey();
+            return {};
+        }
+    };
+
+    void BeginKey()
+    {
+        JSON_ASSERT(stack_size > 0 && "key() must be called inside an object");
+        JSON_ASSERT(stack[stack_size - 1].is_object && "key() must be called inside an object");
+        JSON_ASSERT(!stack[stack_size - 1].has_key && "key() must be followed by a value");
+
+        BeginElement();
+    }
+
+    void EndKey()
+    {
+        sink.Put(':');
+        if (options.indent_width >= 0)
+            sink.Put(' ');
+
+        stack[stack_size - 1].has_key = true;
+    }
+
+    void WriteIndent(int count)
+    {
+        static constexpr char const kSpaces[] = "                                                                ";
+        static constexpr size_t kNumSpaces = sizeof(kSpaces) - 1;
+
+        JSON_ASSERT(count >= 0);
+        auto n = static_cast<size_t>(count);
+        while (n > 0)
+        {
+            size_t const k = n < kNumSpaces ? n : kNumSpaces;
+            sink.Write(kSpaces, k);
+            n -= k;
+        }
+    }
+
+    // Write the separator before the next element or member of the current container.
+    void BeginElement()
+    {
+        JSON_ASSERT(stack_size > 0);
+
+        auto& top = stack[stack_size - 1];
+        if (top.count > 0)
+        {
+            sink.Put(',');
+            if (options.indent_width == 0)
+                sink.Put(' ');
+        }
+        if (options.indent_width > 0)
+        {
+            sink.Put('\n');
+            WriteIndent(curr_indent);
+        }
+        ++top.count;
+    }
+
+    void BeginValue()
+    {
+        JSON_ASSERT(!done && "a complete JSON value has already been written");
+
+        if (stack_size == 0)
+            return;
+
+        auto& top = stack[stack_size - 1];
+        if (top.is_object)
+        {
+            JSON_ASSERT(top.has_key && "object members must start with key()");
+            top.has_key = false;
+        }
+        else
+        {
+            BeginElement();
+        }
+    }
+
+    void EndValue()
+    {
+        if (stack_size == 0)
+            done = true;
+    }
+
+    bool CanPush()
+    {
+        if (failed)
+            return false;
+
+        if (stack_size >= kMaxDepth)
+        {
+            failed = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    void Push(bool is_object)
+    {
+        JSON_ASSERT(stack_size < kMaxDepth);
+
+        stack[stack_size] = {0, is_object, false};
+        ++stack_size;
+        if (options.indent_width > 0)
+            curr_indent += options.indent_width;
+    }
+
+    void Pop()
+    {
+        JSON_ASSERT(stack_size > 0);
+
+        --stack_size;
+        if (options.indent_width > 0)
+        {
+            curr_indent -= options.indent_width;
+            if (stack[stack_size].count > 0)
+            {
+                sink.Put('\n');
+                WriteIndent(curr_indent);
+            }
+        }
+    }
+
+    void WriteNumber(double value)
+    {
+        char buf[32];
+        char* end;
+
+        if (options.single_precision)
+        {
+            // NB: Rounding might produce +-Infinity.
+            float const f = numbers::ToSingle(value);
+            if (options.mode == Mode::strict && !std::isfinite(f))
+            {
+                sink.Write("null", 4);
+                return;
+            }
+            end = numbers::FloatToString(buf, 32, f, /*force_trailing_dot_zero*/ true);
+        }
+        else
+        {
+            if (options.mode == Mode::strict && !std::isfinite(value))
+            {
+                sink.Write("null", 4);
+                return;
+            }
+            end = numbers::NumberToString(buf, 32, value, /*force_trailing_dot_zero*/ true);
+        }
+
+        sink.Write(buf, static_cast<size_t>(end - buf));
+    }
+
+    bool WriteString(char const* str, size_t len)
+    {
+        bool success = true;
+
+        sink.Put('"');
+        if (len != 0)
+        {
+            auto const res = strings::EscapeString(str, str + len, /*allow_invalid_unicode*/ options.mode != Mode::strict,
+                [&](char ch) { sink.Put(ch); },
+                [&](char const* p, intptr_t n) { sink.Write(p, static_cast<size_t>(n)); });
+            success = res.ec == strings::Status::success;
+        }
+        sink.Put('"');
+
+        return success;
+    }
+};
+
+} // namespace json
@@ -1,10 +1,10 @@
 FLOAT_POW5_INV_BITCOUNT = 64 # 60
 FLOAT_POW5_BITCOUNT = 64 # 63
 
-# MIN_EXPONENT = -29
-# MAX_EXPONENT =  47
-MIN_EXPONENT = -30
-MAX_EXPONENT =  46
+# MIN_EXPONENT = -30
+# MAX_EXPONENT =  46
+MIN_EXPONENT = -29
+MAX_EXPONENT =  47
 
 def FloorLog2Pow5(e):
     return (e * 1217359) >> 19
@@ -17,6 +17,7 @@
 #include <limits>
 #include <cstring>
 #include <cmath>
+#include <thread>
 
 template <typename T> void Unused(T&& /*unused*/) {}
 
@@ -341,7 +342,9 @@ TEST_CASE("Parse")
 #include <forward_list>
 #include <iterator>
 #include <list>
+#include <map>
 #include <set>
+#include <unordered_map>
 
 //namespace xxx {
 //    struct S {};
@@ -770,6 +773,11 @@ static const StringTest kTestStrings[] = {
     {"[\"\\u00A2\"]", "\xC2\xA2"},
     {"[\"\\u20AC\"]", "\xE2\x82\xAC"},
     {"[\"\\uD834\\uDD1E\"]", "\xF0\x9D\x84\x9E"},
+    {"[\"\\uabcd\\uABCD\\uaBcD\"]", "\xEA\xAF\x8D\xEA\xAF\x8D\xEA\xAF\x8D"},
+    {"[\"\\u0fF0\\u9fA9\"]", "\xE0\xBF\xB0\xE9\xBE\xA9"},
+    {"[\"0123456789abcdef0123456789abcdef0123456789\\nabcdef\"]", "0123456789abcdef0123456789abcdef0123456789\nabcdef"},
+    {"[\"0123456789abcdef0123456789abcdef\\u00e4bcdef0123456789abcdef\"]", "0123456789abcdef0123456789abcdef\xC3\xA4" "bcdef0123456789abcdef"},
+    {"[\"0123456789abcdef0123456789abcde\xC3\xA4\"]", "0123456789abcdef0123456789abcde\xC3\xA4"},
 };
 
 TEST_CASE("Parse_string")
@@ -804,6 +812,18 @@ TEST_CASE("Invalid/incomplete strings")
 {
     static const std::string kStrings[] = {
         "[\"0123456789ABCDEF",
+        "[\"\\u123\"]",
+        "[\"\\u12G4\"]",
+        "[\"\\u12g4\"]",
+        "[\"\\u:000\"]",
+        "[\"\\u/000\"]",
+        "[\"\\u@000\"]",
+        "[\"\\u`000\"]",
+        "[\"\\u00\xC3\xA4\"]",
+        "[\"0123456789abcdef0123456789abcdef\\u0\"]",
+        "[\"\\u\x10\x10\x10\x10\"]",
+        "[\"\\u\x19\x19\x19\x19\"]",
+        "[\"\\u00\x11\x15\"]",
     };
 
     for (auto const& s : kStrings) {
@@ -1249,6 +1269,57 @@ TEST_CASE("Value - object op")
     CHECK(j3.get_ptr("Zwei") == nullptr);
 }
 
+TEST_CASE("Value - object op with Key")
+{
+    using namespace json::literals;
+
+    static constexpr json::Key kEins = "eins"_jk;
+    static_assert(kEins.size() == 4, "");
+    static_assert(kEins.hash() == json::impl::KeyHash("eins", 4), "");
+
+    json::Value j;
+    j[kEins] = 1;
+    CHECK(j.is_object());
+    CHECK(j.size() == 1);
+    CHECK(j["eins"] == 1);
+    CHECK(&j[kEins] == &j["eins"]);
+
+    j["zwei"_jk] = "zwei";
+    j["ein"_jk] = 0;
+    j["einsx"_jk] = 2;
+    j[""_jk] = 3;
+    j[json::Key("nul\0", 4)] = 4;
+    CHECK(j.size() == 6);
+    CHECK(j[kEins] == 1);
+    CHECK(j[""] == 3);
+    CHECK(j[std::string("nul\0", 4)] == 4);
+
+    json::Value const& cj = j;
+    CHECK(cj[kEins] == 1);
+    CHECK(cj["ein"_jk] == 0);
+    CHECK(cj["einsx"_jk] == 2);
+    CHECK(cj["nul"_jk].is_undefined());
+    CHECK(cj["drei"_jk].is_undefined());
+
+    CHECK(j.has_member("zwei"_jk));
+    CHECK(!j.has_member("Zwei"_jk));
+    CHECK(j.get_ptr("zwei"_jk) == j.get_ptr("zwei"));
+    CHECK(cj.get_ptr("zwei"_jk) == cj.get_ptr("zwei"));
+    CHECK(j.get_ptr("zwe"_jk) == nullptr);
+
+    CHECK(j.erase("zwei"_jk) == 1);
+    CHECK(j.erase("zwei"_jk) == 0);
+    CHECK(!j.has_member("zwei"));
+    CHECK(j.size() == 5);
+
+    CHECK("eins"_jk == std::string("eins"));
+    CHECK("eins"_jk != std::string("ein"));
+    CHECK("ein"_jk < std::string("eins"));
+    CHECK(std::string("eins") < "einsx"_jk);
+    CHECK(!("eins"_jk < std::string("eins")));
+    CHECK("\xFF"_jk.compare("a") > 0);
+}
+
 TEST_CASE("Iterators")
 {
     SECTION("array")
@@ -1364,6 +1435,53 @@ TEST_CASE("as")
     Unused(x);
 }
 
+TEST_CASE("as - containers")
+{
+    SECTION("vector of numbers")
+    {
+        json::Value j = json::Array{1, 2.5, -3, 1e10};
+        CHECK(j.as<std::vector<double>>() == (std::vector<double>{1, 2.5, -3, 1e10}));
+        CHECK(j.as<std::vector<float>>() == (std::vector<float>{1, 2.5f, -3, 1e10f}));
+        CHECK(j.as<std::vector<int>>()[2] == -3);
+
+        CHECK(json::Value(json::Array{}).as<std::vector<double>>().empty());
+    }
+
+    SECTION("move elements out of rvalues")
+    {
+        std::string const long_string(100, 'x');
+
+        json::Value j = json::Array{long_string, long_string};
+        char const* data = j[1].get_string().data();
+
+        auto vec = std::move(j).as<std::vector<std::string>>();
+        REQUIRE(vec.size() == 2);
+        CHECK(vec[1] == long_string);
+        CHECK(vec[1].data() == data);
+
+        json::Value o = json::Object{{"a", long_string}};
+        data = o["a"].get_string().data();
+
+        auto map = std::move(o).as<std::map<std::string, std::string>>();
+        CHECK(map["a"] == long_string);
+        CHECK(map["a"].data() == data);
+    }
+
+    SECTION("objects")
+    {
+        std::map<std::string, int> const map{{"a", 1}, {"b", 2}, {"c", 3}};
+        json::Value j = map;
+        CHECK(j == json::Object{{"a", 1}, {"b", 2}, {"c", 3}});
+        CHECK(j.as<std::map<std::string, int>>() == map);
+        CHECK(j.as<std::unordered_map<std::string, int>>() == (std::unordered_map<std::string, int>{{"a", 1}, {"b", 2}, {"c", 3}}));
+
+        // Unordered input.
+        std::unordered_map<std::string, int> const unordered{{"z", 1}, {"a", 2}, {"m", 3}};
+        json::Value u = unordered;
+        CHECK(u == json::Object{{"a", 2}, {"m", 3}, {"z", 1}});
+    }
+}
+
 #if JSON_VALUE_ALLOW_UNDEFINED_ACCESS
 TEST_CASE("undefined")
 {
@@ -1562,3 +1680,394 @@ TEST_CASE("NaN/Inf")
     CHECK(json::ParseStatus::unrecognized_identifier == json::parse(j, "infinity"));
     CHECK(json::ParseStatus::unrecognized_identifier == json::parse(j, "InfinityInfinityInfinity"));
 }
+
+TEST_CASE("Value - raw")
+{
+    json::Value j(json::raw_tag, R"({"a":[1,2]})");
+    CHECK(j.is_raw());
+    CHECK(j.type() == json::Type::raw);
+    CHECK(!j.is_primitive());
+    CHECK(!j.is_structured());
+    CHECK(j.get_raw() == R"({"a":[1,2]})");
+
+    json::Value k = j;
+    CHECK(k.is_raw());
+    CHECK(k == j);
+    CHECK(k.hash() == j.hash());
+
+    // Raw values compare their text.
+    k.assign(json::raw_tag, R"({"a": [1, 2]})");
+    CHECK(k != j);
+    CHECK(k < j);
+    CHECK(json::Value(json::Object{}) < k);
+
+    k = "string";
+    CHECK(k.is_string());
+    k.assign(json::raw_tag, "[]");
+    CHECK(k.is_raw());
+    k = json::Array{1, 2};
+    CHECK(k.is_array());
+
+    j = json::Value(json::Type::raw);
+    CHECK(j.get_raw() == "null");
+}
+
+TEST_CASE("Parse - capture raw")
+{
+    static constexpr char const* input = R"({"data": [1, {"x": "ä"}, [] ], "id": 7, "meta": {"k": "v"}})";
+
+    json::ParseOptions options;
+    options.capture_raw = [](json::String const& key) { return key == "data" || key == "k"; };
+
+    json::Value j;
+    REQUIRE(json::parse(j, input, options) == json::ParseStatus::success);
+    CHECK(j["data"].is_raw());
+    CHECK(j["data"].get_raw() == R"([1, {"x": "ä"}, [] ])");
+    CHECK(j["id"] == 7);
+    CHECK(j["meta"].is_object());
+    CHECK(j["meta"]["k"].is_raw());
+    CHECK(j["meta"]["k"].get_raw() == R"("v")");
+
+    // Captured values are validated.
+    CHECK(json::parse(j, R"({"data": [1, 2,]})", options) == json::ParseStatus::expected_value);
+    CHECK(json::parse(j, R"({"data": [1, "\uD800"]})", options) == json::ParseStatus::invalid_string);
+    CHECK(json::parse(j, R"({"data": {"\uDFFF": 1}})", options) == json::ParseStatus::invalid_string);
+    CHECK(json::parse(j, R"({"data": [NaN]})", options) == json::ParseStatus::invalid_number);
+
+    // Array elements and the top-level value are never captured.
+    options.capture_raw = [](json::String const&) { return true; };
+    REQUIRE(json::parse(j, R"([{"a": {"b": 1}}, 2])", options) == json::ParseStatus::success);
+    CHECK(j.is_array());
+    CHECK(j[0].is_object());
+    CHECK(j[0]["a"].is_raw());
+    CHECK(j[0]["a"].get_raw() == R"({"b": 1})");
+    CHECK(j[1] == 2);
+
+    options.mode = json::Mode::lenient;
+    REQUIRE(json::parse(j, R"({a: [1, /*two*/ 2,],})", options) == json::ParseStatus::success);
+    CHECK(j["a"].get_raw() == R"([1, /*two*/ 2,])");
+}
+
+TEST_CASE("Parse - lazy")
+{
+    static constexpr char const* input = R"({"id": 1, "body": {"text": "]\"[}", "list": [1, [2, {"x": "{"}], []], "empty": {}}, "tags": ["a", "b"]})";
+
+    json::Value expected;
+    REQUIRE(json::parse(expected, input) == json::ParseStatus::success);
+
+    json::ParseOptions options;
+    options.lazy = true;
+
+    json::Value j;
+    REQUIRE(json::parse(j, input, options) == json::ParseStatus::success);
+    CHECK(!j.is_lazy());
+    CHECK(j["id"] == 1);
+    CHECK(j["body"].is_lazy());
+    CHECK(j["body"].is_object());
+    CHECK(j["tags"].is_lazy());
+    CHECK(j["tags"].is_array());
+
+    // Copies are lazy, too.
+    json::Value const body = j["body"];
+    CHECK(body.is_lazy());
+
+    // Accessing the contents expands a single level.
+    CHECK(body["text"] == "]\"[}");
+    CHECK(!body.is_lazy());
+    CHECK(body["list"].is_lazy());
+    CHECK(body["list"].size() == 3);
+    CHECK(body["list"][1].is_lazy());
+    CHECK(body["list"][1][1]["x"] == "{");
+    CHECK(j["body"].is_lazy());
+
+    CHECK(j == expected);
+    CHECK(j.hash() == expected.hash());
+
+    std::string str;
+    CHECK(json::stringify(str, j));
+    std::string expected_str;
+    CHECK(json::stringify(expected_str, expected));
+    CHECK(str == expected_str);
+
+    // The contents of lazy values are validated.
+    CHECK(json::parse(j, R"({"a": {"b": [1, 2,]}, "d": 1})", options) == json::ParseStatus::expected_value);
+    CHECK(json::parse(j, R"({"a":[1,2,,]})", options) == json::ParseStatus::expected_value);
+    CHECK(json::parse(j, R"({"a": [[1], [2 3]]})", options) == json::ParseStatus::expected_comma_or_closing_bracket);
+    CHECK(json::parse(j, R"([{"a": 1e}])", options) == json::ParseStatus::invalid_number);
+    CHECK(json::parse(j, "[[\"\\x\"]]", options) == json::ParseStatus::invalid_string);
+    CHECK(json::parse(j, "[[\"\xFF\"]]", options) == json::ParseStatus::invalid_string);
+    CHECK(json::parse(j, "[{\"\xFF\": 1}]", options) == json::ParseStatus::invalid_string);
+    CHECK(json::parse(j, "[[NaN]]", options) == json::ParseStatus::invalid_number);
+
+    CHECK(json::parse(j, R"({"a": [1, "]", 2)", options) == json::ParseStatus::expected_comma_or_closing_bracket);
+    CHECK(json::parse(j, R"([1, {"a": "}")", options) == json::ParseStatus::expected_comma_or_closing_brace);
+
+    // Lenient mode: comments may contain brackets.
+    options.mode = json::Mode::lenient;
+    REQUIRE(json::parse(j, "[[1, /* ] */ 2], {// }\n a: 1}]", options) == json::ParseStatus::success);
+    CHECK(j[0].is_lazy());
+    CHECK(j[0].expand() == json::ParseStatus::success);
+    CHECK(j[0] == json::Array{1, 2});
+    CHECK(j[1]["a"] == 1);
+
+    // Assigning to a lazy value.
+    j[1] = "x";
+    CHECK(j[1] == "x");
+}
+
+TEST_CASE("Parse - share duplicates")
+{
+    static constexpr char const* input = R"({"a": {"x": [1, 2], "y": "s"}, "b": [{"x": [1, 2], "y": "s"}, {"x": [1, 2], "y": "t"}], "c": [1, 2], "d": []})";
+
+    json::Value expected;
+    REQUIRE(json::parse(expected, input) == json::ParseStatus::success);
+
+    json::ParseOptions options;
+    options.share_duplicates = true;
+
+    json::Value j;
+    REQUIRE(json::parse(j, input, options) == json::ParseStatus::success);
+    CHECK(j == expected);
+    CHECK(j.hash() == expected.hash());
+
+    json::Value const& cj = j;
+    CHECK(cj.is_shared());
+    CHECK(cj["a"].is_shared());
+    CHECK(!cj["a"]["y"].is_shared()); // strings are not shared
+    CHECK(!cj["a"].is_lazy());
+
+    // Identical subtrees share a single node.
+    CHECK(&cj["a"].get_object() == &cj["b"][0].get_object());
+    CHECK(&cj["a"]["x"].get_array() == &cj["c"].get_array());
+    CHECK(&cj["b"][1]["x"].get_array() == &cj["c"].get_array());
+    CHECK(&cj["a"].get_object() != &cj["b"][1].get_object());
+    CHECK(cj["a"] == cj["b"][0]);
+    CHECK(cj["a"] != cj["b"][1]);
+    CHECK(cj["a"].hash() == expected["a"].hash());
+
+    // Copies share the node.
+    json::Value const copy = cj["a"];
+    CHECK(copy.is_shared());
+    CHECK(&copy.get_object() == &cj["a"].get_object());
+    json::Value assigned;
+    assigned = cj["c"];
+    CHECK(assigned.is_shared());
+    CHECK(&static_cast<json::Value const&>(assigned).get_array() == &cj["c"].get_array());
+
+    // Mutable access copies the node.
+    j["b"][0]["x"].get_array().push_back(3);
+    CHECK(!j["b"].is_shared());
+    CHECK(!j["b"][0].is_shared());
+    CHECK(!j["b"][0]["x"].is_shared());
+    CHECK(j["b"][0]["x"] == json::Array{1, 2, 3});
+    CHECK(cj["a"]["x"] == json::Array{1, 2});
+    CHECK(cj["c"] == json::Array{1, 2});
+    CHECK(copy == expected["a"]);
+    CHECK(cj["b"][1].is_shared());
+
+    j["a"]["y"] = "z";
+    CHECK(j["a"]["y"] == "z");
+    CHECK(copy["y"] == "s");
+
+    // Moving out of a shared value.
+    json::Value moved = std::move(j["d"]);
+    CHECK(moved.is_shared());
+    CHECK(j["d"].is_undefined());
+    auto arr = std::move(moved).get_array();
+    CHECK(arr.empty());
+
+    // Assigning from a (possibly) shared value.
+    json::Value k = cj["c"];
+    k.assign(json::array_tag, k.get_array());
+    CHECK(k == json::Array{1, 2});
+    k = json::Array{3};
+    CHECK(k == json::Array{3});
+    CHECK(cj["c"] == json::Array{1, 2});
+
+    json::Value s;
+    REQUIRE(json::parse(s, R"(["abc", ["abc"], ["abc"]])", options) == json::ParseStatus::success);
+    json::Value t = s[1];
+    t[0].get_string() += "d";
+    CHECK(t[0] == "abcd");
+    CHECK(s[2][0] == "abc");
+}
+
+TEST_CASE("Parse - share duplicates - signed zeros")
+{
+    json::ParseOptions options;
+    options.share_duplicates = true;
+
+    json::Value j;
+    REQUIRE(json::parse(j, R"([[0.0], [-0.0], {"a": -0.0}, {"a": 0.0}, [-0.0]])", options) == json::ParseStatus::success);
+
+    json::Value const& cj = j;
+    CHECK(!std::signbit(cj[0][0].get_number()));
+    CHECK(std::signbit(cj[1][0].get_number()));
+    CHECK(std::signbit(cj[2]["a"].get_number()));
+    CHECK(!std::signbit(cj[3]["a"].get_number()));
+    CHECK(&cj[0].get_array() != &cj[1].get_array());
+    CHECK(&cj[2].get_object() != &cj[3].get_object());
+    CHECK(&cj[1].get_array() == &cj[4].get_array());
+    std::string str;
+    CHECK(json::stringify(str, j));
+    CHECK(str == "[[0],[-0.0],{\"a\":-0.0},{\"a\":0},[-0.0]]");
+}
+
+TEST_CASE("Value - share")
+{
+    json::Value original;
+    REQUIRE(json::parse(original, R"({"config": {"name": "x", "limits": [1, 2, 3]}, "other": {"list": ["a", "b"]}, "n": 1})") == json::ParseStatus::success);
+    json::Value const expected = original;
+
+    original.share();
+    CHECK(original.is_shared());
+    CHECK(original == expected);
+
+    json::Value const& co = original;
+    CHECK(co["config"].is_shared());
+    CHECK(co["config"]["name"].is_shared());
+    CHECK(!co["n"].is_shared());
+
+    // Copies are O(1).
+    json::Value copy = original;
+    CHECK(copy.is_shared());
+    json::Value const& cc = copy;
+    CHECK(&cc.get_object() == &co.get_object());
+
+    // Modifying the copy only copies the path to the modified value.
+    copy["config"]["limits"][1] = 20;
+    CHECK(copy["config"]["limits"] == json::Array{1, 20, 3});
+    CHECK(original == expected);
+    CHECK(!cc.is_shared());
+    CHECK(!cc["config"].is_shared());
+    CHECK(cc["config"]["name"].is_shared());
+    CHECK(&cc["config"]["name"].get_string() == &co["config"]["name"].get_string());
+    CHECK(cc["other"].is_shared());
+    CHECK(&cc["other"].get_object() == &co["other"].get_object());
+
+    // Sharing again only shares the copied nodes.
+    copy.share();
+    CHECK(cc.is_shared());
+    CHECK(&cc["other"].get_object() == &co["other"].get_object());
+
+    // Lazy values are expanded.
+    json::ParseOptions options;
+    options.lazy = true;
+    json::Value lazy;
+    REQUIRE(json::parse(lazy, R"({"a": [1, {"b": 2}]})", options) == json::ParseStatus::success);
+    CHECK(lazy["a"].is_lazy());
+    lazy.share();
+    json::Value const& cl = lazy;
+    CHECK(!cl["a"].is_lazy());
+    CHECK(cl["a"][1].is_shared());
+    CHECK(cl["a"][1]["b"] == 2);
+
+    json::Value scalar = 1.0;
+    scalar.share();
+    CHECK(!scalar.is_shared());
+
+    // Moving out of a shared raw value does not modify the other copies.
+    json::Value raw(json::raw_tag, "[1, 2]");
+    raw.share();
+    CHECK(raw.is_shared());
+    json::Value raw_copy = raw;
+    CHECK(std::move(raw_copy).get_raw() == "[1, 2]");
+    CHECK(raw.get_raw() == "[1, 2]");
+}
+
+TEST_CASE("Value - clone_compact")
+{
+    json::Value original;
+    REQUIRE(json::parse(original, R"({"a": [1, "two", {"b": null, "c": [true]}], "d": {}, "e": "x"})") == json::ParseStatus::success);
+    original["a"].get_array().reserve(100);
+
+    json::Value clone = original.clone_compact();
+    CHECK(clone == original);
+    CHECK(clone["a"].get_array().capacity() == 3);
+
+    clone["a"][2]["c"][0] = false;
+    CHECK(original["a"][2]["c"][0] == true);
+
+    // Shared and lazy values are copied, too.
+    json::Value shared = original;
+    shared.share();
+    json::Value const unshared = shared.clone_compact();
+    CHECK(unshared == original);
+    CHECK(!unshared.is_shared());
+    CHECK(!unshared["a"][1].is_shared());
+
+    json::ParseOptions options;
+    options.lazy = true;
+    json::Value lazy;
+    REQUIRE(json::parse(lazy, R"([[1, 2], {"x": [3]}])", options) == json::ParseStatus::success);
+    json::Value const expanded = lazy.clone_compact();
+    CHECK(!expanded.is_lazy());
+    CHECK(!expanded[1].is_lazy());
+    CHECK(expanded == json::Array{json::Array{1, 2}, json::Object{{"x", json::Array{3}}}});
+
+    CHECK(json::Value(1.5).clone_compact() == 1.5);
+    CHECK(json::Value(json::raw_tag, "[1]").clone_compact().get_raw() == "[1]");
+}
+
+TEST_CASE("Value - compact")
+{
+    json::Value value;
+    REQUIRE(json::parse(value, R"({"a": [1, "two", {"b": null}], "c": "a string which does not fit into the small buffer"})") == json::ParseStatus::success);
+    json::Value const expected = value;
+
+    CHECK(json::compact(value) == 0);
+    CHECK(value == expected);
+
+    value["a"].get_array().reserve(100);
+    value["c"].get_string().reserve(1000);
+    size_t const saved = json::compact(value);
+    CHECK(saved >= 97 * sizeof(json::Value) + 900);
+    CHECK(value == expected);
+    CHECK(value["a"].get_array().capacity() == 3);
+
+    // Shared nodes and lazy values are kept.
+    json::Value shared = expected;
+    shared["a"].share();
+    json::ParseOptions options;
+    options.lazy = true;
+    REQUIRE(json::parse(shared["lazy"], "[[1, 2]]", options) == json::ParseStatus::success);
+    json::Value const& cs = shared;
+    auto const* shared_array = &cs["a"].get_array();
+    json::compact(shared);
+    CHECK(cs["a"].is_shared());
+    CHECK(&cs["a"].get_array() == shared_array);
+    CHECK(cs["lazy"][0].is_lazy());
+    CHECK(cs["lazy"][0] == json::Array{1, 2});
+}
+
+TEST_CASE("Value - share across threads")
+{
+    json::Value snapshot;
+    for (int i = 0; i < 100; ++i)
+        snapshot["key" + std::to_string(i)] = json::Array{i, std::to_string(i), json::Object{{"x", i}}};
+    json::Value const expected_snapshot = snapshot;
+    snapshot.share();
+
+    std::vector<std::thread> threads;
+    std::vector<int> ok(4);
+    for (int t = 0; t < 4; ++t)
+    {
+        json::Value copy = snapshot;
+        threads.emplace_back([copy, t, &ok]() mutable {
+            bool success = true;
+            for (int i = 0; i < 100; ++i)
+            {
+                json::Value request = copy;
+                request["key" + std::to_string(i)][2]["x"] = t;
+                success = success && request["key" + std::to_string(i)][2]["x"] == t;
+                success = success && static_cast<json::Value const&>(copy)["key" + std::to_string(i)][2]["x"] == i;
+            }
+            ok[static_cast<size_t>(t)] = success;
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(ok == std::vector<int>(4, 1));
+    CHECK(snapshot == expected_snapshot);
+}
@@ -91,6 +91,8 @@ inline char const* ParseStatusDescr(json::ParseStatus ec)
         return "invalid string";
     case json::ParseStatus::max_depth_reached:
         return "max. depth reached";
+    case json::ParseStatus::schema_violation:
+        return "schema violation";
     case json::ParseStatus::unknown:
         assert(false && "unreachable");
         return "unknown";
@@ -1,3 +1,4 @@
+#include "../src/json_parser.h"
 #include "../src/json_strings.h"
 #include "../src/json.h"
 #include "catch.hpp"
@@ -277,3 +278,80 @@ TEST_CASE("Invalid UTF-8 (Unicode 11.0)")
     test("\xF4\x91\x92\x93\xFF\x41\x80\xBF\x42", "\\uFFFD" "\\uFFFD" "\\uFFFD" "\\uFFFD" "\\uFFFD" "\x41" "\\uFFFD""\\uFFFD" "\x42");
     test("\xE1\x80\xE2\xF0\x91\x92\xF1\xBF\x41", "\\uFFFD" "\\uFFFD" "\\uFFFD" "\\uFFFD" "\x41");
 }
+
+static json::StringClass LexStringClass(std::string const& input)
+{
+    std::string const str = "\"" + input + "\"";
+
+    json::Lexer lexer;
+    lexer.SetInput(str.data(), str.data() + str.size());
+
+    json::Token const tok = lexer.LexString();
+    CHECK(tok.kind == json::TokenKind::string);
+    return tok.string_class;
+}
+
+TEST_CASE("IsValidUTF8")
+{
+    // Move the sequences over the 16-byte block boundaries.
+    std::string const padding = "0123456789abcdef0123456789abcdef";
+
+    for (auto const& test : kInvalidUTF8)
+    {
+        CAPTURE(ToPrintableString(test.input));
+
+        for (size_t n = 0; n <= 17; ++n)
+        {
+            std::string const input = padding.substr(0, n) + test.input + padding.substr(0, 17 - n);
+            CHECK(!json::impl::IsValidUTF8(input.data(), input.data() + input.size()));
+            CHECK(LexStringClass(input) == json::StringClass::needs_cleaning);
+        }
+    }
+
+    for (uint32_t U = 0x20; U <= 0x10FFFF; U += (U < 0x10000 ? 1 : 61))
+    {
+        if (U >= 0xD800 && U <= 0xDFFF)
+            continue;
+
+        std::string seq;
+        json::impl::unicode::EncodeUTF8(static_cast<char32_t>(U), [&](char ch) { seq += ch; });
+        if (seq == "\"" || seq == "\\")
+            continue;
+
+        // NB: Only check some offsets for the 2-, 3- and 4-byte sequences.
+        size_t const n = U % 17;
+        std::string const input = padding.substr(0, n) + seq + seq + padding.substr(0, 17 - n);
+
+        CAPTURE(U);
+        CHECK(json::impl::IsValidUTF8(input.data(), input.data() + input.size()));
+        CHECK(LexStringClass(input) == json::StringClass::clean);
+    }
+
+    // Valid UTF-8, but not clean.
+    CHECK(LexStringClass("\xC3\xA4\\n") == json::StringClass::needs_cleaning);
+    CHECK(LexStringClass("\xC3\xA4\x1F") == json::StringClass::needs_cleaning);
+    CHECK(LexStringClass("0123456789abcdef\xC3\xA4\x1F") == json::StringClass::needs_cleaning);
+    CHECK(LexStringClass("0123456789abcdef\x1F\xC3\xA4") == json::StringClass::needs_cleaning);
+    CHECK(LexStringClass("0123456789abcd\xC3\xA4\\\"0123456789abcdef") == json::StringClass::needs_cleaning);
+
+    // Invalid UTF-8 after the end of the string.
+    {
+        std::string const str = "\"0123456789\xC3\xA4\"\xC3\xC3\xC3\xC3";
+        json::Lexer lexer;
+        lexer.SetInput(str.data(), str.data() + str.size());
+        json::Token const tok = lexer.LexString();
+        CHECK(tok.kind == json::TokenKind::string);
+        CHECK(tok.string_class == json::StringClass::clean);
+    }
+}
+
+TEST_CASE("Parse non-ASCII strings")
+{
+    std::string const input = R"(["Gr)" "\xC3\xBC\xC3\x9F" R"(e", {"Stra)" "\xC3\x9F" R"(e": ")" "\xF0\x9D\x84\x9E" R"("}])";
+
+    json::Value j;
+    auto const ec = json::parse(j, input);
+    REQUIRE(ec == json::ParseStatus::success);
+    CHECK(j[0].get_string() == "Gr\xC3\xBC\xC3\x9F" "e");
+    CHECK(j[1]["Stra\xC3\x9F" "e"].get_string() == "\xF0\x9D\x84\x9E");
+}
@@ -0,0 +1,140 @@
+#include "catch.hpp"
+#include "../src/json.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// The number of allocations on this thread which succeed before operator new
+// throws std::bad_alloc, or -1 if allocations never fail.
+static thread_local long allocations_left = -1;
+
+void* operator new(size_t size)
+{
+    if (allocations_left == 0)
+        throw std::bad_alloc();
+    if (allocations_left > 0)
+        --allocations_left;
+
+    if (void* p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    try { return ::operator new(size); } catch (...) { return nullptr; }
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+    try { return ::operator new(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t /*size*/) noexcept { std::free(p); }
+void operator delete[](void* p, size_t /*size*/) noexcept { std::free(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { std::free(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { std::free(p); }
+
+// Calls F with an allocator which fails after 0, 1, 2, ... allocations, until
+// F returns normally. ON_FAILURE is called (with a working allocator) after
+// each failed call. Returns the number of failed calls.
+template <typename F, typename OnFailure>
+static int WithFailingAllocator(F f, OnFailure on_failure)
+{
+    for (int n = 0; ; ++n)
+    {
+        allocations_left = n;
+        try
+        {
+            f();
+            allocations_left = -1;
+            return n;
+        }
+        catch (std::bad_alloc const&)
+        {
+            allocations_left = -1;
+            on_failure();
+        }
+    }
+}
+
+static constexpr char const* kInput = R"({"a": {"x": [1, 2], "y": "s"}, "b": [{"x": [1, 2], "y": "s"}, {"x": [1, 2], "y": "t"}], "c": [1, 2], "d": []})";
+
+TEST_CASE("Allocation failure - parse with share_duplicates")
+{
+    json::Value expected;
+    REQUIRE(json::parse(expected, kInput) == json::ParseStatus::success);
+
+    json::ParseOptions options;
+    options.share_duplicates = true;
+
+    json::Value j;
+    int const failures = WithFailingAllocator(
+        [&] {
+            json::Value v;
+            json::parse(v, kInput, kInput + std::strlen(kInput), options);
+            j = std::move(v);
+        },
+        [] {});
+    CHECK(failures > 0);
+    CHECK(j == expected);
+}
+
+TEST_CASE("Allocation failure - share")
+{
+    json::Value expected;
+    REQUIRE(json::parse(expected, kInput) == json::ParseStatus::success);
+
+    json::Value j = expected;
+    int const failures = WithFailingAllocator(
+        [&] { j.share(); },
+        [&] {
+            // Partially shared, but still valid.
+            CHECK(j == expected);
+            json::Value copy = j;
+            copy["b"][1]["y"] = "u";
+            CHECK(j == expected);
+        });
+    CHECK(failures > 0);
+    CHECK(j.is_shared());
+    CHECK(j == expected);
+}
+
+TEST_CASE("Allocation failure - lazy values")
+{
+    json::Value expected;
+    REQUIRE(json::parse(expected, kInput) == json::ParseStatus::success);
+
+    json::ParseOptions options;
+    options.lazy = true;
+
+    json::Value lazy;
+    REQUIRE(json::parse(lazy, kInput, kInput + std::strlen(kInput), options).ec == json::ParseStatus::success);
+
+    // Implicit expansion through the accessors.
+    json::Value j = lazy;
+    json::Value const& cj = j;
+    int const failures = WithFailingAllocator(
+        [&] { static_cast<void>(cj["b"][1]["x"].size()); },
+        [&] { CHECK(j == expected); });
+    CHECK(failures > 0);
+    CHECK(j == expected);
+
+    // Explicit expansion.
+    json::Value k = lazy;
+    json::ParseStatus ec = json::ParseStatus::unknown;
+    int const failures2 = WithFailingAllocator(
+        [&] { ec = k.expand(); },
+        [&] { CHECK(k == expected); });
+    CHECK(failures2 > 0);
+    CHECK(ec == json::ParseStatus::success);
+    CHECK(k == expected);
+}
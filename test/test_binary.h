@@ -0,0 +1,36 @@
+#pragma once
+
+#include "catch.hpp"
+#include "../src/json.h"
+
+#include <string>
+
+// Helpers for the CBOR and MessagePack tests.
+
+inline std::string FromHex(char const* hex)
+{
+    auto const digit = [](char ch) { return ch <= '9' ? ch - '0' : (ch | 0x20) - 'a' + 10; };
+
+    std::string bytes;
+    for ( ; hex[0] != '\0'; hex += 2)
+    {
+        bytes.push_back(static_cast<char>(digit(hex[0]) * 16 + digit(hex[1])));
+    }
+    return bytes;
+}
+
+// ENCODE is json::cbor::encode or json::msgpack::encode.
+inline std::string EncodeWith(bool (*encode)(std::string&, json::Value const&, json::Mode), json::Value const& value)
+{
+    std::string bytes;
+    CHECK(encode(bytes, value, json::Mode::strict));
+    return bytes;
+}
+
+// DECODE is json::cbor::decode or json::msgpack::decode.
+inline json::Value DecodeWith(json::ParseStatus (*decode)(json::Value&, std::string const&, json::Mode), std::string const& bytes, json::Mode mode)
+{
+    json::Value value;
+    CHECK(decode(value, bytes, mode) == json::ParseStatus::success);
+    return value;
+}
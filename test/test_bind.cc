@@ -0,0 +1,254 @@
+#include "catch.hpp"
+#include "../src/json_bind.h"
+
+#include <list>
+#include <map>
+
+namespace bind_test {
+
+struct Address
+{
+    std::string city;
+    int zip = 0;
+};
+JSON_FIELDS(Address, city, zip)
+
+struct Person
+{
+    std::string name;
+    int age = -1;
+    double height = 0;
+    float weight = 0;
+    bool active = false;
+    unsigned long long id = 0;
+    std::vector<std::string> tags;
+    std::vector<Address> addresses;
+    std::map<std::string, int> scores;
+    std::list<double> history;
+    std::vector<bool> flags;
+    json::Value extra;
+    std::nullptr_t nothing = nullptr;
+};
+JSON_FIELDS(Person, name, age, height, weight, active, id, tags, addresses, scores, history, flags, extra, nothing)
+
+// A type with a user-provided Traits specialization.
+struct Celsius
+{
+    double degrees = 0;
+};
+
+} // namespace bind_test
+
+namespace json {
+template <>
+struct Traits<bind_test::Celsius>
+{
+    using tag = Tag_string;
+    static decltype(auto) to_json(bind_test::Celsius const& in) { return std::to_string(in.degrees) + "C"; }
+    static decltype(auto) from_json(Value const& in) { return bind_test::Celsius{std::stod(in.get_string())}; }
+};
+} // namespace json
+
+namespace bind_test {
+
+struct Reading
+{
+    Celsius temperature;
+    std::vector<Celsius> history;
+};
+JSON_FIELDS(Reading, temperature, history)
+
+} // namespace bind_test
+
+TEST_CASE("parse_into - fields")
+{
+    bind_test::Person p;
+    p.age = 99;
+    auto const ec = json::parse_into(p, R"({
+        "name": "Jane \"J\" Doe",
+        "height": 1.75,
+        "weight": 60.5,
+        "active": true,
+        "id": 12345678901,
+        "unknown": {"nested": [1, 2, {"a": null}], "s": "ä"},
+        "tags": ["a", "b\nc"],
+        "addresses": [{"city": "Berlin", "zip": 10115}, {"zip": 1, "city": "Paris", "country": "FR"}],
+        "scores": {"math": 1, "art": 2},
+        "history": [1, 2.5],
+        "flags": [true, false, true],
+        "extra": {"any": ["thing", 1]},
+        "nothing": null
+    })");
+    REQUIRE(ec == json::ParseStatus::success);
+
+    CHECK(p.name == "Jane \"J\" Doe");
+    CHECK(p.age == 99); // missing keys leave fields unchanged
+    CHECK(p.height == 1.75);
+    CHECK(p.weight == 60.5f);
+    CHECK(p.active == true);
+    CHECK(p.id == 12345678901ull);
+    CHECK(p.tags == std::vector<std::string>{"a", "b\nc"});
+    REQUIRE(p.addresses.size() == 2);
+    CHECK(p.addresses[0].city == "Berlin");
+    CHECK(p.addresses[0].zip == 10115);
+    CHECK(p.addresses[1].city == "Paris");
+    CHECK(p.addresses[1].zip == 1);
+    CHECK(p.scores == std::map<std::string, int>{{"art", 2}, {"math", 1}});
+    CHECK(p.history == std::list<double>{1.0, 2.5});
+    CHECK(p.flags == std::vector<bool>{true, false, true});
+    CHECK(p.extra == json::Object{{"any", json::Array{"thing", 1}}});
+}
+
+TEST_CASE("parse_into - scalars and containers")
+{
+    int i = 0;
+    CHECK(json::parse_into(i, " -42 ") == json::ParseStatus::success);
+    CHECK(i == -42);
+
+    std::string s;
+    CHECK(json::parse_into(s, R"("😀")") == json::ParseStatus::success);
+    CHECK(s == "\xF0\x9F\x98\x80");
+
+    std::vector<std::vector<double>> m = {{9}};
+    CHECK(json::parse_into(m, "[[1, 2], [], [3]]") == json::ParseStatus::success);
+    CHECK(m == std::vector<std::vector<double>>{{1, 2}, {}, {3}});
+
+    json::Array a;
+    CHECK(json::parse_into(a, R"([1, "two", [3]])") == json::ParseStatus::success);
+    CHECK(json::Value(a) == json::Array{1, "two", json::Array{3}});
+
+    json::Object o;
+    CHECK(json::parse_into(o, R"({"a": {"b": true}})") == json::ParseStatus::success);
+    CHECK(json::Value(o) == json::Object{{"a", json::Object{{"b", true}}}});
+}
+
+TEST_CASE("parse_into - Traits")
+{
+    bind_test::Reading r;
+    REQUIRE(json::parse_into(r, R"({"temperature": "21.5", "history": ["1", "2"]})") == json::ParseStatus::success);
+    CHECK(r.temperature.degrees == 21.5);
+    REQUIRE(r.history.size() == 2);
+    CHECK(r.history[1].degrees == 2.0);
+}
+
+TEST_CASE("parse_into - errors")
+{
+    bind_test::Address a;
+    CHECK(json::parse_into(a, R"([])") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_into(a, R"({"zip": "1"})") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_into(a, R"({"zip": null})") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_into(a, R"({"city": 1})") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_into(a, R"({"city": "x")") == json::ParseStatus::expected_comma_or_closing_brace);
+    CHECK(json::parse_into(a, R"({"city" "x"})") == json::ParseStatus::expected_colon_after_key);
+    CHECK(json::parse_into(a, R"({city: "x"})") == json::ParseStatus::expected_key);
+    CHECK(json::parse_into(a, R"({"zip": 1} x)") == json::ParseStatus::expected_eof);
+    CHECK(json::parse_into(a, R"({"zip": NaN})") == json::ParseStatus::invalid_number);
+    CHECK(json::parse_into(a, R"({"zip": nul})") == json::ParseStatus::unrecognized_identifier);
+    CHECK(json::parse_into(a, R"({"other": [1, 2)") == json::ParseStatus::expected_comma_or_closing_bracket);
+    CHECK(json::parse_into(a, R"({"other": "\x"})") == json::ParseStatus::invalid_string);
+
+    std::string deep(1000, '[');
+    CHECK(json::parse_into(a, R"({"other": )" + deep) == json::ParseStatus::max_depth_reached);
+
+    // Lenient mode
+    bind_test::Address b;
+    CHECK(json::parse_into(b, R"({city: "x", /* c */ zip: 1,})", json::Mode::lenient) == json::ParseStatus::success);
+    CHECK(b.city == "x");
+    CHECK(b.zip == 1);
+}
+
+TEST_CASE("write - fields")
+{
+    bind_test::Person p;
+    p.name = "Jane \"J\" Doe";
+    p.age = 42;
+    p.height = 1.75;
+    p.weight = 60.5f;
+    p.active = true;
+    p.id = 12345678901ull;
+    p.tags = {"a", "b\nc"};
+    p.addresses = {{"Berlin", 10115}, {"Paris", 1}};
+    p.scores = {{"math", 1}, {"art", 2}};
+    p.history = {1.0, 2.5};
+    p.flags = {true, false};
+    p.extra = json::Object{{"any", json::Array{"thing", 1}}};
+
+    json::Value const expected = json::Object{
+        {"name", p.name},
+        {"age", 42},
+        {"height", 1.75},
+        {"weight", 60.5},
+        {"active", true},
+        {"id", 12345678901.0},
+        {"tags", json::Array{"a", "b\nc"}},
+        {"addresses", json::Array{json::Object{{"city", "Berlin"}, {"zip", 10115}}, json::Object{{"city", "Paris"}, {"zip", 1}}}},
+        {"scores", json::Object{{"art", 2}, {"math", 1}}},
+        {"history", json::Array{1.0, 2.5}},
+        {"flags", json::Array{true, false}},
+        {"extra", p.extra},
+        {"nothing", nullptr},
+    };
+
+    std::string str;
+    REQUIRE(json::stringify(str, p));
+
+    // Fields are written in declaration order.
+    CHECK(str.compare(0, 31, R"({"name":"Jane \"J\" Doe","age":)") == 0);
+
+    json::Value v;
+    REQUIRE(json::parse(v, str) == json::ParseStatus::success);
+    CHECK(v == expected);
+
+    bind_test::Person q;
+    REQUIRE(json::parse_into(q, str) == json::ParseStatus::success);
+    CHECK(q.name == p.name);
+    CHECK(q.addresses[1].city == "Paris");
+    CHECK(q.flags == p.flags);
+
+    for (int indent_width = 0; indent_width <= 2; ++indent_width)
+    {
+        json::StringifyOptions options;
+        options.indent_width = static_cast<int8_t>(indent_width);
+
+        std::string s1;
+        std::string s2;
+        REQUIRE(json::stringify(s1, p, options));
+        REQUIRE(json::stringify(s2, json::Value(json::Object{{"x", v["addresses"]}}), options));
+        CHECK(s1.find("\"addresses\"") != std::string::npos);
+
+        std::string s3;
+        REQUIRE(json::stringify(s3, std::map<std::string, std::vector<bind_test::Address>>{{"x", p.addresses}}, options));
+        CHECK(s3 == s2);
+    }
+}
+
+TEST_CASE("write - scalars and Traits")
+{
+    auto to_string = [](auto const& in) {
+        std::string str;
+        CHECK(json::stringify(str, in));
+        return str;
+    };
+
+    CHECK(to_string(1) == "1");
+    CHECK(to_string(0.5f) == "0.5");
+    CHECK(to_string(true) == "true");
+    CHECK(to_string(nullptr) == "null");
+    CHECK(to_string(std::string("\xC3\xA4\t")) == "\"\xC3\xA4\\t\"");
+    CHECK(to_string("literal") == "\"literal\"");
+    CHECK(to_string(std::vector<int>{}) == "[]");
+    CHECK(to_string(std::map<int, bool>{{1, true}, {2, false}}) == R"({"1":true,"2":false})");
+    CHECK(to_string(bind_test::Celsius{2}) == "\"2.000000C\"");
+
+    bind_test::Reading r;
+    r.temperature.degrees = 1;
+    CHECK(to_string(r) == R"({"temperature":"1.000000C","history":[]})");
+
+    std::string invalid = "\xFF";
+    std::string str;
+    CHECK(!json::stringify(str, std::vector<std::string>{invalid}));
+
+    json::StringifyOptions options;
+    options.mode = json::Mode::lenient;
+    CHECK(json::stringify(str, std::vector<std::string>{invalid}, options));
+}
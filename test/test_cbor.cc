@@ -0,0 +1,325 @@
+#include "catch.hpp"
+#include "test_binary.h"
+#include "../src/json_cbor.h"
+
+#include <cmath>
+#include <limits>
+
+static std::string Encode(json::Value const& value)
+{
+    return EncodeWith(json::cbor::encode, value);
+}
+
+static json::Value Decode(std::string const& bytes, json::Mode mode = json::Mode::lenient)
+{
+    return DecodeWith(json::cbor::decode, bytes, mode);
+}
+
+TEST_CASE("CBOR - encode")
+{
+    // RFC 8949, Appendix A
+    CHECK(Encode(0) == FromHex("00"));
+    CHECK(Encode(1) == FromHex("01"));
+    CHECK(Encode(10) == FromHex("0a"));
+    CHECK(Encode(23) == FromHex("17"));
+    CHECK(Encode(24) == FromHex("1818"));
+    CHECK(Encode(25) == FromHex("1819"));
+    CHECK(Encode(100) == FromHex("1864"));
+    CHECK(Encode(1000) == FromHex("1903e8"));
+    CHECK(Encode(1000000) == FromHex("1a000f4240"));
+    CHECK(Encode(1000000000000.0) == FromHex("1b000000e8d4a51000"));
+    CHECK(Encode(18446744073709549568.0) == FromHex("1bfffffffffffff800"));
+    CHECK(Encode(-1) == FromHex("20"));
+    CHECK(Encode(-10) == FromHex("29"));
+    CHECK(Encode(-100) == FromHex("3863"));
+    CHECK(Encode(-1000) == FromHex("3903e7"));
+    CHECK(Encode(-18446744073709551616.0) == FromHex("3bffffffffffffffff"));
+    CHECK(Encode(18446744073709551616.0) == FromHex("fa5f800000"));
+    CHECK(Encode(-0.0) == FromHex("fa80000000"));
+    CHECK(Encode(1.1) == FromHex("fb3ff199999999999a"));
+    CHECK(Encode(100000.0) == FromHex("1a000186a0"));
+    CHECK(Encode(3.4028234663852886e+38) == FromHex("fa7f7fffff"));
+    CHECK(Encode(1.0e+300) == FromHex("fb7e37e43c8800759c"));
+    CHECK(Encode(-4.1) == FromHex("fbc010666666666666"));
+    CHECK(Encode(0.5) == FromHex("fa3f000000"));
+    CHECK(Encode(std::numeric_limits<double>::infinity()) == FromHex("fa7f800000"));
+    CHECK(Encode(-std::numeric_limits<double>::infinity()) == FromHex("faff800000"));
+    CHECK(Encode(std::numeric_limits<double>::quiet_NaN()) == FromHex("f97e00"));
+    CHECK(Encode(false) == FromHex("f4"));
+    CHECK(Encode(true) == FromHex("f5"));
+    CHECK(Encode(nullptr) == FromHex("f6"));
+    CHECK(Encode(json::Value{}) == FromHex("f7"));
+    CHECK(Encode("") == FromHex("60"));
+    CHECK(Encode("a") == FromHex("6161"));
+    CHECK(Encode("IETF") == FromHex("6449455446"));
+    CHECK(Encode("\"\\") == FromHex("62225c"));
+    CHECK(Encode("\xC3\xBC") == FromHex("62c3bc"));
+    CHECK(Encode("\xE6\xB0\xB4") == FromHex("63e6b0b4"));
+    CHECK(Encode("\xF0\x90\x85\x91") == FromHex("64f0908591"));
+    CHECK(Encode(json::Array{}) == FromHex("80"));
+    CHECK(Encode(json::Array{1, 2, 3}) == FromHex("83010203"));
+    CHECK(Encode(json::Array{1, json::Array{2, 3}, json::Array{4, 5}}) == FromHex("8301820203820405"));
+    CHECK(Encode(json::Object{}) == FromHex("a0"));
+    CHECK(Encode(json::Object{{"a", 1}, {"b", json::Array{2, 3}}}) == FromHex("a26161016162820203"));
+
+    json::Value arr25 = json::Array{};
+    for (int i = 1; i <= 25; ++i)
+        arr25.push_back(i);
+    CHECK(Encode(arr25) == FromHex("98190102030405060708090a0b0c0d0e0f101112131415161718181819"));
+}
+
+TEST_CASE("CBOR - encode invalid UTF-8")
+{
+    std::string bytes;
+    CHECK(!json::cbor::encode(bytes, "\xFF"));
+    CHECK(!json::cbor::encode(bytes, json::Object{{"\xFF", 1}}));
+
+    bytes.clear();
+    CHECK(json::cbor::encode(bytes, "\xFF", json::Mode::lenient));
+    CHECK(bytes == FromHex("61ff"));
+}
+
+TEST_CASE("CBOR - encode raw")
+{
+    json::Value raw;
+    raw.assign(json::raw_tag, R"({"a": [1, 2.5, "xü"], "b": {"c": null, "d": true}})");
+
+    // Indefinite-length arrays and maps.
+    CHECK(Encode(raw) == FromHex("bf61619f01fa40200000" "6378c3bc" "ff6162bf6163f66164f5ffff"));
+
+    json::Value expected;
+    REQUIRE(json::parse(expected, raw.get_raw()) == json::ParseStatus::success);
+    CHECK(Decode(Encode(raw)) == expected);
+
+    json::Value invalid;
+    invalid.assign(json::raw_tag, "[1,");
+    std::string bytes;
+    CHECK(!json::cbor::encode(bytes, invalid));
+}
+
+TEST_CASE("CBOR - decode")
+{
+    // RFC 8949, Appendix A
+    CHECK(Decode(FromHex("00")) == 0);
+    CHECK(Decode(FromHex("17")) == 23);
+    CHECK(Decode(FromHex("1818")) == 24);
+    CHECK(Decode(FromHex("1903e8")) == 1000);
+    CHECK(Decode(FromHex("1a000f4240")) == 1000000);
+    CHECK(Decode(FromHex("1b000000e8d4a51000")) == 1000000000000.0);
+    CHECK(Decode(FromHex("1bffffffffffffffff")) == 18446744073709551615.0);
+    CHECK(Decode(FromHex("c249010000000000000000")) == "AQAAAAAAAAAA"); // bignum -> tag ignored, base64url
+    CHECK(Decode(FromHex("3bffffffffffffffff")) == -18446744073709551616.0);
+    CHECK(Decode(FromHex("20")) == -1);
+    CHECK(Decode(FromHex("3903e7")) == -1000);
+    CHECK(Decode(FromHex("f90000")) == 0.0);
+    CHECK(std::signbit(Decode(FromHex("f98000")).get_number()));
+    CHECK(Decode(FromHex("f93c00")) == 1.0);
+    CHECK(Decode(FromHex("fb3ff199999999999a")) == 1.1);
+    CHECK(Decode(FromHex("f93e00")) == 1.5);
+    CHECK(Decode(FromHex("f97bff")) == 65504.0);
+    CHECK(Decode(FromHex("fa47c35000")) == 100000.0);
+    CHECK(Decode(FromHex("fa7f7fffff")) == 3.4028234663852886e+38);
+    CHECK(Decode(FromHex("fb7e37e43c8800759c")) == 1.0e+300);
+    CHECK(Decode(FromHex("f90001")) == 5.960464477539063e-8);
+    CHECK(Decode(FromHex("f90400")) == 0.00006103515625);
+    CHECK(Decode(FromHex("f9c400")) == -4.0);
+    CHECK(Decode(FromHex("fbc010666666666666")) == -4.1);
+    CHECK(Decode(FromHex("f97c00")) == std::numeric_limits<double>::infinity());
+    CHECK(std::isnan(Decode(FromHex("f97e00")).get_number()));
+    CHECK(Decode(FromHex("f9fc00")) == -std::numeric_limits<double>::infinity());
+    CHECK(Decode(FromHex("fa7f800000")) == std::numeric_limits<double>::infinity());
+    CHECK(Decode(FromHex("fbfff0000000000000")) == -std::numeric_limits<double>::infinity());
+    CHECK(Decode(FromHex("f4")) == false);
+    CHECK(Decode(FromHex("f5")) == true);
+    CHECK(Decode(FromHex("f6")).is_null());
+    CHECK(Decode(FromHex("f7")).is_null());
+    CHECK(Decode(FromHex("f0")).is_null());
+    CHECK(Decode(FromHex("f8ff")).is_null());
+    CHECK(Decode(FromHex("c074323031332d30332d32315432303a30343a30305a")) == "2013-03-21T20:04:00Z");
+    CHECK(Decode(FromHex("c11a514b67b0")) == 1363896240);
+    CHECK(Decode(FromHex("d74401020304")) == "AQIDBA");
+    CHECK(Decode(FromHex("40")) == "");
+    CHECK(Decode(FromHex("4401020304")) == "AQIDBA");
+    CHECK(Decode(FromHex("60")) == "");
+    CHECK(Decode(FromHex("6161")) == "a");
+    CHECK(Decode(FromHex("62225c")) == "\"\\");
+    CHECK(Decode(FromHex("62c3bc")) == "\xC3\xBC");
+    CHECK(Decode(FromHex("64f0908591")) == "\xF0\x90\x85\x91");
+    CHECK(Decode(FromHex("6101")) == "\x01");
+    CHECK(Decode(FromHex("80")) == json::Array{});
+    CHECK(Decode(FromHex("83010203")) == json::Array{1, 2, 3});
+    CHECK(Decode(FromHex("8301820203820405")) == json::Array{1, json::Array{2, 3}, json::Array{4, 5}});
+    CHECK(Decode(FromHex("a0")) == json::Object{});
+    CHECK(Decode(FromHex("a26161016162820203")) == json::Object{{"a", 1}, {"b", json::Array{2, 3}}});
+    CHECK(Decode(FromHex("826161a161626163")) == json::Array{"a", json::Object{{"b", "c"}}});
+
+    // Indefinite length
+    CHECK(Decode(FromHex("5f42010243030405ff")) == "AQIDBAU");
+    CHECK(Decode(FromHex("7f657374726561646d696e67ff")) == "streaming");
+    CHECK(Decode(FromHex("9fff")) == json::Array{});
+    CHECK(Decode(FromHex("9f018202039f0405ffff")) == json::Array{1, json::Array{2, 3}, json::Array{4, 5}});
+    CHECK(Decode(FromHex("9f01820203820405ff")) == json::Array{1, json::Array{2, 3}, json::Array{4, 5}});
+    CHECK(Decode(FromHex("83018202039f0405ff")) == json::Array{1, json::Array{2, 3}, json::Array{4, 5}});
+    CHECK(Decode(FromHex("bf61610161629f0203ffff")) == json::Object{{"a", 1}, {"b", json::Array{2, 3}}});
+    CHECK(Decode(FromHex("826161bf61626163ff")) == json::Array{"a", json::Object{{"b", "c"}}});
+    CHECK(Decode(FromHex("bf6346756ef563416d7421ff")) == json::Object{{"Fun", true}, {"Amt", -2}});
+}
+
+TEST_CASE("CBOR - decode errors")
+{
+    auto decode = [](char const* hex, json::Mode mode = json::Mode::lenient) {
+        json::Value value;
+        return json::cbor::decode(value, FromHex(hex), mode);
+    };
+
+    CHECK(decode("") == json::ParseStatus::expected_value);
+    CHECK(decode("18") == json::ParseStatus::expected_value);
+    CHECK(decode("1b0000") == json::ParseStatus::expected_value);
+    CHECK(decode("1c") == json::ParseStatus::expected_value);
+    CHECK(decode("1f") == json::ParseStatus::expected_value);
+    CHECK(decode("ff") == json::ParseStatus::expected_value);
+    CHECK(decode("62") == json::ParseStatus::expected_value);
+    CHECK(decode("6261") == json::ParseStatus::expected_value);
+    CHECK(decode("83") == json::ParseStatus::expected_value);
+    CHECK(decode("8301") == json::ParseStatus::expected_value);
+    CHECK(decode("9b7fffffffffffffff") == json::ParseStatus::expected_value);
+    CHECK(decode("9f01") == json::ParseStatus::expected_value);
+    CHECK(decode("a1") == json::ParseStatus::expected_value);
+    CHECK(decode("a16161") == json::ParseStatus::expected_value);
+    CHECK(decode("7f") == json::ParseStatus::expected_value);
+    CHECK(decode("7f4100ff") == json::ParseStatus::expected_value); // chunk of wrong type
+    CHECK(decode("7f7f6100ffff") == json::ParseStatus::expected_value); // nested indefinite chunk
+    CHECK(decode("0000") == json::ParseStatus::expected_eof);
+    CHECK(decode("a10101") == json::ParseStatus::invalid_key);
+    CHECK(decode("bf4100ff") == json::ParseStatus::invalid_key);
+    CHECK(decode("61ff", json::Mode::strict) == json::ParseStatus::invalid_string);
+    CHECK(decode("a161ff01", json::Mode::strict) == json::ParseStatus::invalid_string);
+    CHECK(decode("f97e00", json::Mode::strict) == json::ParseStatus::invalid_number);
+    CHECK(decode("fa7f800000", json::Mode::strict) == json::ParseStatus::invalid_number);
+
+    std::string deep(600, static_cast<char>(0x81));
+    deep.push_back(0);
+    json::Value value;
+    CHECK(json::cbor::decode(value, deep) == json::ParseStatus::max_depth_reached);
+}
+
+TEST_CASE("CBOR - decode invalid UTF-8 lenient")
+{
+    json::Value value;
+    REQUIRE(json::cbor::decode(value, FromHex("62ff41"), json::Mode::lenient) == json::ParseStatus::success);
+    CHECK(value == "\xEF\xBF\xBD" "A");
+}
+
+TEST_CASE("CBOR - round trip")
+{
+    static constexpr char const* const kInputs[] = {
+        R"({"menu":{"array":[1],"empty_array":[],"empty_object":{},"header":"SVG \"Viewer\"","items":[{"id":"Open"},{"id":"OpenNew","label":"Open New"},null,true,false,-1.5]}})",
+        R"([0, -0, 1e300, -1e-300, 0.1, 123456789012345678901234567890, -9007199254740993, 4294967296, 65536, 256, -257])",
+        R"(["", "\u0000\u001f\"\\/", "ü水𐅑", "a very long string that exceeds twenty-three bytes"])",
+    };
+
+    for (auto const* input : kInputs)
+    {
+        CAPTURE(input);
+
+        json::Value j;
+        REQUIRE(json::parse(j, input) == json::ParseStatus::success);
+
+        auto const bytes = Encode(j);
+        json::Value k;
+        REQUIRE(json::cbor::decode(k, bytes) == json::ParseStatus::success);
+        CHECK(j == k);
+    }
+}
+
+namespace {
+
+// Numbers are passed as strings if HandleDouble() is not implemented.
+struct CollectCallbacks
+{
+    std::string out;
+
+    json::ParseStatus HandleNull() { out += "null "; return {}; }
+    json::ParseStatus HandleTrue() { out += "true "; return {}; }
+    json::ParseStatus HandleFalse() { out += "false "; return {}; }
+
+    json::ParseStatus HandleNumber(char const* first, char const* last, json::NumberClass nc)
+    {
+        out.append(first, last);
+        out += nc == json::NumberClass::integer ? "i " : (nc == json::NumberClass::decimal ? "d " : "? ");
+        return {};
+    }
+
+    json::ParseStatus HandleString(char const* first, char const* last, json::StringClass sc)
+    {
+        out += '"';
+        out.append(first, last);
+        out += sc == json::StringClass::clean ? "\" " : "\"* ";
+        return {};
+    }
+
+    json::ParseStatus HandleKey(char const* first, char const* last, json::StringClass sc)
+    {
+        out += "key:";
+        return HandleString(first, last, sc);
+    }
+
+    json::ParseStatus HandleBeginArray() { out += "[ "; return {}; }
+    json::ParseStatus HandleEndArray(size_t count) { out += std::to_string(count) + "] "; return {}; }
+    json::ParseStatus HandleEndElement(size_t& /*count*/) { return {}; }
+    json::ParseStatus HandleBeginObject() { out += "{ "; return {}; }
+    json::ParseStatus HandleEndObject(size_t count) { out += std::to_string(count) + "} "; return {}; }
+    json::ParseStatus HandleEndMember(size_t& /*count*/) { return {}; }
+};
+
+} // namespace
+
+TEST_CASE("CBOR - DecodeSAX")
+{
+    CollectCallbacks cb;
+    auto const bytes = FromHex("a2616183011863fb3ff199999999999a62610a9ff97c00f6ff");
+    auto const res = json::cbor::DecodeSAX(cb, bytes.data(), bytes.data() + bytes.size(), json::Mode::strict);
+    CHECK(res.ec == json::ParseStatus::success);
+    CHECK(res.ptr == bytes.data() + bytes.size());
+    CHECK(cb.out == R"({ key:"a" [ 1i 99i 1.1d 3] key:"a\n"* [ Infinity? null 2] 2} )");
+}
+
+namespace {
+
+// Receives strings which contain special characters without escaping.
+struct UnescapedCallbacks : CollectCallbacks
+{
+    json::ParseStatus HandleUnescapedString(char const* first, char const* last)
+    {
+        out += '<';
+        out.append(first, last);
+        out += "> ";
+        return {};
+    }
+
+    json::ParseStatus HandleUnescapedKey(char const* first, char const* last)
+    {
+        out += "key:";
+        return HandleUnescapedString(first, last);
+    }
+};
+
+} // namespace
+
+TEST_CASE("CBOR - DecodeSAX unescaped strings")
+{
+    UnescapedCallbacks cb;
+    auto const bytes = FromHex("a2616183011863fb3ff199999999999a62610a9ff97c00f6ff");
+    auto const res = json::cbor::DecodeSAX(cb, bytes.data(), bytes.data() + bytes.size(), json::Mode::strict);
+    CHECK(res.ec == json::ParseStatus::success);
+    CHECK(cb.out == "{ key:\"a\" [ 1i 99i 1.1d 3] key:<a\n> [ Infinity? null 2] 2} ");
+
+    // Invalid UTF-8 is still escaped.
+    UnescapedCallbacks cb2;
+    auto const invalid = FromHex("62ff0a");
+    CHECK(json::cbor::DecodeSAX(cb2, invalid.data(), invalid.data() + invalid.size(), json::Mode::lenient).ec == json::ParseStatus::success);
+    CHECK(cb2.out.back() == ' ');
+    CHECK(cb2.out.find("\"* ") != std::string::npos);
+
+    CHECK(Decode(FromHex("a1620a2201")) == json::Value(json::object_tag, {{"\n\"", 1}}));
+}
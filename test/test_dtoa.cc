@@ -435,3 +435,141 @@ TEST_CASE("Dtoa - 2^n")
     CHECK_EQ("9007199254740991", Dtoa(PrevDouble(Two53))); // 2^53 - 1 ulp = 2^53 - 1
     CHECK_EQ("9007199254740994.0", Dtoa(NextDouble(Two53))); // 2^53 + 1 ulp
 }
+
+//==================================================================================================
+// IEEE single-precision implementation
+//==================================================================================================
+
+static float FloatFromBits(uint32_t ieeeBits)
+{
+    float value;
+    std::memcpy(&value, &ieeeBits, sizeof(float));
+    return value;
+}
+
+static charconv::ryu::FloatToDecimalResult PositiveFloatToDecimal(float value)
+{
+    REQUIRE(std::isfinite(value));
+    REQUIRE(value > 0);
+    return charconv::ryu::FloatToDecimal(value);
+}
+
+TEST_CASE("Ryu - float")
+{
+    charconv::ryu::FloatToDecimalResult res;
+
+    res = PositiveFloatToDecimal(FloatFromBits(0x00000001u)); // min denormal
+    CHECK_EQ(1u, res.digits);
+    CHECK_EQ(-45, res.exponent);
+    res = PositiveFloatToDecimal(FloatFromBits(0x007FFFFFu)); // max denormal
+    CHECK_EQ(11754942u, res.digits);
+    CHECK_EQ(-45, res.exponent);
+    res = PositiveFloatToDecimal(FloatFromBits(0x00800000u)); // min normal
+    CHECK_EQ(11754944u, res.digits);
+    CHECK_EQ(-45, res.exponent);
+    res = PositiveFloatToDecimal(FloatFromBits(0x7F7FFFFFu)); // max normal
+    CHECK_EQ(34028235u, res.digits);
+    CHECK_EQ(31, res.exponent);
+
+    // Boundary round even
+    res = PositiveFloatToDecimal(3.355445E7f);
+    CHECK_EQ(3355445u, res.digits);
+    CHECK_EQ(1, res.exponent);
+    res = PositiveFloatToDecimal(8.999999E9f);
+    CHECK_EQ(9u, res.digits);
+    CHECK_EQ(9, res.exponent);
+    res = PositiveFloatToDecimal(3.4366717E10f);
+    CHECK_EQ(3436672u, res.digits);
+    CHECK_EQ(4, res.exponent);
+
+    // Exact value round even
+    res = PositiveFloatToDecimal(3.0540412E5f);
+    CHECK_EQ(30540412u, res.digits);
+    CHECK_EQ(-2, res.exponent);
+    res = PositiveFloatToDecimal(8.0990312E3f);
+    CHECK_EQ(80990312u, res.digits);
+    CHECK_EQ(-4, res.exponent);
+
+    // Lots of trailing zeros
+    res = PositiveFloatToDecimal(2.4414062E-4f);
+    CHECK_EQ(24414062u, res.digits);
+    CHECK_EQ(-11, res.exponent);
+    res = PositiveFloatToDecimal(2.4414062E-3f);
+    CHECK_EQ(24414062u, res.digits);
+    CHECK_EQ(-10, res.exponent);
+    res = PositiveFloatToDecimal(4.3945312E-3f);
+    CHECK_EQ(43945312u, res.digits);
+    CHECK_EQ(-10, res.exponent);
+    res = PositiveFloatToDecimal(6.3476562E-3f);
+    CHECK_EQ(63476562u, res.digits);
+    CHECK_EQ(-10, res.exponent);
+
+    // Looks like pow5
+    res = PositiveFloatToDecimal(FloatFromBits(0x5D1502F9u));
+    CHECK_EQ(67108864u, res.digits);
+    CHECK_EQ(10, res.exponent);
+    res = PositiveFloatToDecimal(FloatFromBits(0x5D9502F9u));
+    CHECK_EQ(13421773u, res.digits);
+    CHECK_EQ(11, res.exponent);
+    res = PositiveFloatToDecimal(FloatFromBits(0x5E1502F9u));
+    CHECK_EQ(26843546u, res.digits);
+    CHECK_EQ(11, res.exponent);
+}
+
+static std::string Ftoa(float value, bool force_trailing_dot_zero = true)
+{
+    char buf[32];
+    char* end = json::numbers::FloatToString(buf, 32, value, force_trailing_dot_zero);
+    return std::string(buf, end);
+}
+
+TEST_CASE("Ftoa")
+{
+    CHECK_EQ("Infinity", Ftoa(std::numeric_limits<float>::infinity()));
+    CHECK_EQ("-Infinity", Ftoa(-std::numeric_limits<float>::infinity()));
+    CHECK_EQ("NaN", Ftoa(std::numeric_limits<float>::quiet_NaN()));
+
+    CHECK_EQ("-0.0"           , Ftoa(-0.0f));
+    CHECK_EQ( "0"             , Ftoa( 0.0f));
+    CHECK_EQ( "1"             , Ftoa( 1.0f));
+    CHECK_EQ( "0.1"           , Ftoa( 0.1f));
+    CHECK_EQ( "0.3"           , Ftoa( 0.3f));
+    CHECK_EQ("-1.5"           , Ftoa(-1.5f));
+    CHECK_EQ( "1.2345678"     , Ftoa( 1.2345678f));
+    CHECK_EQ( "123.456"       , Ftoa( 123.456f));
+    CHECK_EQ( "16777216"      , Ftoa( 16777216.0f)); // 2^24
+    CHECK_EQ( "16777218.0"    , Ftoa( 16777218.0f)); // 2^24 + 1 ulp
+    CHECK_EQ( "10000000000.0" , Ftoa( 1.0e10f));
+    CHECK_EQ( "0.000001"      , Ftoa( 1.0e-6f));
+    CHECK_EQ( "1e-7"          , Ftoa( 1.0e-7f));
+    CHECK_EQ( "1e+21"         , Ftoa( 1.0e21f));
+    CHECK_EQ( "3.4028235e+38" , Ftoa( std::numeric_limits<float>::max()));
+    CHECK_EQ( "1.1754944e-38" , Ftoa( std::numeric_limits<float>::min()));
+    CHECK_EQ( "1e-45"         , Ftoa( std::numeric_limits<float>::denorm_min()));
+}
+
+TEST_CASE("Ftoa - round trip")
+{
+    // Check that the shortest representation round-trips and that there is no
+    // shorter representation which does. Samples the whole range of positive
+    // finite floats.
+    for (uint32_t bits = 1; bits < 0x7F800000u; bits += 0x0000FFF1u)
+    {
+        float const value = FloatFromBits(bits);
+
+        std::string const str = Ftoa(value, /*force_trailing_dot_zero*/ false);
+
+        float f;
+        CHECK_TRUE(json::numbers::StringToFloat(f, str.data(), str.data() + str.size()));
+        CHECK_EQ(bits, charconv::Single(f).bits);
+
+        auto const res = charconv::ryu::FloatToDecimal(value);
+        int const num_digits = json::impl::DecimalLength(res.digits);
+        if (num_digits > 1)
+        {
+            char buf[32];
+            snprintf(buf, 32, "%.*e", num_digits - 2, static_cast<double>(value));
+            CHECK(bits != charconv::Single(std::strtof(buf, nullptr)).bits);
+        }
+    }
+}
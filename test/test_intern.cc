@@ -0,0 +1,120 @@
+#include "catch.hpp"
+#include "../src/json_intern.h"
+
+#include <thread>
+#include <unordered_set>
+
+TEST_CASE("StringPool - intern")
+{
+    json::StringPool pool;
+    CHECK(pool.size() == 0);
+    CHECK(!pool.find("id"));
+
+    auto const id = pool.intern("id", 2);
+    REQUIRE(id);
+    CHECK(id.size() == 2);
+    CHECK(std::strcmp(id.data(), "id") == 0);
+    CHECK(id.str() == "id");
+    CHECK(id.hash() == json::impl::KeyHash("id", 2));
+
+    CHECK(pool.intern(std::string("id")) == id);
+    CHECK(pool.find("id", 2) == id);
+    CHECK(pool.intern("ID", 2) != id);
+    CHECK(pool.intern("i", 1) != id);
+    CHECK(pool.size() == 3);
+
+    auto const empty = pool.intern("", 0);
+    CHECK(empty);
+    CHECK(empty.empty());
+    CHECK(empty != json::InternedString{});
+    CHECK(pool.intern(std::string("nul\0", 4)) != pool.intern("nul", 3));
+
+    json::InternedString const null;
+    CHECK(!null);
+    CHECK(null.size() == 0);
+    CHECK(std::strcmp(null.data(), "") == 0);
+    CHECK(null.hash() == json::impl::KeyHash("", 0));
+
+    // Handles stay valid while the tables grow.
+    std::vector<json::InternedString> handles;
+    for (int i = 0; i < 10000; ++i)
+        handles.push_back(pool.intern("key" + std::to_string(i)));
+    for (int i = 0; i < 10000; ++i)
+    {
+        CHECK(pool.find("key" + std::to_string(i)) == handles[static_cast<size_t>(i)]);
+        CHECK(handles[static_cast<size_t>(i)].str() == "key" + std::to_string(i));
+    }
+    CHECK(pool.find("id") == id);
+
+    std::unordered_set<json::InternedString> set(handles.begin(), handles.end());
+    CHECK(set.size() == handles.size());
+
+    pool.clear();
+    CHECK(pool.size() == 0);
+    CHECK(pool.bytes() == 0);
+    CHECK(!pool.find("id"));
+    CHECK(pool.intern("id"));
+}
+
+TEST_CASE("StringPool - limits")
+{
+    json::StringPoolOptions options;
+    options.max_length = 4;
+    options.max_strings = 3;
+
+    json::StringPool pool(options);
+    CHECK(!pool.intern("12345"));
+    CHECK(pool.intern("1234"));
+    CHECK(pool.intern("a"));
+    CHECK(pool.intern("b"));
+    CHECK(!pool.intern("c"));
+    CHECK(pool.size() == 3);
+    CHECK(pool.intern("a") == pool.find("a")); // existing strings are still found
+
+    options.max_strings = 100;
+    options.max_bytes = 2 * (sizeof(json::impl::InternedEntry) + 2);
+    json::StringPool small(options);
+    CHECK(small.intern("a"));
+    CHECK(small.intern("b"));
+    CHECK(!small.intern("c"));
+    CHECK(small.bytes() == options.max_bytes);
+}
+
+TEST_CASE("StringPool - threads")
+{
+    json::StringPool pool;
+
+    constexpr int kNumThreads = 4;
+    constexpr int kNumStrings = 5000;
+
+    std::vector<std::vector<json::InternedString>> results(kNumThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kNumThreads; ++t)
+    {
+        threads.emplace_back([&pool, &results, t] {
+            auto& handles = results[static_cast<size_t>(t)];
+            for (int i = 0; i < kNumStrings; ++i)
+                handles.push_back(pool.intern("string" + std::to_string((i * (t + 1)) % kNumStrings)));
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(pool.size() == kNumStrings);
+    for (int t = 0; t < kNumThreads; ++t)
+    {
+        for (int i = 0; i < kNumStrings; ++i)
+        {
+            auto const h = results[static_cast<size_t>(t)][static_cast<size_t>(i)];
+            CHECK(h == pool.find("string" + std::to_string((i * (t + 1)) % kNumStrings)));
+        }
+    }
+}
+
+TEST_CASE("StringPool - global")
+{
+    auto const a = json::StringPool::global().intern("global");
+    CHECK(a);
+    CHECK(&json::StringPool::global() == &json::StringPool::global());
+    CHECK(json::StringPool::global().find("global") == a);
+}
@@ -0,0 +1,272 @@
+#include "catch.hpp"
+#include "test_binary.h"
+#include "../src/json_msgpack.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+static std::string Encode(json::Value const& value)
+{
+    return EncodeWith(json::msgpack::encode, value);
+}
+
+static json::Value Decode(std::string const& bytes, json::Mode mode = json::Mode::lenient)
+{
+    return DecodeWith(json::msgpack::decode, bytes, mode);
+}
+
+TEST_CASE("MessagePack - encode")
+{
+    CHECK(Encode(0) == FromHex("00"));
+    CHECK(Encode(127) == FromHex("7f"));
+    CHECK(Encode(128) == FromHex("cc80"));
+    CHECK(Encode(255) == FromHex("ccff"));
+    CHECK(Encode(256) == FromHex("cd0100"));
+    CHECK(Encode(65536) == FromHex("ce00010000"));
+    CHECK(Encode(4294967296.0) == FromHex("cf0000000100000000"));
+    CHECK(Encode(18446744073709549568.0) == FromHex("cffffffffffffff800"));
+    CHECK(Encode(-1) == FromHex("ff"));
+    CHECK(Encode(-32) == FromHex("e0"));
+    CHECK(Encode(-33) == FromHex("d0df"));
+    CHECK(Encode(-128) == FromHex("d080"));
+    CHECK(Encode(-129) == FromHex("d1ff7f"));
+    CHECK(Encode(-32769) == FromHex("d2ffff7fff"));
+    CHECK(Encode(-2147483649.0) == FromHex("d3ffffffff7fffffff"));
+    CHECK(Encode(-9223372036854775808.0) == FromHex("d38000000000000000"));
+    CHECK(Encode(-18446744073709551616.0) == FromHex("cadf800000"));
+    CHECK(Encode(-0.0) == FromHex("ca80000000"));
+    CHECK(Encode(0.5) == FromHex("ca3f000000"));
+    CHECK(Encode(1.1) == FromHex("cb3ff199999999999a"));
+    CHECK(Encode(std::numeric_limits<double>::infinity()) == FromHex("ca7f800000"));
+    CHECK(Encode(std::numeric_limits<double>::quiet_NaN()) == FromHex("ca7fc00000"));
+    CHECK(Encode(nullptr) == FromHex("c0"));
+    CHECK(Encode(json::Value{}) == FromHex("c0"));
+    CHECK(Encode(false) == FromHex("c2"));
+    CHECK(Encode(true) == FromHex("c3"));
+    CHECK(Encode("") == FromHex("a0"));
+    CHECK(Encode("a") == FromHex("a161"));
+    CHECK(Encode(std::string(31, 'x')) == FromHex("bf") + std::string(31, 'x'));
+    CHECK(Encode(std::string(32, 'x')) == FromHex("d920") + std::string(32, 'x'));
+    CHECK(Encode(std::string(256, 'x')) == FromHex("da0100") + std::string(256, 'x'));
+    CHECK(Encode(std::string(65536, 'x')) == FromHex("db00010000") + std::string(65536, 'x'));
+    CHECK(Encode(json::Array{}) == FromHex("90"));
+    CHECK(Encode(json::Array{1, 2, 3}) == FromHex("93010203"));
+    CHECK(Encode(json::Object{}) == FromHex("80"));
+    CHECK(Encode(json::Object{{"a", 1}, {"b", json::Array{2, 3}}}) == FromHex("82a16101a162920203"));
+
+    json::Value arr16 = json::Array{};
+    for (int i = 0; i < 16; ++i)
+        arr16.push_back(i);
+    CHECK(Encode(arr16) == FromHex("dc0010000102030405060708090a0b0c0d0e0f"));
+}
+
+TEST_CASE("MessagePack - encode invalid")
+{
+    std::string bytes;
+    CHECK(!json::msgpack::encode(bytes, "\xFF"));
+    CHECK(!json::msgpack::encode(bytes, json::Object{{"\xFF", 1}}));
+
+    bytes.clear();
+    CHECK(json::msgpack::encode(bytes, "\xFF", json::Mode::lenient));
+    CHECK(bytes == FromHex("a1ff"));
+
+    json::Value invalid;
+    invalid.assign(json::raw_tag, "[1,");
+    CHECK(!json::msgpack::encode(bytes, invalid));
+}
+
+TEST_CASE("MessagePack - encode raw")
+{
+    json::Value raw;
+    raw.assign(json::raw_tag, R"({"a": [1, 2.5], "b": null})");
+    CHECK(Encode(raw) == FromHex("82a16192" "01ca40200000" "a162c0"));
+}
+
+TEST_CASE("MessagePack - decode")
+{
+    CHECK(Decode(FromHex("00")) == 0);
+    CHECK(Decode(FromHex("7f")) == 127);
+    CHECK(Decode(FromHex("cc80")) == 128);
+    CHECK(Decode(FromHex("cd0100")) == 256);
+    CHECK(Decode(FromHex("ce00010000")) == 65536);
+    CHECK(Decode(FromHex("cfffffffffffffffff")) == 18446744073709551615.0);
+    CHECK(Decode(FromHex("ff")) == -1);
+    CHECK(Decode(FromHex("e0")) == -32);
+    CHECK(Decode(FromHex("d080")) == -128);
+    CHECK(Decode(FromHex("d07f")) == 127);
+    CHECK(Decode(FromHex("d1ff7f")) == -129);
+    CHECK(Decode(FromHex("d2ffff7fff")) == -32769);
+    CHECK(Decode(FromHex("d38000000000000000")) == -9223372036854775808.0);
+    CHECK(Decode(FromHex("d37fffffffffffffff")) == 9223372036854775807.0);
+    CHECK(Decode(FromHex("ca3f000000")) == 0.5);
+    CHECK(Decode(FromHex("cb3ff199999999999a")) == 1.1);
+    CHECK(Decode(FromHex("ca7f800000")) == std::numeric_limits<double>::infinity());
+    CHECK(std::isnan(Decode(FromHex("ca7fc00000")).get_number()));
+    CHECK(Decode(FromHex("c0")).is_null());
+    CHECK(Decode(FromHex("c2")) == false);
+    CHECK(Decode(FromHex("c3")) == true);
+    CHECK(Decode(FromHex("a0")) == "");
+    CHECK(Decode(FromHex("a3616263")) == "abc");
+    CHECK(Decode(FromHex("d903616263")) == "abc");
+    CHECK(Decode(FromHex("da0003616263")) == "abc");
+    CHECK(Decode(FromHex("db00000003616263")) == "abc");
+    CHECK(Decode(FromHex("a2225c")) == "\"\\");
+    CHECK(Decode(FromHex("a2c3bc")) == "\xC3\xBC");
+    CHECK(Decode(FromHex("c40401020304")) == "AQIDBA");
+    CHECK(Decode(FromHex("c5000401020304")) == "AQIDBA");
+    CHECK(Decode(FromHex("c600000000")) == "");
+    CHECK(Decode(FromHex("c70305010203")) == "AQID");   // ext 8, type 5
+    CHECK(Decode(FromHex("d4ff01")) == "AQ");             // fixext 1, type -1
+    CHECK(Decode(FromHex("d6ff5a4b4a3b")) == "WktKOw");   // timestamp 32
+    CHECK(Decode(FromHex("90")) == json::Array{});
+    CHECK(Decode(FromHex("93010203")) == json::Array{1, 2, 3});
+    CHECK(Decode(FromHex("dc0003010203")) == json::Array{1, 2, 3});
+    CHECK(Decode(FromHex("dd00000003010203")) == json::Array{1, 2, 3});
+    CHECK(Decode(FromHex("80")) == json::Object{});
+    CHECK(Decode(FromHex("82a16101a162920203")) == json::Object{{"a", 1}, {"b", json::Array{2, 3}}});
+    CHECK(Decode(FromHex("de0001d90161c0")) == json::Object{{"a", nullptr}});
+    CHECK(Decode(FromHex("df00000001a16191a162")) == json::Object{{"a", json::Array{"b"}}});
+}
+
+TEST_CASE("MessagePack - decode errors")
+{
+    auto decode = [](char const* hex, json::Mode mode = json::Mode::lenient) {
+        json::Value value;
+        return json::msgpack::decode(value, FromHex(hex), mode);
+    };
+
+    CHECK(decode("") == json::ParseStatus::expected_value);
+    CHECK(decode("c1") == json::ParseStatus::expected_value);
+    CHECK(decode("cc") == json::ParseStatus::expected_value);
+    CHECK(decode("cf00000000") == json::ParseStatus::expected_value);
+    CHECK(decode("cb3ff1") == json::ParseStatus::expected_value);
+    CHECK(decode("a2") == json::ParseStatus::expected_value);
+    CHECK(decode("a261") == json::ParseStatus::expected_value);
+    CHECK(decode("d9") == json::ParseStatus::expected_value);
+    CHECK(decode("c405") == json::ParseStatus::expected_value);
+    CHECK(decode("c7") == json::ParseStatus::expected_value);
+    CHECK(decode("c701") == json::ParseStatus::expected_value);
+    CHECK(decode("d5ff00") == json::ParseStatus::expected_value);
+    CHECK(decode("d4") == json::ParseStatus::expected_value);
+    CHECK(decode("93") == json::ParseStatus::expected_value);
+    CHECK(decode("9301") == json::ParseStatus::expected_value);
+    CHECK(decode("dd7fffffff") == json::ParseStatus::expected_value);
+    CHECK(decode("81") == json::ParseStatus::expected_value);
+    CHECK(decode("81a161") == json::ParseStatus::expected_value);
+    CHECK(decode("0000") == json::ParseStatus::expected_eof);
+    CHECK(decode("810101") == json::ParseStatus::invalid_key);
+    CHECK(decode("81c40161c0") == json::ParseStatus::invalid_key);
+    CHECK(decode("a1ff", json::Mode::strict) == json::ParseStatus::invalid_string);
+    CHECK(decode("81a1ff01", json::Mode::strict) == json::ParseStatus::invalid_string);
+    CHECK(decode("ca7fc00000", json::Mode::strict) == json::ParseStatus::invalid_number);
+
+    std::string deep(600, static_cast<char>(0x91));
+    deep.push_back(0);
+    json::Value value;
+    CHECK(json::msgpack::decode(value, deep) == json::ParseStatus::max_depth_reached);
+}
+
+TEST_CASE("MessagePack - round trip")
+{
+    static constexpr char const* const kInputs[] = {
+        R"({"menu":{"array":[1],"empty_array":[],"empty_object":{},"header":"SVG \"Viewer\"","items":[{"id":"Open"},{"id":"OpenNew","label":"Open New"},null,true,false,-1.5]}})",
+        R"([0, -0, 1e300, -1e-300, 0.1, 123456789012345678901234567890, -9007199254740993, 4294967296, 65536, 256, -257, -1e19])",
+        R"(["", "\u0000\u001f\"\\/", "ü水𐅑", "a string that is longer than thirty-one bytes"])",
+    };
+
+    for (auto const* input : kInputs)
+    {
+        CAPTURE(input);
+
+        json::Value j;
+        REQUIRE(json::parse(j, input) == json::ParseStatus::success);
+
+        auto const bytes = Encode(j);
+        json::Value k;
+        REQUIRE(json::msgpack::decode(k, bytes) == json::ParseStatus::success);
+        CHECK(j == k);
+    }
+}
+
+namespace {
+
+// Records the strings passed to the callbacks.
+struct StringCallbacks
+{
+    std::vector<std::pair<char const*, char const*>> strings;
+
+    json::ParseStatus HandleNull() { return {}; }
+    json::ParseStatus HandleTrue() { return {}; }
+    json::ParseStatus HandleFalse() { return {}; }
+    json::ParseStatus HandleNumber(char const* /*first*/, char const* /*last*/, json::NumberClass /*nc*/) { return {}; }
+    json::ParseStatus HandleString(char const* first, char const* last, json::StringClass /*sc*/) { strings.emplace_back(first, last); return {}; }
+    json::ParseStatus HandleKey(char const* first, char const* last, json::StringClass /*sc*/) { strings.emplace_back(first, last); return {}; }
+    json::ParseStatus HandleBeginArray() { return {}; }
+    json::ParseStatus HandleEndArray(size_t /*count*/) { return {}; }
+    json::ParseStatus HandleEndElement(size_t& /*count*/) { return {}; }
+    json::ParseStatus HandleBeginObject() { return {}; }
+    json::ParseStatus HandleEndObject(size_t /*count*/) { return {}; }
+    json::ParseStatus HandleEndMember(size_t& /*count*/) { return {}; }
+};
+
+} // namespace
+
+TEST_CASE("MessagePack - DecodeSAX zero-copy strings")
+{
+    // {"key": ["abc", 1.5, "xyz"]}
+    auto const bytes = FromHex("81a36b657993a3616263cb3ff8000000000000a378797a");
+
+    StringCallbacks cb;
+    auto const res = json::msgpack::DecodeSAX(cb, bytes.data(), bytes.data() + bytes.size(), json::Mode::strict);
+    REQUIRE(res.ec == json::ParseStatus::success);
+    REQUIRE(cb.strings.size() == 3);
+
+    CHECK(cb.strings[0].first == bytes.data() + 2);
+    CHECK(cb.strings[0].second == bytes.data() + 5);
+    CHECK(cb.strings[1].first == bytes.data() + 7);
+    CHECK(cb.strings[1].second == bytes.data() + 10);
+    CHECK(cb.strings[2].first == bytes.data() + 20);
+    CHECK(cb.strings[2].second == bytes.data() + 23);
+}
+
+namespace {
+
+// Also receives strings which contain special characters.
+struct UnescapedStringCallbacks : StringCallbacks
+{
+    json::ParseStatus HandleUnescapedString(char const* first, char const* last) { strings.emplace_back(first, last); return {}; }
+    json::ParseStatus HandleUnescapedKey(char const* first, char const* last) { strings.emplace_back(first, last); return {}; }
+};
+
+} // namespace
+
+TEST_CASE("MessagePack - DecodeSAX unescaped strings")
+{
+    // {"k\"": ["a\n", "\u00e4\\"]}
+    auto const bytes = FromHex("81a26b2292a2610aa3c3a45c");
+
+    UnescapedStringCallbacks cb;
+    auto const res = json::msgpack::DecodeSAX(cb, bytes.data(), bytes.data() + bytes.size(), json::Mode::strict);
+    REQUIRE(res.ec == json::ParseStatus::success);
+    REQUIRE(cb.strings.size() == 3);
+
+    CHECK(cb.strings[0].first == bytes.data() + 2);
+    CHECK(cb.strings[0].second == bytes.data() + 4);
+    CHECK(cb.strings[1].first == bytes.data() + 6);
+    CHECK(cb.strings[1].second == bytes.data() + 8);
+    CHECK(cb.strings[2].first == bytes.data() + 9);
+    CHECK(cb.strings[2].second == bytes.data() + 12);
+
+    // Without HandleUnescapedString, the strings are escaped.
+    StringCallbacks escaped;
+    REQUIRE(json::msgpack::DecodeSAX(escaped, bytes.data(), bytes.data() + bytes.size(), json::Mode::strict).ec == json::ParseStatus::success);
+    REQUIRE(escaped.strings.size() == 3);
+    CHECK(escaped.strings[2].first != bytes.data() + 9);
+    CHECK(escaped.strings[2].second - escaped.strings[2].first == 4);
+
+    json::Value value;
+    REQUIRE(json::msgpack::decode(value, bytes) == json::ParseStatus::success);
+    CHECK(value["k\""][0] == "a\n");
+    CHECK(value["k\""][1] == "\u00e4\\");
+}
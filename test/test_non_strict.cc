@@ -186,3 +186,30 @@ TEST_CASE("Lenient - NaN/Inf")
     CHECK(json::ParseStatus::unrecognized_identifier == json::parse(j, "infinity", mode));
     CHECK(json::ParseStatus::unrecognized_identifier == json::parse(j, "InfinityInfinityInfinity", mode));
 }
+
+TEST_CASE("Lenient - Invalid UTF-8 in strings")
+{
+    json::Mode mode = json::Mode::lenient;
+    json::Value j;
+
+    std::string const kFFFD = "\xEF\xBF\xBD";
+
+    CHECK(json::ParseStatus::success == json::parse(j, "\"\xFF\"", mode));
+    CHECK(j == kFFFD);
+    CHECK(json::ParseStatus::success == json::parse(j, "\"a\\n\xFF\xFE\"", mode));
+    CHECK(j == "a\n" + kFFFD + kFFFD);
+
+    // Each replacement is 3 times longer than the invalid byte.
+    std::string input = "\"\\t";
+    std::string expected = "\t";
+    for (int i = 0; i < 100; ++i)
+    {
+        input += "\x80";
+        expected += kFFFD;
+    }
+    input += "\"";
+    CHECK(json::ParseStatus::success == json::parse(j, input, mode));
+    CHECK(j == expected);
+
+    CHECK(json::ParseStatus::invalid_string == json::parse(j, "\"\xFF\""));
+}
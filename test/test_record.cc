@@ -0,0 +1,231 @@
+#include "catch.hpp"
+#include "../src/json_record.h"
+#include "../src/json_schema.h"
+
+TEST_CASE("KeyIndex - find")
+{
+    json::KeyIndex const empty;
+    CHECK(empty.size() == 0);
+    CHECK(empty.find("a") == json::KeyIndex::kNone);
+
+    json::KeyIndex const index{"id", "name", "", "a_rather_long_key_with_more_than_16_chars", "id", "n\xC3\xA4me"};
+    REQUIRE(index.size() == 5);
+    CHECK(index.find("id") == 0);
+    CHECK(index.find("name") == 1);
+    CHECK(index.find("") == 2);
+    CHECK(index.find("a_rather_long_key_with_more_than_16_chars") == 3);
+    CHECK(index.find("n\xC3\xA4me") == 4);
+    CHECK(index.key(4) == "n\xC3\xA4me");
+
+    CHECK(index.find("Id") == json::KeyIndex::kNone);
+    CHECK(index.find("nam") == json::KeyIndex::kNone);
+    CHECK(index.find("names") == json::KeyIndex::kNone);
+    CHECK(index.find("a_rather_long_key_with_more_than_16_chars!") == json::KeyIndex::kNone);
+    CHECK(index.find(std::string("id\0", 3)) == json::KeyIndex::kNone);
+
+    static_assert(json::impl::KeyHash("name", 4) != json::impl::KeyHash("nama", 4), "");
+
+    using namespace json::literals;
+    CHECK(index.find("name"_jk) == 1);
+    CHECK(index.find("nam"_jk) == json::KeyIndex::kNone);
+}
+
+TEST_CASE("KeyIndex - many keys")
+{
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; ++i)
+        keys.push_back("key" + std::to_string(i));
+
+    json::KeyIndex const index(keys);
+    REQUIRE(index.size() == keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        CHECK(index.find(keys[i]) == i);
+    CHECK(index.find("key1000") == json::KeyIndex::kNone);
+}
+
+TEST_CASE("KeyIndex - from schema")
+{
+    json::Value document;
+    REQUIRE(json::parse(document, R"({
+        "$defs": {"base": {"properties": {"id": {}, "b": {}}}},
+        "allOf": [{"$ref": "#/$defs/base"}],
+        "properties": {"a": {}, "nested": {"properties": {"x": {}}}}
+    })") == json::ParseStatus::success);
+
+    json::Schema schema;
+    REQUIRE(schema.compile(document));
+
+    json::KeyIndex const index(schema);
+    CHECK(index.size() == 4);
+    CHECK(index.find("a") != json::KeyIndex::kNone);
+    CHECK(index.find("b") != json::KeyIndex::kNone);
+    CHECK(index.find("id") != json::KeyIndex::kNone);
+    CHECK(index.find("nested") != json::KeyIndex::kNone);
+    CHECK(index.find("x") == json::KeyIndex::kNone);
+}
+
+TEST_CASE("Record - parse")
+{
+    json::KeyIndex const index{"id", "name", "tags", "missing"};
+
+    json::Record record;
+    auto const ec = json::parse_record(record, index, R"({
+        "id": 1,
+        "extra": {"id": 2, "name": "inner"},
+        "name": "x",
+        "tags": ["a", {"b": null}],
+        "id": 3,
+        "more": true
+    })");
+    REQUIRE(ec == json::ParseStatus::success);
+    REQUIRE(record.slots.size() == 4);
+    CHECK(record.slots[0] == 3);
+    CHECK(record.slots[1] == "x");
+    CHECK(record.slots[2] == json::Array{"a", json::Object{{"b", nullptr}}});
+    CHECK(record.slots[3].is_undefined());
+
+    CHECK(record.overflow.size() == 2);
+    CHECK(record.overflow["extra"] == json::Object{{"id", 2}, {"name", "inner"}});
+    CHECK(record.overflow["more"] == true);
+
+    // Many unknown members.
+    std::string text = "{";
+    for (int i = 0; i < 500; ++i)
+        text += "\"k" + std::to_string(i) + "\": " + std::to_string(i) + ", \"id\": " + std::to_string(i) + ", ";
+    text += "\"name\": null}";
+    REQUIRE(json::parse_record(record, index, text) == json::ParseStatus::success);
+    CHECK(record.slots[0] == 499);
+    CHECK(record.slots[1].is_null());
+    CHECK(record.slots[2].is_undefined());
+    CHECK(record.overflow.size() == 500);
+    CHECK(record.overflow["k123"] == 123);
+}
+
+TEST_CASE("Record - errors")
+{
+    json::KeyIndex const index{"id"};
+    json::Record record;
+
+    CHECK(json::parse_record(record, index, "[]") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_record(record, index, "1") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_record(record, index, R"({"id": 1)") == json::ParseStatus::expected_comma_or_closing_brace);
+    CHECK(json::parse_record(record, index, R"({"\x": 1})") == json::ParseStatus::invalid_string);
+    CHECK(json::parse_record(record, index, R"({"id": NaN})") == json::ParseStatus::invalid_number);
+
+    // Unchanged on errors.
+    REQUIRE(json::parse_record(record, index, R"({"id": 1, "x": 2})") == json::ParseStatus::success);
+    CHECK(json::parse_record(record, index, R"({"id": 3, "y": 4)") == json::ParseStatus::expected_comma_or_closing_brace);
+    CHECK(json::parse_record(record, index, R"({"id": 3, "y")") == json::ParseStatus::expected_colon_after_key);
+    REQUIRE(record.slots.size() == 1);
+    CHECK(record.slots[0] == 1);
+    REQUIRE(record.overflow.size() == 1);
+    CHECK(record.overflow["x"] == 2);
+}
+
+TEST_CASE("RecordArray - shapes")
+{
+    static constexpr char const* kInput = R"([
+        {"id": 1, "name": "a", "tags": [1, 2]},
+        {"id": 2, "name": "b", "tags": {"x": [3]}},
+        {"id": 3, "name": "c"},
+        {"id": 4, "name": "d", "tags": null},
+        {"name": "e", "id": 5},
+        {"id": 6, "name": "f", "tags": []},
+        {},
+        {"id": 7, "id": 8},
+        "not an object",
+        [{"id": 9}]
+    ])";
+
+    json::RecordArray records;
+    REQUIRE(json::parse_records(records, kInput) == json::ParseStatus::success);
+    REQUIRE(records.size() == 10);
+
+    json::Value expected;
+    REQUIRE(json::parse(expected, kInput) == json::ParseStatus::success);
+    CHECK(records.to_value() == expected);
+
+    // {id, name, tags}, {id, name}, {name, id}, {}
+    CHECK(records.shape_count() == 4);
+    CHECK(records.shape_of(0) == records.shape_of(1));
+    CHECK(records.shape_of(0) == records.shape_of(3));
+    CHECK(records.shape_of(0) == records.shape_of(5));
+    CHECK(records.shape_of(2) != records.shape_of(0));
+    CHECK(records.shape_of(4) != records.shape_of(2));
+    CHECK(records.shape_of(6) != json::RecordArray::kNoShape);
+    CHECK(records.shape_of(7) == json::RecordArray::kNoShape);
+    CHECK(records.shape_of(8) == json::RecordArray::kNoShape);
+    CHECK(records.shape_of(9) == json::RecordArray::kNoShape);
+
+    auto const& shape = records.shape(records.shape_of(4));
+    REQUIRE(shape.size() == 2);
+    CHECK(shape.key(0) == "name");
+    CHECK(shape.key(1) == "id");
+    CHECK(records.value(4, 0) == "e");
+    CHECK(records.value(4, 1) == 5);
+
+    CHECK(records.element(7) == json::Object{{"id", 8}});
+    CHECK(records.element(8) == "not an object");
+
+    using namespace json::literals;
+    CHECK(records.get(0, "id") == 1);
+    CHECK(records.get(1, "tags"_jk) == json::Object{{"x", json::Array{3}}});
+    CHECK(records.get(2, std::string("tags")).is_undefined());
+    CHECK(records.get(7, "id") == 8);
+    CHECK(records.get(8, "id").is_undefined());
+    CHECK(records.get(9, "id").is_undefined());
+
+    auto const name = records.column("name"_jk);
+    CHECK(name.key() == "name");
+    char const* const names[] = {"a", "b", "c", "d", "e", "f"};
+    for (size_t i = 0; i < 6; ++i)
+        CHECK(records.get(i, name) == names[i]);
+    CHECK(records.get(6, name).is_undefined());
+    CHECK(records.get(7, name).is_undefined());
+    CHECK(records.get(8, name).is_undefined());
+
+    auto const id = records.column("id");
+    CHECK(records.get(7, id) == 8);
+}
+
+TEST_CASE("RecordArray - many rows")
+{
+    std::string text = "[";
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (i != 0)
+            text += ",";
+        text += R"({"a": )" + std::to_string(i) + R"(, "b": {"c": )" + std::to_string(i) + "}}";
+    }
+    text += "]";
+
+    json::RecordArray records;
+    REQUIRE(json::parse_records(records, text) == json::ParseStatus::success);
+    REQUIRE(records.size() == 1000);
+    CHECK(records.shape_count() == 1);
+
+    auto const b = records.column("b");
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        CHECK(records.get(i, "a") == static_cast<double>(i));
+        CHECK(records.get(i, b)["c"] == static_cast<double>(i));
+    }
+}
+
+TEST_CASE("RecordArray - errors")
+{
+    json::RecordArray records;
+
+    CHECK(json::parse_records(records, "[]") == json::ParseStatus::success);
+    CHECK(records.empty());
+
+    REQUIRE(json::parse_records(records, R"([{"a": 1}])") == json::ParseStatus::success);
+    CHECK(json::parse_records(records, "{}") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_records(records, "1") == json::ParseStatus::schema_violation);
+    CHECK(json::parse_records(records, R"([{"a": 1})") == json::ParseStatus::expected_comma_or_closing_bracket);
+    CHECK(json::parse_records(records, R"([{"\x": 1}])") == json::ParseStatus::invalid_string);
+    CHECK(json::parse_records(records, R"([{"a": NaN}])") == json::ParseStatus::invalid_number);
+
+    // Unchanged on errors.
+    CHECK(records.size() == 1);
+}
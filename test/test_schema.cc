@@ -0,0 +1,326 @@
+#include "catch.hpp"
+#include "../src/json_schema.h"
+
+#include <limits>
+
+static json::Schema Compile(char const* text)
+{
+    json::Value document;
+    REQUIRE(json::parse(document, text) == json::ParseStatus::success);
+
+    json::Schema schema;
+    REQUIRE(schema.compile(document));
+    return schema;
+}
+
+static bool Valid(json::Schema const& schema, char const* text)
+{
+    auto const ec = json::validate(schema, text);
+    CHECK((ec == json::ParseStatus::success || ec == json::ParseStatus::schema_violation));
+
+    json::Value value;
+    REQUIRE(json::parse(value, text) == json::ParseStatus::success);
+    CHECK(json::validate_value(schema, value) == (ec == json::ParseStatus::success));
+
+    return ec == json::ParseStatus::success;
+}
+
+TEST_CASE("Schema - compile")
+{
+    auto compile = [](char const* text) {
+        json::Value document;
+        REQUIRE(json::parse(document, text) == json::ParseStatus::success);
+        json::Schema schema;
+        bool const ok = schema.compile(document);
+        CHECK(schema.empty() == !ok);
+        return ok;
+    };
+
+    CHECK(compile("true"));
+    CHECK(compile("false"));
+    CHECK(compile("{}"));
+    CHECK(compile(R"({"title": "x", "format": "date", "x-unknown": [1, 2]})"));
+    CHECK(compile(R"({"$defs": {"a": {"$ref": "#/$defs/b"}, "b": {"type": "null"}}, "$ref": "#/$defs/a"})"));
+    CHECK(compile(R"({"properties": {"next": {"$ref": "#"}}})"));
+    CHECK(compile(R"({"uniqueItems": false})"));
+
+    CHECK(!compile("1"));
+    CHECK(!compile("[]"));
+    CHECK(!compile(R"({"type": "float"})"));
+    CHECK(!compile(R"({"type": []})"));
+    CHECK(!compile(R"({"minLength": -1})"));
+    CHECK(!compile(R"({"minLength": 1.5})"));
+    CHECK(!compile(R"({"multipleOf": 0})"));
+    CHECK(!compile(R"({"allOf": []})"));
+    CHECK(!compile(R"({"required": [1]})"));
+    CHECK(!compile(R"({"pattern": "^a"})"));
+    CHECK(!compile(R"({"uniqueItems": true})"));
+    CHECK(!compile(R"({"contains": {}})"));
+    CHECK(!compile(R"({"items": [{}]})"));
+    CHECK(!compile(R"({"enum": [[1]]})"));
+    CHECK(!compile(R"({"const": {}})"));
+    CHECK(!compile(R"({"$ref": "other.json"})"));
+    CHECK(!compile(R"({"$ref": "#/$defs/missing"})"));
+    CHECK(!compile(R"({"$ref": "#"})"));
+    CHECK(!compile(R"({"$defs": {"a": {"allOf": [{"$ref": "#/$defs/b"}]}, "b": {"not": {"$ref": "#/$defs/a"}}}, "$ref": "#/$defs/a"})"));
+}
+
+TEST_CASE("Schema - type")
+{
+    auto const s = Compile(R"({"type": ["integer", "string"]})");
+    CHECK(Valid(s, "1"));
+    CHECK(Valid(s, "1.0"));
+    CHECK(Valid(s, "\"a\""));
+    CHECK(!Valid(s, "1.5"));
+    CHECK(!Valid(s, "null"));
+    CHECK(!Valid(s, "[]"));
+
+    auto const n = Compile(R"({"type": "number"})");
+    CHECK(Valid(n, "1"));
+    CHECK(Valid(n, "1.5"));
+    CHECK(!Valid(n, "true"));
+
+    // Infinities are numbers, but not integers.
+    auto const i = Compile(R"({"type": "integer"})");
+    double const inf = std::numeric_limits<double>::infinity();
+    CHECK(json::validate(i, "1e400", json::Mode::strict) == json::ParseStatus::invalid_number);
+    CHECK(json::validate(i, "1e400", json::Mode::lenient) == json::ParseStatus::schema_violation);
+    CHECK(json::validate(i, "-Infinity", json::Mode::lenient) == json::ParseStatus::schema_violation);
+    CHECK(json::validate(n, "1e400", json::Mode::lenient) == json::ParseStatus::success);
+    CHECK(!json::validate_value(i, json::Value(inf)));
+    CHECK(!json::validate_value(i, json::Value(-inf)));
+    CHECK(json::validate_value(n, json::Value(inf)));
+    CHECK(json::validate_value(i, json::Value(1e300)));
+
+    CHECK(Valid(Compile("true"), R"({"a": [1, 2]})"));
+    CHECK(!Valid(Compile("false"), "null"));
+}
+
+TEST_CASE("Schema - enum and const")
+{
+    auto const s = Compile(R"({"enum": [null, false, 1, "a\u00e4"]})");
+    CHECK(Valid(s, "null"));
+    CHECK(Valid(s, "false"));
+    CHECK(Valid(s, "1.0"));
+    CHECK(Valid(s, "\"a\u00e4\""));
+    CHECK(Valid(s, "\"a\\u00e4\""));
+    CHECK(!Valid(s, "true"));
+    CHECK(!Valid(s, "2"));
+    CHECK(!Valid(s, "\"a\""));
+    CHECK(!Valid(s, "[]"));
+
+    auto const c = Compile(R"({"const": "x"})");
+    CHECK(Valid(c, "\"x\""));
+    CHECK(!Valid(c, "\"y\""));
+}
+
+TEST_CASE("Schema - numbers")
+{
+    auto const s = Compile(R"({"minimum": 1, "exclusiveMaximum": 10, "multipleOf": 0.5})");
+    CHECK(Valid(s, "1"));
+    CHECK(Valid(s, "9.5"));
+    CHECK(!Valid(s, "0.5"));
+    CHECK(!Valid(s, "10"));
+    CHECK(!Valid(s, "2.25"));
+    CHECK(Valid(s, "\"not a number\""));
+
+    auto const d1 = Compile(R"({"multipleOf": 0.1})");
+    CHECK(Valid(d1, "0"));
+    CHECK(Valid(d1, "0.3"));
+    CHECK(Valid(d1, "0.7"));
+    CHECK(Valid(d1, "-1.1"));
+    CHECK(Valid(d1, "123.4"));
+    CHECK(!Valid(d1, "0.35"));
+    CHECK(!Valid(d1, "0.30001"));
+
+    auto const d2 = Compile(R"({"multipleOf": 0.01})");
+    CHECK(Valid(d2, "0.07"));
+    CHECK(Valid(d2, "19.99"));
+    CHECK(!Valid(d2, "0.075"));
+
+    // The quotients overflow and underflow.
+    auto const tiny = Compile(R"({"multipleOf": 1e-300})");
+    CHECK(Valid(tiny, "1e300"));
+    CHECK(Valid(tiny, "-1e300"));
+    CHECK(Valid(tiny, "0"));
+    auto const huge = Compile(R"({"multipleOf": 1e300})");
+    CHECK(Valid(huge, "3e300"));
+    CHECK(Valid(huge, "0"));
+    CHECK(!Valid(huge, "1e-300"));
+    CHECK(!Valid(huge, "1"));
+
+    auto const t = Compile(R"({"exclusiveMinimum": 1, "maximum": 10})");
+    CHECK(!Valid(t, "1"));
+    CHECK(Valid(t, "10"));
+    CHECK(!Valid(t, "10.5"));
+
+    CHECK(json::validate(t, "NaN", json::Mode::strict) == json::ParseStatus::invalid_number);
+    CHECK(!json::validate_value(t, json::Value(std::numeric_limits<double>::quiet_NaN())));
+}
+
+TEST_CASE("Schema - strings")
+{
+    auto const s = Compile(R"({"minLength": 2, "maxLength": 3})");
+    CHECK(!Valid(s, "\"a\""));
+    CHECK(Valid(s, "\"ab\""));
+    CHECK(Valid(s, "\"\u6c34\U00010151\""));
+    CHECK(Valid(s, "\"a\\n\\u00e4\""));
+    CHECK(!Valid(s, "\"abcd\""));
+
+    CHECK(json::validate(s, "\"\\x\"") == json::ParseStatus::invalid_string);
+}
+
+TEST_CASE("Schema - arrays")
+{
+    auto const s = Compile(R"({
+        "prefixItems": [{"type": "string"}, {"type": "boolean"}],
+        "items": {"type": "integer"},
+        "minItems": 1,
+        "maxItems": 4
+    })");
+    CHECK(!Valid(s, "[]"));
+    CHECK(Valid(s, R"(["a"])"));
+    CHECK(Valid(s, R"(["a", true, 1, 2])"));
+    CHECK(!Valid(s, R"([1])"));
+    CHECK(!Valid(s, R"(["a", 1])"));
+    CHECK(!Valid(s, R"(["a", true, 1.5])"));
+    CHECK(!Valid(s, R"(["a", true, 1, 2, 3])"));
+    CHECK(Valid(s, R"({"not": "an array"})"));
+
+    auto const nested = Compile(R"({"items": {"items": {"type": "null"}}})");
+    CHECK(Valid(nested, "[[], [null], [null, null]]"));
+    CHECK(!Valid(nested, "[[], [null], [null, 1]]"));
+}
+
+TEST_CASE("Schema - objects")
+{
+    auto const s = Compile(R"({
+        "properties": {
+            "id": {"type": "integer"},
+            "name": {"type": "string"}
+        },
+        "required": ["name", "id", "name"],
+        "additionalProperties": {"type": "boolean"},
+        "maxProperties": 3
+    })");
+    CHECK(Valid(s, R"({"id": 1, "name": "x"})"));
+    CHECK(Valid(s, R"({"name": "x", "id": 1, "flag": true})"));
+    CHECK(Valid(s, R"({"n\u0061me": "x", "id": 1})"));
+    CHECK(!Valid(s, R"({"id": 1})"));
+    CHECK(!Valid(s, R"({"id": "1", "name": "x"})"));
+    CHECK(!Valid(s, R"({"id": 1, "name": "x", "flag": 1})"));
+    CHECK(!Valid(s, R"({"id": 1, "name": "x", "a": true, "b": true})"));
+
+    auto const closed = Compile(R"({"properties": {"a": {}}, "additionalProperties": false, "minProperties": 1})");
+    CHECK(Valid(closed, R"({"a": [1, {"b": 2}]})"));
+    CHECK(!Valid(closed, R"({})"));
+    CHECK(!Valid(closed, R"({"a": 1, "b": 2})"));
+
+    // Duplicate keys count only once.
+    auto const counts = Compile(R"({"minProperties": 2, "maxProperties": 2, "additionalProperties": {"maxProperties": 1}})");
+    CHECK(!Valid(counts, R"({"a": 1, "a": 2})"));
+    CHECK(Valid(counts, R"({"a": 1, "b": 2, "a": 3})"));
+    CHECK(!Valid(counts, R"({"a": 1, "b": 2, "c": 3})"));
+    CHECK(Valid(counts, R"({"a": {"x": 1, "x": 2}, "b": {}})"));
+    CHECK(!Valid(counts, R"({"a": {"x": 1, "y": 2}, "b": {}})"));
+}
+
+TEST_CASE("Schema - combinators")
+{
+    auto const all = Compile(R"({"allOf": [{"minimum": 1}, {"maximum": 2}]})");
+    CHECK(Valid(all, "1.5"));
+    CHECK(!Valid(all, "3"));
+
+    auto const any = Compile(R"({"anyOf": [{"type": "string"}, {"minimum": 2}]})");
+    CHECK(Valid(any, "\"a\""));
+    CHECK(Valid(any, "3"));
+    CHECK(!Valid(any, "1"));
+
+    auto const one = Compile(R"({"oneOf": [{"type": "integer"}, {"minimum": 2}]})");
+    CHECK(Valid(one, "1"));
+    CHECK(Valid(one, "2.5"));
+    CHECK(!Valid(one, "3"));
+    CHECK(!Valid(one, "1.5"));
+
+    auto const not_ = Compile(R"({"not": {"type": "array", "items": {"type": "null"}}})");
+    CHECK(Valid(not_, "1"));
+    CHECK(Valid(not_, "[1]"));
+    CHECK(!Valid(not_, "[null]"));
+
+    auto const cond = Compile(R"({
+        "if": {"properties": {"kind": {"const": "a"}}, "required": ["kind"]},
+        "then": {"required": ["a"]},
+        "else": {"required": ["b"]}
+    })");
+    CHECK(Valid(cond, R"({"kind": "a", "a": 1})"));
+    CHECK(!Valid(cond, R"({"kind": "a", "b": 1})"));
+    CHECK(Valid(cond, R"({"kind": "b", "b": 1})"));
+    CHECK(Valid(cond, R"({"b": 1})"));
+    CHECK(!Valid(cond, R"({"a": 1})"));
+}
+
+TEST_CASE("Schema - $ref")
+{
+    auto const s = Compile(R"({
+        "$defs": {
+            "node": {
+                "type": "object",
+                "properties": {
+                    "value": {"type": "integer"},
+                    "children": {"type": "array", "items": {"$ref": "#/$defs/node"}}
+                },
+                "required": ["value"]
+            },
+            "a/b": {"type": "null"}
+        },
+        "properties": {
+            "root": {"$ref": "#/$defs/node"},
+            "escaped": {"$ref": "#/$defs/a~1b"}
+        }
+    })");
+    CHECK(Valid(s, R"({"root": {"value": 1, "children": [{"value": 2}, {"value": 3, "children": []}]}})"));
+    CHECK(!Valid(s, R"({"root": {"value": 1, "children": [{"value": 2}, {"children": []}]}})"));
+    CHECK(Valid(s, R"({"escaped": null})"));
+    CHECK(!Valid(s, R"({"escaped": 0})"));
+}
+
+TEST_CASE("Schema - early stop")
+{
+    auto const s = Compile(R"({"items": {"type": "integer"}})");
+
+    std::string const text = "[1, 2, \"x\", 4, 5]";
+    auto const res = json::validate(s, text.data(), text.data() + text.size());
+    CHECK(res.ec == json::ParseStatus::schema_violation);
+    CHECK(res.ptr - text.data() == 10); // just past "x", the rest is not parsed
+
+    // Syntax errors are reported as such.
+    CHECK(json::validate(s, "[1, 2") == json::ParseStatus::expected_comma_or_closing_bracket);
+}
+
+TEST_CASE("Schema - parse")
+{
+    auto const s = Compile(R"({"properties": {"a": {"type": "integer"}}, "required": ["a"]})");
+
+    json::ParseOptions options;
+    options.schema = &s;
+
+    json::Value j;
+    CHECK(json::parse(j, R"({"a": 1, "b": [true]})", options) == json::ParseStatus::success);
+    CHECK(j["a"] == 1.0);
+    CHECK(j["b"][0] == true);
+
+    CHECK(json::parse(j, R"({"a": 1.5})", options) == json::ParseStatus::schema_violation);
+    CHECK(json::parse(j, R"({"b": 1})", options) == json::ParseStatus::schema_violation);
+    CHECK(json::parse(j, R"({"a": 1)", options) == json::ParseStatus::expected_comma_or_closing_brace);
+}
+
+TEST_CASE("Schema - raw values")
+{
+    auto const s = Compile(R"({"properties": {"a": {"items": {"type": "integer"}}}})");
+
+    json::Value j = json::Object{};
+    j["a"].assign(json::raw_tag, "[1, 2, 3]");
+    CHECK(json::validate_value(s, j));
+    j["a"].assign(json::raw_tag, "[1, 2, 3.5]");
+    CHECK(!json::validate_value(s, j));
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+#include "../src/json_snapshot.h"
+
+#include <cstdio>
+#include <limits>
+
+static constexpr char const* kSnapshotFile = "test_snapshot.snp";
+
+static constexpr char const* kInput = R"({
+    "menu": {
+        "array": [1, -1.5, 1e300],
+        "empty_array": [],
+        "empty_object": {},
+        "header": "SVG \"Viewer\"",
+        "items": [{"id": "Open"}, {"id": "OpenNew", "label": "Open New"}, null, true, false],
+        "unicode": "ü水𐅑",
+        "": "empty key"
+    }
+})";
+
+TEST_CASE("Snapshot - round trip")
+{
+    json::Value j;
+    REQUIRE(json::parse(j, kInput) == json::ParseStatus::success);
+    j["menu"]["raw"].assign(json::raw_tag, "[1, 2, 3]");
+    j["menu"]["undefined"] = json::Value{};
+    j["menu"][std::string("nul\0char", 8)] = std::string("a\0b", 3);
+
+    REQUIRE(json::save_snapshot(j, kSnapshotFile));
+
+    {
+        json::Snapshot snapshot = json::open_snapshot(kSnapshotFile);
+        REQUIRE(snapshot.is_open());
+
+        json::SnapshotView const root = snapshot.root();
+        CHECK(root.is_object());
+        CHECK(root.size() == 1);
+        CHECK(root.to_value() == j);
+
+        json::SnapshotView const menu = root["menu"];
+        REQUIRE(menu.is_object());
+        CHECK(menu.size() == 10);
+
+        auto const arr = menu["array"];
+        REQUIRE(arr.is_array());
+        REQUIRE(arr.size() == 3);
+        CHECK(arr[0].get_number() == 1.0);
+        CHECK(arr[1].get_number() == -1.5);
+        CHECK(arr[2].get_number() == 1e300);
+
+        CHECK(menu["empty_array"].is_array());
+        CHECK(menu["empty_array"].empty());
+        CHECK(menu["empty_object"].is_object());
+        CHECK(menu["empty_object"].empty());
+
+        auto const header = menu["header"];
+        REQUIRE(header.is_string());
+        CHECK(std::string(header.get_string(), header.size()) == "SVG \"Viewer\"");
+        CHECK(header.get_string()[header.size()] == '\0');
+
+        auto const items = menu["items"];
+        REQUIRE(items.is_array());
+        REQUIRE(items.size() == 5);
+        CHECK(std::string(items[1]["label"].get_string()) == "Open New");
+        CHECK(items[1]["missing"].is_undefined());
+        CHECK(items[2].is_null());
+        CHECK(items[3].get_boolean() == true);
+        CHECK(items[4].get_boolean() == false);
+        CHECK(items[4]["key"].is_undefined()); // not an object
+
+        CHECK(std::string(menu[""].get_string()) == "empty key");
+        CHECK(std::string(menu["raw"].get_raw(), menu["raw"].size()) == "[1, 2, 3]");
+        CHECK(menu["undefined"].is_undefined());
+        CHECK(menu.find("nul\0char", 8).size() == 3);
+        CHECK(menu.find(std::string("nul")).is_undefined());
+        CHECK(menu.find("zzz").is_undefined());
+
+        // Members are sorted by key.
+        for (size_t i = 1; i < menu.size(); ++i)
+        {
+            CHECK(std::string(menu.key(i - 1), menu.key_size(i - 1)) < std::string(menu.key(i), menu.key_size(i)));
+        }
+
+        json::Snapshot moved = std::move(snapshot);
+        CHECK(!snapshot.is_open());
+        CHECK(moved.is_open());
+        CHECK(moved.root().to_value() == j);
+
+        moved.close();
+        CHECK(!moved.is_open());
+    }
+
+    std::remove(kSnapshotFile);
+}
+
+TEST_CASE("Snapshot - scalars")
+{
+    json::Value const values[] = {
+        nullptr,
+        true,
+        -0.0,
+        std::numeric_limits<double>::infinity(),
+        "",
+        json::Array{},
+        json::Object{},
+    };
+
+    for (auto const& value : values)
+    {
+        REQUIRE(json::save_snapshot(value, kSnapshotFile));
+
+        json::Snapshot const snapshot = json::open_snapshot(kSnapshotFile);
+        REQUIRE(snapshot.is_open());
+        CHECK(snapshot.root().type() == value.type());
+        CHECK(snapshot.root().to_value() == value);
+    }
+
+    std::remove(kSnapshotFile);
+}
+
+TEST_CASE("Snapshot - invalid files")
+{
+    CHECK(!json::open_snapshot("this file does not exist").is_open());
+
+    auto write_file = [](std::string const& contents) {
+        std::FILE* file = std::fopen(kSnapshotFile, "wb");
+        REQUIRE(file != nullptr);
+        std::fwrite(contents.data(), 1, contents.size(), file);
+        std::fclose(file);
+    };
+
+    write_file("");
+    CHECK(!json::open_snapshot(kSnapshotFile).is_open());
+
+    write_file("not a snapshot, but long enough to contain a header");
+    CHECK(!json::open_snapshot(kSnapshotFile).is_open());
+
+    // Truncated
+    REQUIRE(json::save_snapshot(json::Array{1, 2, 3}, kSnapshotFile));
+    std::string contents;
+    {
+        std::FILE* file = std::fopen(kSnapshotFile, "rb");
+        REQUIRE(file != nullptr);
+        char buf[256];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), file)) != 0)
+            contents.append(buf, n);
+        std::fclose(file);
+    }
+    CHECK(json::open_snapshot(kSnapshotFile).is_open());
+
+    write_file(contents.substr(0, contents.size() - 1));
+    CHECK(!json::open_snapshot(kSnapshotFile).is_open());
+
+    std::remove(kSnapshotFile);
+}
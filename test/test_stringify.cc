@@ -1,6 +1,9 @@
 #include "catch.hpp"
 #include "../src/json.h"
 
+#include <cstdio>
+#include <sstream>
+
 // sorted objects
 static constexpr char const* svg_menu = R"({"menu":{"array":[1],"empty_array":[],"header":"SVG Viewer","items":[{"id":"Open"},{"id":"OpenNew","label":"Open New"},null]}})";
 
@@ -51,3 +54,371 @@ TEST_CASE("Stringify - pretty")
     REQUIRE(ecs == true);
     CHECK(expected == str);
 }
+
+TEST_CASE("Stringify - single precision")
+{
+    json::Value j;
+    auto const ec = json::parse(j, R"([0.1,-1.5,16777216,16777217,0.30000001192092896,1e39,-0.0,3.4028234663852886e38])");
+    REQUIRE(ec == json::ParseStatus::success);
+
+    json::StringifyOptions options;
+    options.single_precision = true;
+
+    std::string str;
+    auto const ecs = json::stringify(str, j, options);
+    REQUIRE(ecs == true);
+    CHECK(R"([0.1,-1.5,16777216,16777216,0.3,null,-0.0,3.4028235e+38])" == str);
+}
+
+TEST_CASE("Stringify - escape strings")
+{
+    struct Test {
+        std::string inp;
+        std::string expected;
+    };
+
+    static const Test tests[] = {
+        {"\"", "\\\""},
+        {"\\", "\\\\"},
+        {"/", "/"},
+        {"</", "<\\/"},
+        {"\x01\x1F", "\\u0001\\u001F"},
+        {"\b\f\n\r\t", "\\b\\f\\n\\r\\t"},
+        {"\xC3\xA4", "\xC3\xA4"},
+        {"\xE2\x80\xA8\xE2\x80\xA9", "\\u2028\\u2029"},
+        {"\xF0\x9D\x84\x9E", "\xF0\x9D\x84\x9E"},
+        {"\xC3\xA4\"\xC3\xB6\n\xE2\x82\xAC", "\xC3\xA4\\\"\xC3\xB6\\n\xE2\x82\xAC"},
+        {"\xC3\xA4</\xF0\x9D\x84\x9E", "\xC3\xA4<\\/\xF0\x9D\x84\x9E"},
+        {"\xC3\xA4\xE2\x80\xA8\xC3\xB6", "\xC3\xA4\\u2028\xC3\xB6"},
+    };
+
+    // Move the special characters over the 16-byte block boundaries.
+    std::string const padding = "0123456789abcdef0123456789abcdef0123456789abcdef";
+
+    for (auto const& test : tests)
+    {
+        for (size_t n = 0; n <= 33; ++n)
+        {
+            std::string const prefix = padding.substr(0, n);
+            std::string const suffix = padding.substr(0, 33 - n);
+
+            CAPTURE(test.inp);
+            CAPTURE(n);
+
+            std::string str;
+            auto const ok = json::stringify(str, json::Value(prefix + test.inp + suffix));
+            CHECK(ok);
+            CHECK(str == "\"" + prefix + test.expected + suffix + "\"");
+        }
+    }
+}
+
+TEST_CASE("Stringify - invalid UTF-8")
+{
+    json::Value const j = "\xC3\xA4\xFF\xC3\xB6\"\xE2\x82 \xC3\xA4";
+
+    std::string str;
+    CHECK(!json::stringify(str, j));
+
+    json::StringifyOptions options;
+    options.mode = json::Mode::lenient;
+
+    str.clear();
+    CHECK(json::stringify(str, j, options));
+    CHECK(str == "\"\xC3\xA4\\uFFFD\xC3\xB6\\\"\\uFFFD \xC3\xA4\"");
+}
+
+TEST_CASE("Stringify - sinks")
+{
+    json::Value j;
+    auto const ec = json::parse(j, svg_menu);
+    REQUIRE(ec == json::ParseStatus::success);
+
+    json::StringifyOptions options;
+    options.indent_width = 80; // Indentation larger than the buffers below.
+
+    std::string expected;
+    REQUIRE(json::stringify(expected, j, options));
+
+    SECTION("StringSink")
+    {
+        std::string str = "prefix";
+        {
+            json::StringSink sink(str);
+            CHECK(json::stringify(sink, j, options));
+            CHECK(json::stringify(sink, j, options));
+        }
+        CHECK(str == "prefix" + expected + expected);
+    }
+
+    SECTION("ArraySink")
+    {
+        std::vector<char> buf(expected.size());
+        json::ArraySink sink(buf.data(), buf.data() + buf.size());
+        CHECK(json::stringify(sink, j, options));
+        CHECK(sink.Size() == expected.size());
+        CHECK(std::string(buf.data(), sink.Size()) == expected);
+
+        json::ArraySink small_sink(buf.data(), buf.data() + buf.size() - 1);
+        CHECK(!json::stringify(small_sink, j, options));
+        CHECK(small_sink.Failed());
+    }
+
+    SECTION("CallbackSink")
+    {
+        for (size_t buffer_size = 1; buffer_size <= 64; buffer_size *= 2)
+        {
+            std::vector<char> buf(buffer_size);
+            std::string str;
+            int num_calls = 0;
+            json::CallbackSink sink(buf.data(), buf.size(), [&](char const* p, size_t n) {
+                CHECK(n > 0);
+                str.append(p, n);
+                ++num_calls;
+                return true;
+            });
+            CHECK(json::stringify(sink, j, options));
+            CHECK(str == expected);
+            CHECK(num_calls > 1);
+        }
+
+        char buf[16];
+        json::CallbackSink failing_sink(buf, sizeof(buf), [](char const*, size_t) { return false; });
+        CHECK(!json::stringify(failing_sink, j, options));
+        CHECK(failing_sink.Failed());
+    }
+
+    SECTION("StreamSink")
+    {
+        std::ostringstream os;
+        {
+            json::StreamSink sink(os);
+            CHECK(json::stringify(sink, j, options));
+        }
+        CHECK(os.str() == expected);
+    }
+
+    SECTION("FileSink")
+    {
+        std::FILE* file = std::tmpfile();
+        REQUIRE(file != nullptr);
+        {
+            json::FileSink sink(file);
+            CHECK(json::stringify(sink, j, options));
+        }
+
+        std::string str(expected.size() + 1, '\0');
+        std::rewind(file);
+        str.resize(std::fread(&str[0], 1, str.size(), file));
+        std::fclose(file);
+
+        CHECK(str == expected);
+    }
+}
+
+TEST_CASE("Stringify - stringified_size")
+{
+    static constexpr char const* inputs[] = {
+        R"(null)",
+        R"(true)",
+        R"(false)",
+        R"(0)",
+        R"(-1.5e-300)",
+        R"(123456789012345678901234567890)",
+        R"("")",
+        R"("Hello \"World\"\n\u0001 </ä")",
+        R"([])",
+        R"({})",
+        R"([[]])",
+        R"([{}])",
+        R"({"a":[]})",
+        R"([1,2.5,"three",[4,[5,{}]],{"six":6,"seven":[7,7.5],"eight":{"nine":null}},true,false,null])",
+        svg_menu,
+    };
+
+    for (auto const* input : inputs)
+    {
+        CAPTURE(input);
+
+        json::Value j;
+        auto const ec = json::parse(j, input);
+        REQUIRE(ec == json::ParseStatus::success);
+
+        for (int indent_width = -1; indent_width <= 4; ++indent_width)
+        {
+            for (bool single_precision : {false, true})
+            {
+                CAPTURE(indent_width);
+                CAPTURE(single_precision);
+
+                json::StringifyOptions options;
+                options.indent_width = static_cast<int8_t>(indent_width);
+                options.single_precision = single_precision;
+
+                std::string str;
+                REQUIRE(json::stringify(str, j, options));
+                CHECK(json::stringified_size(j, options) == str.size());
+
+                std::vector<char> buf(str.size());
+                json::ArraySink sink(buf.data(), buf.data() + buf.size());
+                CHECK(json::stringify(sink, j, options));
+                CHECK(std::string(buf.data(), sink.Size()) == str);
+            }
+        }
+    }
+
+    // Invalid UTF-8
+    {
+        json::Value j = json::Array{1, "\xFF", 2};
+        CHECK(json::stringified_size(j) == 0);
+
+        json::StringifyOptions options;
+        options.mode = json::Mode::lenient;
+
+        std::string str;
+        REQUIRE(json::stringify(str, j, options));
+        CHECK(json::stringified_size(j, options) == str.size());
+    }
+
+    // Non-finite numbers
+    {
+        json::Value j = json::Array{std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::quiet_NaN(), 1e300};
+
+        for (auto mode : {json::Mode::strict, json::Mode::lenient})
+        {
+            for (bool single_precision : {false, true})
+            {
+                json::StringifyOptions options;
+                options.mode = mode;
+                options.single_precision = single_precision;
+
+                std::string str;
+                REQUIRE(json::stringify(str, j, options));
+                CHECK(json::stringified_size(j, options) == str.size());
+            }
+        }
+    }
+}
+
+TEST_CASE("Stringify - raw")
+{
+    static constexpr char const* input = R"({"data": [1, {"x": "\u00e4"}, [], {}], "id": 7})";
+
+    json::Value expected;
+    REQUIRE(json::parse(expected, input) == json::ParseStatus::success);
+
+    json::ParseOptions parse_options;
+    parse_options.capture_raw = [](json::String const& key) { return key == "data"; };
+
+    json::Value j;
+    REQUIRE(json::parse(j, input, parse_options) == json::ParseStatus::success);
+    REQUIRE(j["data"].is_raw());
+
+    // Compact output copies the source text.
+    std::string str;
+    CHECK(json::stringify(str, j));
+    CHECK(str == R"({"data":[1, {"x": "\u00e4"}, [], {}],"id":7})");
+    CHECK(json::stringified_size(j) == str.size());
+
+    // Pretty-printed output is re-indented.
+    for (int indent_width = 0; indent_width <= 4; ++indent_width)
+    {
+        CAPTURE(indent_width);
+
+        json::StringifyOptions options;
+        options.indent_width = static_cast<int8_t>(indent_width);
+
+        std::string expected_str;
+        REQUIRE(json::stringify(expected_str, expected, options));
+
+        std::string raw_str;
+        CHECK(json::stringify(raw_str, j, options));
+        CHECK(json::stringified_size(j, options) == raw_str.size());
+
+        // Strings are copied verbatim.
+        auto const pos = raw_str.find("\\u00e4");
+        REQUIRE(pos != std::string::npos);
+        raw_str.replace(pos, 6, "\xC3\xA4");
+        CHECK(raw_str == expected_str);
+    }
+
+    // Comments are removed when re-indenting.
+    json::Value lenient(json::raw_tag, "[1, /* two */ 2]");
+    json::StringifyOptions options;
+    options.indent_width = 0;
+    std::string lenient_str;
+    CHECK(json::stringify(lenient_str, lenient, options));
+    CHECK(lenient_str == "[1, 2]");
+
+    // Invalid raw text is only detected when re-indenting.
+    json::Value invalid(json::raw_tag, "[1,");
+    std::string invalid_str;
+    CHECK(json::stringify(invalid_str, invalid));
+    CHECK(invalid_str == "[1,");
+    CHECK(!json::stringify(invalid_str, invalid, options));
+}
+
+TEST_CASE("Stringify - parallel")
+{
+    json::Value j = json::Object{};
+    {
+        auto& items = j["items"] = json::Array{};
+        for (int i = 0; i < 200; ++i)
+        {
+            json::Value item = json::Object{};
+            item["id"] = i;
+            item["name"] = "item " + std::to_string(i);
+            item["tags"] = json::Array{"a", "b", i % 3 == 0 ? json::Value(json::Array{}) : json::Value(i * 0.5)};
+            if (i % 50 == 0)
+            {
+                auto& nested = item["nested"] = json::Array{};
+                for (int k = 0; k < 40; ++k)
+                    nested.push_back(json::Array{k, std::string(100, 'x'), json::Object{}});
+            }
+            items.push_back(std::move(item));
+        }
+        j["empty"] = json::Object{};
+        j["scalar"] = 1.5;
+        j["matrix"] = json::Array{json::Array{1, 2, 3}, json::Array{4, 5, 6}};
+    }
+
+    for (int indent_width = -1; indent_width <= 2; ++indent_width)
+    {
+        CAPTURE(indent_width);
+
+        json::StringifyOptions options;
+        options.indent_width = static_cast<int8_t>(indent_width);
+
+        std::string expected;
+        REQUIRE(json::stringify(expected, j, options));
+
+        static const size_t kChunkSizes[] = {1, 2, 3, 10, 100, 1000, 100000};
+        for (size_t chunk_size : kChunkSizes)
+        {
+            CAPTURE(chunk_size);
+
+            options.num_threads = 4;
+            options.parallel_chunk_size = chunk_size;
+
+            std::string str = "prefix";
+            CHECK(json::stringify(str, j, options));
+            CHECK(str == "prefix" + expected);
+        }
+    }
+
+    // Invalid UTF-8
+    {
+        json::StringifyOptions options;
+        options.num_threads = 4;
+        options.parallel_chunk_size = 1;
+
+        json::Value invalid_key = j;
+        invalid_key["\xFF"] = json::Array{1, 2, 3};
+        std::string str;
+        CHECK(!json::stringify(str, invalid_key, options));
+
+        json::Value invalid_value = j;
+        invalid_value["items"][100]["name"] = "\xFF";
+        CHECK(!json::stringify(str, invalid_value, options));
+    }
+}
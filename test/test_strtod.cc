@@ -1061,3 +1061,71 @@ TEST_CASE("Strtod - Regression")
 
     CHECK_EQ(6114917000000003e-14, Strtod("6114917000000003e-14"));
 }
+
+static float Strtof(std::string const& str)
+{
+    float value;
+    auto const res = json::numbers::StringToFloat(value, str.data(), str.data() + str.size());
+    CHECK(res == true);
+    return value;
+}
+
+static uint32_t StrtofBits(std::string const& str)
+{
+    return charconv::Single(Strtof(str)).bits;
+}
+
+TEST_CASE("Strtof")
+{
+    CHECK_EQ(0.0f, Strtof("0"));
+    CHECK_EQ(0.0f, Strtof("0.0"));
+    CHECK_EQ(0x80000000u, StrtofBits("-0.0"));
+    CHECK_EQ(1.0f, Strtof("1"));
+    CHECK_EQ(0.1f, Strtof("0.1"));
+    CHECK_EQ(-1.5f, Strtof("-1.5"));
+    CHECK_EQ(1.2345678f, Strtof("1.2345678"));
+    CHECK_EQ(16777216.0f, Strtof("16777217")); // tie => even
+    CHECK_EQ(16777220.0f, Strtof("16777219")); // tie => even
+    CHECK_EQ(1.0e10f, Strtof("1e10"));
+    CHECK_EQ(std::numeric_limits<float>::infinity(), Strtof("1e39"));
+    CHECK_EQ(std::numeric_limits<float>::infinity(), Strtof("1e99999999999"));
+    CHECK_EQ(0.0f, Strtof("1e-46"));
+    CHECK_EQ(0.0f, Strtof("1e-99999999999"));
+}
+
+TEST_CASE("Strtof - Boundaries")
+{
+    // 1 + 2^-24 is halfway between 1 and the next float (1 + 2^-23).
+    CHECK_EQ(0x3F800000u, StrtofBits("1.000000059604644775390625")); // tie => even
+    CHECK_EQ(0x3F800001u, StrtofBits("1.000000059604644775390626"));
+    CHECK_EQ(0x3F800000u, StrtofBits("1.000000059604644775390624"));
+
+    // These are rounded to exactly 1 + 2^-24 when converted to double first.
+    // Converting the double to float would then produce the wrong result.
+    CHECK_EQ(0x3F800001u, StrtofBits("1.000000059604644775390625000000000000001"));
+    CHECK_EQ(0x3F800000u, StrtofBits("1.000000059604644775390624999999999999999"));
+    CHECK_EQ(0x3F800001u, StrtofBits("1.0000000596046447753906250000000000000000000000000000000000000000000000000001"));
+
+    // 1 + 3 * 2^-24 is halfway between 1 + 2^-23 and 1 + 2^-22.
+    CHECK_EQ(0x3F800002u, StrtofBits("1.000000178813934326171875")); // tie => even
+
+    // Max float: (2^24 - 1) * 2^104
+    CHECK_EQ(0x7F7FFFFFu, StrtofBits("3.4028234663852886e38"));
+    CHECK_EQ(0x7F7FFFFFu, StrtofBits("3.4028235e38"));
+    CHECK_EQ(0x7F7FFFFFu, StrtofBits("340282356779733661637539395458142568447"));
+    CHECK_EQ(0x7F800000u, StrtofBits("340282356779733661637539395458142568448")); // tie => infinity
+    CHECK_EQ(0x7F800000u, StrtofBits("3.4028236e38"));
+
+    // Min normal: 2^-126
+    CHECK_EQ(0x00800000u, StrtofBits("1.1754943508222875e-38"));
+    CHECK_EQ(0x007FFFFFu, StrtofBits("1.1754942e-38"));
+
+    // Min denormal: 2^-149
+    CHECK_EQ(0x00000001u, StrtofBits("1.401298464324817e-45"));
+    CHECK_EQ(0x00000001u, StrtofBits("1e-45"));
+    CHECK_EQ(0x00000001u, StrtofBits("7.1e-46"));
+    CHECK_EQ(0x00000000u, StrtofBits("7.00649232162408535461864791644958065640130970938257885878534141944895541342930300743319094181060791015625e-46")); // tie => even
+    CHECK_EQ(0x00000000u, StrtofBits("7.006492321624085354618647916449580656401309709382578858785341419448955413429303e-46"));
+    CHECK_EQ(0x00000001u, StrtofBits("7.006492321624085354618647916449580656401309709382578858785341419448955413429304e-46"));
+    CHECK_EQ(0x00000000u, StrtofBits("7e-46"));
+}
@@ -0,0 +1,206 @@
+#include "catch.hpp"
+#include "../src/json_writer.h"
+
+static constexpr char const* kInput = R"({"menu":{"array":[1],"empty_array":[],"empty_object":{},"header":"SVG \"Viewer\"","items":[{"id":"Open"},{"id":"OpenNew","label":"Open New"},null,true,false,-1.5]}})";
+
+static void WriteMenu(json::Writer<json::OutputSink>& w)
+{
+    w.begin_object();
+    w.key("menu");
+    w.begin_object();
+        w.key("array");
+        w.begin_array();
+            w.number(1);
+        w.end_array();
+        w.key("empty_array");
+        w.begin_array();
+        w.end_array();
+        w.key("empty_object");
+        w.begin_object();
+        w.end_object();
+        w.key("header");
+        w.string("SVG \"Viewer\"");
+        w.key("items");
+        w.begin_array();
+            w.begin_object();
+                w.key("id");
+                w.string("Open");
+            w.end_object();
+            w.begin_object();
+                w.key("id");
+                w.string("OpenNew");
+                w.key(std::string("label"));
+                w.string(std::string("Open New"));
+            w.end_object();
+            w.null();
+            w.boolean(true);
+            w.boolean(false);
+            w.number(-1.5);
+        w.end_array();
+    w.end_object();
+    w.end_object();
+}
+
+TEST_CASE("Writer")
+{
+    json::Value j;
+    auto const ec = json::parse(j, kInput);
+    REQUIRE(ec == json::ParseStatus::success);
+
+    for (int indent_width = -1; indent_width <= 4; ++indent_width)
+    {
+        CAPTURE(indent_width);
+
+        json::StringifyOptions options;
+        options.indent_width = static_cast<int8_t>(indent_width);
+
+        std::string expected;
+        REQUIRE(json::stringify(expected, j, options));
+
+        {
+            std::string str;
+            json::StringSink sink(str);
+            json::Writer<> w(sink, options);
+            WriteMenu(w);
+            CHECK(w.is_complete());
+            CHECK(w.depth() == 0);
+            sink.Flush();
+            CHECK(str == expected);
+        }
+        {
+            std::string str;
+            json::StringSink sink(str);
+            json::Writer<> w(sink, options);
+            CHECK(w.value(j));
+            CHECK(w.is_complete());
+            sink.Flush();
+            CHECK(str == expected);
+        }
+    }
+}
+
+TEST_CASE("Writer - scalars")
+{
+    auto write = [](auto f, json::StringifyOptions const& options = {}) {
+        std::string str;
+        json::StringSink sink(str);
+        json::Writer<> w(sink, options);
+        f(w);
+        CHECK(w.is_complete());
+        sink.Flush();
+        return str;
+    };
+
+    CHECK(write([](auto& w) { w.null(); }) == "null");
+    CHECK(write([](auto& w) { w.boolean(true); }) == "true");
+    CHECK(write([](auto& w) { w.number(0.1); }) == "0.1");
+    CHECK(write([](auto& w) { w.number(std::numeric_limits<double>::infinity()); }) == "null");
+    CHECK(write([](auto& w) { w.string("\n\xC3\xA4"); }) == "\"\\n\xC3\xA4\"");
+
+    json::StringifyOptions options;
+    options.single_precision = true;
+    CHECK(write([](auto& w) { w.number(0.1); }, options) == "0.1");
+    CHECK(write([](auto& w) { w.number(1.0 / 3.0); }, options) == "0.33333334");
+}
+
+TEST_CASE("Writer - invalid UTF-8")
+{
+    std::string str;
+    json::StringSink sink(str);
+    json::Writer<> w(sink);
+
+    CHECK(w.begin_object());
+    CHECK(!w.key("\xFF"));
+    CHECK(!w.string("\xFF"));
+    CHECK(w.end_object());
+}
+
+TEST_CASE("Writer - raw")
+{
+    json::Value j;
+    REQUIRE(json::parse(j, kInput) == json::ParseStatus::success);
+
+    std::string menu;
+    REQUIRE(json::stringify(menu, j["menu"]));
+
+    for (int indent_width = -1; indent_width <= 4; ++indent_width)
+    {
+        CAPTURE(indent_width);
+
+        json::StringifyOptions options;
+        options.indent_width = static_cast<int8_t>(indent_width);
+
+        std::string expected;
+        REQUIRE(json::stringify(expected, j, options));
+
+        std::string str;
+        json::StringSink sink(str);
+        json::Writer<> w(sink, options);
+        w.begin_object();
+        w.key("menu");
+        CHECK(w.raw(menu));
+        w.end_object();
+        CHECK(w.is_complete());
+        sink.Flush();
+        CHECK(str == expected);
+
+        json::Value raw = json::Object{};
+        raw["menu"].assign(json::raw_tag, menu);
+        std::string str2;
+        json::StringSink sink2(str2);
+        json::Writer<> w2(sink2, options);
+        CHECK(w2.value(raw));
+        sink2.Flush();
+        CHECK(str2 == expected);
+    }
+}
+
+TEST_CASE("Writer - max depth")
+{
+    std::string str;
+    json::StringSink sink(str);
+    json::Writer<> w(sink);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        REQUIRE(w.begin_array());
+    }
+    CHECK(w.depth() == 500);
+    CHECK(!w.has_failed());
+    CHECK(!w.begin_array());
+    CHECK(!w.begin_object());
+    CHECK(w.has_failed());
+    CHECK(w.depth() == 500);
+    CHECK(!w.null());
+    CHECK(!w.end_array());
+    CHECK(!w.is_complete());
+
+    json::Value deep;
+    json::Value* curr = &deep;
+    for (int i = 0; i < 520; ++i)
+    {
+        *curr = json::Array{json::Value()};
+        curr = &curr->get_array()[0];
+    }
+    *curr = nullptr;
+
+    std::string str2;
+    json::StringSink sink2(str2);
+    json::Writer<> w2(sink2);
+    CHECK(!w2.value(deep));
+    CHECK(w2.has_failed());
+
+    json::Value raw;
+    raw.assign(json::raw_tag, std::string(400, '[') + std::string(400, ']'));
+    json::StringifyOptions options;
+    options.indent_width = 0;
+    std::string str3;
+    json::StringSink sink3(str3);
+    json::Writer<> w3(sink3, options);
+    for (int i = 0; i < 200; ++i)
+    {
+        REQUIRE(w3.begin_array());
+    }
+    CHECK(!w3.value(raw));
+    CHECK(w3.has_failed());
+}